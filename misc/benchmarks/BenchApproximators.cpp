@@ -0,0 +1,95 @@
+/**
+@file
+
+\brief time the function approximators of the RL brains
+
+Measures how long a backprop network and tile coding take to choose an
+action and learn, as TDBrain does in each step. It is a measure rather than
+a check, so it is kept out of the unit tests under test/. It has no target
+in the build: compile it with the flags of OpenNERO and link it against the
+objects the OpenNERO build makes of source/ai/rl, source/ai/AI.cpp,
+source/core and source/math (Log.cpp needs the rest of the kernel, or a stub
+of Log::Output and Log::IsEnabled), with Boost serialization and thread.
+Run it as
+
+    BenchApproximators [steps]
+
+where steps defaults to 20000.
+*/
+#include "core/Common.h"
+#include "ai/rl/Approximator.h"
+#include "ai/rl/BackpropApproximator.h"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+using namespace OpenNero;
+
+namespace
+{
+    /// two continuous sensors in [-1, 1] and [0, 10], and one discrete
+    /// action in [0, 2]
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        sensors.addContinuous(0, 10);
+        ActionInfo actions;
+        actions.addDiscrete(0, 2);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    FeatureVector MakeState(int i)
+    {
+        FeatureVector state(2);
+        state[0] = (i % 21) / 10.0 - 1;
+        state[1] = (i * 7 % 11);
+        return state;
+    }
+
+    FeatureVector MakeAction(int a)
+    {
+        FeatureVector action(1);
+        action[0] = a;
+        return action;
+    }
+
+    /// @return the time one step takes, in microseconds
+    double TimeSteps(Approximator& approximator, int steps)
+    {
+        std::vector<FeatureVector> actions;
+        for (int a = 0; a <= 2; ++a)
+        {
+            actions.push_back(MakeAction(a));
+        }
+        std::vector<double> values;
+        std::clock_t start = std::clock();
+        for (int i = 0; i < steps; ++i)
+        {
+            FeatureVector state = MakeState(i);
+            approximator.predict_all(state, actions, values);
+            approximator.update(state, actions[i % 3], values[i % 3] + 0.1);
+        }
+        double seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+        return seconds * 1e6 / steps;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int steps = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (steps <= 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [steps]" << std::endl;
+        return 1;
+    }
+
+    AgentInitInfo info = MakeInfo();
+    BackpropApproximator network(info, 32);
+    TilesApproximator tiles(info, 16, 4096);
+    std::cout << "backprop (32 hidden units): " << TimeSteps(network, steps) << " us per step" << std::endl;
+    std::cout << "tiles (16 tilings): " << TimeSteps(tiles, steps) << " us per step" << std::endl;
+    return 0;
+}
@@ -242,28 +242,31 @@ class NeroEnvironment(OpenNero.Environment):
         if not foes:
             return None
 
-        min_enemy = None
-        min_dist = constants.MAX_FIRE_ACTION_RADIUS
+        # cast a ray to every foe in range at once, then take the nearest
+        # one that no obstacle hides
         pose = self.get_state(agent).pose
-        color = OpenNero.Color(128, 0, 0, 0)
+        in_range = []
+        rays = []
         for f in foes:
-            f_pose = self.get_state(f).pose
-            dist = self.distance(pose, f_pose)
-            if dist < min_dist:
+            dist = self.distance(pose, self.get_state(f).pose)
+            if dist < constants.MAX_FIRE_ACTION_RADIUS:
                 source_pos = agent.state.position
                 target_pos = f.state.position
                 source_pos.z = source_pos.z + 5
                 target_pos.z = target_pos.z + 5
-                obstacles = OpenNero.getSimContext().findInRay(
-                    source_pos,
-                    target_pos,
-                    constants.OBJECT_TYPE_OBSTACLE,
-                    False,
-                    color,
-                    color)
-                if len(obstacles) == 0:
-                    min_enemy = f
-                    min_dist = dist
+                in_range.append((dist, f))
+                rays.append((source_pos, target_pos))
+        if not rays:
+            return None
+        obstacles = OpenNero.getSimContext().findInRays(
+            rays, constants.OBJECT_TYPE_OBSTACLE)
+
+        min_enemy = None
+        min_dist = constants.MAX_FIRE_ACTION_RADIUS
+        for (dist, f), hit in zip(in_range, obstacles):
+            if dist < min_dist and len(hit) == 0:
+                min_enemy = f
+                min_dist = dist
         return min_enemy
 
     def step(self, agent, action):
@@ -349,13 +352,13 @@ class NeroEnvironment(OpenNero.Environment):
                         else:
                             color = OpenNero.Color(255, 255, 255, 0)
                         wall_color = OpenNero.Color(128, 0, 255, 0)
-                        obstacles = OpenNero.getSimContext().findInRay(
-                            source_pos,
-                            target_pos,
+                        obstacles = OpenNero.getSimContext().findInRays(
+                            [(source_pos, target_pos)],
                             constants.OBJECT_TYPE_OBSTACLE,
+                            1,
                             True,
                             wall_color,
-                            color)
+                            color)[0]
                         #if len(obstacles) == 0 and random.random() < d/2:
                         if len(obstacles) == 0:
                             # count as hit depending on distance
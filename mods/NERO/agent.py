@@ -436,11 +436,13 @@ class QLearningAgent(NeroAgent, OpenNero.QLearningBrain):
 
     def __init__(self, gamma=0.8, alpha=0.8, epsilon=0.1,
                  action_bins=3, state_bins=5,
-                 num_tiles=0, num_weights=0):
+                 num_tiles=0, num_weights=0, hidden_units=0, shared=False):
         OpenNero.QLearningBrain.__init__(
             self, gamma, alpha, epsilon,
             action_bins, state_bins,
-            num_tiles, num_weights)
+            num_tiles, num_weights, hidden_units)
+        # learn one table for the whole team
+        self.shared = shared
         NeroAgent.__init__(self)
     
     def set_display_hint(self):
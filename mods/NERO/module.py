@@ -71,6 +71,9 @@ class NeroModule:
         self.environment = self.create_environment()
         OpenNero.set_environment(self.environment)
 
+        # walls do not move, so rays can index their triangles once
+        OpenNero.getSimContext().setStaticRayTypes(constants.OBJECT_TYPE_OBSTACLE)
+
         # world walls
         height = constants.HEIGHT + constants.OFFSET
         common.addObject(
@@ -181,12 +184,17 @@ class NeroModule:
         if rtneat:
             location = rtneat.save_population(str(location))
         # then, check whether there are any qlearning agents, and save them.
-        with open(location, 'a') as handle:
-            for agent in self.environment.teams[team]:
-                if agent.group == 'Agent' and agent.ai == 'qlearning':
-                    handle.write('\n\n%s' % agent.to_string())
-                if hasattr(agent, 'stats'):
-                    handle.write('\n\n%s' % agent.stats())
+        # agents that share what they learn write it with the first of them.
+        OpenNero.begin_brain_save()
+        try:
+            with open(location, 'a') as handle:
+                for agent in self.environment.teams[team]:
+                    if agent.group == 'Agent' and agent.ai == 'qlearning':
+                        handle.write('\n\n%s' % agent.to_string())
+                    if hasattr(agent, 'stats'):
+                        handle.write('\n\n%s' % agent.stats())
+        finally:
+            OpenNero.end_brain_save()
 
     #The following is run when the Load button is pressed
     def load_team(self, location, team=constants.OBJECT_TYPE_TEAM_0):
@@ -216,7 +224,7 @@ class NeroModule:
 
         rtneat, qlearning, stats = self._split_population(contents.splitlines(True))
 
-        print 'qlearning agents:', qlearning.count('Approximator')
+        print 'qlearning agents:', qlearning.count('serialization::archive')
 
         # load any qlearning agents first, subtracting them from the population
         # size that rtneat will need to manage. since we cannot deserialize an
@@ -281,7 +289,7 @@ class NeroModule:
                 if line.startswith('genomestart'):
                     state = 'RTNEAT'
                     rtneat.append(line)
-                if 'OpenNero' in line and 'Approximator' in line:
+                if 'serialization::archive' in line:
                     state = 'QLEARNING'
                     qlearning.append(line)
                 if '<message>' in line:
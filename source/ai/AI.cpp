@@ -140,11 +140,11 @@ namespace OpenNero
         {
             if (isDiscrete(i))
             {
-                result.push_back(RANDOM.randI( (uint32_t)(getMax(i) - getMin(i)) ) + getMin(i));
+                result.push_back(ThreadRandom().randI( (uint32_t)(getMax(i) - getMin(i)) ) + getMin(i));
             }
             else
             {
-                result.push_back(RANDOM.randD(getMax(i) - getMin(i)) + getMin(i));
+                result.push_back(ThreadRandom().randD(getMax(i) - getMin(i)) + getMin(i));
             }
         }
         return result;
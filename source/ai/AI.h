@@ -32,6 +32,7 @@ namespace OpenNero {
     BOOST_SHARED_STRUCT(PlayerAction);
     BOOST_SHARED_DECL(SimEntity);
     BOOST_SHARED_DECL(SimEntityData);
+    class Bitstream;
     /// @endcond
 
     /// A fixed dimension vector of real numbers
@@ -228,6 +229,14 @@ namespace OpenNero {
 
         /// update our entity base on our object access mode
         virtual void ProcessTick( float32_t incAmt ) = 0;
+
+        /// write the state that a world snapshot should bring back
+        virtual void SaveState( Bitstream& stream ) const {}
+
+        /// read the state written by SaveState
+        /// @return false if the stream does not hold a complete state, in
+        /// which case the AI is left as it was
+        virtual bool LoadState( Bitstream& stream ) { return true; }
     };
 
 }
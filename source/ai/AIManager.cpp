@@ -98,6 +98,82 @@ namespace OpenNero
     {
         mAIs[name] = ai;
     }
+
+    void AIManager::SaveState(Bitstream& stream) const
+    {
+        uint32_t count = 0;
+        map<string, AIPtr>::const_iterator iter;
+        for (iter = mAIs.begin(); iter != mAIs.end(); ++iter)
+        {
+            if (iter->second)
+                ++count;
+        }
+        stream << count;
+
+        // each state goes with its length, so that one that an AI does not
+        // read completely does not throw off the rest
+        Bitstream state;
+        for (iter = mAIs.begin(); iter != mAIs.end(); ++iter)
+        {
+            if (!iter->second)
+                continue;
+            state.Clear();
+            iter->second->SaveState(state);
+            stream << iter->first << state.ByteLength() << state;
+        }
+    }
+
+    bool AIManager::ReadState(Bitstream& stream, SavedAIs& saved)
+    {
+        uint32_t count;
+        stream >> count;
+        // every state takes more than a byte, so a corrupt count shows here
+        if (stream.Failed() || count > stream.ByteLength())
+        {
+            LOG_F_ERROR("ai", "the saved AI states are cut short");
+            return false;
+        }
+
+        saved.clear();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            string name;
+            uint32_t length;
+            stream >> name >> length;
+            if (stream.Failed() || length > stream.ByteLength())
+            {
+                LOG_F_ERROR("ai", "the saved AI states end after " << i << " of " << count);
+                return false;
+            }
+            Bitstream& state = saved[name];
+            state.Clear();
+            if (length > 0)
+            {
+                vector<uint8_t> bytes(length);
+                stream.PopBytes(&bytes[0], length);
+                state.PushBytes(&bytes[0], length);
+            }
+        }
+        return true;
+    }
+
+    bool AIManager::LoadState(const SavedAIs& saved)
+    {
+        bool complete = true;
+        SavedAIs::const_iterator iter;
+        for (iter = saved.begin(); iter != saved.end(); ++iter)
+        {
+            AIPtr ai = GetAI(iter->first);
+            // read a copy, so that the states can be loaded again
+            Bitstream state(iter->second);
+            if (!ai || !ai->LoadState(state))
+            {
+                LOG_F_WARNING("ai", "the AI " << iter->first << " could not take its saved state");
+                complete = false;
+            }
+        }
+        return complete;
+    }
     
     /// tick the AIs
     void AIManager::ProcessTick( float32_t incAmt )
@@ -2,7 +2,9 @@
 #define _OPENNERO_AI_AIMANAGER_H_
 
 #include <set>
+#include <map>
 #include "ai/AI.h"
+#include "core/Bitstream.h"
 
 namespace OpenNero
 {
@@ -18,7 +20,7 @@ namespace OpenNero
     class AIManager
     {
         // private constructor
-        AIManager() : mEnabled(false), mEnvironment() {}
+        AIManager() : mEnabled(false), mPhased(false), mNumThreads(1), mEnvironment() {}
 
     public:
         /// singleton instance of class
@@ -33,6 +35,24 @@ namespace OpenNero
 
         /// return true iff AI is enabled
         bool IsEnabled() const { return mEnabled; }
+
+        /// choose how agents tick. By default, they tick one after another
+        /// and each sees what the ones before it did. In phases, the agents
+        /// with C++ brains all sense and decide before any of them acts,
+        /// which gives the same results for any number of threads.
+        /// @param phased whether to tick the agents in phases
+        void SetPhased(bool phased) { mPhased = phased; }
+
+        /// @return true if the agents tick in phases
+        bool IsPhased() const { return mPhased; }
+
+        /// set the number of threads to sense and decide on when the agents
+        /// tick in phases
+        /// @param num_threads the number of threads, 0 for one per core
+        void SetNumThreads(size_t num_threads) { mNumThreads = num_threads; }
+
+        /// get the number of threads to tick the agents on
+        size_t GetNumThreads() const { return mNumThreads; }
         
         /// tick the AIs
         void ProcessTick( float32_t incAmt );
@@ -49,6 +69,20 @@ namespace OpenNero
         /// set the named AI instance
         void SetAI(const std::string& name, AIPtr ai);
 
+        /// the saved states of the AIs, by name
+        typedef std::map<std::string, Bitstream> SavedAIs;
+
+        /// write the state of every AI, with its name
+        void SaveState(Bitstream& stream) const;
+
+        /// read the states written by SaveState, without touching the AIs
+        /// @return false if the stream is cut short or corrupt
+        static bool ReadState(Bitstream& stream, SavedAIs& saved);
+
+        /// give the AIs of the same names the states read by ReadState
+        /// @return false if one of them could not take its state
+        bool LoadState(const SavedAIs& saved);
+
         /// log the performance of AI agents
         void Log(SimId id, size_t episode, size_t step, Reward reward, Reward fitness);
         
@@ -60,6 +94,8 @@ namespace OpenNero
 
     private:
         bool mEnabled; ///< global "disable AI" switch
+        bool mPhased; ///< whether the agents tick in phases
+        size_t mNumThreads; ///< threads to tick the agents on, 0 for one per core
         EnvironmentPtr mEnvironment; ///< current environment
         std::map<std::string, AIPtr> mAIs; ///< AIs currently used
     };
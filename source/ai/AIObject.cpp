@@ -52,32 +52,68 @@ namespace OpenNero
     /// get the AI move and apply it to the shared data
     void AIObject::ProcessTick(float32_t dt)
     {
-        Assert(getBrain());
-
-        if (getBrain()->step == 0) // if first step
+        if (BeginTick(dt))
         {
-            Observations observations = sense();
-            setActions(getBrain()->start(dt, observations));
-            setReward(getWorld()->step(getBrain(), getActions()));
-            getBrain()->step++;
+            SenseSensors();
+            SenseWorld();
+            Decide(dt);
+            EndTick();
         }
-        else
-        {
-            Assert(getWorld());
-            if (getWorld()->is_episode_over(getBrain())) {
-                getBrain()->end(dt, getReward());
-                getWorld()->reset(getBrain());
-                getBrain()->episode++;
-                getBrain()->step = 0;
-                getBrain()->fitness = getInitInfo().reward.getInstance();
-            } else {
-                Observations observations = sense();
-                if (!getBrain()->GetSkip()) // only generate new actions when not skipping
-                    setActions(getBrain()->act(dt, observations, getReward()));
-                setReward(getWorld()->step(getBrain(), getActions()));
-                getBrain()->step++;
-            }
+    }
+
+    bool AIObject::BeginTick(float32_t dt)
+    {
+        Assert(getBrain());
+        if (getBrain()->step == 0) // if first step
+            return true;
+        Assert(getWorld());
+        if (getWorld()->is_episode_over(getBrain())) {
+            getBrain()->end(dt, getReward());
+            getWorld()->reset(getBrain());
+            getBrain()->episode++;
+            getBrain()->step = 0;
+            getBrain()->fitness = getInitInfo().reward.getInstance();
+            return false;
         }
+        return true;
+    }
+
+    void AIObject::SenseSensors()
+    {
+        // create a new observation vector
+        mObservations = getInitInfo().sensors.getInstance();
+        // pass it along to the built-in sensors so that they can set some of the values
+        mSensors.getObservations(mObservations);
+    }
+
+    void AIObject::SenseWorld()
+    {
+        // let the environment compute the final sensor vector
+        mObservations = getWorld()->sense(getBrain(), mObservations);
+    }
+
+    void AIObject::Decide(float32_t dt)
+    {
+        if (getBrain()->step == 0)
+            setActions(getBrain()->start(dt, mObservations));
+        else if (!getBrain()->GetSkip()) // only generate new actions when not skipping
+            setActions(getBrain()->act(dt, mObservations, getReward()));
+    }
+
+    void AIObject::EndTick()
+    {
+        setReward(getWorld()->step(getBrain(), getActions()));
+        getBrain()->step++;
+    }
+
+    bool AIObject::IsNative() const
+    {
+        return !dynamic_cast<const PyAgentBrain*>(getBrain().get()) && mSensors.isNative();
+    }
+
+    bool AIObject::HasNativeWorld() const
+    {
+        return !dynamic_cast<const PyEnvironment*>(getWorld().get());
     }
     
     void AIObject::setReward(Reward reward)
@@ -97,16 +133,32 @@ namespace OpenNero
              getBrain()->fitness);
     }
 
+    void AIObject::SaveState(Bitstream& stream) const
+    {
+        Assert(getBrain());
+        stream << mActions << mReward;
+        getBrain()->SaveState(stream);
+    }
+
+    bool AIObject::LoadState(Bitstream& stream)
+    {
+        Assert(getBrain());
+        Actions actions;
+        Reward reward;
+        stream >> actions >> reward;
+        if (stream.Failed() || !getBrain()->LoadState(stream))
+            return false;
+        mActions = actions;
+        mReward = reward;
+        return true;
+    }
+
     /// sense the agent's environment
     Observations AIObject::sense()
     {
-        // create a new observation vector
-        Observations o = getInitInfo().sensors.getInstance();
-        // first, pass it along to the built-in sensors so that they can set some of the values
-        mSensors.getObservations(o);
-        // then, pass it to the environment and let it compute the final sensor vector
-        Observations observations = getWorld()->sense(getBrain(), o);
-        return observations;
+        SenseSensors();
+        SenseWorld();
+        return mObservations;
     }
 
     inline std::ostream& operator<<(std::ostream& out, AIObject& obj)
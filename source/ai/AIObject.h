@@ -19,6 +19,7 @@ namespace OpenNero
     /// @endcond
 
     class SimEntityData;
+    class Bitstream;
 
     /// interface for objects connecting an AgentBrain to a SimEntity body
     class AIObject : public BOOST_SHARED_THIS(AIObject),
@@ -40,6 +41,46 @@ namespace OpenNero
         /// sense the agent's environment
         virtual Observations sense();
 
+        /** @name Tick phases
+         * ProcessTick in parts, so that a simulation can run the sensing and
+         * deciding of many agents in parallel and then apply their actions
+         * one at a time. BeginTick and EndTick change the world; the other
+         * phases only read it.
+         */
+        ///@{
+
+        /// end the episode if it is over
+        /// @return true if the agent senses and acts during this tick
+        bool BeginTick(float32_t dt);
+
+        /// read the built-in sensors into the pending observations
+        void SenseSensors();
+
+        /// let the environment complete the pending observations
+        void SenseWorld();
+
+        /// pick the next actions based on the pending observations
+        void Decide(float32_t dt);
+
+        /// perform the picked actions in the environment and collect the reward
+        void EndTick();
+
+        /// @return true if the brain and the sensors of this agent are C++,
+        /// so that its sensors and decisions do not need Python
+        bool IsNative() const;
+
+        /// @return true if the environment is C++, so that SenseWorld does not need Python
+        bool HasNativeWorld() const;
+
+        ///@}
+
+        /// write the last actions and reward, and the state of the brain, to a world snapshot
+        void SaveState(Bitstream& stream) const;
+
+        /// continue from a state written by SaveState
+        /// @return false if the state does not fit the brain
+        bool LoadState(Bitstream& stream);
+
         /// add a new sensor to the built-in sensor collection for this AIObject
         size_t add_sensor(SensorPtr sensor) { return mSensors.addSensor(sensor); }
 
@@ -76,6 +117,7 @@ namespace OpenNero
     private:
 
         Actions mActions; ///< last performed action
+        Observations mObservations; ///< observations for the decision being made
         AgentBrainPtr mAgentBrain; ///< the brain whose actions we are applying
         EnvironmentWPtr mWorld; ///< world we are acting in
         Reward mReward; ///< the reward received by the agent after performing the previous action
@@ -9,6 +9,28 @@ namespace OpenNero
 {
     using namespace boost::python;
 
+    namespace {
+        uint32_t sLastPass = 0;             ///< the number of the last pass opened
+        std::vector<uint32_t> sOpenPasses;  ///< the numbers of the open passes, innermost last
+    }
+
+    void BrainSavePass::Begin()
+    {
+        sOpenPasses.push_back(++sLastPass);
+    }
+
+    void BrainSavePass::End()
+    {
+        Assert(!sOpenPasses.empty());
+        if (!sOpenPasses.empty())
+            sOpenPasses.pop_back();
+    }
+
+    uint32_t BrainSavePass::Current()
+    {
+        return sOpenPasses.empty() ? 0 : sOpenPasses.back();
+    }
+
     /// Should the next call to act be skipped? (clears the flag)
     bool AgentBrain::GetSkip() const
     {
@@ -20,6 +42,28 @@ namespace OpenNero
         }
     }
 
+    /// write the counters of the brain to a world snapshot
+    void AgentBrain::SaveState(Bitstream& stream) const
+    {
+        stream << uint32_t(episode) << uint32_t(step) << fitness << uint8_t(skip_flag);
+    }
+
+    /// read the counters written by SaveState
+    bool AgentBrain::LoadState(Bitstream& stream)
+    {
+        uint32_t episode_count, step_count;
+        uint8_t skip;
+        Reward saved_fitness;
+        stream >> episode_count >> step_count >> saved_fitness >> skip;
+        if (stream.Failed())
+            return false;
+        fitness = saved_fitness;
+        episode = episode_count;
+        step = step_count;
+        skip_flag = (skip != 0);
+        return true;
+    }
+
     /// Causes the agent to ignore collisions and to be placed exactly where specified by state
     void AgentBrain::Teleport()
     {
@@ -7,6 +7,7 @@
 #define _OPENNERO_AI_AGENT_H_
 
 #include "core/ONTime.h"
+#include "core/Bitstream.h"
 #include "ai/AI.h"
 #include "ai/AIObject.h"
 #include "game/objects/TemplatedObject.h"
@@ -65,6 +66,19 @@ namespace OpenNero
             /// get the current fitness of the agent
             Reward get_fitness() { return fitness; }
 
+            /// write what changes as the agent lives (its counters and, for
+            /// C++ brains, what it has learned) to a world snapshot
+            virtual void SaveState(Bitstream& stream) const;
+
+            /// continue from a state written by SaveState
+            /// @return false if the state does not fit this brain
+            virtual bool LoadState(Bitstream& stream);
+
+            /// @return true if deciding changes state that other brains use
+            /// too (such as a shared approximator), so that the decisions of
+            /// these brains have to be taken one at a time to be repeatable
+            virtual bool SharesState() const { return false; }
+
             /// add a sensor to this agent's body
             size_t add_sensor(SensorPtr s) { return GetBody()->add_sensor(s); }
 
@@ -90,6 +104,36 @@ namespace OpenNero
     /// shared pointer to an AgentBrain
     BOOST_SHARED_DECL(AgentBrain);
 
+    /// Groups the saving of many brains (a team, a world snapshot), so that
+    /// state they share, such as a shared approximator, is written with the
+    /// first of them only and the others just refer to it. Outside of a pass
+    /// every brain writes all it needs to be loaded on its own. Passes nest,
+    /// and an inner one (a world snapshot taken while Python saves a team)
+    /// is a pass of its own, written to an output of its own. Passes belong
+    /// to the main thread.
+    class BrainSavePass
+    {
+        public:
+            /// open a pass until this object goes away
+            BrainSavePass() { Begin(); }
+
+            /// close the pass opened by the constructor
+            ~BrainSavePass() { End(); }
+
+            /// open a pass (for Python, which cannot scope one)
+            static void Begin();
+
+            /// close the pass opened by Begin
+            static void End();
+
+            /// @return the number of the innermost open pass, 0 if there is none
+            static uint32_t Current();
+
+        private:
+            BrainSavePass(const BrainSavePass&);
+            BrainSavePass& operator=(const BrainSavePass&);
+    };
+
     /// C++ interface for Python-side AgentBrain
     class PyAgentBrain : public AgentBrain, public TryWrapper<AgentBrain>
     {
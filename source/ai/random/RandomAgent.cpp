@@ -11,12 +11,12 @@ namespace OpenNero {
             if (_init.actions.isDiscrete(i))
             {
                 result[i]
-                    = RANDOM.randI( (uint32_t)(_init.actions.getMax(i)
+                    = ThreadRandom().randI( (uint32_t)(_init.actions.getMax(i)
                         - _init.actions.getMin(i)) ) + _init.actions.getMin(i);
             }
             else
             {
-                result[i] = RANDOM.randD(_init.actions.getMax(i)
+                result[i] = ThreadRandom().randD(_init.actions.getMax(i)
                     - _init.actions.getMin(i)) + _init.actions.getMin(i);
             }
         }
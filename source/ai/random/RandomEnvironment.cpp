@@ -17,14 +17,14 @@ namespace OpenNero
             if (mInitInfo.sensors.isDiscrete(i))
             {
                 result[i]
-                    = RANDOM.randI( (uint32_t)(mInitInfo.sensors.getMax(i)
+                    = ThreadRandom().randI( (uint32_t)(mInitInfo.sensors.getMax(i)
                         - mInitInfo.sensors.getMin(i)) )
                         + mInitInfo.sensors.getMin(i);
             }
             else
             {
                 result[i]
-                    = RANDOM.randD(mInitInfo.sensors.getMax(i)
+                    = ThreadRandom().randD(mInitInfo.sensors.getMax(i)
                         - mInitInfo.sensors.getMin(i))
                         + mInitInfo.sensors.getMin(i);
             }
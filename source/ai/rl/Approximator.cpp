@@ -1,5 +1,8 @@
 #include <boost/serialization/export.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include "core/Common.h"
 #include "math/Random.h"
 #include "Approximator.h"
@@ -7,22 +10,171 @@
 
 namespace OpenNero
 {
+    /// @param observation sensor vector
+    /// @param actions the actions to evaluate
+    /// @param values the value of each action, in order
+    void Approximator::predict_all(const FeatureVector& observation, const std::vector<FeatureVector>& actions, std::vector<double>& values)
+    {
+        values.resize(actions.size());
+        for (size_t i = 0; i < actions.size(); ++i)
+        {
+            values[i] = predict(observation, actions[i]);
+        }
+    }
+
+    namespace {
+        /// scatter the bits of an index over the whole word
+        inline uint64_t mix(uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            key *= 0xc4ceb9fe1a85ec53ULL;
+            key ^= key >> 33;
+            return key;
+        }
+    }
+
+    IndexValueMap::IndexValueMap() : mKeys(), mValues(), mCount(0)
+    {
+    }
+
+    double IndexValueMap::get(uint64_t index) const
+    {
+        if (mCount == 0)
+        {
+            return 0;
+        }
+        size_t slot = find(index + 1);
+        return mKeys[slot] ? mValues[slot] : 0;
+    }
+
+    double& IndexValueMap::at(uint64_t index)
+    {
+        // keep at least half of the slots empty so that probes stay short
+        if ((mCount + 1) * 2 > mKeys.size())
+        {
+            grow();
+        }
+        size_t slot = find(index + 1);
+        if (!mKeys[slot])
+        {
+            mKeys[slot] = index + 1;
+            mValues[slot] = 0;
+            ++mCount;
+        }
+        return mValues[slot];
+    }
+
+    void IndexValueMap::clear()
+    {
+        std::fill(mKeys.begin(), mKeys.end(), 0);
+        mCount = 0;
+    }
+
+    size_t IndexValueMap::find(uint64_t key) const
+    {
+        const size_t mask = mKeys.size() - 1;
+        size_t slot = size_t(mix(key)) & mask;
+        while (mKeys[slot] != 0 && mKeys[slot] != key)
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void IndexValueMap::grow()
+    {
+        std::vector<uint64_t> keys(std::max<size_t>(16, mKeys.size() * 2), 0);
+        std::vector<double> values(keys.size(), 0);
+        keys.swap(mKeys);
+        values.swap(mValues);
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i])
+            {
+                size_t slot = find(keys[i]);
+                mKeys[slot] = keys[i];
+                mValues[slot] = values[i];
+            }
+        }
+    }
+
+    TableValues::TableValues() : table(), dense(), shared(false)
+    {
+    }
+
+    size_t TableValues::stripe(uint64_t index)
+    {
+        // the high bits, since the maps find their slots with the low ones
+        return size_t(mix(index + 1) >> 60) % kStripes;
+    }
+
+    double TableValues::get(uint64_t index) const
+    {
+        const size_t s = stripe(index);
+        if (!shared)
+        {
+            return hashed[s].get(index);
+        }
+        boost::mutex::scoped_lock lock(hashed_locks[s]);
+        return hashed[s].get(index);
+    }
+
+    void TableValues::set(uint64_t index, double value)
+    {
+        const size_t s = stripe(index);
+        if (!shared)
+        {
+            hashed[s].at(index) = value;
+            return;
+        }
+        boost::mutex::scoped_lock lock(hashed_locks[s]);
+        hashed[s].at(index) = value;
+    }
+
+    void TableValues::clear()
+    {
+        table.clear();
+        std::fill(dense.begin(), dense.end(), 0);
+        for (size_t s = 0; s < kStripes; ++s)
+        {
+            hashed[s].clear();
+        }
+    }
+
+    void TableValues::assign(const TableValues& other)
+    {
+        table = other.table;
+        dense = other.dense;
+        for (size_t s = 0; s < kStripes; ++s)
+        {
+            hashed[s] = other.hashed[s];
+        }
+    }
+
     /// @param info information about the agent for which this approximator is to be used
     TableApproximator::TableApproximator(const AgentInitInfo& info, const int actions, const int states) :
         Approximator(info)
-        , table()
+        , learned(new TableValues())
+        , digits()
+        , storage(kExact)
         , action_bins(actions)
         , state_bins(states)
     {
+        layout();
     }
 
     /// copy constructor
     TableApproximator::TableApproximator(const TableApproximator& a) :
         Approximator(a)
-        , table(a.table)
+        , learned(new TableValues())
+        , digits(a.digits)
+        , storage(a.storage)
         , action_bins(a.action_bins)
         , state_bins(a.state_bins)
     {
+        learned->assign(*a.learned);
     }
 
     /// destructor
@@ -30,16 +182,164 @@ namespace OpenNero
     {
     }
 
+    /// Both tables keep storing into the same values, which from now on are
+    /// guarded against being changed from several threads at once.
+    ApproximatorPtr TableApproximator::share()
+    {
+        if (!learned->shared)
+        {
+            learned->shared = true;
+        }
+        boost::shared_ptr<TableApproximator> p(new TableApproximator());
+        p->mInfo = mInfo;
+        p->learned = learned;
+        p->digits = digits;
+        p->storage = storage;
+        p->action_bins = action_bins;
+        p->state_bins = state_bins;
+        return p;
+    }
+
+    /// Number the cells of the quantized space. Each dimension is a digit
+    /// whose radix is its number of bins (the integers between the bounds
+    /// for discrete dimensions), the first state dimension being the least
+    /// significant one.
+    void TableApproximator::layout()
+    {
+        digits.clear();
+        learned.reset(new TableValues());
+        storage = kExact;
+
+        const FeatureVectorInfo* infos[2] = { &mInfo.sensors, &mInfo.actions };
+        const int bins[2] = { state_bins, action_bins };
+        double size = 1;
+        for (size_t part = 0; part < 2; ++part)
+        {
+            const FeatureVectorInfo& info = *infos[part];
+            for (size_t i = 0; i < info.size(); ++i)
+            {
+                Digit digit;
+                digit.discrete = info.isDiscrete(i);
+                if (digit.discrete)
+                {
+                    digit.lo = int(info.getMin(i));
+                    digit.inc = 1;
+                    digit.span = 0;
+                    digit.radix = std::max(1, int(info.getMax(i)) - int(info.getMin(i)) + 1);
+                }
+                else if (bins[part] > 0)
+                {
+                    digit.lo = info.getMin(i);
+                    digit.span = info.getMax(i) - info.getMin(i);
+                    digit.inc = bins[part] > 1 ? digit.span / (bins[part] - 1) : 0;
+                    digit.radix = digit.span > 0 ? bins[part] : 1;
+                }
+                else
+                {
+                    // the values are kept as they are, so they cannot be numbered
+                    digits.clear();
+                    return;
+                }
+                size *= double(digit.radix);
+                digits.push_back(digit);
+            }
+        }
+
+        if (size > double(uint64_t(1) << 62))
+        {
+            digits.clear();
+        }
+        else if (size <= double(kMaxDenseSize))
+        {
+            storage = kDense;
+            learned->dense.assign(size_t(size), 0);
+        }
+        else
+        {
+            storage = kHashed;
+        }
+    }
+
+    /// the bin of a value, as quantize finds it, clamped to the bounds
+    uint64_t TableApproximator::bin(const Digit& digit, double value)
+    {
+        if (digit.radix == 1)
+        {
+            return 0;
+        }
+        int64_t b;
+        if (digit.discrete)
+        {
+            b = int64_t(int(value)) - int64_t(digit.lo);
+        }
+        else
+        {
+            double interp = (value - (digit.lo - digit.inc / 2)) / digit.span;
+            b = int((digit.radix - 1) * interp);
+        }
+        if (b < 0)
+        {
+            return 0;
+        }
+        return std::min<uint64_t>(uint64_t(b), digit.radix - 1);
+    }
+
+    uint64_t TableApproximator::index(const FeatureVector& observation, const FeatureVector& action) const
+    {
+        const size_t num_sensors = observation.size();
+        Assert(num_sensors + action.size() == digits.size());
+        uint64_t result = 0, place = 1;
+        for (size_t i = 0; i < digits.size(); ++i)
+        {
+            const Digit& digit = digits[i];
+            double value = (i < num_sensors) ? observation[i] : action[i - num_sensors];
+            result += bin(digit, value) * place;
+            place *= digit.radix;
+        }
+        return result;
+    }
+
+    void TableApproximator::unindex(uint64_t index, FeatureVector& observation, FeatureVector& action) const
+    {
+        const size_t num_sensors = mInfo.sensors.size();
+        observation.resize(num_sensors);
+        action.resize(digits.size() - num_sensors);
+        for (size_t i = 0; i < digits.size(); ++i)
+        {
+            const Digit& digit = digits[i];
+            double value = digit.lo + digit.inc * double(index % digit.radix);
+            index /= digit.radix;
+            if (i < num_sensors)
+                observation[i] = value;
+            else
+                action[i - num_sensors] = value;
+        }
+    }
+
     /// predict the value associated with a particular feature vector
     /// @param observation observation to update
     /// @param action action to update
     /// @return currently approximated (exact) value
     double TableApproximator::predict(const FeatureVector& observation, const FeatureVector& action)
     {
+        switch (storage)
+        {
+            case kDense:
+                return learned->dense[index(observation, action)];
+            case kHashed:
+                return learned->get(index(observation, action));
+            default:
+                break;
+        }
         const FeatureVector& s = quantize_state(observation);
         const FeatureVector& a = quantize_action(action);
-        StateActionDoubleMap::iterator found = table.find(StateActionPair(s, a));
-        if (found == table.end())
+        boost::mutex::scoped_lock lock(learned->table_lock, boost::defer_lock);
+        if (learned->shared)
+        {
+            lock.lock();
+        }
+        StateActionDoubleMap::iterator found = learned->table.find(StateActionPair(s, a));
+        if (found == learned->table.end())
         {
             return 0;
         }
@@ -55,9 +355,346 @@ namespace OpenNero
     /// @param target new value for this state/action pair
     void TableApproximator::update(const FeatureVector& observation, const FeatureVector& action, double target)
     {
+        switch (storage)
+        {
+            case kDense:
+                learned->dense[index(observation, action)] = target;
+                return;
+            case kHashed:
+                learned->set(index(observation, action), target);
+                return;
+            default:
+                break;
+        }
         const FeatureVector& s = quantize_state(observation);
         const FeatureVector& a = quantize_action(action);
-        table[StateActionPair(s, a)] = target;
+        boost::mutex::scoped_lock lock(learned->table_lock, boost::defer_lock);
+        if (learned->shared)
+        {
+            lock.lock();
+        }
+        learned->table[StateActionPair(s, a)] = target;
+    }
+
+    /// The state digits are the least significant ones, so their part of
+    /// the index is worked out once for all the actions.
+    /// @param observation sensor vector
+    /// @param actions the actions to evaluate
+    /// @param values the value of each action, in order
+    void TableApproximator::predict_all(const FeatureVector& observation, const std::vector<FeatureVector>& actions, std::vector<double>& values)
+    {
+        if (storage == kExact)
+        {
+            Approximator::predict_all(observation, actions, values);
+            return;
+        }
+        const size_t num_sensors = observation.size();
+        Assert(num_sensors <= digits.size());
+        uint64_t state = 0, place = 1;
+        for (size_t i = 0; i < num_sensors; ++i)
+        {
+            state += bin(digits[i], observation[i]) * place;
+            place *= digits[i].radix;
+        }
+        values.resize(actions.size());
+        for (size_t a = 0; a < actions.size(); ++a)
+        {
+            const FeatureVector& action = actions[a];
+            Assert(num_sensors + action.size() == digits.size());
+            uint64_t result = state, action_place = place;
+            for (size_t i = 0; i < action.size(); ++i)
+            {
+                const Digit& digit = digits[num_sensors + i];
+                result += bin(digit, action[i]) * action_place;
+                action_place *= digit.radix;
+            }
+            values[a] = (storage == kDense) ? learned->dense[result] : learned->get(result);
+        }
+    }
+
+    /// the values keyed by quantized vectors; the cells of the flat array
+    /// that were never set (or set to 0) are left out
+    StateActionDoubleMap TableApproximator::entries() const
+    {
+        if (storage == kExact)
+        {
+            return learned->table;
+        }
+        StateActionDoubleMap result;
+        StateActionPair key;
+        if (storage == kDense)
+        {
+            const std::vector<double>& dense = learned->dense;
+            for (size_t i = 0; i < dense.size(); ++i)
+            {
+                if (dense[i] != 0)
+                {
+                    unindex(i, key.first, key.second);
+                    result[key] = dense[i];
+                }
+            }
+        }
+        else
+        {
+            for (size_t s = 0; s < TableValues::kStripes; ++s)
+            {
+                const IndexValueMap& hashed = learned->hashed[s];
+                for (size_t slot = 0; slot < hashed.slots(); ++slot)
+                {
+                    if (hashed.used(slot))
+                    {
+                        unindex(hashed.index(slot), key.first, key.second);
+                        result[key] = hashed.value(slot);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    /// quantized vectors fall in the middle of their bins, so they are
+    /// numbered the same way again
+    void TableApproximator::set_entries(const StateActionDoubleMap& saved)
+    {
+        if (storage == kExact)
+        {
+            learned->table = saved;
+            return;
+        }
+        StateActionDoubleMap::const_iterator iter;
+        for (iter = saved.begin(); iter != saved.end(); ++iter)
+        {
+            update(iter->first.first, iter->first.second, iter->second);
+        }
+    }
+
+    void TableApproximator::SaveState(Bitstream& stream) const
+    {
+        stream << uint8_t(storage);
+        if (storage == kExact)
+        {
+            const StateActionDoubleMap& table = learned->table;
+            stream << uint32_t(table.size());
+            StateActionDoubleMap::const_iterator iter;
+            for (iter = table.begin(); iter != table.end(); ++iter)
+            {
+                stream << iter->first.first << iter->first.second << iter->second;
+            }
+            return;
+        }
+
+        // the cells that were set, by index
+        const std::vector<double>& dense = learned->dense;
+        uint32_t count = 0;
+        if (storage == kDense)
+        {
+            for (size_t i = 0; i < dense.size(); ++i)
+            {
+                count += (dense[i] != 0);
+            }
+        }
+        else
+        {
+            for (size_t s = 0; s < TableValues::kStripes; ++s)
+            {
+                count += uint32_t(learned->hashed[s].size());
+            }
+        }
+        stream << count;
+        if (storage == kDense)
+        {
+            for (size_t i = 0; i < dense.size(); ++i)
+            {
+                if (dense[i] != 0)
+                {
+                    stream << uint32_t(0) << uint32_t(i) << dense[i];
+                }
+            }
+        }
+        else
+        {
+            for (size_t s = 0; s < TableValues::kStripes; ++s)
+            {
+                const IndexValueMap& hashed = learned->hashed[s];
+                for (size_t slot = 0; slot < hashed.slots(); ++slot)
+                {
+                    if (hashed.used(slot))
+                    {
+                        uint64_t i = hashed.index(slot);
+                        stream << uint32_t(i >> 32) << uint32_t(i) << hashed.value(slot);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Any tables sharing the values see the loaded ones. Nothing is
+    /// replaced unless the whole table reads back.
+    bool TableApproximator::LoadState(Bitstream& stream)
+    {
+        uint8_t saved_storage;
+        uint32_t size;
+        stream >> saved_storage >> size;
+        if (stream.Failed())
+            return false;
+        if (saved_storage != uint8_t(storage))
+        {
+            LOG_F_WARNING("ai.rl", "the saved table is stored differently from this one");
+            return false;
+        }
+        // every entry takes more than a byte, so a corrupt size shows here
+        if (size > stream.ByteLength())
+        {
+            stream.SetFailed();
+            return false;
+        }
+        if (storage == kExact)
+        {
+            StateActionDoubleMap saved;
+            StateActionPair key;
+            double value;
+            for (uint32_t i = 0; i < size && !stream.Failed(); ++i)
+            {
+                stream >> key.first >> key.second >> value;
+                saved[key] = value;
+            }
+            if (stream.Failed())
+                return false;
+            learned->clear();
+            learned->table.swap(saved);
+            return true;
+        }
+        std::vector<uint64_t> indices(size);
+        std::vector<double> values(size);
+        for (uint32_t n = 0; n < size; ++n)
+        {
+            uint32_t hi, lo;
+            stream >> hi >> lo >> values[n];
+            indices[n] = (uint64_t(hi) << 32) | lo;
+            if (stream.Failed() || (storage == kDense && indices[n] >= learned->dense.size()))
+                return false;
+        }
+        learned->clear();
+        for (uint32_t n = 0; n < size; ++n)
+        {
+            if (storage == kDense)
+            {
+                learned->dense[indices[n]] = values[n];
+            }
+            else
+            {
+                learned->set(indices[n], values[n]);
+            }
+        }
+        return true;
+    }
+
+    void TableApproximator::SaveBinary(BinaryWriter& out) const
+    {
+        out.write(uint32_t(storage));
+        if (storage == kDense)
+        {
+            out.write_array(learned->dense);
+            return;
+        }
+
+        std::vector<double> values;
+        if (storage == kHashed)
+        {
+            std::vector<uint64_t> indices;
+            for (size_t s = 0; s < TableValues::kStripes; ++s)
+            {
+                const IndexValueMap& hashed = learned->hashed[s];
+                for (size_t slot = 0; slot < hashed.slots(); ++slot)
+                {
+                    if (hashed.used(slot))
+                    {
+                        indices.push_back(hashed.index(slot));
+                        values.push_back(hashed.value(slot));
+                    }
+                }
+            }
+            out.write_array(indices);
+            out.write_array(values);
+            return;
+        }
+
+        // the quantized state and action of each entry, one after the other
+        const size_t width = mInfo.sensors.size() + mInfo.actions.size();
+        const StateActionDoubleMap& table = learned->table;
+        std::vector<double> keys;
+        keys.reserve(table.size() * width);
+        values.reserve(table.size());
+        StateActionDoubleMap::const_iterator iter;
+        for (iter = table.begin(); iter != table.end(); ++iter)
+        {
+            Assert(iter->first.first.size() + iter->first.second.size() == width);
+            keys.insert(keys.end(), iter->first.first.begin(), iter->first.first.end());
+            keys.insert(keys.end(), iter->first.second.begin(), iter->first.second.end());
+            values.push_back(iter->second);
+        }
+        out.write(uint32_t(width));
+        out.write_array(keys);
+        out.write_array(values);
+    }
+
+    /// Any tables sharing the values see the loaded ones.
+    bool TableApproximator::LoadBinary(BinaryReader& in)
+    {
+        uint32_t saved_storage;
+        if (!in.read(saved_storage) || saved_storage != uint32_t(storage))
+        {
+            LOG_F_WARNING("ai.rl", "the saved table is stored differently from this one");
+            return false;
+        }
+        if (storage == kDense)
+        {
+            std::vector<double>& dense = learned->dense;
+            if (!in.read_array(&dense[0], dense.size()))
+            {
+                LOG_F_WARNING("ai.rl", "expected " << dense.size() << " table cells");
+                return false;
+            }
+            return true;
+        }
+
+        const double* values;
+        size_t count;
+        if (storage == kHashed)
+        {
+            const uint64_t* indices;
+            size_t num_indices;
+            if (!in.view_array(indices, num_indices) || !in.view_array(values, count) || num_indices != count)
+                return false;
+            learned->clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                learned->set(indices[i], values[i]);
+            }
+            return true;
+        }
+
+        const size_t num_sensors = mInfo.sensors.size();
+        const size_t width = num_sensors + mInfo.actions.size();
+        uint32_t saved_width;
+        const double* keys;
+        size_t num_keys;
+        if (!in.read(saved_width) || saved_width != width
+            || !in.view_array(keys, num_keys) || !in.view_array(values, count)
+            || num_keys != count * width)
+        {
+            LOG_F_WARNING("ai.rl", "the saved table does not fit this one");
+            return false;
+        }
+        learned->clear();
+        StateActionPair key;
+        for (size_t i = 0; i < count; ++i, keys += width)
+        {
+            key.first.assign(keys, keys + num_sensors);
+            key.second.assign(keys + num_sensors, keys + width);
+            learned->table[key] = values[i];
+        }
+        return true;
     }
 
     /// given a feature vector from a continuous space, quantize each component
@@ -132,7 +769,8 @@ namespace OpenNero
         , ints()
         , floats()
         , tiles()
-        , weights()
+        , weights(new std::vector<float>(num_weights))
+        , state_sums()
     {
         LOG_F_DEBUG("ai", "TilesApproximator( "  << info << " )");
         size_t num_sensors = info.sensors.size();
@@ -163,10 +801,9 @@ namespace OpenNero
         ints.resize(ints_index.size());
         floats.resize(floats_index.size());
         tiles.resize(num_tiles);
-        weights.resize(num_weights);
-        for (size_t i = 0; i < weights.size(); ++i)
+        for (size_t i = 0; i < weights->size(); ++i)
         {
-            weights[i] = RANDOM.normalF(0,1);
+            (*weights)[i] = ThreadRandom().normalF(0,1);
         }
     }
 
@@ -178,61 +815,147 @@ namespace OpenNero
         , ints(a.ints)
         , floats(a.floats)
         , tiles(a.tiles)
-        , weights(a.weights)
+        , weights(new std::vector<float>(*a.weights))
+        , state_sums()
     {
     }
 
+    /// Both approximators keep their own tiles and features, and add to the
+    /// same weights without locks (Hogwild!): a float written by two threads
+    /// at once keeps one of the two updates.
+    ApproximatorPtr TilesApproximator::share()
+    {
+        boost::shared_ptr<TilesApproximator> p(new TilesApproximator());
+        p->mInfo = mInfo;
+        p->mAlpha = mAlpha;
+        p->ints_index = ints_index;
+        p->floats_index = floats_index;
+        p->ints = ints;
+        p->floats = floats;
+        p->tiles = tiles;
+        p->weights = weights;
+        return p;
+    }
+
     TilesApproximator::~TilesApproximator()
     {
     }
 
-    /// convert feature vector into tiles
-    void TilesApproximator::to_tiles(const FeatureVector& observation, const FeatureVector& action)
+    namespace {
+        /// the increment GetTiles hashes the coordinates with
+        const int kTileHashIncrement = 449;
+    }
+
+    /// GetTiles hashes the coordinates of a tile by adding up one random
+    /// number per coordinate: those of the real features, then the number of
+    /// the tiling, then those of the integer features. The state features come
+    /// before the action features in each group, so the part of each sum that
+    /// only depends on the state can be kept for all the actions.
+    void TilesApproximator::hash_state(const FeatureVector& observation)
     {
-        size_t num_sensors = mInfo.sensors.size();
-        size_t num_actions = mInfo.actions.size();
+        const size_t num_sensors = mInfo.sensors.size();
+        const int num_tilings = (int)tiles.size();
+        const int num_floats = (int)floats.size();
         Assert(num_sensors == observation.size());
-        Assert(num_actions == action.size());
-        // shuffle feature vector into the arrays
-        for (size_t i = 0; i < ints_index.size(); ++i)
+        state_sums.resize(tiles.size());
+        for (int j = 0; j < num_tilings; ++j)
+        {
+            state_sums[j] = (long)hash_UNH_term(j, num_floats, kTileHashIncrement);
+        }
+        for (size_t i = 0; i < floats_index.size() && floats_index[i] < num_sensors; ++i)
         {
-            if (ints_index[i] < num_sensors)
+            floats[i] = (float)observation[floats_index[i]];
+            int q = (int)std::floor(floats[i] * num_tilings);
+            // each tiling is displaced by 1 + 2i from the previous one
+            for (int j = 0; j < num_tilings; ++j)
             {
-                ints[i] = (int)observation[ints_index[i]];
+                int coordinate = q - mod(q - j * (1 + 2 * (int)i), num_tilings);
+                state_sums[j] += (long)hash_UNH_term(coordinate, (int)i, kTileHashIncrement);
             }
-            else
+        }
+        for (size_t i = 0; i < ints_index.size() && ints_index[i] < num_sensors; ++i)
+        {
+            ints[i] = (int)observation[ints_index[i]];
+            long term = (long)hash_UNH_term(ints[i], num_floats + 1 + (int)i, kTileHashIncrement);
+            for (int j = 0; j < num_tilings; ++j)
             {
-                ints[i] = (int)action[ints_index[i] - num_sensors];
+                state_sums[j] += term;
             }
         }
+    }
+
+    /// @param action action vector
+    /// @return the sum of the weights of the tiles, which are left in tiles
+    double TilesApproximator::hash_action(const FeatureVector& action)
+    {
+        const size_t num_sensors = mInfo.sensors.size();
+        const int num_tilings = (int)tiles.size();
+        const int num_floats = (int)floats.size();
+        const std::vector<float>& w = *weights;
+        const long memory_size = (long)w.size();
+        Assert(mInfo.actions.size() == action.size());
+        Assert(state_sums.size() == tiles.size());
+        size_t first_float = floats_index.size(), first_int = ints_index.size();
         for (size_t i = 0; i < floats_index.size(); ++i)
         {
-            if (floats_index[i] < num_sensors)
+            if (floats_index[i] >= num_sensors)
             {
-                floats[i] = (float)observation[floats_index[i]];
+                floats[i] = (float)action[floats_index[i] - num_sensors];
+                first_float = std::min(first_float, i);
             }
-            else
+        }
+        for (size_t i = 0; i < ints_index.size(); ++i)
+        {
+            if (ints_index[i] >= num_sensors)
             {
-                floats[i] = (float)action[floats_index[i] - num_sensors];
+                ints[i] = (int)action[ints_index[i] - num_sensors];
+                first_int = std::min(first_int, i);
+            }
+        }
+        double result = 0.0;
+        for (int j = 0; j < num_tilings; ++j)
+        {
+            long sum = state_sums[j];
+            for (size_t i = first_float; i < floats_index.size(); ++i)
+            {
+                int q = (int)std::floor(floats[i] * num_tilings);
+                int coordinate = q - mod(q - j * (1 + 2 * (int)i), num_tilings);
+                sum += (long)hash_UNH_term(coordinate, (int)i, kTileHashIncrement);
             }
+            for (size_t i = first_int; i < ints_index.size(); ++i)
+            {
+                sum += (long)hash_UNH_term(ints[i], num_floats + 1 + (int)i, kTileHashIncrement);
+            }
+            long index = sum % memory_size;
+            while (index < 0)
+                index += memory_size;
+            tiles[j] = (int)index;
+            result += w[tiles[j]];
         }
-        // convert the input values to tiles
-        GetTiles(tiles, weights.size(), floats, ints);
+        return result;
     }
-    
+
     /// @param observation sensor vector
     /// @param action action vector
     double TilesApproximator::predict(const FeatureVector& observation, const FeatureVector& action)
     {
-        to_tiles(observation, action);
-        double result=0.0;
-        for (size_t i = 0; i < tiles.size(); ++i) 
+        hash_state(observation);
+        return hash_action(action);
+    }
+
+    /// @param observation sensor vector
+    /// @param actions the actions to evaluate
+    /// @param values the value of each action, in order
+    void TilesApproximator::predict_all(const FeatureVector& observation, const std::vector<FeatureVector>& actions, std::vector<double>& values)
+    {
+        hash_state(observation);
+        values.resize(actions.size());
+        for (size_t i = 0; i < actions.size(); ++i)
         {
-            result += weights[tiles[i]];
+            values[i] = hash_action(actions[i]);
         }
-        return result;
     }
-    
+
     /// Adapt the tile weights for the tiles that are triggered by the given example
     /// @param observation sensor vector
     /// @param action action vector
@@ -243,8 +966,45 @@ namespace OpenNero
         // then, adapt weights towards the prediction
         for (size_t i = 0; i < tiles.size(); ++i) 
         {
-            weights[tiles[i]] += (float)(mAlpha / tiles.size() * (target - x));
+            (*weights)[tiles[i]] += (float)(mAlpha / tiles.size() * (target - x));
+        }
+    }
+
+    void TilesApproximator::SaveState(Bitstream& stream) const
+    {
+        stream << *weights;
+    }
+
+    bool TilesApproximator::LoadState(Bitstream& stream)
+    {
+        std::vector<float> saved;
+        stream >> saved;
+        if (stream.Failed())
+            return false;
+        if (saved.size() != weights->size())
+        {
+            LOG_F_WARNING("ai.rl", "expected " << weights->size() << " tile weights, not " << saved.size());
+            return false;
+        }
+        // in place, so that any approximators sharing the weights see them
+        weights->swap(saved);
+        return true;
+    }
+
+    void TilesApproximator::SaveBinary(BinaryWriter& out) const
+    {
+        out.write_array(*weights);
+    }
+
+    /// the weights are copied in place, as by LoadState
+    bool TilesApproximator::LoadBinary(BinaryReader& in)
+    {
+        if (!in.read_array(weights->empty() ? (float*)NULL : &(*weights)[0], weights->size()))
+        {
+            LOG_F_WARNING("ai.rl", "expected " << weights->size() << " tile weights");
+            return false;
         }
+        return true;
     }
 }
 
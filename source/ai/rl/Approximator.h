@@ -11,9 +11,14 @@
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/map.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "core/Common.h"
 #include "ai/AI.h"
+#include "core/Bitstream.h"
+#include "BinaryArchive.h"
 #include "core/HashMap.h"
 
 /////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////8
@@ -57,16 +62,7 @@ namespace boost {
                              boost::unordered_map<Key, Type, Hash, Compare, Allocator> &t,
                              const unsigned int /* file_version */
                              ){
-            boost::serialization::stl::load_collection<
-                Archive,
-                boost::unordered_map<Key, Type, Hash, Compare, Allocator>,
-                boost::serialization::stl::archive_input_map<
-                Archive, boost::unordered_map<Key, Type, Hash, Compare, Allocator> >,
-                boost::serialization::stl::no_reserve_imp<boost::unordered_map<
-                Key, Type, Hash, Compare, Allocator
-                >
-                >
-                >(ar, t);
+            boost::serialization::load_map_collection(ar, t);
         }
 
         // split non-intrusive serialization function member into separate
@@ -106,12 +102,36 @@ namespace OpenNero
         /// return a copy of this approximator
         virtual ApproximatorPtr copy() const = 0;
 
+        /// return an approximator for another agent that learns into the
+        /// same values as this one; the two may be used from different
+        /// threads at the same time
+        /// @return null if the values cannot be shared
+        virtual ApproximatorPtr share() { return ApproximatorPtr(); }
+
         /// predict the value associated with a particular feature vector
         virtual double predict(const FeatureVector& sensors, const FeatureVector& actions) = 0;
 
         /// update the value associated with a particular feature vector
         virtual void update(const FeatureVector& sensors, const FeatureVector& actions, double target) = 0;
 
+        /// predict the values associated with one state and each of a list of actions
+        /// @param values resized to hold the value of each action, in order
+        virtual void predict_all(const FeatureVector& sensors, const std::vector<FeatureVector>& actions, std::vector<double>& values);
+
+        /// write the learned values to a world snapshot
+        virtual void SaveState(Bitstream& stream) const = 0;
+
+        /// continue from values written by SaveState
+        /// @return false if they do not fit this approximator
+        virtual bool LoadState(Bitstream& stream) = 0;
+
+        /// write the learned values to a binary archive, as raw arrays
+        virtual void SaveBinary(BinaryWriter& out) const = 0;
+
+        /// replace the learned values with ones written by SaveBinary
+        /// @return false if they do not fit this approximator
+        virtual bool LoadBinary(BinaryReader& in) = 0;
+
         /// serialize this object to/from a Boost serialization archive
         template<class Archive>
         void serialize(Archive & ar, const unsigned int version)
@@ -122,19 +142,152 @@ namespace OpenNero
 
 	typedef boost::unordered_map<StateActionPair, double> StateActionDoubleMap;
 
-	/// An exact table-based approximator
+    /// An open-addressed hash map from integer indices to values. The
+    /// entries live in two flat arrays and are found by linear probing, so
+    /// looking one up or changing it allocates nothing.
+    class IndexValueMap
+    {
+    public:
+        IndexValueMap();
+
+        /// @return the value stored for an index, or 0 if there is none
+        double get(uint64_t index) const;
+
+        /// @return the value stored for an index, added as 0 if there is none
+        double& at(uint64_t index);
+
+        /// @return the number of indices stored
+        size_t size() const { return mCount; }
+
+        /// remove all the entries
+        void clear();
+
+        /// @return the number of slots, some of which may be empty
+        size_t slots() const { return mKeys.size(); }
+
+        /// @return true if a slot holds an entry
+        bool used(size_t slot) const { return mKeys[slot] != 0; }
+
+        /// @return the index stored in a used slot
+        uint64_t index(size_t slot) const { return mKeys[slot] - 1; }
+
+        /// @return the value stored in a used slot
+        double value(size_t slot) const { return mValues[slot]; }
+
+    private:
+        /// @return the slot holding a key or the empty slot where it would go
+        size_t find(uint64_t key) const;
+
+        /// double the number of slots
+        void grow();
+
+        std::vector<uint64_t> mKeys;  ///< index + 1 for each slot, 0 for an empty one
+        std::vector<double> mValues;  ///< the value for each slot
+        size_t mCount;                ///< the number of used slots
+    };
+
+    /// The learned values of a TableApproximator. The tables of the agents
+    /// made from one template may share them while each agent acts in its
+    /// own thread: the flat array is then written without locks, Hogwild!
+    /// style (an update that races with another one may be lost), the hashed
+    /// values are split into stripes with a lock each, and the exact map has
+    /// a single lock.
+    class TableValues : private boost::noncopyable
+    {
+    public:
+        /// the number of stripes of the hashed values
+        static const size_t kStripes = 16;
+
+        TableValues();
+
+        /// @return the hashed value of an index, or 0 if there is none
+        double get(uint64_t index) const;
+
+        /// store the hashed value of an index
+        void set(uint64_t index, double value);
+
+        /// @return the stripe of the hashed values that holds an index
+        static size_t stripe(uint64_t index);
+
+        /// remove all the values, keeping the size of the flat array
+        void clear();
+
+        /// copy the values (and not the locks) of another table
+        void assign(const TableValues& other);
+
+        StateActionDoubleMap table;         ///< the values by quantized vectors (kExact)
+        std::vector<double> dense;          ///< the values by index (kDense)
+        IndexValueMap hashed[kStripes];     ///< the values by index (kHashed), by stripe
+        mutable boost::mutex table_lock;    ///< guards table while shared
+        mutable boost::mutex hashed_locks[kStripes]; ///< guard the stripes of hashed while shared
+        bool shared;                        ///< whether more than one table uses these values
+    };
+
+    /// @cond
+    BOOST_SHARED_DECL(TableValues);
+    /// @endcond
+
+	/// An exact table-based approximator. The quantized state and action
+	/// are numbered as the digits of one mixed-radix integer, which indexes a
+	/// flat array when the space is small enough and an IndexValueMap
+	/// otherwise. Spaces that cannot be numbered (continuous dimensions with
+	/// no bins) are kept in a map from the quantized vectors.
     class TableApproximator : public Approximator
     {
+    public:
+        /// the largest space to keep in a flat array
+        static const uint64_t kMaxDenseSize = 1 << 16;
+
     private:
         friend class boost::serialization::access;
-        StateActionDoubleMap table;
+
+        /// how the values are stored
+        enum Storage
+        {
+            kExact,     ///< in table, by the quantized vectors
+            kDense,     ///< in dense, by index
+            kHashed     ///< in hashed, by index
+        };
+
+        /// how one dimension of the state or the action turns into a digit of the index
+        struct Digit
+        {
+            double lo;          ///< the lowest value (the center of the first bin)
+            double inc;         ///< the distance between the centers of the bins
+            double span;        ///< the width of the range (continuous dimensions)
+            uint64_t radix;     ///< the number of bins
+            bool discrete;      ///< whether the values are integers
+        };
+
+        TableValuesPtr learned;         ///< the learned values, perhaps shared with other tables
+        std::vector<Digit> digits;      ///< the state dimensions and then the action dimensions
+        Storage storage;                ///< where the values are
         int action_bins;
         int state_bins;
+
+        /// work out the digits and the storage from the bounds and the bins
+        void layout();
+
+        /// @return the bin of one value of a dimension
+        static uint64_t bin(const Digit& digit, double value);
+
+        /// @return the number of the quantized state and action
+        uint64_t index(const FeatureVector& sensors, const FeatureVector& actions) const;
+
+        /// turn an index back into the quantized state and action
+        void unindex(uint64_t index, FeatureVector& sensors, FeatureVector& actions) const;
+
+        /// @return the values in the form they are serialized in
+        StateActionDoubleMap entries() const;
+
+        /// store values in the form they are serialized in
+        void set_entries(const StateActionDoubleMap& values);
+
     public:
         /// constructor
-        TableApproximator() {}
+        TableApproximator() : learned(new TableValues()), storage(kExact), action_bins(0), state_bins(0) {}
         explicit TableApproximator(const AgentInitInfo& info, const int action_bins, const int state_bins);
-        explicit TableApproximator(const AgentInitInfo& info)
+        explicit TableApproximator(const AgentInitInfo& info) : learned(new TableValues())
         {
             // FIXME: magic numbers
             TableApproximator(info, 3, 5);
@@ -151,27 +304,63 @@ namespace OpenNero
         ApproximatorPtr copy() const
             { ApproximatorPtr p(new TableApproximator(*this)); return p; }
 
+        /// return a table that stores into the same values as this one
+        ApproximatorPtr share();
+
         /// predict the value associated with a particular feature vector
         double predict(const FeatureVector& sensors, const FeatureVector& actions);
 
         /// update the value associated with a particular feature vector
         void update(const FeatureVector& sensors, const FeatureVector& actions, double target);
 
+        /// predict the values of one state with each of a list of actions
+        void predict_all(const FeatureVector& sensors, const std::vector<FeatureVector>& actions, std::vector<double>& values);
+
+        /// write the table to a world snapshot
+        void SaveState(Bitstream& stream) const;
+
+        /// replace the table with one written by SaveState
+        bool LoadState(Bitstream& stream);
+
+        /// write the table to a binary archive: the flat array as it is, or
+        /// the indices (or quantized vectors) and the values in two arrays
+        void SaveBinary(BinaryWriter& out) const;
+
+        /// replace the table with one written by SaveBinary
+        bool LoadBinary(BinaryReader& in);
+
         /// quantize continuous state or action vectors
         FeatureVector quantize_action(const FeatureVector& continuous) const;
         FeatureVector quantize_state(const FeatureVector& continuous) const;
 
-        /// serialize this object to/from a Boost serialization archive
+        /// serialize this object to a Boost serialization archive
         template<class Archive>
-        void serialize(Archive & ar, const unsigned int version)
+        void save(Archive & ar, const unsigned int version) const
         {
             ar & boost::serialization::base_object<Approximator>(*this);
             ar & BOOST_SERIALIZATION_NVP(action_bins);
             ar & BOOST_SERIALIZATION_NVP(state_bins);
-            // this uses unordered_map serialization
+            // the archive keeps the quantized vectors, whatever the storage
+            StateActionDoubleMap table = entries();
             ar & BOOST_SERIALIZATION_NVP(table);
-            LOG_F_DEBUG("serialize", "(de)serialized TableApproximator with " << table.size() << " entries.");
+            LOG_F_DEBUG("serialize", "serialized TableApproximator with " << table.size() << " entries.");
         }
+
+        /// deserialize this object from a Boost serialization archive
+        template<class Archive>
+        void load(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<Approximator>(*this);
+            ar & BOOST_SERIALIZATION_NVP(action_bins);
+            ar & BOOST_SERIALIZATION_NVP(state_bins);
+            StateActionDoubleMap table;
+            ar & BOOST_SERIALIZATION_NVP(table);
+            layout();
+            set_entries(table);
+            LOG_F_DEBUG("serialize", "deserialized TableApproximator with " << table.size() << " entries.");
+        }
+
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
     /// A CMAC tile coding function approximator
@@ -186,15 +375,20 @@ namespace OpenNero
         std::vector<int> ints; ///< integer feature array
         std::vector<float> floats; ///< real feature array
         std::vector<int> tiles; ///< tiles array
-        std::vector<float> weights; ///< weight array
+        boost::shared_ptr< std::vector<float> > weights; ///< weight array, perhaps shared with other approximators
+        std::vector<long> state_sums; ///< the hash sums of the state features and the tiling, for each tiling
 
-        /// convert feature vector into tiles
-        void to_tiles(const FeatureVector& sensors, const FeatureVector& actions);
+        /// hash the state features (and the tiling number) of every tiling into state_sums
+        void hash_state(const FeatureVector& sensors);
+
+        /// finish the tiles of the hashed state with an action
+        /// @return the sum of the weights of the tiles
+        double hash_action(const FeatureVector& actions);
     public:
         /// constructors
-        TilesApproximator() {}
+        TilesApproximator() : weights(new std::vector<float>()) {}
         explicit TilesApproximator(const AgentInitInfo& info, const int num_tiles, const int num_weights);
-        explicit TilesApproximator(const AgentInitInfo& info)
+        explicit TilesApproximator(const AgentInitInfo& info) : weights(new std::vector<float>())
         {
             TilesApproximator(info, 32, 1024);
         }
@@ -208,15 +402,50 @@ namespace OpenNero
         /// return a copy of this approximator
         ApproximatorPtr copy() const { ApproximatorPtr p(new TilesApproximator(*this)); return p; }
 
+        /// return an approximator that learns into the same weights as this one,
+        /// without locks (Hogwild!)
+        ApproximatorPtr share();
+
         /// predict the value associated with a particular feature vector
         double predict(const FeatureVector& sensors, const FeatureVector& actions);
 
         /// update the value associated with a particular feature vector
         void update(const FeatureVector& sensors, const FeatureVector& actions, double target);
 
-        /// serialize this object to/from a Boost serialization archive
+        /// predict the values of one state with each of a list of actions,
+        /// hashing the state only once
+        void predict_all(const FeatureVector& sensors, const std::vector<FeatureVector>& actions, std::vector<double>& values);
+
+        /// write the weights to a world snapshot
+        void SaveState(Bitstream& stream) const;
+
+        /// replace the weights with ones written by SaveState
+        bool LoadState(Bitstream& stream);
+
+        /// write the weights to a binary archive as one array
+        void SaveBinary(BinaryWriter& out) const;
+
+        /// replace the weights with ones written by SaveBinary
+        bool LoadBinary(BinaryReader& in);
+
+        /// serialize this object to a Boost serialization archive
         template<class Archive>
-        void serialize(Archive & ar, const unsigned int version)
+        void save(Archive & ar, const unsigned int version) const
+        {
+            ar & boost::serialization::base_object<Approximator>(*this);
+            ar & BOOST_SERIALIZATION_NVP(mAlpha);
+            ar & BOOST_SERIALIZATION_NVP(ints_index);
+            ar & BOOST_SERIALIZATION_NVP(floats_index);
+            ar & BOOST_SERIALIZATION_NVP(ints);
+            ar & BOOST_SERIALIZATION_NVP(floats);
+            ar & BOOST_SERIALIZATION_NVP(tiles);
+            const std::vector<float>& weights = *this->weights;
+            ar & BOOST_SERIALIZATION_NVP(weights);
+        }
+
+        /// deserialize this object from a Boost serialization archive
+        template<class Archive>
+        void load(Archive & ar, const unsigned int version)
         {
             ar & boost::serialization::base_object<Approximator>(*this);
             ar & BOOST_SERIALIZATION_NVP(mAlpha);
@@ -225,8 +454,13 @@ namespace OpenNero
             ar & BOOST_SERIALIZATION_NVP(ints);
             ar & BOOST_SERIALIZATION_NVP(floats);
             ar & BOOST_SERIALIZATION_NVP(tiles);
+            // the loaded weights are this approximator's own
+            weights.reset(new std::vector<float>());
+            std::vector<float>& weights = *this->weights;
             ar & BOOST_SERIALIZATION_NVP(weights);
         }
+
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
 }
@@ -0,0 +1,403 @@
+#include <boost/serialization/export.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/Common.h"
+#include "core/Bitstream.h"
+#include "math/Random.h"
+#include "BackpropApproximator.h"
+
+namespace OpenNero
+{
+    namespace {
+        /// the sum of a[i] * b[i]; four independent sums let the compiler
+        /// keep a vector register (or four scalar pipelines) busy
+        inline float dot(const float* a, const float* b, size_t n)
+        {
+            float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                s0 += a[i] * b[i];
+                s1 += a[i + 1] * b[i + 1];
+                s2 += a[i + 2] * b[i + 2];
+                s3 += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; ++i)
+            {
+                s0 += a[i] * b[i];
+            }
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        /// y[i] += a * x[i]
+        inline void axpy(float a, const float* x, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                y[i] += a * x[i];
+            }
+        }
+    }
+
+    BackpropApproximator::BackpropApproximator()
+        : Approximator()
+        , mAlpha(0.05f)
+        , batch_size(kDefaultBatchSize)
+        , replay_size(kDefaultReplaySize)
+        , layers()
+        , weights(new std::vector<float>())
+        , replay_next(0)
+        , replay_count(0)
+        , pending(0)
+    {
+    }
+
+    /// The weights start out small and random, scaled by the number of
+    /// inputs of each unit so that the sums start out in the bend of tanh.
+    BackpropApproximator::BackpropApproximator(const AgentInitInfo& info, uint32_t hidden_units, uint32_t hidden_layers)
+        : Approximator(info)
+        , mAlpha(0.05f)
+        , batch_size(kDefaultBatchSize)
+        , replay_size(kDefaultReplaySize)
+        , layers()
+        , weights(new std::vector<float>())
+        , replay_next(0)
+        , replay_count(0)
+        , pending(0)
+    {
+        LOG_F_DEBUG("ai", "BackpropApproximator( " << info << " )");
+        AssertMsg(hidden_units > 0, "a network needs at least one hidden unit");
+        layers.push_back(uint32_t(info.sensors.size() + info.actions.size()));
+        for (uint32_t i = 0; i < hidden_layers; ++i)
+        {
+            layers.push_back(hidden_units);
+        }
+        layers.push_back(1);
+        for (size_t l = 1; l < layers.size(); ++l)
+        {
+            const size_t fan_in = layers[l - 1] + 1;
+            const float sigma = 1.0f / std::sqrt(float(fan_in));
+            for (size_t i = 0; i < layers[l] * fan_in; ++i)
+            {
+                weights->push_back(ThreadRandom().normalF(0, sigma));
+            }
+        }
+        setup();
+    }
+
+    BackpropApproximator::BackpropApproximator(const BackpropApproximator& a)
+        : Approximator(a.mInfo)
+        , mAlpha(a.mAlpha)
+        , batch_size(a.batch_size)
+        , replay_size(a.replay_size)
+        , layers(a.layers)
+        , weights(new std::vector<float>(*a.weights))
+        , input_scale(a.input_scale)
+        , input_offset(a.input_offset)
+        , weight_offsets(a.weight_offsets)
+        , unit_offsets(a.unit_offsets)
+        , activations(a.activations)
+        , deltas(a.deltas)
+        , gradient(a.gradient)
+        , first_layer(a.first_layer)
+        , replay_inputs(a.replay_inputs)
+        , replay_targets(a.replay_targets)
+        , replay_next(a.replay_next)
+        , replay_count(a.replay_count)
+        , pending(a.pending)
+    {
+    }
+
+    BackpropApproximator::~BackpropApproximator()
+    {
+    }
+
+    /// Both approximators keep their own scratch space and replay buffer, and
+    /// step the same weights without locks (Hogwild!), like shared tiles.
+    ApproximatorPtr BackpropApproximator::share()
+    {
+        BackpropApproximatorPtr p(new BackpropApproximator());
+        p->mInfo = mInfo;
+        p->mAlpha = mAlpha;
+        p->batch_size = batch_size;
+        p->replay_size = replay_size;
+        p->layers = layers;
+        p->weights = weights;
+        p->setup();
+        return p;
+    }
+
+    void BackpropApproximator::setup()
+    {
+        replay_next = replay_count = pending = 0;
+        if (layers.empty())
+        {
+            return;
+        }
+
+        // map [min, max] onto [-1, 1]; a dimension without a span is always 0
+        input_scale.clear();
+        input_offset.clear();
+        const FeatureVectorInfo* infos[2] = { &mInfo.sensors, &mInfo.actions };
+        for (size_t part = 0; part < 2; ++part)
+        {
+            const FeatureVectorInfo& info = *infos[part];
+            for (size_t i = 0; i < info.size(); ++i)
+            {
+                double span = info.getMax(i) - info.getMin(i);
+                float scale = span > 0 ? float(2 / span) : 0;
+                input_scale.push_back(scale);
+                input_offset.push_back(span > 0 ? float(-1 - info.getMin(i) * 2 / span) : 0);
+            }
+        }
+        AssertMsg(input_scale.size() == num_inputs(), "the network has " << num_inputs() << " inputs, the agent " << input_scale.size());
+
+        weight_offsets.assign(layers.size(), 0);
+        unit_offsets.assign(layers.size(), 0);
+        size_t num_weights = 0, num_units = layers[0];
+        for (size_t l = 1; l < layers.size(); ++l)
+        {
+            weight_offsets[l] = num_weights;
+            unit_offsets[l] = num_units;
+            num_weights += size_t(layers[l]) * (layers[l - 1] + 1);
+            num_units += layers[l];
+        }
+        AssertMsg(weights->size() == num_weights, "expected " << num_weights << " weights, not " << weights->size());
+
+        activations.assign(num_units, 0);
+        deltas.assign(num_units, 0);
+        gradient.assign(num_weights, 0);
+        first_layer.assign(layers[1], 0);
+        replay_inputs.assign(size_t(replay_size) * num_inputs(), 0);
+        replay_targets.assign(replay_size, 0);
+    }
+
+    void BackpropApproximator::encode(const FeatureVector& sensors, const FeatureVector& actions, float* input) const
+    {
+        const size_t num_sensors = sensors.size();
+        Assert(num_sensors + actions.size() == num_inputs());
+        for (size_t i = 0; i < num_sensors; ++i)
+        {
+            input[i] = float(sensors[i]) * input_scale[i] + input_offset[i];
+        }
+        for (size_t i = 0; i < actions.size(); ++i)
+        {
+            input[num_sensors + i] = float(actions[i]) * input_scale[num_sensors + i] + input_offset[num_sensors + i];
+        }
+    }
+
+    /// each unit is the dot product of its row with the layer before, plus
+    /// the bias at the end of the row; all but the output go through tanh
+    float BackpropApproximator::forward(size_t first)
+    {
+        const float* w = &(*weights)[0];
+        const size_t last = layers.size() - 1;
+        for (size_t l = first; l <= last; ++l)
+        {
+            const size_t n = layers[l - 1];
+            const float* in = &activations[unit_offsets[l - 1]];
+            float* out = &activations[unit_offsets[l]];
+            const float* row = w + weight_offsets[l];
+            for (size_t j = 0; j < layers[l]; ++j, row += n + 1)
+            {
+                float sum = dot(row, in, n) + row[n];
+                out[j] = (l < last) ? std::tanh(sum) : sum;
+            }
+        }
+        return activations.back();
+    }
+
+    /// backpropagate the error of the half squared difference
+    void BackpropApproximator::backward(float output, float target)
+    {
+        const float* w = &(*weights)[0];
+        deltas.back() = output - target;
+        for (size_t l = layers.size() - 1; l >= 1; --l)
+        {
+            const size_t n = layers[l - 1];
+            const float* in = &activations[unit_offsets[l - 1]];
+            const float* delta = &deltas[unit_offsets[l]];
+            float* g = &gradient[weight_offsets[l]];
+            for (size_t j = 0; j < layers[l]; ++j, g += n + 1)
+            {
+                axpy(delta[j], in, g, n);
+                g[n] += delta[j];
+            }
+            if (l == 1)
+            {
+                break;
+            }
+
+            // the error of the layer before, through the derivative of tanh
+            float* before = &deltas[unit_offsets[l - 1]];
+            std::fill(before, before + n, 0.0f);
+            const float* row = w + weight_offsets[l];
+            for (size_t j = 0; j < layers[l]; ++j, row += n + 1)
+            {
+                axpy(delta[j], row, before, n);
+            }
+            for (size_t i = 0; i < n; ++i)
+            {
+                before[i] *= 1 - in[i] * in[i];
+            }
+        }
+    }
+
+    void BackpropApproximator::train()
+    {
+        if (replay_count == 0)
+        {
+            return;
+        }
+        const size_t n = num_inputs();
+        const uint32_t batch = std::min(batch_size, replay_count);
+        std::fill(gradient.begin(), gradient.end(), 0.0f);
+        for (uint32_t b = 0; b < batch; ++b)
+        {
+            uint32_t k = ThreadRandom().randI(replay_count - 1);
+            const float* input = &replay_inputs[k * n];
+            std::copy(input, input + n, activations.begin());
+            backward(forward(), replay_targets[k]);
+        }
+        axpy(-mAlpha / batch, &gradient[0], &(*weights)[0], gradient.size());
+    }
+
+    /// @param sensors sensor vector
+    /// @param actions action vector
+    /// @return the output of the network
+    double BackpropApproximator::predict(const FeatureVector& sensors, const FeatureVector& actions)
+    {
+        encode(sensors, actions, &activations[0]);
+        return forward();
+    }
+
+    /// The example goes into the replay buffer (over the oldest one when it
+    /// is full), and every batch_size examples the network learns from a
+    /// minibatch of them.
+    /// @param sensors sensor vector
+    /// @param actions action vector
+    /// @param target the value the network should predict for them
+    void BackpropApproximator::update(const FeatureVector& sensors, const FeatureVector& actions, double target)
+    {
+        encode(sensors, actions, &replay_inputs[size_t(replay_next) * num_inputs()]);
+        replay_targets[replay_next] = float(target);
+        replay_next = (replay_next + 1) % replay_size;
+        replay_count = std::min(replay_count + 1, replay_size);
+        if (++pending >= batch_size)
+        {
+            pending = 0;
+            train();
+        }
+    }
+
+    /// The columns of the first layer split into the state's and the
+    /// action's; the state's part of each sum is the same for every action.
+    void BackpropApproximator::predict_all(const FeatureVector& sensors, const std::vector<FeatureVector>& actions, std::vector<double>& values)
+    {
+        values.resize(actions.size());
+        if (actions.empty())
+        {
+            return;
+        }
+        const size_t n = num_inputs();
+        const size_t num_sensors = sensors.size();
+        const size_t num_actions = n - num_sensors;
+        const bool hidden = layers.size() > 2;
+        encode(sensors, actions[0], &activations[0]);
+        const float* w = &(*weights)[weight_offsets[1]];
+        const float* row = w;
+        for (size_t j = 0; j < layers[1]; ++j, row += n + 1)
+        {
+            first_layer[j] = dot(row, &activations[0], num_sensors) + row[n];
+        }
+        for (size_t a = 0; a < actions.size(); ++a)
+        {
+            encode(sensors, actions[a], &activations[0]);
+            const float* action_inputs = &activations[num_sensors];
+            float* out = &activations[unit_offsets[1]];
+            row = w + num_sensors;
+            for (size_t j = 0; j < layers[1]; ++j, row += n + 1)
+            {
+                float sum = first_layer[j] + dot(row, action_inputs, num_actions);
+                out[j] = hidden ? std::tanh(sum) : sum;
+            }
+            values[a] = forward(2);
+        }
+    }
+
+    void BackpropApproximator::SaveState(Bitstream& stream) const
+    {
+        stream << layers << *weights;
+        stream << replay_next << replay_count << pending;
+        stream << replay_inputs << replay_targets;
+    }
+
+    /// the weights are written in place, so approximators that share them
+    /// all see the loaded ones; nothing is written unless the whole record
+    /// fits this network
+    bool BackpropApproximator::LoadState(Bitstream& stream)
+    {
+        std::vector<uint32_t> saved_layers;
+        std::vector<float> saved_weights;
+        uint32_t saved_next, saved_count, saved_pending;
+        std::vector<float> saved_inputs, saved_targets;
+        stream >> saved_layers >> saved_weights;
+        stream >> saved_next >> saved_count >> saved_pending;
+        stream >> saved_inputs >> saved_targets;
+        if (stream.Failed())
+            return false;
+        if (saved_layers != layers || saved_weights.size() != weights->size())
+        {
+            LOG_F_WARNING("ai.rl", "the saved network is laid out differently from this one");
+            return false;
+        }
+        const size_t saved_size = saved_targets.size();
+        if (saved_size == 0 || saved_inputs.size() != saved_size * num_inputs()
+            || saved_next >= saved_size || saved_count > saved_size)
+        {
+            LOG_F_WARNING("ai.rl", "the saved replay buffer does not fit the network");
+            return false;
+        }
+        std::copy(saved_weights.begin(), saved_weights.end(), weights->begin());
+        replay_next = saved_next;
+        replay_count = saved_count;
+        pending = saved_pending;
+        replay_inputs.swap(saved_inputs);
+        replay_targets.swap(saved_targets);
+        replay_size = uint32_t(saved_size);
+        return true;
+    }
+
+    void BackpropApproximator::SaveBinary(BinaryWriter& out) const
+    {
+        out.write(mAlpha);
+        out.write(batch_size);
+        out.write(replay_size);
+        out.write_array(layers);
+        out.write_array(*weights);
+    }
+
+    /// the weights are copied in place, as by LoadState
+    bool BackpropApproximator::LoadBinary(BinaryReader& in)
+    {
+        float saved_alpha;
+        uint32_t saved_batch_size, saved_replay_size;
+        std::vector<uint32_t> saved_layers;
+        if (!in.read(saved_alpha) || !in.read(saved_batch_size) || !in.read(saved_replay_size)
+            || !in.read_array(saved_layers) || saved_layers != layers
+            || !in.read_array(&(*weights)[0], weights->size()))
+        {
+            LOG_F_WARNING("ai.rl", "the saved network is laid out differently from this one");
+            return false;
+        }
+        mAlpha = saved_alpha;
+        batch_size = std::max<uint32_t>(saved_batch_size, 1);
+        replay_size = std::max<uint32_t>(saved_replay_size, 1);
+        setup();
+        return true;
+    }
+}
+
+BOOST_CLASS_EXPORT(OpenNero::BackpropApproximator)
@@ -1,35 +1,168 @@
 #ifndef _OPENNERO_AI_RL_BACKAPPROXIMATOR_H_
 #define _OPENNERO_AI_RL_BACKAPPROXIMATOR_H_
 
+#include <vector>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/split_member.hpp>
+
 #include "core/Common.h"
 #include "ai/AI.h"
+#include "Approximator.h"
 
 namespace OpenNero
 {
+    /// @cond
+    BOOST_PTR_DECL(BackpropApproximator);
+    /// @endcond
 
-    /// A CMAC tile coding function approximator
+    /// A multilayer perceptron function approximator. The sensors and the
+    /// actions, scaled to [-1, 1] by their bounds, feed layers of tanh units
+    /// and a single linear output. All the weights live in one contiguous
+    /// array, layer after layer; each layer is a row-major matrix with one
+    /// row per unit and the bias in the last column.
+    ///
+    /// Updates are not applied one at a time: each example goes into a
+    /// replay buffer, and every batch_size updates the network takes one
+    /// gradient step on a minibatch drawn from the buffer.
     class BackpropApproximator : public Approximator
     {
-            SNetwork network;
+    public:
+        /// the default number of updates between gradient steps (and the size of a minibatch)
+        static const uint32_t kDefaultBatchSize = 16;
+
+        /// the default number of examples the replay buffer keeps
+        static const uint32_t kDefaultReplaySize = 1024;
+
+    private:
+        friend class boost::serialization::access;
+
+        float mAlpha;               ///< learning rate
+        uint32_t batch_size;        ///< updates between gradient steps, and the size of a minibatch
+        uint32_t replay_size;       ///< the most examples the replay buffer keeps
+        std::vector<uint32_t> layers; ///< the units in each layer, from the inputs to the output
+        boost::shared_ptr< std::vector<float> > weights; ///< all the weights, perhaps shared with other approximators
+
+        // derived from the bounds and the layers, not serialized
+        std::vector<float> input_scale;     ///< multiplies each input
+        std::vector<float> input_offset;    ///< is then added to each input
+        std::vector<size_t> weight_offsets; ///< where the weights of each layer start
+        std::vector<size_t> unit_offsets;   ///< where the units of each layer start in activations and deltas
+
+        // scratch space, reused between calls
+        std::vector<float> activations;     ///< the output of every unit
+        std::vector<float> deltas;          ///< the error of every unit
+        std::vector<float> gradient;        ///< the sum of the gradients of a minibatch
+        std::vector<float> first_layer;     ///< the first layer's sums for the state alone (predict_all)
+
+        // the replay buffer
+        std::vector<float> replay_inputs;   ///< the scaled inputs of the examples, one row each
+        std::vector<float> replay_targets;  ///< the targets of the examples
+        uint32_t replay_next;               ///< where the next example goes
+        uint32_t replay_count;              ///< how many examples are in the buffer
+        uint32_t pending;                   ///< updates since the last gradient step
+
+        /// work out everything that is not serialized
+        void setup();
+
+        /// @return the number of inputs (sensors and actions)
+        size_t num_inputs() const { return layers.front(); }
+
+        /// scale the sensors and the actions into the input layer
+        void encode(const FeatureVector& sensors, const FeatureVector& actions, float* input) const;
+
+        /// run the layers from first on, the ones before it being in activations
+        /// @return the output of the network
+        float forward(size_t first = 1);
+
+        /// add the gradient of the error on one example to gradient
+        void backward(float output, float target);
+
+        /// take one gradient step on a minibatch from the replay buffer
+        void train();
+
+    public:
+        /// constructor
+        BackpropApproximator();
+
+        /// @param info information about the agent
+        /// @param hidden_units the number of units in each hidden layer
+        /// @param hidden_layers the number of hidden layers
+        explicit BackpropApproximator(const AgentInitInfo& info, uint32_t hidden_units, uint32_t hidden_layers = 1);
+
+        /// copy constructor
+        BackpropApproximator(const BackpropApproximator& a);
+
+        /// destructor
+        ~BackpropApproximator();
+
+        /// return a copy of this approximator
+        ApproximatorPtr copy() const { ApproximatorPtr p(new BackpropApproximator(*this)); return p; }
+
+        /// return an approximator that trains the same weights as this one,
+        /// without locks (Hogwild!), from its own replay buffer
+        ApproximatorPtr share();
+
+        /// predict the value associated with a particular feature vector
+        double predict(const FeatureVector& sensors, const FeatureVector& actions);
+
+        /// update the value associated with a particular feature vector
+        void update(const FeatureVector& sensors, const FeatureVector& actions, double target);
+
+        /// predict the values of one state with each of a list of actions,
+        /// summing the state's part of the first layer only once
+        void predict_all(const FeatureVector& sensors, const std::vector<FeatureVector>& actions, std::vector<double>& values);
+
+        /// write the weights and the replay buffer to a world snapshot
+        void SaveState(Bitstream& stream) const;
+
+        /// replace the weights and the replay buffer with ones written by SaveState
+        bool LoadState(Bitstream& stream);
+
+        /// write the shape and the weights (not the replay buffer) to a binary archive
+        void SaveBinary(BinaryWriter& out) const;
 
-        public:
-            /// constructor
-            explicit BackpropApproximator(const AgentInitInfo& info);
+        /// replace the weights with ones written by SaveBinary, emptying the replay buffer
+        bool LoadBinary(BinaryReader& in);
 
-            /// copy constructor
-            BackpropApproximator(const BackpropApproximator& a);
+        /// set the learning rate
+        void setAlpha(float alpha) { mAlpha = alpha; }
 
-            /// destructor
-            ~BackpropApproximator();
+        /// set the number of updates between gradient steps
+        void setBatchSize(uint32_t size) { batch_size = size > 0 ? size : 1; }
 
-            /// return a copy of this approximator
-            ApproximatorPtr copy() const { ApproximatorPtr p(new BackpropApproximator(*this)); return p; }
+        /// serialize this object to a Boost serialization archive
+        template<class Archive>
+        void save(Archive & ar, const unsigned int version) const
+        {
+            ar & boost::serialization::base_object<Approximator>(*this);
+            ar & BOOST_SERIALIZATION_NVP(mAlpha);
+            ar & BOOST_SERIALIZATION_NVP(batch_size);
+            ar & BOOST_SERIALIZATION_NVP(replay_size);
+            ar & BOOST_SERIALIZATION_NVP(layers);
+            const std::vector<float>& weights = *this->weights;
+            ar & BOOST_SERIALIZATION_NVP(weights);
+        }
 
-            /// predict the value associated with a particular feature vector
-            double predict(const FeatureVector& sensors, const FeatureVector& actions);
+        /// deserialize this object from a Boost serialization archive
+        /// (with an empty replay buffer)
+        template<class Archive>
+        void load(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<Approximator>(*this);
+            ar & BOOST_SERIALIZATION_NVP(mAlpha);
+            ar & BOOST_SERIALIZATION_NVP(batch_size);
+            ar & BOOST_SERIALIZATION_NVP(replay_size);
+            ar & BOOST_SERIALIZATION_NVP(layers);
+            weights.reset(new std::vector<float>());
+            std::vector<float>& weights = *this->weights;
+            ar & BOOST_SERIALIZATION_NVP(weights);
+            setup();
+        }
 
-            /// update the value associated with a particular feature vector
-            void update(const FeatureVector& sensors, const FeatureVector& actions, double target);
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 }
 
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <fstream>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "core/Common.h"
+#include "BinaryArchive.h"
+
+namespace OpenNero
+{
+    namespace {
+        const char kMagic[8] = { 'O', 'N', 'R', 'L', 'B', 'I', 'N', 0 };
+        const uint32_t kVersion = 2; // 2: a TDBrain keeps its hidden units apart from its weights
+        const uint32_t kByteOrder = 0x01020304;
+
+        /// the start of a binary archive file
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order;
+            uint64_t size;      ///< the size of the fields after the header
+        };
+
+        /// @return the size rounded up to a multiple of 8
+        inline size_t padded(size_t size)
+        {
+            return (size + 7) & ~size_t(7);
+        }
+    }
+
+    struct BinaryReader::Mapping
+    {
+        boost::interprocess::file_mapping file;
+        boost::interprocess::mapped_region region;
+    };
+
+    void BinaryWriter::append(const void* bytes, size_t size)
+    {
+        const size_t at = mData.size();
+        mData.resize(at + padded(size), 0);
+        if (size > 0)
+            memcpy(&mData[at], bytes, size);
+    }
+
+    bool BinaryWriter::save(const std::string& filename) const
+    {
+        std::ofstream out(filename.c_str(), std::ios::binary);
+        if (!out)
+            return false;
+        Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.byte_order = kByteOrder;
+        header.size = mData.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!mData.empty())
+            out.write(&mData[0], mData.size());
+        out.close();
+        return !out.fail();
+    }
+
+    BinaryReader::BinaryReader()
+        : mData(NULL), mSize(0), mPos(0), mGood(false), mBuffer(), mMapping()
+    {
+    }
+
+    BinaryReader::BinaryReader(const char* data, size_t size)
+        : mData(data), mSize(size), mPos(0), mGood(true), mBuffer(), mMapping()
+    {
+    }
+
+    BinaryReader::~BinaryReader()
+    {
+    }
+
+    bool BinaryReader::is_archive(const std::string& filename)
+    {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        char magic[sizeof(kMagic)];
+        return in.read(magic, sizeof(magic)) && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    }
+
+    bool BinaryReader::open(const std::string& filename, bool mapped)
+    {
+        using namespace boost::interprocess;
+
+        mData = NULL;
+        mSize = mPos = 0;
+        mGood = false;
+        mBuffer.clear();
+        mMapping.reset();
+
+        const char* start = NULL;
+        size_t size = 0;
+        if (mapped)
+        {
+            boost::shared_ptr<Mapping> mapping(new Mapping());
+            try
+            {
+                file_mapping(filename.c_str(), read_only).swap(mapping->file);
+                mapped_region(mapping->file, read_only).swap(mapping->region);
+            }
+            catch (const interprocess_exception& e)
+            {
+                LOG_F_ERROR("ai.rl", "could not map " << filename << ": " << e.what());
+                return false;
+            }
+            mMapping = mapping;
+            start = static_cast<const char*>(mapping->region.get_address());
+            size = mapping->region.get_size();
+        }
+        else
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if (!in)
+            {
+                LOG_F_ERROR("ai.rl", "could not open " << filename);
+                return false;
+            }
+            in.seekg(0, std::ios::end);
+            size = size_t(in.tellg());
+            in.seekg(0, std::ios::beg);
+            mBuffer.resize(padded(size) / sizeof(uint64_t));
+            start = reinterpret_cast<const char*>(mBuffer.empty() ? NULL : &mBuffer[0]);
+            if (size > 0 && !in.read(reinterpret_cast<char*>(&mBuffer[0]), size))
+            {
+                LOG_F_ERROR("ai.rl", "could not read " << filename);
+                return false;
+            }
+        }
+
+        Header header;
+        if (size < sizeof(header))
+        {
+            LOG_F_ERROR("ai.rl", filename << " is too short for a binary archive");
+            return false;
+        }
+        memcpy(&header, start, sizeof(header));
+        if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+        {
+            LOG_F_ERROR("ai.rl", filename << " is not a binary archive");
+            return false;
+        }
+        if (header.version != kVersion || header.byte_order != kByteOrder)
+        {
+            LOG_F_ERROR("ai.rl", filename << " was written by an incompatible build");
+            return false;
+        }
+        if (header.size > size - sizeof(header))
+        {
+            LOG_F_ERROR("ai.rl", filename << " is truncated");
+            return false;
+        }
+        mData = start + sizeof(header);
+        mSize = size_t(header.size);
+        mGood = true;
+        return true;
+    }
+
+    const void* BinaryReader::take(size_t size)
+    {
+        if (!mGood || size > remaining())
+        {
+            fail();
+            return NULL;
+        }
+        const void* bytes = mData + mPos;
+        mPos = std::min(mSize, mPos + padded(size));
+        return bytes;
+    }
+}
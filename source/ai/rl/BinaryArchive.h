@@ -0,0 +1,160 @@
+#ifndef _OPENNERO_AI_RL_BINARYARCHIVE_H_
+#define _OPENNERO_AI_RL_BINARYARCHIVE_H_
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "core/Common.h"
+
+namespace OpenNero
+{
+    /// A BINARY ARCHIVE of a learner is a short header followed by fields
+    /// that each start on an 8-byte boundary: a scalar is stored as it is
+    /// in memory, an array as a 64-bit count followed by its elements. The
+    /// arrays of a file can be used straight from a read-only mapping.
+    ///
+    /// Archives are written in the byte order of the machine that saves
+    /// them, which is little-endian on every platform OpenNERO builds for;
+    /// the header records it and a file in the other order is rejected
+    /// rather than misread.
+    class BinaryWriter : private boost::noncopyable
+    {
+    public:
+        BinaryWriter() : mData() {}
+
+        /// append a scalar (a number or a plain struct)
+        template <typename T>
+        void write(const T& value)
+        {
+            append(&value, sizeof(T));
+        }
+
+        /// append an array of scalars
+        template <typename T>
+        void write_array(const T* values, size_t count)
+        {
+            write(uint64_t(count));
+            append(values, count * sizeof(T));
+        }
+
+        /// append a vector of scalars
+        template <typename T>
+        void write_array(const std::vector<T>& values)
+        {
+            write_array(values.empty() ? (const T*)NULL : &values[0], values.size());
+        }
+
+        /// @return the fields written so far
+        const std::vector<char>& data() const { return mData; }
+
+        /// write a header and the fields to a file
+        /// @return false if the file could not be written
+        bool save(const std::string& filename) const;
+
+    private:
+        /// append bytes and pad them to a multiple of 8
+        void append(const void* bytes, size_t size);
+
+        std::vector<char> mData; ///< the fields written so far
+    };
+
+    /// Reads the fields of a BinaryWriter back, from memory or from a file
+    /// that is either read or mapped into memory. Every read fails (and
+    /// keeps failing) rather than go past the end of the data.
+    class BinaryReader : private boost::noncopyable
+    {
+    public:
+        /// a reader with no data; see open
+        BinaryReader();
+
+        /// read fields from memory (without a header)
+        BinaryReader(const char* data, size_t size);
+
+        ~BinaryReader();
+
+        /// @return whether a file starts with the header of a binary archive
+        static bool is_archive(const std::string& filename);
+
+        /// read a file written by BinaryWriter::save, mapping it into memory
+        /// (read-only) or reading it into a buffer
+        /// @return false if the file could not be read or is not an archive
+        bool open(const std::string& filename, bool mapped);
+
+        /// read a scalar
+        template <typename T>
+        bool read(T& value)
+        {
+            const void* bytes = take(sizeof(T));
+            if (!bytes)
+                return false;
+            memcpy(&value, bytes, sizeof(T));
+            return true;
+        }
+
+        /// point at an array in place, without copying it
+        template <typename T>
+        bool view_array(const T*& values, size_t& count)
+        {
+            uint64_t n;
+            if (!read(n) || n > remaining() / sizeof(T))
+                return fail();
+            count = size_t(n);
+            values = static_cast<const T*>(take(count * sizeof(T)));
+            return values != NULL;
+        }
+
+        /// copy an array into a vector
+        template <typename T>
+        bool read_array(std::vector<T>& values)
+        {
+            const T* first;
+            size_t count;
+            if (!view_array(first, count))
+                return false;
+            values.assign(first, first + count);
+            return true;
+        }
+
+        /// copy an array into exactly count elements
+        /// @return false if the array has another size
+        template <typename T>
+        bool read_array(T* values, size_t count)
+        {
+            const T* first;
+            size_t n;
+            if (!view_array(first, n) || n != count)
+                return fail();
+            std::copy(first, first + n, values);
+            return true;
+        }
+
+        /// @return whether all the reads so far succeeded
+        bool good() const { return mGood; }
+
+    private:
+        /// the file mapping and region, when a file is mapped
+        struct Mapping;
+
+        /// @return the next size bytes (padded to 8) or NULL if there are not that many
+        const void* take(size_t size);
+
+        /// @return the number of bytes left
+        size_t remaining() const { return mSize - mPos; }
+
+        /// stop reading
+        bool fail() { mGood = false; return false; }
+
+        const char* mData;                  ///< the fields
+        size_t mSize;                       ///< the size of the fields
+        size_t mPos;                        ///< where the next field starts
+        bool mGood;                         ///< whether all the reads succeeded
+        std::vector<uint64_t> mBuffer;      ///< a file that was read (aligned for any field)
+        boost::shared_ptr<Mapping> mMapping; ///< a file that was mapped
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "math/Random.h"
 #include "Approximator.h"
 #include "QLearning.h"
+#include <algorithm>
 #include <cfloat>
 #include <vector>
 
@@ -9,14 +10,10 @@ namespace OpenNero
 {
 	double QLearningBrain::predict(const Observations& new_state) {
 		double max_value = -DBL_MAX;
-		std::vector< Actions >::const_iterator iter;
-		for (iter = action_list.begin(); iter != action_list.end(); ++iter)
+		mApproximator->predict_all(new_state, action_list, action_values);
+		for (size_t i = 0; i < action_values.size(); ++i)
 		{
-			double value = mApproximator->predict(new_state, *iter);
-			if (value > max_value)
-			{
-				max_value = value;
-			}
+			max_value = std::max(max_value, action_values[i]);
 		}
 		return max_value;
 	}
@@ -23,8 +23,11 @@ namespace OpenNero
 		/// @param epsilon parameter for the epsilon-greedy policy (between 0 and 1)
         /// @param actions number of bins for quantizing continuous action dimensions
         /// @param states number of bins for quantizing continuous state space dimensions
-        QLearningBrain(double gamma, double alpha, double epsilon, int actions, int states, int tiles, int weights)
-        : TDBrain(gamma, alpha, epsilon, actions, states, tiles, weights)
+        /// @param tiles number of tilings, or 0 for a table (or, with states == 0, a network)
+        /// @param weights number of tile weights
+        /// @param hidden number of hidden units of a network
+        QLearningBrain(double gamma, double alpha, double epsilon, int actions, int states, int tiles, int weights, int hidden = 0)
+        : TDBrain(gamma, alpha, epsilon, actions, states, tiles, weights, hidden)
 		{}
 
 		/// constructor
@@ -27,8 +27,11 @@ namespace OpenNero
         	/// @param lambda parameter for the SARSA(lambda) learning algorith
             /// @param actions number of bins for quantizing continuous action dimensions
             /// @param states number of bins for quantizing continuous state space dimensions
-            SarsaBrain(double gamma, double alpha, double epsilon, double lambda, int actions, int states, int tiles, int weights)
-            : TDBrain(gamma, alpha, epsilon, actions, states, tiles, weights)
+            /// @param tiles number of tilings, or 0 for a table (or, with states == 0, a network)
+            /// @param weights number of tile weights
+            /// @param hidden number of hidden units of a network
+            SarsaBrain(double gamma, double alpha, double epsilon, double lambda, int actions, int states, int tiles, int weights, int hidden = 0)
+            : TDBrain(gamma, alpha, epsilon, actions, states, tiles, weights, hidden)
             , mLambda(lambda)
 			, cumulative_reward(0)
 			, n_episodes(0)
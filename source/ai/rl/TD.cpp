@@ -2,6 +2,10 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
@@ -10,11 +14,163 @@
 #include "core/Common.h"
 #include "math/Random.h"
 #include "Approximator.h"
+#include "BackpropApproximator.h"
 #include "ai/AI.h"
+#include "ai/AIObject.h"
+#include "game/SimEntity.h"
 #include "TD.h"
 
 namespace OpenNero
 {
+    namespace {
+        /// an approximator shared by the agents of a template
+        struct SharedApproximator
+        {
+            ApproximatorWPtr approximator;  ///< goes away with the last of the agents
+            uint32_t saved_in[TDBrain::kNumSaveFormats]; ///< the last BrainSavePass that wrote its values to each format
+
+            SharedApproximator() : approximator()
+            {
+                std::fill(saved_in, saved_in + TDBrain::kNumSaveFormats, 0);
+            }
+        };
+
+        /// the approximators shared by the agents of each template
+        typedef std::map<std::string, SharedApproximator> SharedApproximatorMap;
+
+        SharedApproximatorMap& SharedApproximators()
+        {
+            static SharedApproximatorMap approximators;
+            return approximators;
+        }
+
+        /// forget the approximators whose agents are all gone
+        void PruneSharedApproximators()
+        {
+            SharedApproximatorMap& approximators = SharedApproximators();
+            SharedApproximatorMap::iterator iter = approximators.begin();
+            while (iter != approximators.end())
+            {
+                if (iter->second.approximator.expired())
+                    approximators.erase(iter++);
+                else
+                    ++iter;
+            }
+        }
+
+        /// what a saved brain holds of what it learned
+        enum LearnedKind
+        {
+            kNothingLearned = 0,    ///< no approximator was set up
+            kLearnedValues = 1,     ///< the values of its approximator follow
+            kSharedValues = 2       ///< the key of the shared approximator follows
+        };
+
+        /// write the bounds of a feature vector as three arrays
+        void WriteInfo(BinaryWriter& out, const FeatureVectorInfo& info)
+        {
+            std::vector<double> lower(info.size()), upper(info.size());
+            std::vector<uint8_t> discrete(info.size());
+            for (size_t i = 0; i < info.size(); ++i)
+            {
+                lower[i] = info.getMin(i);
+                upper[i] = info.getMax(i);
+                discrete[i] = info.isDiscrete(i);
+            }
+            out.write_array(lower);
+            out.write_array(upper);
+            out.write_array(discrete);
+        }
+
+        /// read the bounds written by WriteInfo
+        bool ReadInfo(BinaryReader& in, FeatureVectorInfo& info)
+        {
+            std::vector<double> lower, upper;
+            std::vector<uint8_t> discrete;
+            if (!in.read_array(lower) || !in.read_array(upper) || !in.read_array(discrete)
+                || upper.size() != lower.size() || discrete.size() != lower.size())
+                return false;
+            info = FeatureVectorInfo();
+            for (size_t i = 0; i < lower.size(); ++i)
+            {
+                if (discrete[i])
+                    info.addDiscrete(int(lower[i]), int(upper[i]));
+                else
+                    info.addContinuous(lower[i], upper[i]);
+            }
+            return true;
+        }
+
+        /// @return whether two feature vectors have the same bounds
+        bool SameInfo(const FeatureVectorInfo& a, const FeatureVectorInfo& b)
+        {
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                if (a.getMin(i) != b.getMin(i) || a.getMax(i) != b.getMax(i) || a.isDiscrete(i) != b.isDiscrete(i))
+                    return false;
+            }
+            return true;
+        }
+
+        /// @return whether the bins, tiles, weights and hidden units describe
+        /// an approximator that initialize would accept
+        bool ValidLayout(int actions, int states, int tiles, int weights, int hidden)
+        {
+            if (actions < 0 || states < 0 || tiles < 0 || weights < 0 || hidden < 0)
+                return false;
+            if (tiles > 0)
+                return actions == 0 && states == 0;
+            if (states == 0)
+                return hidden > 0;
+            return actions > 0;
+        }
+    }
+
+    /// The agents share an approximator if they come from the same template
+    /// (or, for agents without a body, the same brain expression) and their
+    /// approximators are set up the same way.
+    std::string TDBrain::SharingKey()
+    {
+        std::ostringstream key;
+        AIObjectPtr body = GetBody();
+        SimEntityPtr ent = body ? body->GetEntity() : SimEntityPtr();
+        key << (ent ? ent->GetCreationTemplate() : name)
+            << ' ' << action_bins << ' ' << state_bins
+            << ' ' << num_tiles << ' ' << num_weights
+            << ' ' << hidden_units << ' ' << mInfo;
+        return key.str();
+    }
+
+    bool TDBrain::WritesLearned(SaveFormat format) const
+    {
+        uint32_t pass = BrainSavePass::Current();
+        if (!mSharedModel || pass == 0)
+            return true;
+        SharedApproximator& shared = SharedApproximators()[mSharingKey];
+        if (shared.saved_in[format] == pass)
+            return false;
+        shared.saved_in[format] = pass;
+        return true;
+    }
+
+    bool TDBrain::JoinsShared(const std::string& key) const
+    {
+        if (mSharedModel && key == mSharingKey)
+            return true;
+        LOG_F_WARNING("ai.rl", "the saved agent refers to values shared by agents this one does not learn with");
+        return false;
+    }
+
+    ApproximatorPtr TDBrain::CreateApproximator(const AgentInitInfo& info, int actions, int states, int tiles, int weights, int hidden)
+    {
+        if (tiles > 0)
+            return ApproximatorPtr(new TilesApproximator(info, tiles, weights));
+        if (states == 0)
+            return ApproximatorPtr(new BackpropApproximator(info, hidden));
+        return ApproximatorPtr(new TableApproximator(info, actions, states));
+    }
 
     /// called right before the agent is born
     bool TDBrain::initialize(const AgentInitInfo& init)
@@ -24,21 +180,53 @@ namespace OpenNero
 
         int bins = action_bins;
 
+        std::string key;
+        mSharedModel.reset();
+        if (mShared)
+        {
+            PruneSharedApproximators();
+            key = SharingKey();
+            mSharedModel = SharedApproximators()[key].approximator.lock();
+        }
+
         if (num_tiles > 0)
         {
             AssertMsg(action_bins == 0, "action_bins must be 0 for num_tiles > 0");
             AssertMsg(state_bins == 0, "state_bins must be 0 for num_tiles > 0");
-            mApproximator.reset(
-                new TilesApproximator(mInfo, num_tiles, num_weights));
             bins = 7; // XXX force bins > 0 to discretize action_list below
         }
+        else if (state_bins == 0)
+        {
+            // no tiles and no table: a network with hidden_units hidden units
+            AssertMsg(hidden_units > 0, "hidden_units > 0 for a network (num_tiles == 0, state_bins == 0)");
+            if (bins == 0)
+                bins = 7; // as for tiles, to discretize action_list below
+        }
         else
         {
             AssertMsg(action_bins > 0, "action_bins > 0 for num_tiles == 0");
             AssertMsg(state_bins > 0, "action_bins > 0 for num_tiles == 0");
-            mApproximator.reset(
-                new TableApproximator(mInfo, action_bins, state_bins));
         }
+        if (!mSharedModel)
+            mApproximator = CreateApproximator(mInfo, action_bins, state_bins, num_tiles, num_weights, hidden_units);
+
+        if (mShared)
+        {
+            // the model itself is not used by any agent, each gets its own view
+            if (!mSharedModel)
+            {
+                mSharedModel = mApproximator;
+                SharedApproximators()[key].approximator = mSharedModel;
+            }
+            mApproximator = mSharedModel->share();
+            if (!mApproximator)
+            {
+                LOG_F_WARNING("ai.rl", "this approximator cannot be shared, learning alone");
+                mApproximator = mSharedModel;
+                mSharedModel.reset();
+            }
+        }
+        mSharingKey = mSharedModel ? key : std::string();
 
         // Similar to FeatureVectorInfo::enumerate (from AI.cpp).
         //
@@ -117,27 +305,37 @@ namespace OpenNero
     double TDBrain::epsilon_greedy(const Observations& new_state)
     {
         // with chance epsilon, select random action
-        if (RANDOM.randF() < mEpsilon)
+        if (ThreadRandom().randF() < mEpsilon)
         {
             new_action = mInfo.actions.getRandom();
             double value = predict(new_state);
             return value;
         }
         // enumerate all possible actions (actions must be discrete!)
-        new_action = mInfo.actions.getInstance();
-        // select the greedy action in random order
-        std::random_shuffle(action_list.begin(), action_list.end());
+        if (action_list.empty())
+        {
+            new_action = mInfo.actions.getInstance();
+            return -DBL_MAX;
+        }
+        mApproximator->predict_all(new_state, action_list, action_values);
+        // select the greedy action, breaking ties at random
         double max_value = -DBL_MAX;
-        std::vector< Actions >::const_iterator iter;
-        for (iter = action_list.begin(); iter != action_list.end(); ++iter)
+        size_t best = 0, ties = 0;
+        for (size_t i = 0; i < action_values.size(); ++i)
         {
-            double value = mApproximator->predict(new_state, *iter);
-            if (value > max_value)
+            if (action_values[i] > max_value)
             {
-                max_value = value;
-                new_action = *iter;
+                max_value = action_values[i];
+                best = i;
+                ties = 1;
+            }
+            else if (action_values[i] == max_value && ThreadRandom().randI(ties++) == 0)
+            {
+                // the k-th of k equal values replaces the choice with chance 1/k
+                best = i;
             }
         }
+        new_action = action_list[best];
         // Assuming if you choose max value, you will want to update with that as your prediction
         return max_value;
     }
@@ -157,16 +355,263 @@ namespace OpenNero
         return oss.str();
     }
 
+    /// write the state of this brain to a world snapshot
+    void TDBrain::SaveState(Bitstream& stream) const
+    {
+        AgentBrain::SaveState(stream);
+        stream << mGamma << mAlpha << mEpsilon << action << state << new_action;
+        if (!mApproximator)
+        {
+            stream << uint8_t(kNothingLearned);
+        }
+        else if (WritesLearned(kSnapshot))
+        {
+            stream << uint8_t(kLearnedValues);
+            mApproximator->SaveState(stream);
+        }
+        else
+        {
+            stream << uint8_t(kSharedValues) << mSharingKey;
+        }
+    }
+
+    /// read the state written by SaveState
+    bool TDBrain::LoadState(Bitstream& stream)
+    {
+        // the counters are put back if the rest does not load
+        Bitstream counters;
+        AgentBrain::SaveState(counters);
+        if (!AgentBrain::LoadState(stream))
+            return false;
+        double gamma, alpha, epsilon;
+        Actions saved_action, saved_new_action;
+        Observations saved_state;
+        uint8_t learned;
+        stream >> gamma >> alpha >> epsilon >> saved_action >> saved_state >> saved_new_action >> learned;
+        bool loaded = !stream.Failed();
+        if (loaded && learned == kLearnedValues)
+        {
+            loaded = mApproximator && mApproximator->LoadState(stream);
+        }
+        else if (loaded && learned == kSharedValues)
+        {
+            std::string key;
+            stream >> key;
+            loaded = !stream.Failed() && JoinsShared(key);
+        }
+        else if (learned != kNothingLearned)
+        {
+            loaded = false;
+        }
+        if (!loaded)
+        {
+            AgentBrain::LoadState(counters);
+            return false;
+        }
+        mGamma = gamma;
+        mAlpha = alpha;
+        mEpsilon = epsilon;
+        action = saved_action;
+        state = saved_state;
+        new_action = saved_new_action;
+        return true;
+    }
+
     /// deserialize this brain from a text string
-    void TDBrain::from_string(const std::string& s)
+    bool TDBrain::from_string(const std::string& s)
     {
+        ApproximatorPtr current = mApproximator;
         try {
             std::istringstream iss(s);
             boost::archive::text_iarchive ia(iss);
             ia >> *this;
         } catch (boost::archive::archive_exception const& e) {
             LOG_F_ERROR("ai.rl", "unable to load agent because of error, " << e.what());
+            return false;
+        }
+        // an agent that refers to the shared values keeps its view of them
+        if (mSharedModel && mApproximator && mApproximator != current)
+        {
+            // put the loaded values into the shared approximator, for the
+            // other agents as well, instead of keeping them to this one
+            Bitstream stream;
+            mApproximator->SaveState(stream);
+            ApproximatorPtr view = mSharedModel->share();
+            if (view->LoadState(stream))
+            {
+                mApproximator = view;
+            }
+            else
+            {
+                LOG_F_WARNING("ai.rl", "the loaded agent does not fit the shared approximator, learning alone");
+                mSharedModel.reset();
+            }
+        }
+        return true;
+    }
+
+    bool TDBrain::to_file(const std::string& filename, bool binary) const
+    {
+        bool written;
+        if (binary)
+        {
+            BinaryWriter out;
+            SaveBinary(out);
+            written = out.save(filename);
+        }
+        else
+        {
+            std::ofstream out(filename.c_str());
+            out << to_string();
+            out.close();
+            written = !out.fail();
+        }
+        if (!written)
+        {
+            LOG_F_ERROR("ai.rl", "could not write agent to " << filename);
+        }
+        return written;
+    }
+
+    bool TDBrain::from_file(const std::string& filename, bool mapped)
+    {
+        if (!BinaryReader::is_archive(filename))
+        {
+            std::ifstream in(filename.c_str());
+            if (!in)
+            {
+                LOG_F_ERROR("ai.rl", "could not open " << filename);
+                return false;
+            }
+            std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            return from_string(text);
+        }
+        BinaryReader in;
+        if (!in.open(filename, mapped))
+        {
+            return false;
+        }
+        if (!LoadBinary(in))
+        {
+            LOG_F_ERROR("ai.rl", "unable to load agent from " << filename);
+            return false;
         }
+        return true;
+    }
+
+    void TDBrain::SaveBinary(BinaryWriter& out) const
+    {
+        out.write(mGamma);
+        out.write(mAlpha);
+        out.write(mEpsilon);
+        out.write(int32_t(action_bins));
+        out.write(int32_t(state_bins));
+        out.write(int32_t(num_tiles));
+        out.write(int32_t(num_weights));
+        out.write(int32_t(hidden_units));
+        WriteInfo(out, mInfo.sensors);
+        WriteInfo(out, mInfo.actions);
+        WriteInfo(out, mInfo.reward);
+
+        // the actions one after the other
+        std::vector<double> actions;
+        for (size_t i = 0; i < action_list.size(); ++i)
+        {
+            actions.insert(actions.end(), action_list[i].begin(), action_list[i].end());
+        }
+        out.write(uint32_t(mInfo.actions.size()));
+        out.write_array(actions);
+
+        if (!mApproximator)
+        {
+            out.write(uint8_t(kNothingLearned));
+        }
+        else if (WritesLearned(kBinaryArchive))
+        {
+            out.write(uint8_t(kLearnedValues));
+            mApproximator->SaveBinary(out);
+        }
+        else
+        {
+            out.write(uint8_t(kSharedValues));
+            out.write_array(mSharingKey.data(), mSharingKey.size());
+        }
+    }
+
+    /// A brain set up the same way as the saved one (as the agents of a
+    /// saved team are) loads the values into its own approximator, shared
+    /// or not; any other brain gets a new approximator for them. Nothing
+    /// changes unless the whole brain loads.
+    bool TDBrain::LoadBinary(BinaryReader& in)
+    {
+        double gamma, alpha, epsilon;
+        int32_t bins[5];
+        AgentInitInfo info;
+        uint32_t width;
+        std::vector<double> actions;
+        uint8_t learned;
+        if (!in.read(gamma) || !in.read(alpha) || !in.read(epsilon)
+            || !in.read(bins[0]) || !in.read(bins[1]) || !in.read(bins[2]) || !in.read(bins[3]) || !in.read(bins[4])
+            || !ReadInfo(in, info.sensors) || !ReadInfo(in, info.actions) || !ReadInfo(in, info.reward)
+            || !in.read(width) || !in.read_array(actions) || !in.read(learned)
+            || width != info.actions.size() || (width == 0 ? !actions.empty() : actions.size() % width != 0))
+        {
+            LOG_F_WARNING("ai.rl", "the saved agent is incomplete");
+            return false;
+        }
+        if (!ValidLayout(bins[0], bins[1], bins[2], bins[3], bins[4]))
+        {
+            LOG_F_WARNING("ai.rl", "the saved agent has no valid approximator layout");
+            return false;
+        }
+
+        const bool same = mApproximator
+            && bins[0] == action_bins && bins[1] == state_bins
+            && bins[2] == num_tiles && bins[3] == num_weights && bins[4] == hidden_units
+            && SameInfo(info.sensors, mInfo.sensors) && SameInfo(info.actions, mInfo.actions);
+
+        // an agent saved before it learned anything keeps what this brain
+        // has, or starts afresh if the layout changed
+        ApproximatorPtr approximator = same
+            ? mApproximator
+            : CreateApproximator(info, bins[0], bins[1], bins[2], bins[3], bins[4]);
+        if (learned == kLearnedValues && !approximator->LoadBinary(in))
+        {
+            return false;
+        }
+        if (learned > kSharedValues)
+        {
+            LOG_F_WARNING("ai.rl", "the saved agent holds its values in an unknown way");
+            return false;
+        }
+        if (learned == kSharedValues)
+        {
+            std::vector<char> key;
+            if (!in.read_array(key) || !same || !JoinsShared(std::string(key.begin(), key.end())))
+                return false;
+        }
+
+        if (!same && mSharedModel)
+        {
+            LOG_F_WARNING("ai.rl", "the loaded agent does not fit the shared approximator, learning alone");
+            mSharedModel.reset();
+        }
+        mGamma = gamma;
+        mAlpha = alpha;
+        mEpsilon = epsilon;
+        action_bins = bins[0];
+        state_bins = bins[1];
+        num_tiles = bins[2];
+        num_weights = bins[3];
+        hidden_units = bins[4];
+        mInfo = info;
+        action_list.clear();
+        for (size_t i = 0; i < actions.size(); i += width)
+        {
+            action_list.push_back(Actions(actions.begin() + i, actions.begin() + i + width));
+        }
+        mApproximator = approximator;
+        return true;
     }
 }
 
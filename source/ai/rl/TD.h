@@ -8,7 +8,10 @@
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "core/Common.h"
 #include "ai/AgentBrain.h"
@@ -24,6 +27,17 @@ namespace OpenNero
     /// A TD reinforcement learning agent
     class TDBrain : public AgentBrain
     {
+    public:
+        /// the outputs a brain is saved to; each of them holds the shared
+        /// values once per BrainSavePass
+        enum SaveFormat
+        {
+            kTextArchive,   ///< to_string and the Boost archives
+            kSnapshot,      ///< SaveState, for world snapshots
+            kBinaryArchive, ///< SaveBinary
+            kNumSaveFormats
+        };
+
     protected:
         friend class boost::serialization::access;
 
@@ -36,10 +50,30 @@ namespace OpenNero
         Actions action;      ///< previous action taken
         Observations state;  ///< previous state
         Actions new_action;  ///< new action
+        std::vector<double> action_values; ///< the value of each action in action_list, reused every step
         int action_bins; ///< number of discrete bins for action space.
         int state_bins; ///< number of discrete bins for state space.
         int num_tiles; ///< number of discrete bins for action space.
         int num_weights; ///< number of discrete bins for state space.
+        int hidden_units; ///< number of hidden units of a network
+        bool mShared; ///< whether to learn into one approximator with the other agents from the same template
+        ApproximatorPtr mSharedModel; ///< the approximator shared with those agents
+        std::string mSharingKey; ///< the name of that approximator
+
+        /// @return the name of the approximator shared by the agents like this one
+        std::string SharingKey();
+
+        /// @return true if this brain writes its learned values when saved:
+        /// always, unless it shares them with a brain that already wrote
+        /// them to the same format during the open BrainSavePass
+        bool WritesLearned(SaveFormat format) const;
+
+        /// @return true if this brain learns into the shared approximator a
+        /// saved brain that did not write its values referred to
+        bool JoinsShared(const std::string& key) const;
+
+        /// @return a new approximator of the kind the bins, tiles, weights and hidden units ask for
+        static ApproximatorPtr CreateApproximator(const AgentInitInfo& info, int actions, int states, int tiles, int weights, int hidden);
 
     	// predicts reinforcement for current round
     	virtual double predict(const Observations& new_state) = 0;
@@ -50,7 +84,10 @@ namespace OpenNero
         /// @param epsilon parameter for the epsilon-greedy policy (between 0 and 1)
         /// @param actions number of bins for quantizing continuous action dimensions
         /// @param states number of bins for quantizing continuous state space dimensions
-        TDBrain(double gamma, double alpha, double epsilon, int actions, int states, int tiles, int weights)
+        /// @param tiles number of tilings, or 0 for a table (or, with states == 0, a network)
+        /// @param weights number of tile weights
+        /// @param hidden number of hidden units of a network (tiles == 0 and states == 0)
+        TDBrain(double gamma, double alpha, double epsilon, int actions, int states, int tiles, int weights, int hidden = 0)
         : AgentBrain()
         , mGamma(gamma)
         , mAlpha(alpha)
@@ -60,10 +97,15 @@ namespace OpenNero
         , action()
         , state()
         , new_action()
+        , action_values()
         , action_bins(actions)
         , state_bins(states)
         , num_tiles(tiles)
         , num_weights(weights)
+        , hidden_units(hidden)
+        , mShared(false)
+        , mSharedModel()
+        , mSharingKey()
         {}
 
         /// constructor
@@ -80,10 +122,15 @@ namespace OpenNero
         , action()
         , state()
         , new_action()
+        , action_values()
         , action_bins(3)
         , state_bins(5)
         , num_tiles(0)
         , num_weights(0)
+        , hidden_units(0)
+        , mShared(false)
+        , mSharedModel()
+        , mSharingKey()
         {}
 
         /// copy constructor
@@ -93,14 +140,19 @@ namespace OpenNero
         , mAlpha(agent.mAlpha)
         , mEpsilon(agent.mEpsilon)
         , mInfo(agent.mInfo)
-        , mApproximator(agent.mApproximator->copy())
+        , mApproximator(agent.mSharedModel ? agent.mSharedModel->share() : agent.mApproximator->copy())
         , action(agent.action)
         , state(agent.state)
         , new_action(agent.new_action)
+        , action_values()
         , action_bins(agent.action_bins)
         , state_bins(agent.state_bins)
         , num_tiles(agent.num_tiles)
         , num_weights(agent.num_weights)
+        , hidden_units(agent.hidden_units)
+        , mShared(agent.mShared)
+        , mSharedModel(agent.mSharedModel)
+        , mSharingKey(agent.mSharingKey)
         {}
 
         /// destructor
@@ -145,6 +197,20 @@ namespace OpenNero
         /// @return prob. of selecting a random action instead of the greedy one
         double getEpsilon() { return mEpsilon; }
 
+        /// Learn into one approximator with all the other agents made from
+        /// the same template that do so (set before the brain is initialized).
+        /// Saved within one BrainSavePass (a world snapshot, or a team saved
+        /// between begin_brain_save and end_brain_save), the first of these
+        /// agents writes the shared values and the others only refer to them.
+        /// @param shared whether to share the approximator
+        void setShared(bool shared) { mShared = shared; }
+
+        /// @return whether this brain shares its approximator
+        bool getShared() { return mShared; }
+
+        /// @return true if this brain learns into a shared approximator
+        bool SharesState() const { return bool(mSharedModel); }
+
         /// select action according to policy
         double epsilon_greedy(const Observations& new_state);
 
@@ -153,11 +219,56 @@ namespace OpenNero
 			{ return false; /* TODO: implement when we have better template */ }
 
         std::string to_string() const;
-        void from_string(const std::string& s);
 
-        /// serialize this object to/from a Boost serialization archive
+        /// load a brain saved by to_string
+        /// @return false if the string could not be read
+        bool from_string(const std::string& s);
+
+        /// save this brain to a file, as a compact binary archive or as the text of to_string
+        /// @return false if the file could not be written
+        bool to_file(const std::string& filename, bool binary = true) const;
+
+        /// load a brain saved by to_file, whichever way it was saved
+        /// @param mapped map a binary archive into memory instead of reading it
+        /// @return false if the file could not be read or does not fit this brain
+        bool from_file(const std::string& filename, bool mapped = false);
+
+        /// write the parameters and the learned values to a binary archive
+        void SaveBinary(BinaryWriter& out) const;
+
+        /// replace the parameters and the learned values with ones written by SaveBinary
+        bool LoadBinary(BinaryReader& in);
+
+        /// write the episode, the parameters and the learned values to a world snapshot
+        void SaveState(Bitstream& stream) const;
+
+        /// continue from a state written by SaveState
+        bool LoadState(Bitstream& stream);
+
+        /// serialize this object to a Boost serialization archive
+        template<class Archive>
+        void save(Archive & ar, const unsigned int version) const
+        {
+            ar & BOOST_SERIALIZATION_NVP(mGamma);
+            ar & BOOST_SERIALIZATION_NVP(mAlpha);
+            ar & BOOST_SERIALIZATION_NVP(mEpsilon);
+            ar & BOOST_SERIALIZATION_NVP(action_bins);
+            ar & BOOST_SERIALIZATION_NVP(state_bins);
+            ar & BOOST_SERIALIZATION_NVP(num_tiles);
+            ar & BOOST_SERIALIZATION_NVP(num_weights);
+            ar & BOOST_SERIALIZATION_NVP(hidden_units);
+            ar & BOOST_SERIALIZATION_NVP(mInfo);
+            ar & BOOST_SERIALIZATION_NVP(action_list);
+            // a brain that shares values another one wrote refers to them
+            const std::string shared_key = WritesLearned(kTextArchive) ? std::string() : mSharingKey;
+            ar & BOOST_SERIALIZATION_NVP(shared_key);
+            if (shared_key.empty())
+                ar & BOOST_SERIALIZATION_NVP(mApproximator);
+        }
+
+        /// serialize this object from a Boost serialization archive
         template<class Archive>
-        void serialize(Archive & ar, const unsigned int version)
+        void load(Archive & ar, const unsigned int version)
         {
             ar & BOOST_SERIALIZATION_NVP(mGamma);
             ar & BOOST_SERIALIZATION_NVP(mAlpha);
@@ -166,11 +277,34 @@ namespace OpenNero
             ar & BOOST_SERIALIZATION_NVP(state_bins);
             ar & BOOST_SERIALIZATION_NVP(num_tiles);
             ar & BOOST_SERIALIZATION_NVP(num_weights);
+            if (version > 1)
+            {
+                ar & BOOST_SERIALIZATION_NVP(hidden_units);
+            }
+            else
+            {
+                // networks used to keep their hidden units in num_weights
+                hidden_units = (num_tiles == 0 && state_bins == 0) ? num_weights : 0;
+                if (hidden_units > 0)
+                    num_weights = 0;
+            }
             ar & BOOST_SERIALIZATION_NVP(mInfo);
             ar & BOOST_SERIALIZATION_NVP(action_list);
-            ar & BOOST_SERIALIZATION_NVP(mApproximator);
+            std::string shared_key;
+            if (version > 0)
+                ar & BOOST_SERIALIZATION_NVP(shared_key);
+            if (shared_key.empty())
+                ar & BOOST_SERIALIZATION_NVP(mApproximator);
+            else if (!JoinsShared(shared_key))
+                throw boost::archive::archive_exception(boost::archive::archive_exception::other_exception);
         }
+
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 } // namespace OpenNero
 
+// version 1 may refer to shared values instead of holding them,
+// version 2 keeps the hidden units of a network apart from num_weights
+BOOST_CLASS_VERSION(OpenNero::TDBrain, 2)
+
 #endif // _OPENNERO_AI_RL_TD_H_
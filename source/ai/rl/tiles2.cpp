@@ -20,8 +20,8 @@ across integer values.
  
 It is recommended by the UNH folks that num-tilings be a power of 2, e.g., 16. 
  
-We assume the existence of a function "rand()" that produces successive
-random integers, of which we use only the low-order bytes.
+The hash adds up entries of a fixed table of random integers that is filled
+once, deterministically, during static initialization.
 */
 
 #include <iostream>
@@ -77,38 +77,58 @@ void GetTiles(
 }
 
 
+namespace
+{
+    /// The table of random numbers the hash adds up.
+    /// Filled once during static initialization, before any agent thread
+    /// can hash, and from a fixed-seed generator rather than rand() so that
+    /// every run (and every thread) indexes its weights through the same table.
+    struct UNHTable
+    {
+        unsigned int rndseq[2048];
+
+        UNHTable()
+        {
+            unsigned int state = 0x2545F491u;
+            for (int k = 0; k < 2048; k++)
+            {
+                rndseq[k] = 0;
+                for (int i = 0; i < (int)sizeof(int); ++i)
+                {
+                    // 32-bit linear congruential step (Numerical Recipes)
+                    state = state * 1664525u + 1013904223u;
+                    rndseq[k] = (rndseq[k] << 8) | ((state >> 24) & 0xff);
+                }
+            }
+        }
+    };
+
+    const UNHTable unh_table;
+}
+
+/// The random number hash_UNH adds to its sum for the value at a position of its array
+unsigned int hash_UNH_term(int value, int position, int increment)
+{
+    /* add random table offset for this dimension and wrap around */
+    long index = value;
+    index += (increment * position);
+    index %= 2048;
+    while (index < 0)
+        index += 2048;
+    return unh_table.rndseq[(int)index];
+}
+
 /// Takes an array of integers and returns the corresponding tile after hashing 
 int hash_UNH(const std::vector<int>& ints, long m, int increment)
 {
-    static unsigned int rndseq[2048];
-    static int first_call =  1;
-    int i,k;
+    int i;
     long index;
     long sum = 0;
 
-    /* if first call to hashing, initialize table of random numbers */
-    if (first_call)
-    {
-        for (k = 0; k < 2048; k++)
-        {
-            rndseq[k] = 0;
-            for (i=0; i < (int)sizeof(int); ++i)
-                rndseq[k] = (rndseq[k] << 8) | (rand() & 0xff);
-        }
-        first_call = 0;
-    }
-
     for (i = 0; i < ints.size(); i++)
     {
-        /* add random table offset for this dimension and wrap around */
-        index = ints[i];
-        index += (increment * i);
-        index %= 2048;
-        while (index < 0)
-            index += 2048;
-
         /* add selected random number to sum */
-        sum += (long)rndseq[(int)index];
+        sum += (long)hash_UNH_term(ints[i], i, increment);
     }
     index = (int)(sum % m);
     while (index < 0)
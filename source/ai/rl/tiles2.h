@@ -26,5 +26,11 @@ void GetTiles(
 
 int hash_UNH(const std::vector<int>& ints, long m, int increment);
 
+/// the random number hash_UNH adds to its sum for the value at a position of its array
+unsigned int hash_UNH_term(int value, int position, int increment);
+
+/// n mod k, non-negative for negative n
+int mod(int n, int k);
+
 #endif
 
@@ -0,0 +1,140 @@
+#include "core/Common.h"
+#include "ai/rtneat/IslandModel.h"
+#include "core/Bitstream.h"
+#include <boost/bind.hpp>
+
+namespace OpenNero
+{
+    namespace {
+        /// tick one island, called on a thread of the pool
+        void tick_island(const std::vector<RTNEATPtr>* islands, float32_t incAmt, size_t i)
+        {
+            (*islands)[i]->ProcessTick(incAmt);
+        }
+
+        /// champions leaving an island
+        struct Departure
+        {
+            size_t from; ///< index of the island they leave
+            std::vector<OrganismPtr> champions; ///< the emigrants, the fittest first
+        };
+    }
+
+    IslandModel::IslandModel(const MigrationPolicy& policy, size_t num_threads)
+        : mIslands()
+        , mLastMigration()
+        , mPolicy(policy)
+        , mNumThreads(num_threads)
+        , mThreadPool()
+    {
+    }
+
+    IslandModel::~IslandModel()
+    {
+    }
+
+    /// add an island to the end of the migration order
+    void IslandModel::add_island(RTNEATPtr island)
+    {
+        AssertMsg(island, "cannot add an empty island");
+        // the islands already tick in parallel, so each evolves on its own thread
+        island->set_serial(mNumThreads != 1);
+        mIslands.push_back(island);
+        mLastMigration.push_back(island->get_offspring_count());
+    }
+
+    /// @return the i'th island
+    RTNEATPtr IslandModel::get_island(size_t i) const
+    {
+        AssertMsg(i < mIslands.size(), "island " << i << " out of " << mIslands.size());
+        return mIslands[i];
+    }
+
+    /// send the champions of every island that is due
+    size_t IslandModel::migrate()
+    {
+        if (mPolicy.interval == 0 || mPolicy.migrants == 0 || mIslands.size() < 2)
+            return 0;
+
+        // pick all the emigrants before anybody arrives, so that a champion
+        // does not travel on to the next island in the same round
+        std::vector<Departure> departures;
+        for (size_t i = 0; i < mIslands.size(); ++i)
+        {
+            if (mIslands[i]->get_offspring_count() - mLastMigration[i] < mPolicy.interval)
+                continue;
+            departures.push_back(Departure());
+            departures.back().from = i;
+            mIslands[i]->get_champions(mPolicy.migrants, departures.back().champions);
+        }
+
+        size_t arrived = 0;
+        std::vector<size_t> received(mIslands.size(), 0);
+        for (size_t d = 0; d < departures.size(); ++d)
+        {
+            const Departure& departure = departures[d];
+            for (size_t k = 1; k < mIslands.size(); ++k)
+            {
+                size_t to = (departure.from + k) % mIslands.size();
+                for (size_t c = 0; c < departure.champions.size(); ++c)
+                {
+                    if (mIslands[to]->immigrate(departure.champions[c]))
+                        ++received[to];
+                }
+                if (mPolicy.topology == MigrationPolicy::MIGRATE_RING)
+                    break;
+            }
+        }
+
+        // immigrants do not count towards the next migration of their new island
+        for (size_t i = 0; i < mIslands.size(); ++i)
+        {
+            mLastMigration[i] += received[i];
+            arrived += received[i];
+        }
+        for (size_t d = 0; d < departures.size(); ++d)
+            mLastMigration[departures[d].from] = mIslands[departures[d].from]->get_offspring_count();
+
+        if (arrived > 0)
+            LOG_F_DEBUG("ai.rtneat.evolve", "islands: " << departures.size() << " sent champions, " << arrived << " arrived");
+        return arrived;
+    }
+
+    /// tick all the islands in parallel, then migrate
+    void IslandModel::ProcessTick( float32_t incAmt )
+    {
+        if (!mThreadPool)
+            mThreadPool.reset(new ThreadPool(mNumThreads));
+        mThreadPool->ParallelFor(mIslands.size(), boost::bind(&tick_island, &mIslands, incAmt, _1));
+        migrate();
+    }
+
+    void IslandModel::SaveState( Bitstream& stream ) const
+    {
+        stream << uint32_t(mIslands.size());
+        for (size_t i = 0; i < mIslands.size(); ++i)
+            mIslands[i]->SaveState(stream);
+    }
+
+    bool IslandModel::LoadState( Bitstream& stream )
+    {
+        uint32_t count;
+        stream >> count;
+        if (stream.Failed() || count != mIslands.size())
+            return false;
+        // put back the islands already read if a later one fails
+        Bitstream before;
+        SaveState(before);
+        for (size_t i = 0; i < mIslands.size(); ++i)
+        {
+            if (!mIslands[i]->LoadState(stream))
+            {
+                before >> count;
+                for (size_t j = 0; j < i; ++j)
+                    mIslands[j]->LoadState(before);
+                return false;
+            }
+        }
+        return true;
+    }
+}
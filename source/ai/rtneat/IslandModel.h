@@ -0,0 +1,101 @@
+/// @file
+/// Several rtNEAT populations evolving side by side with periodic migration.
+
+#ifndef _OPENNERO_AI_RTNEAT_ISLANDMODEL_H_
+#define _OPENNERO_AI_RTNEAT_ISLANDMODEL_H_
+
+#include "core/Preprocessor.h"
+#include "core/ThreadPool.h"
+#include "ai/AI.h"
+#include "ai/rtneat/rtNEAT.h"
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+
+namespace OpenNero
+{
+    /// @cond
+    BOOST_SHARED_DECL(IslandModel);
+    /// @endcond
+
+    /// How champions move between the islands of an IslandModel
+    struct MigrationPolicy
+    {
+        /// where the champions of an island go
+        enum Topology
+        {
+            MIGRATE_RING, ///< to the next island (the last one sends to the first)
+            MIGRATE_ALL   ///< to every other island
+        };
+
+        /// Constructor
+        /// @param interval reproductions an island makes between migrations (0 to never migrate)
+        /// @param migrants number of champions an island sends each time
+        /// @param topology where the champions go
+        explicit MigrationPolicy(size_t interval = 100, size_t migrants = 1, Topology topology = MIGRATE_RING)
+            : interval(interval), migrants(migrants), topology(topology) {}
+
+        size_t interval; ///< reproductions an island makes between migrations (0 to never migrate)
+        size_t migrants; ///< number of champions an island sends each time
+        Topology topology; ///< where the champions go
+    };
+
+    /// Runs several rtNEAT instances (islands), each with its own population,
+    /// on a pool of threads. Each island keeps its own agents, lifetime,
+    /// compatibility threshold and random stream, so the islands evolve
+    /// independently. Once an island has made MigrationPolicy::interval
+    /// reproductions since it last sent champions, copies of its fittest
+    /// organisms replace the worst organisms of the islands it sends to.
+    ///
+    /// The islands are ticked by the model, so they should not also be
+    /// registered with the AIManager on their own.
+    class IslandModel : public AI
+    {
+        std::vector<RTNEATPtr> mIslands;       ///< the islands, in migration order
+        std::vector<size_t> mLastMigration;    ///< offspring count of each island when it last sent champions
+        MigrationPolicy mPolicy;               ///< when and where champions move
+        size_t mNumThreads;                    ///< threads to tick the islands on (0 for one per core)
+        boost::scoped_ptr<ThreadPool> mThreadPool; ///< created on the first tick
+    public:
+        /// Constructor
+        /// @param policy when and where champions move between the islands
+        /// @param num_threads threads to tick the islands on (0 for one per core)
+        explicit IslandModel(const MigrationPolicy& policy = MigrationPolicy(), size_t num_threads = 0);
+
+        /// Destructor
+        ~IslandModel();
+
+        /// add an island to the end of the migration order; unless the
+        /// islands tick on one thread, it evolves on its own thread alone
+        void add_island(RTNEATPtr island);
+
+        /// @return the number of islands
+        size_t get_num_islands() const { return mIslands.size(); }
+
+        /// @return the i'th island
+        RTNEATPtr get_island(size_t i) const;
+
+        /// @return when and where champions move between the islands
+        const MigrationPolicy& get_policy() const { return mPolicy; }
+
+        /// change when and where champions move between the islands
+        void set_policy(const MigrationPolicy& policy) { mPolicy = policy; }
+
+        /// send the champions of every island that is due, as set by the policy
+        /// @return the number of organisms that were replaced by immigrants
+        size_t migrate();
+
+        /// tick all the islands in parallel, then migrate
+        virtual void ProcessTick( float32_t incAmt );
+
+        /// write the state of every island, in migration order
+        virtual void SaveState( Bitstream& stream ) const;
+
+        /// read the states written by SaveState
+        virtual bool LoadState( Bitstream& stream );
+
+        /// load info about this AI from the object template
+        bool LoadFromTemplate( ObjectTemplatePtr objTemplate, const SimEntityData& data) { return true; }
+    };
+}
+
+#endif /* _OPENNERO_AI_RTNEAT_ISLANDMODEL_H_ */
@@ -13,14 +13,7 @@ namespace OpenNero {
         , m_SumOfSquares(m_Zero)
         , m_Average(m_Zero)
         , m_StandardDeviation(m_Zero)
-        , m_Min(m_Zero)
-        , m_Max(m_Zero)
     {
-        for (size_t i = 0; i < m_Min.size(); ++i)
-        {
-            m_Min[i] = FLT_MAX;
-            m_Max[i] = -FLT_MAX;
-        }
     }
     
     ScoreHelper::~ScoreHelper()
@@ -34,11 +27,6 @@ namespace OpenNero {
         m_SumOfSquares = m_Zero;
         m_Average = m_Zero;
         m_StandardDeviation = m_Zero;    
-        for (size_t i = 0; i < m_Min.size(); ++i)
-        {
-            m_Min[i] = FLT_MAX;
-            m_Max[i] = -FLT_MAX;
-        }
     }
     
     void ScoreHelper::doCalculations()
@@ -60,7 +48,9 @@ namespace OpenNero {
     {
         if (m_SampleSize > 0) {
             for (size_t i = 0; i < m_StandardDeviation.size(); ++i) {
-                m_StandardDeviation[i] = sqrt( m_SumOfSquares[i] / m_SampleSize - m_Average[i] * m_Average[i]);
+                // removing samples can leave a tiny negative rounding error
+                double variance = m_SumOfSquares[i] / m_SampleSize - m_Average[i] * m_Average[i];
+                m_StandardDeviation[i] = variance > 0 ? sqrt(variance) : 0;
             }
         } else {
             m_StandardDeviation = m_Zero;
@@ -68,21 +58,34 @@ namespace OpenNero {
     }
     
     /// add a reward sample
-    void ScoreHelper::addSample(Reward sample)
+    void ScoreHelper::addSample(const Reward& sample)
     {
-        m_Total += sample;
         for (size_t i = 0; i < sample.size(); ++i)
         {
+            m_Total[i] += sample[i];
             m_SumOfSquares[i] += (sample[i] * sample[i]);
-            if (m_Min[i] > sample[i])
-                m_Min[i] = sample[i];
-            if (m_Max[i] < sample[i])
-                m_Max[i] = sample[i];
         }
         
         ++m_SampleSize;
     }
 
+    /// remove a reward sample that was added before
+    void ScoreHelper::removeSample(const Reward& sample)
+    {
+        Assert(m_SampleSize > 0);
+        if (--m_SampleSize == 0) {
+            // start over exactly instead of keeping the rounding errors
+            m_Total = m_Zero;
+            m_SumOfSquares = m_Zero;
+            return;
+        }
+        for (size_t i = 0; i < sample.size(); ++i)
+        {
+            m_Total[i] -= sample[i];
+            m_SumOfSquares[i] -= (sample[i] * sample[i]);
+        }
+    }
+
     /// preferred generic method
     Reward ScoreHelper::getRelativeScore(Reward absoluteScore) const
     {
@@ -98,6 +101,19 @@ namespace OpenNero {
         return result;
     }
 
+    /// weighted sum of the Z-scores, without building the score vector
+    double ScoreHelper::getWeightedScore(const Reward& absoluteScore, const FeatureVector& weights) const
+    {
+        double result = 0;
+        for (size_t i = 0; i < absoluteScore.size(); ++i)
+        {
+            if (m_StandardDeviation[i] > 0) {
+                result += (absoluteScore[i] - m_Average[i]) / m_StandardDeviation[i] * weights[i];
+            }
+        }
+        return result;
+    }
+
     /// Number of trials processed over the unit's lifetime
     Stats::Stats(const RewardInfo& info) 
         : m_NumLifetimeTrials(0)
@@ -10,6 +10,9 @@ namespace OpenNero
 
 
     /// Holdings scoring information
+    /// The totals are running sums, so samples can be added and removed one
+    /// at a time and doCalculations() updates the statistics in time
+    /// proportional to the number of reward dimensions only.
     class ScoreHelper {
     private:
 
@@ -19,8 +22,6 @@ namespace OpenNero
         Reward m_SumOfSquares;
         Reward m_Average;
         Reward m_StandardDeviation;
-        Reward m_Min;
-        Reward m_Max;
 
     public:
     
@@ -33,7 +34,10 @@ namespace OpenNero
         void calculateStandardDeviations();
 
         /// add a reward sample
-        void addSample(Reward sample);
+        void addSample(const Reward& sample);
+
+        /// remove a reward sample that was added before
+        void removeSample(const Reward& sample);
 
         /// average scores in all dimensions
         const Reward& getAverage() const { return m_Average; }
@@ -46,10 +50,9 @@ namespace OpenNero
 
         /// get the relative (scaled) Z-scores along the dimensions
         Reward getRelativeScore(Reward absoluteScore) const;
-        
-        const Reward& getMin() const { return m_Min; }
-        
-        const Reward& getMax() const { return m_Max; }
+
+        /// get the sum of the relative Z-scores weighted by the given weights
+        double getWeightedScore(const Reward& absoluteScore, const FeatureVector& weights) const;
     };
     
     class Stats
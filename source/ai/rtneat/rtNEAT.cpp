@@ -7,10 +7,15 @@
 #include "ai/rtneat/rtNEAT.h"
 #include "rtneat/population.h"
 #include "rtneat/network.h"
+#include "rtneat/snapshot.h"
 #include "scripting/scriptIncludes.h"
 #include "math/Random.h"
+#include "core/Bitstream.h"
 #include <ostream>
 #include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/algorithm/string/predicate.hpp>
 
 namespace OpenNero
 {
@@ -27,12 +32,49 @@ namespace OpenNero
         const size_t kNumSpeciesTarget = 5; ///< target number of species in the population
         const double kCompatMod = 0.1; ///< compatibility threshold modifier
         const double kMinCompatThreshold = 0.3; // minimum species compatibility threshold
+        const char* kSnapshotExtension = ".snap"; ///< populations saved under this extension are binary snapshots
+
+        /// a contiguous buffer of doubles exported by a Python object, such
+        /// as a float64 numpy array or an array.array('d')
+        class DoubleBuffer
+        {
+        public:
+            DoubleBuffer(py::object obj, bool writable)
+            {
+                int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+                if (PyObject_GetBuffer(obj.ptr(), &mView, flags) != 0)
+                    py::throw_error_already_set();
+                // native doubles only
+                const char* format = mView.format ? mView.format : "B";
+                if (*format == '@' || *format == '=')
+                    ++format;
+                if (std::string(format) != "d" || mView.itemsize != sizeof(F64))
+                {
+                    PyBuffer_Release(&mView);
+                    PyErr_SetString(PyExc_TypeError, "expected a contiguous buffer of doubles");
+                    py::throw_error_already_set();
+                }
+            }
+            ~DoubleBuffer() { PyBuffer_Release(&mView); }
+            F64* data() const { return static_cast<F64*>(mView.buf); }
+            size_t size() const { return mView.len / sizeof(F64); }
+        private:
+            Py_buffer mView;
+            DoubleBuffer(const DoubleBuffer&);
+            DoubleBuffer& operator=(const DoubleBuffer&);
+        };
 
         /// compare two organisms by fitness
         bool fitness_less(OrganismPtr a, OrganismPtr b)
         {
             return a->fitness < b->fitness;
         }
+
+        /// compare two organisms by fitness, the fitter first
+        bool fitness_greater(const OrganismPtr& a, const OrganismPtr& b)
+        {
+            return a->fitness > b->fitness;
+        }
     }
 
     /// Constructor
@@ -50,31 +92,37 @@ namespace OpenNero
         , mWaitingBrainList()
         , mBrainList()
         , mBrainBodyMap()
+        , mOrganismBrains()
+        , mFieldedNets()
         , mOffspringCount(population_size)
         , mSpawnTickCount(0)
         , mEvolutionTickCount(0)
         , mTotalUnitsDeleted(0)
         , mUnitsToDeleteBeforeFirstJudgment(population_size)
-        , mTimeBetweenEvolutions(NEAT::time_alive_minimum)
+        , mTimeBetweenEvolutions(0)
         , mRewardInfo(reward_info)
         , mFitnessWeights(reward_info.size())
         , mEvolutionEnabled(true)
         , mChampionId(-1)
+        , mScoreHelper(reward_info)
+        , mScoredBrains()
+        , mChampion(NULL)
+        , mScoresChanged(false)
         , mGenerational(generational)
+        , mSerial(false)
     {
         NEAT::load_neat_params(Kernel::findResource(param_file));
         NEAT::pop_size = population_size;
         std::string pop_fname = Kernel::findResource(filename);
-        mPopulation.reset(new Population(pop_fname, population_size));
+        if (is_population_snapshot(pop_fname))
+            mPopulation = load_population_snapshot(pop_fname);
+        else
+            mPopulation.reset(new Population(pop_fname, population_size));
         AssertMsg(mPopulation, "initial population creation failed");
         mOffspringCount = mPopulation->organisms.size();
         AssertMsg(mOffspringCount == population_size, "population has " << mOffspringCount << " organisms instead of " << population_size);
-        for (size_t i = 0; i < mPopulation->organisms.size(); ++i)
-        {
-            PyOrganismPtr brain(new PyOrganism(mPopulation->organisms[i], reward_info));
-            mWaitingBrainList.push(brain);
-            mBrainList.push_back(brain);
-        }
+        mTimeBetweenEvolutions = mPopulation->params.time_alive_minimum;
+        createBrains();
     }
 
     /// Constructor
@@ -96,16 +144,24 @@ namespace OpenNero
         , mWaitingBrainList()
         , mBrainList()
         , mBrainBodyMap()
+        , mOrganismBrains()
+        , mFieldedNets()
         , mOffspringCount(0)
         , mSpawnTickCount(0)
         , mEvolutionTickCount(0)
         , mTotalUnitsDeleted(0)
         , mUnitsToDeleteBeforeFirstJudgment(population_size)
-        , mTimeBetweenEvolutions(NEAT::time_alive_minimum)
+        , mTimeBetweenEvolutions(0)
         , mRewardInfo(reward_info)
         , mFitnessWeights(reward_info.size())
         , mEvolutionEnabled(true)
+        , mChampionId(-1)
+        , mScoreHelper(reward_info)
+        , mScoredBrains()
+        , mChampion(NULL)
+        , mScoresChanged(false)
         , mGenerational(generational)
+        , mSerial(false)
     {
         NEAT::load_neat_params(Kernel::findResource(param_file));
         NEAT::pop_size = population_size;
@@ -114,12 +170,8 @@ namespace OpenNero
         AssertMsg(mPopulation, "initial population creation failed");
         mOffspringCount = mPopulation->organisms.size();
         AssertMsg(mOffspringCount == population_size, "population has " << mOffspringCount << " organisms instead of " << population_size);
-        for (size_t i = 0; i < mPopulation->organisms.size(); ++i)
-        {
-            PyOrganismPtr brain(new PyOrganism(mPopulation->organisms[i], reward_info));
-            mWaitingBrainList.push(brain);
-            mBrainList.push_back(brain);
-        }
+        mTimeBetweenEvolutions = mPopulation->params.time_alive_minimum;
+        createBrains();
     }
 
     /// Destructor
@@ -154,10 +206,11 @@ namespace OpenNero
     py::list PyNetwork::get_outputs()
     {
         py::list l;
-        std::vector<NNodePtr>::const_iterator iter;
-        for (iter = mNetwork->outputs.begin(); iter != mNetwork->outputs.end(); ++iter)
+        std::vector<double> outputs;
+        mNetwork->get_outputs(outputs);
+        for (size_t i = 0; i < outputs.size(); ++i)
             {
-                l.append((*iter)->get_active_out());
+                l.append(outputs[i]);
             }
         return l;
     }
@@ -174,14 +227,57 @@ namespace OpenNero
         return output;
     }
 
-    /// load the population from a file
+    /// load the population from a file, either a binary snapshot or text genomes
     bool RTNEAT::load_population(const std::string& pop_file)
     {
         std::string fname = Kernel::findResource(pop_file, false);
-        mPopulation.reset(new Population(fname));
+        PopulationPtr population;
+        const bool snapshot = is_population_snapshot(fname);
+        try
+        {
+            if (snapshot)
+                population = load_population_snapshot(fname);
+            else
+                population.reset(new Population(fname));
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Could not load population from " << fname << ": " << e.what());
+            return false;
+        }
+        // the lifetime and the compatibility threshold belong to this rtNEAT,
+        // not to the file; a snapshot continues its own random stream
+        MTRand::uint32 randgen[MTRand::SAVE];
+        population->params.randgen.save(randgen);
+        population->params = mPopulation->params;
+        if (snapshot)
+            population->params.randgen.load(randgen);
+        mPopulation = population;
+        LOG_F_MSG("ai.rtneat", "Loaded population from file: " << fname);
+        createBrains();
         return true;
     }
 
+    /// wrap every organism of the population in a brain that waits to be fielded
+    void RTNEAT::createBrains()
+    {
+        mWaitingBrainList = queue<PyOrganismPtr>();
+        mBrainList.clear();
+        mBrainBodyMap.clear();
+        mOrganismBrains.clear();
+        mScoreHelper.reset();
+        mScoredBrains.clear();
+        mChampion = NULL;
+        mScoresChanged = false;
+        for (size_t i = 0; i < mPopulation->organisms.size(); ++i)
+        {
+            PyOrganismPtr brain(new PyOrganism(mPopulation->organisms[i], mRewardInfo));
+            mWaitingBrainList.push(brain);
+            mBrainList.push_back(brain);
+            mOrganismBrains[mPopulation->organisms[i]] = brain;
+        }
+    }
+
     /// are we ready to spawn a new organism?
     bool RTNEAT::ready()
     {
@@ -233,9 +329,74 @@ namespace OpenNero
         }
     }
 
-    /// save a population to a file
+    /// the ids of the fielded bodies, in the order of the rows of activate_all
+    py::list RTNEAT::fielded_bodies() const
+    {
+        py::list bodies;
+        typedef BrainBodyMap::left_map::const_iterator const_iterator;
+        for (const_iterator iter = mBrainBodyMap.left.begin(); iter != mBrainBodyMap.left.end(); ++iter)
+            bodies.append(iter->first->GetId());
+        return bodies;
+    }
+
+    /// activate the networks of all the fielded agents in one call
+    size_t RTNEAT::activate_all(py::object sensors, py::object outputs)
+    {
+        DoubleBuffer in(sensors, false);
+        DoubleBuffer out(outputs, true);
+        size_t rows = mBrainBodyMap.size();
+        if (rows == 0)
+            return 0;
+
+        // the networks of a population all have the same inputs and outputs
+        const NetworkPtr& net = mBrainBodyMap.left.begin()->second->GetOrganism()->net;
+        size_t num_inputs = net->inputs.size();
+        size_t num_outputs = net->outputs.size();
+        if (in.size() != rows * num_inputs || out.size() != rows * num_outputs)
+        {
+            stringstream ss;
+            ss << "expected " << rows << " rows of " << num_inputs << " sensors and "
+               << num_outputs << " outputs, got buffers of " << in.size() << " and " << out.size() << " values";
+            PyErr_SetString(PyExc_ValueError, ss.str().c_str());
+            py::throw_error_already_set();
+        }
+        return activate_all(in.data(), num_inputs, out.data(), num_outputs);
+    }
+
+    /// activate the networks of all the fielded agents in one call
+    size_t RTNEAT::activate_all(const F64* sensors, size_t num_inputs, F64* outputs, size_t num_outputs)
+    {
+        // look up the networks once, in the order of the rows
+        mFieldedNets.clear();
+        typedef BrainBodyMap::left_map::const_iterator const_iterator;
+        for (const_iterator iter = mBrainBodyMap.left.begin(); iter != mBrainBodyMap.left.end(); ++iter)
+            mFieldedNets.push_back(iter->second->GetOrganism()->net);
+        Network::activate_all(mFieldedNets, sensors, num_inputs, outputs, num_outputs);
+        size_t rows = mFieldedNets.size();
+        // keep the room, but not the networks
+        mFieldedNets.clear();
+        return rows;
+    }
+
+    /// save a population to a file, as a binary snapshot if the name ends in .snap
     std::string RTNEAT::save_population(const std::string& pop_file)
     {
+        if (boost::algorithm::iends_with(pop_file, kSnapshotExtension))
+        {
+            std::string fname = pop_file;
+            if (!save_population_snapshot(mPopulation, fname))
+            {
+                fname = Kernel::findResource(pop_file, false);
+                if (!save_population_snapshot(mPopulation, fname))
+                {
+                    LOG_ERROR("Could not open file: " << fname);
+                    return "";
+                }
+            }
+            LOG_F_MSG("ai.rtneat", "Saving population snapshot to file: " << fname);
+            return fname;
+        }
+
         // try looking for the filename as is
         std::string fname = pop_file;
         std::ofstream output(fname.c_str());
@@ -269,10 +430,8 @@ namespace OpenNero
         BrainBodyMap::right_map::const_iterator found = mBrainBodyMap.right.find(brain);
 
         if (found != mBrainBodyMap.right.end()) {
-            SimId body_id = found->second->GetId();
-            U32 brain_id = brain->GetId();
             LOG_F_DEBUG("ai.rtneat",
-                        "remove brain: " << brain_id << " from body: " << body_id);
+                        "remove brain: " << brain->GetId() << " from body: " << found->second->GetId());
 
             // disconnect brain from body
             mBrainBodyMap.right.erase(brain);
@@ -296,6 +455,30 @@ namespace OpenNero
         }
     }
 
+    void RTNEAT::SaveState( Bitstream& stream ) const
+    {
+        MTRand::uint32 state[MTRand::SAVE];
+        mPopulation->params.randgen.save(state);
+        for (size_t i = 0; i < MTRand::SAVE; ++i)
+            stream << uint32_t(state[i]);
+    }
+
+    bool RTNEAT::LoadState( Bitstream& stream )
+    {
+        MTRand::uint32 state[MTRand::SAVE];
+        for (size_t i = 0; i < MTRand::SAVE; ++i)
+        {
+            uint32_t word;
+            stream >> word;
+            state[i] = word;
+        }
+        // the last word counts the numbers left before the next reload
+        if (stream.Failed() || state[MTRand::N] > MTRand::N)
+            return false;
+        mPopulation->params.randgen.load(state);
+        return true;
+    }
+
     void RTNEAT::ProcessTick( float32_t incAmt )
     {
         // Increment the spawn tick and evolution tick counters
@@ -322,61 +505,63 @@ namespace OpenNero
 
     void RTNEAT::evaluateAll()
     {
-        // Calculate the Z-score
-        ScoreHelper scoreHelper(mRewardInfo);
-
-
-        for (vector<PyOrganismPtr>::iterator iter = mBrainList.begin(); iter != mBrainList.end(); ++iter)
-        {
-            PyOrganismPtr brain = *iter;
-            if (brain->GetOrganism()->time_alive >= NEAT::time_alive_minimum) {
-                size_t time_alive = brain->GetOrganism()->time_alive;
-                if ( time_alive % NEAT::time_alive_minimum == 0 && time_alive > 0 )
-                {
-                    stringstream ss;
-                    ss << "NEW TRIAL: brain: " << brain->GetId();
-                    ss << " stats: " << brain->mStats;
-                    ss << " time_alive: " << time_alive << "/" << NEAT::time_alive_minimum;
-                    brain->mStats.startNextTrial();
-                    ss << " new stats: " << brain->mStats;
-                    LOG_F_DEBUG("ai.rtneat", ss.str());
-                }
-                Reward stats = brain->mStats.getStats();
-                scoreHelper.addSample(stats);
+        // only the fielded brains age and finish trials, so only their stats
+        // can have changed since the last tick
+        size_t lifetime = mPopulation->params.time_alive_minimum;
+        typedef BrainBodyMap::left_map::const_iterator const_iterator;
+        for( const_iterator
+                 iter = mBrainBodyMap.left.begin(),
+                 iend = mBrainBodyMap.left.end();
+             iter != iend;
+             ++iter ) {
+            PyOrganism& brain = *iter->second;
+            size_t time_alive = brain.GetTimeAlive();
+            bool scored = time_alive >= lifetime;
+            bool new_trial = scored && time_alive % lifetime == 0 && time_alive > 0;
+            if (new_trial)
+            {
+                stringstream ss;
+                ss << "NEW TRIAL: brain: " << brain.GetId();
+                ss << " stats: " << brain.mStats;
+                ss << " time_alive: " << time_alive << "/" << lifetime;
+                brain.mStats.startNextTrial();
+                ss << " new stats: " << brain.mStats;
+                LOG_F_DEBUG("ai.rtneat", ss.str());
+            }
+            if (new_trial || scored != (brain.mScoredIndex >= 0))
+            {
+                scoreBrain(brain, scored);
             }
         }
 
-        scoreHelper.doCalculations();
+        // the Z-scores only move when some stats or the weights change
+        if (!mScoresChanged)
+            return;
+        mScoresChanged = false;
+
+        // Calculate the Z-score
+        mScoreHelper.doCalculations();
 
         F32 minAbsoluteScore = 0; // min of 0, min abs score
         F32 maxAbsoluteScore = -FLT_MAX; // max raw score
 
-        size_t evaluated = 0;
+        PyOrganism* champ = NULL;
 
-        PyOrganismPtr champ;
-
-        for (vector<PyOrganismPtr>::iterator iter = mBrainList.begin(); iter != mBrainList.end(); ++iter) {
-            PyOrganismPtr brain = *iter;
-            // reset champion flag
-            brain->champion = false;
-            if (brain->GetOrganism()->time_alive >= NEAT::time_alive_minimum) {
-                brain->mAbsoluteScore = 0;
-                ++evaluated;
-                Reward stats = brain->mStats.getStats();
-                Reward relative_score = scoreHelper.getRelativeScore(stats);
-                for (size_t i = 0; i < relative_score.size(); ++i)
-                {
-                    brain->mAbsoluteScore += relative_score[i] * mFitnessWeights[i];
-                }
-                if (brain->mAbsoluteScore < minAbsoluteScore)
-                    minAbsoluteScore = brain->mAbsoluteScore;
-                if (brain->mAbsoluteScore > maxAbsoluteScore) {
-                    maxAbsoluteScore = brain->mAbsoluteScore;
-                    champ = brain;
-                }
+        for (size_t i = 0; i < mScoredBrains.size(); ++i) {
+            PyOrganism& brain = *mScoredBrains[i];
+            brain.mAbsoluteScore = mScoreHelper.getWeightedScore(brain.mScoredStats, mFitnessWeights);
+            if (brain.mAbsoluteScore < minAbsoluteScore)
+                minAbsoluteScore = brain.mAbsoluteScore;
+            if (brain.mAbsoluteScore > maxAbsoluteScore) {
+                maxAbsoluteScore = brain.mAbsoluteScore;
+                champ = &brain;
             }
         }
 
+        // move the champion flag
+        if (mChampion)
+            mChampion->champion = false;
+        mChampion = champ;
         if (champ) {
             champ->champion = true;
             if (mChampionId != champ->GetId()) {
@@ -390,36 +575,76 @@ namespace OpenNero
             }
         }
 
-        //if (scoreHelper.getSampleSize() > 0 && evaluated > 0)
+        //if (mScoreHelper.getSampleSize() > 0)
         //{
-        //    LOG_F_DEBUG("ai.rtneat", "brains: " << mBrainList.size() << " active: " << mBrainBodyMap.size() << " waiting: " << mWaitingBrainList.size() << " evaluated: " << evaluated);
+        //    LOG_F_DEBUG("ai.rtneat", "brains: " << mBrainList.size() << " active: " << mBrainBodyMap.size() << " waiting: " << mWaitingBrainList.size() << " evaluated: " << mScoredBrains.size());
         //    if (minAbsoluteScore != maxAbsoluteScore) {
         //        LOG_F_DEBUG("ai.rtneat",
         //                    "z-min: " << minAbsoluteScore <<
         //                    " z-max: " << maxAbsoluteScore <<
-        //                    " r-min: " << scoreHelper.getMin() <<
-        //                    " r-max: " << scoreHelper.getMax() <<
         //                    " w: " << mFitnessWeights <<
-        //                    " mean: " << scoreHelper.getAverage() <<
-        //                    " stdev: " << scoreHelper.getStandardDeviation());
+        //                    " mean: " << mScoreHelper.getAverage() <<
+        //                    " stdev: " << mScoreHelper.getStandardDeviation());
         //    }
         //}
 
-        for (vector<PyOrganismPtr>::iterator iter = mBrainList.begin(); iter != mBrainList.end(); ++iter) {
-            if ((*iter)->GetOrganism()->time_alive >= NEAT::time_alive_minimum) {
-                F32 modifiedFitness = (*iter)->mAbsoluteScore - (minAbsoluteScore < 0 ? minAbsoluteScore : 0);
+        for (size_t i = 0; i < mScoredBrains.size(); ++i) {
+            PyOrganism& brain = *mScoredBrains[i];
+            F32 modifiedFitness = brain.mAbsoluteScore - (minAbsoluteScore < 0 ? minAbsoluteScore : 0);
+            OrganismPtr org = brain.GetOrganism();
 
-                if (!((*iter)->GetOrganism()->smited)) {
-                    (*iter)->GetOrganism()->fitness = modifiedFitness;
-                } else {
-                    (*iter)->GetOrganism()->fitness = 0.01 * modifiedFitness;
-                }
+            // only the organisms whose fitness changed move in the removal index
+            if (!org->smited) {
+                mPopulation->set_fitness(org, modifiedFitness);
+            } else {
+                mPopulation->set_fitness(org, 0.01 * modifiedFitness);
             }
         }
     }
 
+    void RTNEAT::scoreBrain(PyOrganism& brain, bool scored)
+    {
+        bool was_scored = brain.mScoredIndex >= 0;
+        if (was_scored)
+        {
+            mScoreHelper.removeSample(brain.mScoredStats);
+            if (!scored)
+            {
+                // move the last scored brain into its place
+                PyOrganism* last = mScoredBrains.back();
+                mScoredBrains[brain.mScoredIndex] = last;
+                last->mScoredIndex = brain.mScoredIndex;
+                mScoredBrains.pop_back();
+                brain.mScoredIndex = -1;
+            }
+        }
+        else if (scored)
+        {
+            brain.mScoredIndex = mScoredBrains.size();
+            mScoredBrains.push_back(&brain);
+        }
+        if (scored != was_scored)
+        {
+            // it may have become old enough to be removed, or too young; its
+            // fitness may not change, so the removal index has to hear it here
+            mPopulation->update_organism(brain.GetOrganism());
+        }
+        if (scored)
+        {
+            // copy into the preallocated sample rather than allocating a new one
+            const Reward& stats = brain.mStats.getStats();
+            std::copy(stats.begin(), stats.end(), brain.mScoredStats.begin());
+            mScoreHelper.addSample(brain.mScoredStats);
+        }
+        mScoresChanged = true;
+    }
+
     void RTNEAT::evolveAll()
     {
+        // draw from the random stream of this population, so that rtNEATs
+        // evolving on other threads do not disturb it
+        ScopedRandGen stream(mPopulation->params.randgen);
+
         // Remove the worst organism
         OrganismPtr deadorg = mPopulation->remove_worst();
 
@@ -441,7 +666,7 @@ namespace OpenNero
 
             // Estimate all species' fitnesses
             for (vector<SpeciesPtr>::iterator curspec = (mPopulation->species).begin(); curspec != (mPopulation->species).end(); ++curspec) {
-                (*curspec)->estimate_average();
+                (*curspec)->estimate_average(mPopulation->params.time_alive_minimum);
             }
 
             // TODO: milestoning is not implemented for now
@@ -466,55 +691,98 @@ namespace OpenNero
                 F64 compat_mod=0.1;  //Modify compat thresh to control speciation
 
                 // This tinkers with the compatibility threshold, which normally would be held constant
+                F64& compat_threshold = mPopulation->params.compat_threshold;
                 if (num_species < num_species_target)
-                    NEAT::compat_threshold -= compat_mod;
+                    compat_threshold -= compat_mod;
                 else if (num_species > num_species_target)
-                    NEAT::compat_threshold += compat_mod;
+                    compat_threshold += compat_mod;
 
-                if (NEAT::compat_threshold < 0.3)
-                    NEAT::compat_threshold = 0.3;
+                if (compat_threshold < 0.3)
+                    compat_threshold = 0.3;
 
                 //Go through entire population, reassigning organisms to new species
-                vector<OrganismPtr>::iterator curorg = mPopulation->organisms.begin();
-                vector<OrganismPtr>::iterator orgend = mPopulation->organisms.end();
-                for (; curorg != orgend; ++curorg) {
-                    mPopulation->reassign_species(*curorg);
-                }
+                mPopulation->reassign_all_species(mSerial ? 1 : NEAT::num_threads);
             }
 
-            // Iterate through all of the Brains
-            //   - find the one whose Organism was killed off
-            //   - link that Brain to the newly created Organism, effectively
-            //     doing a "hot swap" of the Organisms in that Brain.
-            LOG_F_DEBUG("ai.rtneat", "print out population after evolveAll");
-            for (vector<PyOrganismPtr>::iterator iter = mBrainList.begin(); iter != mBrainList.end(); ++iter) {
-                PyOrganismPtr brain = *iter;
-                if (brain->GetOrganism() == deadorg) {
-                    LOG_F_DEBUG("ai.rtneat", "  DELETING Organims #"<< brain->GetId() << " Fitness: " << brain->GetFitness() << " Time: "<< brain->GetTimeAlive());
-                    brain->SetOrganism(new_org);
-                    brain->mStats.resetAll();
-                    deleteUnit(brain);
-                    //break;
-                } else {
-                    LOG_F_DEBUG("ai.rtneat", "  Organims #"<< brain->GetId() << " Fitness: " << brain->GetFitness() << " Time: "<< brain->GetTimeAlive());
-                }
-            }
+            swapOrganism(deadorg, new_org);
+        }
+    }
+
+    /// Find the Brain whose Organism was killed off and link it to
+    /// the newly created Organism, effectively doing a "hot swap" of
+    /// the Organisms in that Brain.
+    void RTNEAT::swapOrganism(const OrganismPtr& deadorg, const OrganismPtr& new_org)
+    {
+        OrganismBrainMap::iterator found = mOrganismBrains.find(deadorg);
+        if (found != mOrganismBrains.end()) {
+            PyOrganismPtr brain = found->second;
+            mOrganismBrains.erase(found);
+            LOG_F_DEBUG("ai.rtneat", "  DELETING Organims #"<< brain->GetId() << " Fitness: " << brain->GetFitness() << " Time: "<< brain->GetTimeAlive());
+            brain->SetOrganism(new_org);
+            mOrganismBrains[new_org] = brain;
+            brain->mStats.resetAll();
+            if (brain->mScoredIndex >= 0)
+                scoreBrain(*brain, false);
+            deleteUnit(brain);
         }
     }
 
+    /// the fittest organisms that have lived long enough to be judged, the fittest first
+    void RTNEAT::get_champions(size_t count, vector<OrganismPtr>& champions) const
+    {
+        champions.clear();
+        S32 lifetime = mPopulation->params.time_alive_minimum;
+        for (size_t i = 0; i < mPopulation->organisms.size(); ++i)
+            if (mPopulation->organisms[i]->time_alive >= lifetime)
+                champions.push_back(mPopulation->organisms[i]);
+        if (champions.size() > count) {
+            std::partial_sort(champions.begin(), champions.begin() + count, champions.end(), fitness_greater);
+            champions.resize(count);
+        } else {
+            std::sort(champions.begin(), champions.end(), fitness_greater);
+        }
+    }
+
+    /// replace the worst organism with a copy of an organism from another population
+    bool RTNEAT::immigrate(const OrganismPtr& migrant)
+    {
+        ScopedRandGen stream(mPopulation->params.randgen);
+
+        OrganismPtr deadorg = mPopulation->remove_worst();
+        if (!deadorg)
+            return false;
+
+        GenomePtr genome = migrant->gnome->duplicate(mOffspringCount);
+        OrganismPtr new_org(new Organism(0.0, genome, mOffspringCount));
+        ++mOffspringCount;
+
+        // keep the innovations of this population from reusing the numbers of the newcomer
+        mPopulation->cur_node_id = std::max(mPopulation->cur_node_id, genome->get_last_node_id());
+        if (!genome->genes.empty())
+            mPopulation->cur_innov_num = std::max(mPopulation->cur_innov_num, genome->get_last_gene_innovnum());
+
+        mPopulation->add_organism(new_org);
+        LOG_F_DEBUG("ai.rtneat.evolve", "immigrant: " << migrant->gnome->genome_id << " replaces: " << deadorg->gnome->genome_id);
+        swapOrganism(deadorg, new_org);
+        return true;
+    }
+
     /// set the lifetime so that we can ensure that the units have been alive
     /// at least that long before evaluating them
     void RTNEAT::set_lifetime(size_t lifetime)
     {
-        // TODO: currently this will make it impossible to have more than one
-        //       rtNEAT with different lifetimes at the same time, but changing it
-        //       to a local value requires making changes to the code in source/rtneat
-        //       as well.
         if (lifetime > 0) {
-            NEAT::time_alive_minimum = lifetime;
+            mPopulation->params.time_alive_minimum = lifetime;
             mTimeBetweenEvolutions = (F32)lifetime / FRACTION_POPULATION_INELIGIBLE_ALLOWED / (F32)(mPopulation->organisms.size());
+            // the new lifetime can change which of the brains are old enough to be scored
+            for (vector<PyOrganismPtr>::iterator iter = mBrainList.begin(); iter != mBrainList.end(); ++iter) {
+                PyOrganism& brain = **iter;
+                bool scored = (size_t)brain.GetTimeAlive() >= lifetime;
+                if (scored != (brain.mScoredIndex >= 0))
+                    scoreBrain(brain, scored);
+            }
             LOG_F_DEBUG("ai.rtneat",
-                "time_alive_minimum: " << NEAT::time_alive_minimum <<
+                "time_alive_minimum: " << lifetime <<
                 " mTimeBetweenEvolutions: " << mTimeBetweenEvolutions);
         }
     }
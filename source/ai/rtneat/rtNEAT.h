@@ -16,6 +16,7 @@
 #include <iostream>
 #include <boost/python.hpp>
 #include <boost/bimap.hpp>
+#include <boost/unordered_map.hpp>
 
 namespace OpenNero
 {
@@ -33,12 +34,17 @@ namespace OpenNero
     /// A bi-directional map associating AIObjects (bodies) with PyOrganisms (rtNEAT brains)
     typedef boost::bimap<AIObjectPtr, PyOrganismPtr> BrainBodyMap;
 
+    /// A map from rtNEAT organisms to the brains that hold them
+    typedef boost::unordered_map<OrganismPtr, PyOrganismPtr> OrganismBrainMap;
+
     /// An interface for the RTNEAT learning algorithm
     class RTNEAT : public AI {
         PopulationPtr mPopulation;        ///< population of organisms
         queue<PyOrganismPtr> mWaitingBrainList; ///< queue of organisms to be evaluated
         vector<PyOrganismPtr> mBrainList; ///< all the organisms along with their stats
         BrainBodyMap mBrainBodyMap;       ///< map from agents to organisms
+        OrganismBrainMap mOrganismBrains; ///< map from organisms to the brains holding them
+        vector<NetworkPtr> mFieldedNets;  ///< the networks of the fielded bodies, reused by activate_all
         size_t mOffspringCount;           ///< number of reproductions so far
 		size_t mSpawnTickCount;           ///< number of spawn ticks
 		size_t mEvolutionTickCount;       ///< number of evolution ticks
@@ -51,7 +57,13 @@ namespace OpenNero
 
         S32 mChampionId; ///< the id of the last champion of the population
 
+        ScoreHelper mScoreHelper;         ///< running Z-score statistics of the scored brains
+        vector<PyOrganism*> mScoredBrains; ///< brains old enough to be scored, in no particular order
+        PyOrganism* mChampion;            ///< the scored brain with the highest score
+        bool mScoresChanged;              ///< whether the scores changed since fitness was last assigned
+
         bool mGenerational;               ///< whether to run NEAT in generational or realtime mode
+        bool mSerial;                     ///< whether to evolve on the ticking thread alone
     public:
         /// Constructor
         /// @param filename name of the file with the initial population genomes
@@ -101,21 +113,49 @@ namespace OpenNero
         /// release the organism that was being used by the agent
         void release_organism(AgentBrainPtr agent);
 
+        /// @return the ids of the fielded bodies, in the order of the rows of activate_all
+        py::list fielded_bodies() const;
+
+        /// activate the networks of all the fielded agents in one call
+        /// @param sensors a contiguous buffer of doubles (such as a float64 numpy array)
+        ///        with a row of sensor values for each body, in fielded_bodies order
+        /// @param outputs a writable contiguous buffer of doubles that receives a row
+        ///        of network outputs for each body
+        /// @return the number of bodies activated
+        size_t activate_all(py::object sensors, py::object outputs);
+
+        /// activate the networks of all the fielded agents in one call
+        /// @param sensors row-major buffer with num_inputs sensor values per body, in fielded_bodies order
+        /// @param num_inputs number of sensor values in each row
+        /// @param outputs row-major buffer that receives num_outputs network outputs per body
+        /// @param num_outputs number of outputs in each row
+        /// @return the number of bodies activated
+        size_t activate_all(const F64* sensors, size_t num_inputs, F64* outputs, size_t num_outputs);
+
         /// Called every step by the OpenNERO system
         virtual void ProcessTick( float32_t incAmt );
 
-        /// save the current population to a file
+        /// write the state of the random stream of the population
+        virtual void SaveState( Bitstream& stream ) const;
+
+        /// read the state of the random stream of the population
+        virtual bool LoadState( Bitstream& stream );
+
+        /// save the current population to a file, as a binary snapshot
+        /// if the file name ends in .snap and as text genomes otherwise
 		/// return the name of the file the population was saved to
 		std::string save_population(const std::string& population_file);
 
-        /// load a population from a file
+        /// load a population from a file written by save_population
+        /// (the format is detected from the contents of the file)
+        /// and give every organism a fresh brain
         bool load_population(const std::string& population_file);
 
         /// get the weight vector
         const FeatureVector& get_weights() const { return mFitnessWeights; }
 
         /// set the i'th weight
-        void set_weight(size_t i, double weight) { mFitnessWeights[i] = weight; }
+        void set_weight(size_t i, double weight) { mFitnessWeights[i] = weight; mScoresChanged = true; }
 
         /// set the lifetime so that we can ensure that the units have been alive
         /// at least that long before evaluating them
@@ -133,6 +173,23 @@ namespace OpenNero
         /// @return the current population
         PopulationPtr get_population() { return mPopulation; }
 
+        /// @return the number of organisms created so far, including the initial population
+        size_t get_offspring_count() const { return mOffspringCount; }
+
+        /// evolve on the ticking thread alone, as an island ticked on a
+        /// thread of its own should, instead of on NEAT::num_threads threads
+        void set_serial(bool serial) { mSerial = serial; }
+
+        /// get the fittest organisms that have lived long enough to be judged, the fittest first
+        /// @param count the most organisms to return
+        /// @param champions receives the organisms
+        void get_champions(size_t count, vector<OrganismPtr>& champions) const;
+
+        /// replace the worst organism of the population with a copy of an organism
+        /// from another population (as if it were an offspring)
+        /// @return false if no organism is old enough to be replaced
+        bool immigrate(const OrganismPtr& migrant);
+
         /// load info about this AI from the object template
         bool LoadFromTemplate( ObjectTemplatePtr objTemplate, const SimEntityData& data) { return true; }
 
@@ -141,13 +198,22 @@ namespace OpenNero
         /// tally the rewards of all the fielded agents
         void tallyAll();
 
+        /// replace all the brains with new ones for the organisms of the population
+        void createBrains();
+
 		/// evaluate all brains by compiling their stats
 		void evaluateAll();
 
+        /// add, update or remove the stats of a brain in the Z-score statistics
+        void scoreBrain(PyOrganism& brain, bool scored);
+
 		/// evolution step that potentially replaces an organism with an
 		/// offspring
 		void evolveAll();
 
+        /// give the brain of a removed organism to the organism that replaces it
+        void swapOrganism(const OrganismPtr& deadorg, const OrganismPtr& new_org);
+
 		/// Delete the unit which is currently associated with the specified
 		/// brain and move the brain back to waiting list.
 		void deleteUnit(PyOrganismPtr brain);
@@ -210,6 +276,12 @@ namespace OpenNero
         /// we keep our own champion flag
         bool champion;
 
+        /// the stats this brain currently contributes to the Z-score statistics
+        Reward mScoredStats;
+
+        /// position of this brain in the list of scored brains, -1 if it is not scored
+        S32 mScoredIndex;
+
 		/// constructor for a PyOrganism
         /// @param org rtNEAT organism to wrap
         /// @param reward_info the info about the multidimensional reward
@@ -217,7 +289,9 @@ namespace OpenNero
             mOrganism(org),
             mAbsoluteScore(0),
             mStats(reward_info),
-            champion(false)
+            champion(false),
+            mScoredStats(reward_info.getInstance()),
+            mScoredIndex(-1)
         { }
 
         /// set the fitness of the organism
@@ -24,7 +24,6 @@ namespace OpenNero
         , topbound(LockDegreesTo180(tb))
         , radius(radius)
         , value(0)
-        , observed(false)
         , vis(vis)
     {
     }
@@ -34,11 +33,6 @@ namespace OpenNero
     //! Decide if this sensor is interested in a particular object
     bool RadarSensor::process(SimEntityPtr source, SimEntityPtr target)
     {
-        if (observed)
-        {
-            observed = false;
-            value = 0;
-        }
         // the position of the source of the sensor
         Vector3f sourcePos = source->GetPosition();
         
@@ -109,8 +103,11 @@ namespace OpenNero
     //! Get the value computed for this sensor given the filtered objects
     double RadarSensor::getObservation(SimEntityPtr source)
     {
-        observed = true;
-        return std::max(0.0, std::min(value,1.0));
+        // objects out of range are not processed at all, so start over
+        // here rather than on the next call to process
+        double observation = std::max(0.0, std::min(value,1.0));
+        value = 0;
+        return observation;
     }
     
     void RadarSensor::toXMLParams(std::ostream& out) const
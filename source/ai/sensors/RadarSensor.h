@@ -25,12 +25,9 @@ namespace OpenNero
         //! the radius of the radar sector (how far it extends)
         double radius;
 
-        //! cumulative value for the observation
+        //! cumulative value for the observation (reset once observed)
         double value;
 
-        //! bookkeeping for resetting the value
-        bool observed;
-
         //! whether or not the sensor is displayed on screen
         bool vis;
         
@@ -41,7 +38,6 @@ namespace OpenNero
             , bottombound(0), topbound(0)
             , radius(0)
             , value(0)
-            , observed(false)
             , vis(false)
         {}
     
@@ -68,6 +64,9 @@ namespace OpenNero
         //! get the maximum possible observation
         double getMax();
 
+        //! the radar only looks at objects within its radius
+        double getRange() const { return radius; }
+
         //! Process an object of interest
         bool process(SimEntityPtr source, SimEntityPtr target);
         
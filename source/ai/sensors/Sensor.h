@@ -48,6 +48,10 @@ namespace OpenNero
         //! Get the types of objects this sensor needs to look at
         U32 getTypes() const { return types; }
 
+        //! Get how far from the source this sensor needs to look for objects,
+        //! or a negative number if it needs to look at all of them
+        virtual double getRange() const { return -1; }
+
         //! get the minimal possible observation
         virtual double getMin() = 0;
         
@@ -5,26 +5,61 @@
 
 namespace OpenNero
 {
+    namespace {
+        /// feeds the visited entities to a sensor
+        struct ProcessEntities
+        {
+            const SensorPtr& sensor; ///< the sensor to feed
+            const SimEntityPtr& source; ///< the entity that carries the sensor
+            ProcessEntities(const SensorPtr& sensor, const SimEntityPtr& source)
+                : sensor(sensor), source(source) {}
+            void operator()(const SimEntityPtr& ent) { sensor->process(source, ent); }
+        };
+    }
+
     size_t SensorArray::addSensor(SensorPtr sensor)
     {
         sensors.push_back(sensor);
         return sensors.size() - 1;
     }
 
+    bool SensorArray::isNative() const
+    {
+        std::vector<SensorPtr>::const_iterator sensIter;
+        for (sensIter = sensors.begin(); sensIter != sensors.end(); ++sensIter)
+        {
+            if (dynamic_cast<const PySensor*>(sensIter->get()))
+                return false;
+        }
+        return true;
+    }
+
     void SensorArray::getObservations(Observations& observations)
     {
+        SimulationPtr sim = Kernel::instance().GetSimContext()->getSimulation();
+        SimEntityPtr source = GetEntity();
         std::vector<SensorPtr>::iterator sensIter;
         size_t i = 0;
         for (sensIter = sensors.begin(); sensIter != sensors.end(); ++sensIter) 
         {
             AssertMsg(i < observations.size(), "There are more built-in sensors than observations in AgentInitInfo");
-            SimEntitySet::const_iterator entIter;
-            const SimEntitySet entSet = Kernel::instance().GetSimContext()->getSimulation()->GetEntities((*sensIter)->getTypes());
-            for (entIter = entSet.begin(); entIter != entSet.end(); ++entIter) 
+            double range = (*sensIter)->getRange();
+            if (range >= 0)
+            {
+                // only the objects within range can affect the sensor
+                sim->GetEntitiesWithin(source->GetPosition(), range, (*sensIter)->getTypes(), nearby);
+                SimEntityVector::const_iterator entIter;
+                for (entIter = nearby.begin(); entIter != nearby.end(); ++entIter)
+                {
+                    (*sensIter)->process(source, (*entIter));
+                }
+            }
+            else
             {
-                (*sensIter)->process(GetEntity(), (*entIter));
+                ProcessEntities process(*sensIter, source);
+                sim->ForEachEntity((*sensIter)->getTypes(), process);
             }
-            observations[i] = (*sensIter)->getObservation(GetEntity());
+            observations[i] = (*sensIter)->getObservation(source);
             i++;
         }
     }
@@ -4,6 +4,7 @@
 #include "ai/sensors/Sensor.h"
 #include "core/Common.h"
 #include "game/SimEntity.h"
+#include "game/SpatialIndex.h"
 #include "game/objects/SimEntityComponent.h"
 #include "ai/AI.h"
 
@@ -15,11 +16,14 @@ namespace OpenNero {
         : public SimEntityComponent
     {
         std::vector<SensorPtr> sensors;
+        SimEntityVector nearby; ///< reused between the range queries of the sensors
     public:
         explicit SensorArray(SimEntityPtr parent) : SimEntityComponent(parent) {}
         size_t getNumSensors() { return sensors.size(); }
         size_t addSensor(SensorPtr sensor);
         void getObservations(Observations& observations);
+        /// @return true if none of the sensors is implemented in Python
+        bool isNative() const;
         friend std::ostream& operator<<(std::ostream& out, const SensorArray& sa);
     };
 
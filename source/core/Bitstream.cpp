@@ -5,19 +5,22 @@
 
 #include "core/Common.h"
 #include "Bitstream.h"
-#include "Error.h"
+#include "Error.h"
+#include <algorithm>
+#include <cstring>
 
 namespace OpenNero
 {
     using namespace std;
 
 	/// Default constructor
-	Bitstream::Bitstream() : mFront(0) {}
+	Bitstream::Bitstream() : mFront(0), mFailed(false) {}
 
     /// Take in a stream
     Bitstream::Bitstream( uint8_t* stream, uint32_t streamSize ) : 
         mStream(streamSize),
-        mFront(0)
+        mFront(0),
+        mFailed(false)
     {        
         mStream.insert( mStream.begin(), stream, stream + streamSize );
     }
@@ -27,6 +30,7 @@ namespace OpenNero
 	{		
 		mStream = stream.mStream;
 		mFront  = stream.mFront;
+		mFailed = stream.mFailed;
 	}
 	
 	/// Destructor
@@ -37,6 +41,7 @@ namespace OpenNero
 	void Bitstream::Clear()
 	{
 		mFront = 0;
+		mFailed = false;
 		mStream.clear();
 	}
 
@@ -74,6 +79,7 @@ namespace OpenNero
 	{
 		mStream = stream.mStream;
 		mFront  = stream.mFront;
+		mFailed = stream.mFailed;
 		return *this;
 	}
 
@@ -101,11 +107,15 @@ namespace OpenNero
 
 	/**
 	 * Pop a byte off of the front of the stream
-	 * @return the popped byte
+	 * @return the popped byte, or zero if the stream is empty
     */
 	uint8_t Bitstream::PopByte()
 	{
-		Assert( !IsEmpty() );
+		if( IsEmpty() )
+		{
+			mFailed = true;
+			return 0;
+		}
 		return mStream[mFront++];
 	}
 
@@ -119,6 +129,34 @@ namespace OpenNero
 		Assert( !IsEmpty() );
 	}
 
+	/**
+	 * Push several bytes into our stream
+	 * @param bytes the bytes to push
+	 * @param count how many there are
+	*/
+	void Bitstream::PushBytes( const uint8_t* bytes, uint32_t count )
+	{
+		mStream.insert(mStream.end(), bytes, bytes + count);
+	}
+
+	/**
+	 * Pop several bytes off of the front of the stream
+	 * @param bytes where to put them
+	 * @param count how many to pop
+	 * If fewer are left, the stream fails and the bytes are zeroed.
+	*/
+	void Bitstream::PopBytes( uint8_t* bytes, uint32_t count )
+	{
+		if( count > ByteLength() )
+		{
+			mFailed = true;
+			std::fill(bytes, bytes + count, uint8_t(0));
+			return;
+		}
+		std::copy(mStream.begin() + mFront, mStream.begin() + mFront + count, bytes);
+		mFront += count;
+	}
+
     ostream& operator<<( ostream& os, const Bitstream& bitstream)
     {
         return os << "<Bitstream address\"" << &bitstream << "\" length=\"" << bitstream.ByteLength() << "\" />";
@@ -146,10 +184,12 @@ namespace OpenNero
 	Bitstream& operator<<( Bitstream& stream, const uint32_t& val)
 	{
 		// push high byte to low byte
-		stream.PushByte( ( val >> 24 ) & 0xFF );
-		stream.PushByte( ( val >> 16 ) & 0xFF );
-		stream.PushByte( ( val >>  8 ) & 0xFF );
-		stream.PushByte( ( val >>  0 ) & 0xFF );
+		const uint8_t bytes[4] = {
+			uint8_t( ( val >> 24 ) & 0xFF ),
+			uint8_t( ( val >> 16 ) & 0xFF ),
+			uint8_t( ( val >>  8 ) & 0xFF ),
+			uint8_t( ( val >>  0 ) & 0xFF ) };
+		stream.PushBytes( bytes, 4 );
 		return stream;
 	}
 
@@ -174,16 +214,18 @@ namespace OpenNero
 	/// move a float32_t into the stream
 	Bitstream& operator<<( Bitstream& stream, const float32_t& val)
 	{
-		stream << *(uint32_t*)&val;		
-		return stream;
+		uint32_t uVal;
+		memcpy(&uVal, &val, sizeof(uVal));
+		return stream << uVal;
 	}
 
 	/// move a float64_t into the stream
 	Bitstream& operator<<( Bitstream& stream, const float64_t& val)
 	{
-		uint32_t* ptr = (uint32_t*)&val;
-		stream << ptr[0];
-		stream << ptr[1];
+		uint32_t uVals[2];
+		memcpy(uVals, &val, sizeof(uVals));
+		stream << uVals[0];
+		stream << uVals[1];
 
 		return stream;
 	}
@@ -204,11 +246,8 @@ namespace OpenNero
     /// move a string to a stream
     Bitstream& operator<<( Bitstream& stream, const string& val)
     {
-        for (string::const_iterator iter = val.begin(); iter != val.end(); ++iter)
-        {
-            stream.PushByte(*iter);
-        }
-        stream.PushByte('\0');
+        // the terminating zero goes along
+        stream.PushBytes(reinterpret_cast<const uint8_t*>(val.c_str()), (uint32_t)val.size() + 1);
         return stream;
     }
 
@@ -217,8 +256,6 @@ namespace OpenNero
 	/// move a uint8_t out of the stream
 	Bitstream& operator>>(Bitstream& stream, uint8_t& val)
 	{
-		Assert( !stream.IsEmpty() );
-
 		val = stream.PopByte();
 		return stream;
 	}
@@ -226,8 +263,6 @@ namespace OpenNero
 	/// move a uint16_t out of the stream
 	Bitstream& operator>>(Bitstream& stream, uint16_t& val)
 	{
-		Assert( !stream.IsEmpty() );
-
 		val = ( stream.PopByte() << 8 ) +
 			  ( stream.PopByte() << 0 );
 		return stream;
@@ -236,12 +271,12 @@ namespace OpenNero
 	/// move a uint32_t out of the stream
 	Bitstream& operator>>(Bitstream& stream, uint32_t& val)
 	{
-		Assert( !stream.IsEmpty() );
-
-		val = ( stream.PopByte() << 24 ) +
-			  ( stream.PopByte() << 16 ) +
-			  ( stream.PopByte() <<  8 ) +
-			  ( stream.PopByte() <<  0 );
+		uint8_t bytes[4];
+		stream.PopBytes( bytes, 4 );
+		val = ( uint32_t(bytes[0]) << 24 ) |
+			  ( uint32_t(bytes[1]) << 16 ) |
+			  ( uint32_t(bytes[2]) <<  8 ) |
+			  ( uint32_t(bytes[3]) <<  0 );
 		return stream;
 	}
 
@@ -275,11 +310,9 @@ namespace OpenNero
 	/// move a float32_t out of the stream
 	Bitstream& operator>>(Bitstream& stream, float32_t& val)
 	{
-		Assert( !stream.IsEmpty() );
-
-		uint32_t uVal;
+		uint32_t uVal = 0;
 		stream >> uVal;
-		val = *(float32_t*)&uVal;
+		memcpy(&val, &uVal, sizeof(val));
 		
 		return stream;
 	}
@@ -287,13 +320,11 @@ namespace OpenNero
 	/// move a float64_t out of the stream
 	Bitstream& operator>>(Bitstream& stream, float64_t& val)
 	{
-		Assert( !stream.IsEmpty() );
-
 		uint32_t uVals[2];
 		stream >> uVals[0];
 		stream >> uVals[1];
 
-		val = *(float64_t*)uVals;
+		memcpy(&val, uVals, sizeof(val));
 		return stream;
 	}
 
@@ -311,15 +342,18 @@ namespace OpenNero
 
     // TODO: STL strings don't have to terminate on 0 character. ours do.
     /// move a string out of a stream
+    /// a string that is not terminated before the end fails the stream
     Bitstream& operator>>( Bitstream& stream, std::string& val)
     {
         val.clear();
-        char c = static_cast<char>(stream.PopByte());
-        while (c != '\0' && !stream.IsEmpty())
+        while (!stream.IsEmpty())
         {
+            char c = static_cast<char>(stream.PopByte());
+            if (c == '\0')
+                return stream;
             val += c;
-            c = static_cast<char>(stream.PopByte());
         }
+        stream.SetFailed();
         return stream;
     }
 
@@ -35,6 +35,14 @@ namespace OpenNero
 		// returns the size of our stream in bytes
 		uint32_t ByteLength() const;
 
+		// did a read ask for more bytes than were left?
+		// Note: A failed read takes nothing out of the stream and
+		// leaves zeros in its target; the flag stays set until Clear
+		bool Failed() const { return mFailed; }
+
+		// mark the stream as failed, for a read that found bad data
+		void SetFailed() { mFailed = true; }
+
         // rewind the stream back to the beginning
         void Rewind( uint32_t offset = 0 );
 
@@ -56,6 +64,12 @@ namespace OpenNero
 		// push a byte into the front of the stream
 		inline void PushByte( uint8_t b );
 
+		// push several bytes at once
+		void PushBytes( const uint8_t* bytes, uint32_t count );
+
+		// remove several bytes from the front at once
+		void PopBytes( uint8_t* bytes, uint32_t count );
+
 	private:
 
 		// we need access to the array stream, hence we did
@@ -63,6 +77,7 @@ namespace OpenNero
 
 		std::vector<uint8_t>	mStream; ///< The container for the stream data
 		uint32_t				mFront;	 ///< The index in the vector of the front entry
+		bool					mFailed; ///< Whether a read ran past the end of the stream
 
 	}; // end Bitstream
 
@@ -113,7 +128,8 @@ namespace OpenNero
     /**
      * Output the contents of the vector t a stream, must have a >> operator for T to this stream.
      * The first parameter it reads from the string is the size, so this only works on vectors
-     * put into the stream with <<
+     * put into the stream with <<. A size that cannot fit in the rest of the
+     * stream fails the stream and leaves the buffer empty.
      * @param stream the bitstream to move data out of
      * @param buffer the vector put the data in
      * @return the resultant stream
@@ -124,14 +140,21 @@ namespace OpenNero
         uint32_t size;
 		stream >> size;
 
-		if( size )
+		// every element takes at least a byte, so a corrupt size shows
+		// before it is allocated
+		if( stream.Failed() || size > stream.ByteLength() )
 		{
-			buffer.resize(size);
-
-			for( uint32_t i = 0; i < (uint32_t)buffer.size(); ++i )
-				stream >> buffer[i];
+			stream.SetFailed();
+			buffer.clear();
+			return stream;
 		}
 
+		// an empty vector empties the buffer too
+		buffer.resize(size);
+
+		for( uint32_t i = 0; i < (uint32_t)buffer.size(); ++i )
+			stream >> buffer[i];
+
         return stream;
     }
 
@@ -17,6 +17,7 @@ namespace OpenNero
 	{
 		extern void LogWarning( const char* type,  const char* connectionName, const char* msg );
         extern void LogError( const char* type,  const char* connectionName, const char* msg );
+        extern void LogSystemFlush();
 	}
 }
 
@@ -28,7 +29,7 @@ namespace OpenNero
     // TODO : It would be nice if we could put the breakpoint directly in this line so the callstack would lead 
     // directly to the assert, not our assert extension code. As of now, it seems visual studio has trouble parsing
     // this line with NERO_BREAK inside of it.
-    #define AssertDie( exp, msg ) do { static bool __enable_assert = true; if( !(exp) && __enable_assert ) { std::stringstream str; str << "Assertion Failure! [ " << __FILE__ << ":" << __LINE__ << " ] -> " << #exp << " - " << msg; OpenNero::Log::LogError(NULL,NULL,str.str().c_str()); assert( (exp) || OpenNero::AssertExt::ShowAssert( str.str(), __enable_assert ) );  } } while(0)        
+    #define AssertDie( exp, msg ) do { static bool __enable_assert = true; if( !(exp) && __enable_assert ) { std::stringstream str; str << "Assertion Failure! [ " << __FILE__ << ":" << __LINE__ << " ] -> " << #exp << " - " << msg; OpenNero::Log::LogError(NULL,NULL,str.str().c_str()); OpenNero::Log::LogSystemFlush(); assert( (exp) || OpenNero::AssertExt::ShowAssert( str.str(), __enable_assert ) );  } } while(0)        
 #else
     #define AssertDie( exp, msg )
 #endif
@@ -8,15 +8,31 @@
 #include "LogConnections.h"
 #include "scripting/scriptIncludes.h"
 #include "game/Kernel.h"
+#include <csignal>
+#include <map>
 #include <vector>
 #include <iostream>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
 
 namespace OpenNero
 {
 	namespace Log
 	{
 		static ILogConnectionVector sLogConnections;
-        static FilterList           sFilterList;
+        static boost::shared_mutex  sConnectionMutex; ///< messages can come from worker threads while connections change
+
+        /// the number of categories with a level of their own; any more share the last slot
+        static const size_t kMaxCategories = 256;
+
+        typedef std::map<std::string, size_t> CategoryMap;
+
+        static CategoryMap          sCategories;    ///< the slot of each category seen so far
+        static boost::mutex         sCategoryMutex; ///< categories are interned from any thread
+        static volatile uint8_t     sCategoryLevels[kMaxCategories]; ///< the level of each slot (zero, or debug, to start)
+
+        const volatile uint8_t kUnresolvedLevel = kLevelDebug;
 
         /// helper utility functions
         namespace LogUtil
@@ -36,25 +52,30 @@ namespace OpenNero
                 return ILogConnectionPtr();
             }
 
+            /// @return the level slot of a category, interning it if it is new
+            const volatile uint8_t* intern( const std::string& category )
+            {
+                boost::mutex::scoped_lock lock(sCategoryMutex);
+                CategoryMap::iterator found = sCategories.find(category);
+                if( found == sCategories.end() )
+                {
+                    size_t slot = std::min(sCategories.size(), kMaxCategories - 1);
+                    found = sCategories.insert( CategoryMap::value_type(category, slot) ).first;
+                }
+                return &sCategoryLevels[found->second];
+            }
+
             /// define a pointer to member method of ILogConnection
             typedef void (ILogConnection::*MemberLogFunc)( const char* msg );
 
             /// output a message to a member method of ILogConnection on an instance of ILogConnection
             /// @param func the member function to call
-            /// @param msgType the type of message
             /// @param connectionName the name of the connection
             /// @param msg the message to output
-            void OutputToLogFunc( MemberLogFunc func, const char* msgType, const char* connectionName, const char* msg )
+            void OutputToLogFunc( MemberLogFunc func, const char* connectionName, const char* msg )
             {
-                if( msgType )
-                {
-                    // if the message type is in the filter list, then ignore it
-                    // if we do not contain the 'all' receiver or the msgType receiver, exit
-                    if( std::find( sFilterList.begin(), sFilterList.end(), msgType )   != sFilterList.end() )
-                    {
-                        return;
-                    }
-                }
+                // the connections write one message at a time themselves
+                boost::shared_lock<boost::shared_mutex> lock(sConnectionMutex);
 
                 // if the connectionName is null, broadcast to all
                 if( !connectionName )
@@ -83,6 +104,50 @@ namespace OpenNero
                     }
                 }
             }
+
+            /// the signals that end the program, and their handlers before ours
+            const int kCrashSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+            const size_t kNumCrashSignals = sizeof(kCrashSignals) / sizeof(kCrashSignals[0]);
+            void (*sPreviousHandlers[kNumCrashSignals])(int);
+            bool sCrashHandlersInstalled = false;
+
+            /// write out what the connections hold before the program dies,
+            /// then let the signal do what it would have done
+            void OnCrash( int sig )
+            {
+                // no locks: the crashing thread may hold one already
+                ILogConnectionVector::iterator itr = sLogConnections.begin();
+                for( ; itr != sLogConnections.end(); ++itr )
+                    (*itr)->flushOnCrash();
+
+                for( size_t i = 0; i < kNumCrashSignals; ++i )
+                {
+                    if( kCrashSignals[i] == sig )
+                        signal( sig, sPreviousHandlers[i] == SIG_ERR ? SIG_DFL : sPreviousHandlers[i] );
+                }
+                raise(sig);
+            }
+
+            /// flush the logs when the program crashes
+            void InstallCrashHandlers()
+            {
+                for( size_t i = 0; i < kNumCrashSignals; ++i )
+                    sPreviousHandlers[i] = signal( kCrashSignals[i], &OnCrash );
+                sCrashHandlersInstalled = true;
+            }
+
+            /// put back the handlers from before InstallCrashHandlers
+            void RemoveCrashHandlers()
+            {
+                if( !sCrashHandlersInstalled )
+                    return;
+                for( size_t i = 0; i < kNumCrashSignals; ++i )
+                {
+                    if( sPreviousHandlers[i] != SIG_ERR )
+                        signal( kCrashSignals[i], sPreviousHandlers[i] );
+                }
+                sCrashHandlersInstalled = false;
+            }
         }
 
 		/**
@@ -93,6 +158,7 @@ namespace OpenNero
 		{
 			if(conn)
 			{
+                boost::unique_lock<boost::shared_mutex> lock(sConnectionMutex);
 				sLogConnections.push_back(conn);
 			}
 		}
@@ -103,16 +169,73 @@ namespace OpenNero
 	    */
 		void RemoveLogConnection( ILogConnectionPtr conn )
 		{
-            std::remove( sLogConnections.begin(), sLogConnections.end(), conn );
+            boost::unique_lock<boost::shared_mutex> lock(sConnectionMutex);
+            sLogConnections.erase( std::remove( sLogConnections.begin(), sLogConnections.end(), conn ), sLogConnections.end() );
 		}
 
+        /// Set the lowest level shown for a category
+        /// @param category the category of messages
+        /// @param level the lowest level to show, kLevelOff to show none
+        void SetLogLevel( const std::string& category, LogLevel level )
+        {
+            *const_cast<volatile uint8_t*>( LogUtil::intern(category) ) = uint8_t(level);
+        }
+
+        /// @return the lowest level shown for a category
+        LogLevel GetLogLevel( const std::string& category )
+        {
+            return LogLevel( *LogUtil::intern(category) );
+        }
+
+        /// Check whether a log statement should format its message, looking up
+        /// its category the first time (the pointer is written the same by any
+        /// thread that gets here at once)
+        /// @param site the log statement
+        /// @param level the level of the message
+        bool IsEnabled( LogSite& site, LogLevel level )
+        {
+            if( site.level == &kUnresolvedLevel )
+            {
+                site.level = LogUtil::intern(site.category);
+            }
+            return *site.level <= level;
+        }
+
+        /// Send out a message of any level
+        /// @param level the level of the message
+        /// @param connectionName the target connection name, if NULL broadcast to all
+        /// @param msg the message to log
+        void Output( LogLevel level, const char* connectionName, const char* msg )
+        {
+            switch( level )
+            {
+                case kLevelDebug:   LogUtil::OutputToLogFunc( &ILogConnection::LogDebug, connectionName, msg ); break;
+                case kLevelMsg:     LogUtil::OutputToLogFunc( &ILogConnection::LogMsg, connectionName, msg ); break;
+                case kLevelWarning: LogUtil::OutputToLogFunc( &ILogConnection::LogWarning, connectionName, msg ); break;
+                case kLevelError:   LogUtil::OutputToLogFunc( &ILogConnection::LogError, connectionName, msg ); break;
+                default: break;
+            }
+        }
+
+        namespace LogUtil
+        {
+            /// send out a message if its category (if any) is shown at its level
+            void OutputIfEnabled( LogLevel level, const char* type, const char* connectionName, const char* msg )
+            {
+                if( !type || *intern(type) <= level )
+                {
+                    Output( level, connectionName, msg );
+                }
+            }
+        }
+
         /// Log a debug message
         /// @param type the type of message to communicate
         /// @param connectionName the target connection name, if NULL broadcast to all
         /// @param msg the message to log
         void LogDebug( const char* type, const char* connectionName, const char* msg )
         {
-            LogUtil::OutputToLogFunc( &ILogConnection::LogDebug, type, connectionName, msg );
+            LogUtil::OutputIfEnabled( kLevelDebug, type, connectionName, msg );
         }
 
         /// Log a normal message
@@ -121,7 +244,7 @@ namespace OpenNero
         /// @param msg the message to log
         void LogMsg( const char* type, const char* connectionName, const char* msg )
         {
-            LogUtil::OutputToLogFunc( &ILogConnection::LogMsg, type, connectionName, msg );
+            LogUtil::OutputIfEnabled( kLevelMsg, type, connectionName, msg );
         }
 
         /// Log a warning message
@@ -130,7 +253,7 @@ namespace OpenNero
         /// @param msg the message to log
         void LogWarning( const char* type, const char* connectionName, const char* msg )
         {
-            LogUtil::OutputToLogFunc( &ILogConnection::LogWarning, type, connectionName, msg );
+            LogUtil::OutputIfEnabled( kLevelWarning, type, connectionName, msg );
         }
 
         /// Log an error message
@@ -139,32 +262,62 @@ namespace OpenNero
         /// @param msg the message to log
         void LogError( const char* type, const char* connectionName, const char* msg )
         {
-            LogUtil::OutputToLogFunc( &ILogConnection::LogError, type, connectionName, msg );
+            LogUtil::OutputIfEnabled( kLevelError, type, connectionName, msg );
         }
 
-        /// Setup the log system by adding a file log and a console log
+        /// Setup the log system by adding a file log and a console log, both
+        /// written on background threads so that logging does not hold up a frame
 		void LogSystemInit( const std::string& logFileName )
 		{
             // initialize the connections
 			string log_file = Kernel::instance().findResource(logFileName, false);
 			cout << "LOG CREATED in " << log_file << endl;
-            ILogConnectionPtr fileLog( new FileStreamConnection( "nero_file_log", log_file.c_str()) );
-            ILogConnectionPtr stdioLog( new StreamLogConnection<std::ostream>( "console_log", &std::cout ) );
+            boost::shared_ptr<FileStreamConnection> fileLog( new FileStreamConnection( "nero_file_log", log_file.c_str()) );
+            boost::shared_ptr< StreamLogConnection<std::ostream> > stdioLog( new StreamLogConnection<std::ostream>( "console_log", &std::cout ) );
+            fileLog->setFlushEachMessage(false);
+            stdioLog->setFlushEachMessage(false);
 
-			AddLogConnection(fileLog);
-            AddLogConnection(stdioLog);
+			AddLogConnection( ILogConnectionPtr( new AsyncLogConnection(fileLog) ) );
+            AddLogConnection( ILogConnectionPtr( new AsyncLogConnection(stdioLog) ) );
+            LogUtil::InstallCrashHandlers();
 		}
 
-        /// Set the list of filters we want to ignore
+        /// Set the list of filters we want to ignore: the listed categories
+        /// are turned off and all others show every level
         void LogSystemSpecifyFilters( const FilterList& flist )
         {
-            sFilterList = flist;
+            {
+                boost::mutex::scoped_lock lock(sCategoryMutex);
+                for( size_t i = 0; i < kMaxCategories; ++i )
+                    sCategoryLevels[i] = kLevelDebug;
+            }
+            FilterList::const_iterator itr = flist.begin();
+            for( ; itr != flist.end(); ++itr )
+                SetLogLevel( *itr, kLevelOff );
+        }
+
+        /// write out the messages that the connections still hold
+        void LogSystemFlush()
+        {
+            boost::shared_lock<boost::shared_mutex> lock(sConnectionMutex);
+            ILogConnectionVector::iterator itr = sLogConnections.begin();
+            for( ; itr != sLogConnections.end(); ++itr )
+                (*itr)->flush();
         }
 
-        /// clear all the log connections
+        /// write out what is left and clear all the log connections
 		void LogSystemShutdown()
 		{
-			sLogConnections.clear();
+            LogUtil::RemoveCrashHandlers();
+            LogSystemFlush();
+
+            ILogConnectionVector connections;
+            {
+                boost::unique_lock<boost::shared_mutex> lock(sConnectionMutex);
+                connections.swap(sLogConnections);
+            }
+            // the asynchronous connections write out the rest as they are destroyed
+            connections.clear();
 		}
 
 	} // end Log
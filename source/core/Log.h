@@ -15,6 +15,12 @@
 // only possibly turn off logs in the final release
 #define NERO_ENABLE_LOGS (!NERO_FINAL_RELEASE)
 
+// the levels of messages, lowest first (numbers, for use in #if)
+#define NERO_LOG_LEVEL_DEBUG    0
+#define NERO_LOG_LEVEL_MSG      1
+#define NERO_LOG_LEVEL_WARNING  2
+#define NERO_LOG_LEVEL_ERROR    3
+
 namespace OpenNero
 {
     namespace Log
@@ -45,6 +51,13 @@ namespace OpenNero
 
             /// get an identifying name for this connection
             virtual const std::string getConnectionName() const = 0;
+
+            /// write out any messages that are still buffered (from any thread)
+            virtual void flush() {}
+
+            /// write out buffered messages from a thread that is crashing: the
+            /// connection may not take locks, and should give up after a while
+            virtual void flushOnCrash() {}
         };
         
         typedef boost::shared_ptr<ILogConnection> ILogConnectionPtr;
@@ -68,49 +81,137 @@ namespace OpenNero
         extern void LogSystemSpecifyFilters( const FilterList& flist );
         extern void LogSystemShutdown();
 
+        /// write out the messages that the connections still hold
+        extern void LogSystemFlush();
+
         /// Allow ALL messages of any type to come through the logger
         extern const std::string kLogFilterAcceptAll;
 
+        /// the levels of messages, lowest first
+        enum LogLevel
+        {
+            kLevelDebug = NERO_LOG_LEVEL_DEBUG,
+            kLevelMsg = NERO_LOG_LEVEL_MSG,
+            kLevelWarning = NERO_LOG_LEVEL_WARNING,
+            kLevelError = NERO_LOG_LEVEL_ERROR,
+            kLevelOff   ///< not a message level: a category at this level shows nothing
+        };
+
+        /// the lowest level shown for each category; a category is interned
+        /// the first time it is used and its level is kept in a fixed slot,
+        /// so a log statement can look it up without comparing strings
+        extern void SetLogLevel( const std::string& category, LogLevel level );
+        extern LogLevel GetLogLevel( const std::string& category );
+
+        /// the level a log statement sees before it has looked up its category
+        extern const volatile uint8_t kUnresolvedLevel;
+
+        /// A log statement of a category. The filter macros keep one of these
+        /// in a static (initialized at compile time) and point it at the level
+        /// of the category the first time the statement runs.
+        struct LogSite
+        {
+            const char* category;           ///< the category of the statement
+            const volatile uint8_t* level;  ///< the level of the category
+        };
+
+        /// @return whether messages of the site's category are shown at the level
+        extern bool IsEnabled( LogSite& site, LogLevel level );
+
+        /// send out a formatted message, without checking its category
+        extern void Output( LogLevel level, const char* connectionName, const char* msg );
+
     } // end Log
 
 // some semi-ugly defines
 
+// messages below this level are compiled out; the console and file logs
+// only show debug messages in debug builds, so other builds leave them out
+#ifndef NERO_LOG_MIN_LEVEL
+    #if NERO_DEBUG
+        #define NERO_LOG_MIN_LEVEL NERO_LOG_LEVEL_DEBUG
+    #else
+        #define NERO_LOG_MIN_LEVEL NERO_LOG_LEVEL_MSG
+    #endif
+#endif
+
 #if NERO_ENABLE_LOGS
 
-    // default broadcasting logger macros - sends the message to every log connection regardless of target or type
-    #define LOG_DEBUG_EVERY(t, msg) do { static int counter = 0; if (++counter % t == 0) { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (D) " << msg; OpenNero::Log::LogDebug( NULL, NULL, cmsg.str().c_str() ); } } while (0)
-    #define LOG_DEBUG( msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (D) " << msg; OpenNero::Log::LogDebug  ( NULL, NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_ERROR( msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << msg; OpenNero::Log::LogError  ( NULL, NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_MSG( msg )     do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (M) " << msg; OpenNero::Log::LogMsg    ( NULL, NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_WARNING( msg ) do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (*) " << msg; OpenNero::Log::LogWarning( NULL, NULL, cmsg.str().c_str() ); } while(0)
+    // format a message and send it out (the gates have been passed)
+    #define LOG_EMIT_( level, tag, target, msg ) do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << tag << msg; OpenNero::Log::Output( (level), (target), cmsg.str().c_str() ); } while(0)
+
+    // format and send a message of a category only if the category is
+    // enabled at the level; each statement keeps a pointer to the level of
+    // its category, so a disabled one costs a load and a branch
+    #define LOG_CATEGORY_( lvl, tag, type, target, msg ) \
+        do { \
+            static OpenNero::Log::LogSite log_site_ = { (type), &OpenNero::Log::kUnresolvedLevel }; \
+            if( *log_site_.level <= (lvl) && OpenNero::Log::IsEnabled( log_site_, (lvl) ) ) \
+                LOG_EMIT_( (lvl), tag << LOG_FILTER_TOKEN(type), (target), msg ); \
+        } while(0)
+
+    #define LOG_NONE_ do { } while(0)
 
+    #define LOG_FILTER_TOKEN(type) "[" << (type) << "] "
+
+    // default broadcasting logger macros - sends the message to every log connection regardless of target or type
     // destination based logs - send the message to a certain connection
     // Example: LOG_D_DEBUG( "texture_loader_connection", "A texture load as failed" )
-    #define LOG_D_DEBUG( name, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << msg; OpenNero::Log::LogDebug  ( NULL, (name), cmsg.str().c_str() ); } while(0)
-    #define LOG_D_ERROR( name, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << msg; OpenNero::Log::LogError  ( NULL, (name), cmsg.str().c_str() ); } while(0)
-    #define LOG_D_MSG( name, msg )     do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (M) " << msg; OpenNero::Log::LogMsg    ( NULL, (name), cmsg.str().c_str() ); } while(0)
-    #define LOG_D_WARNING( name, msg ) do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (*) " << msg; OpenNero::Log::LogWarning( NULL, (name), cmsg.str().c_str() ); } while(0)
 
     // filter based logs - send the message only to receivers of certain types
-    
-    #define LOG_FILTER_TOKEN(type) "[" << (type) << "] "
-    
+    //
     // The basis behind this is that a user or developer should be able to filter out the log messages that are relevant.
     // If I am only concerned with messages from a given system, don't show me messages from these other ones.
     // Example: LOG_F_MSG( "render", "Rendering a complex object" )
-    //   This message only gets sent to developers that have the "render" type enabled in their filter list
-    //   as setup by the LogSystemSpecifyFilters method
-
-    #define LOG_F_DEBUG( type, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogDebug(   (type), NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_F_ERROR( type, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogError(   (type), NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_F_MSG( type, msg )     do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (M) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogMsg(     (type), NULL, cmsg.str().c_str() ); } while(0)
-    #define LOG_F_WARNING( type, msg ) do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (*) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogWarning( (type), NULL, cmsg.str().c_str() ); } while(0)
+    //   This message only gets sent to developers that have the "render" type enabled
+    //   (see SetLogLevel and the LogSystemSpecifyFilters method); the message is not
+    //   even formatted otherwise
 
     // filter and destination based logs - send the message only to the given connection only to receivers of certain types
-    #define LOG_FD_DEBUG( type, target, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogDebug(   (type), (target), cmsg.str().c_str() ); } while(0)
-    #define LOG_FD_ERROR( type, target, msg )   do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (!) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogError(   (type), (target), cmsg.str().c_str() ); } while(0)
-    #define LOG_FD_MSG( type, target, msg )     do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (M) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogMsg(     (type), (target), cmsg.str().c_str() ); } while(0)
-    #define LOG_FD_WARNING( type, target, msg ) do { std::stringstream cmsg; GetStaticTimer().stamp(cmsg); cmsg << " (*) " << LOG_FILTER_TOKEN(type) << msg; OpenNero::Log::LogWarning( (type), (target), cmsg.str().c_str() ); } while(0)
+
+    #if NERO_LOG_MIN_LEVEL <= NERO_LOG_LEVEL_DEBUG
+        #define LOG_DEBUG_EVERY(t, msg) do { static int counter = 0; if (++counter % t == 0) LOG_EMIT_( OpenNero::Log::kLevelDebug, " (D) ", NULL, msg ); } while (0)
+        #define LOG_DEBUG( msg )                    LOG_EMIT_( OpenNero::Log::kLevelDebug, " (D) ", NULL, msg )
+        #define LOG_D_DEBUG( name, msg )            LOG_EMIT_( OpenNero::Log::kLevelDebug, " (!) ", (name), msg )
+        #define LOG_F_DEBUG( type, msg )            LOG_CATEGORY_( OpenNero::Log::kLevelDebug, " (!) ", type, NULL, msg )
+        #define LOG_FD_DEBUG( type, target, msg )   LOG_CATEGORY_( OpenNero::Log::kLevelDebug, " (!) ", type, target, msg )
+    #else
+        #define LOG_DEBUG_EVERY(t, msg)             LOG_NONE_
+        #define LOG_DEBUG( msg )                    LOG_NONE_
+        #define LOG_D_DEBUG( name, msg )            LOG_NONE_
+        #define LOG_F_DEBUG( type, msg )            LOG_NONE_
+        #define LOG_FD_DEBUG( type, target, msg )   LOG_NONE_
+    #endif
+
+    #if NERO_LOG_MIN_LEVEL <= NERO_LOG_LEVEL_MSG
+        #define LOG_MSG( msg )                      LOG_EMIT_( OpenNero::Log::kLevelMsg, " (M) ", NULL, msg )
+        #define LOG_D_MSG( name, msg )              LOG_EMIT_( OpenNero::Log::kLevelMsg, " (M) ", (name), msg )
+        #define LOG_F_MSG( type, msg )              LOG_CATEGORY_( OpenNero::Log::kLevelMsg, " (M) ", type, NULL, msg )
+        #define LOG_FD_MSG( type, target, msg )     LOG_CATEGORY_( OpenNero::Log::kLevelMsg, " (M) ", type, target, msg )
+    #else
+        #define LOG_MSG( msg )                      LOG_NONE_
+        #define LOG_D_MSG( name, msg )              LOG_NONE_
+        #define LOG_F_MSG( type, msg )              LOG_NONE_
+        #define LOG_FD_MSG( type, target, msg )     LOG_NONE_
+    #endif
+
+    #if NERO_LOG_MIN_LEVEL <= NERO_LOG_LEVEL_WARNING
+        #define LOG_WARNING( msg )                  LOG_EMIT_( OpenNero::Log::kLevelWarning, " (*) ", NULL, msg )
+        #define LOG_D_WARNING( name, msg )          LOG_EMIT_( OpenNero::Log::kLevelWarning, " (*) ", (name), msg )
+        #define LOG_F_WARNING( type, msg )          LOG_CATEGORY_( OpenNero::Log::kLevelWarning, " (*) ", type, NULL, msg )
+        #define LOG_FD_WARNING( type, target, msg ) LOG_CATEGORY_( OpenNero::Log::kLevelWarning, " (*) ", type, target, msg )
+    #else
+        #define LOG_WARNING( msg )                  LOG_NONE_
+        #define LOG_D_WARNING( name, msg )          LOG_NONE_
+        #define LOG_F_WARNING( type, msg )          LOG_NONE_
+        #define LOG_FD_WARNING( type, target, msg ) LOG_NONE_
+    #endif
+
+    // errors are always compiled in
+    #define LOG_ERROR( msg )                        LOG_EMIT_( OpenNero::Log::kLevelError, " (!) ", NULL, msg )
+    #define LOG_D_ERROR( name, msg )                LOG_EMIT_( OpenNero::Log::kLevelError, " (!) ", (name), msg )
+    #define LOG_F_ERROR( type, msg )                LOG_CATEGORY_( OpenNero::Log::kLevelError, " (!) ", type, NULL, msg )
+    #define LOG_FD_ERROR( type, target, msg )       LOG_CATEGORY_( OpenNero::Log::kLevelError, " (!) ", type, target, msg )
 
 #else
 
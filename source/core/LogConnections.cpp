@@ -4,8 +4,12 @@
 //---------------------------------------------------
 
 #include "core/Common.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <fstream>
+#include <boost/bind.hpp>
 #include "LogConnections.h"
 #include "scripting/scripting.h"
 
@@ -45,9 +49,258 @@ namespace OpenNero
         /// flushes the file
         void FileStreamConnection::flush()
         {
+            boost::recursive_mutex::scoped_lock lock(mWriteMutex);
             mStream.flush();
         }
 
+        namespace
+        {
+            /// how long the writer sleeps when there is nothing to write (ms)
+            const long kWriteInterval = 20;
+
+            /// how long a flush waits for the writer at most (ms)
+            const long kFlushTimeout = 1000;
+        }
+
+        const size_t AsyncLogConnection::kDefaultCapacity;
+        const size_t AsyncLogConnection::kMaxMessageLength;
+
+        /// A record holds a message once its sequence is one past its position
+        /// in the ring, and is free for the position (capacity) records further
+        /// on once the writer has set its sequence to that position.
+        struct AsyncLogConnection::Record
+        {
+            boost::atomic<size_t> sequence;         ///< which position the record is at, and whether it is full
+            uint8_t level;                          ///< the level of the message
+            char text[kMaxMessageLength + 1];       ///< the message
+        };
+
+        /**
+         * Constructor. Starts the writer thread.
+         * @param target the connection to pass the messages on to
+         * @param capacity the number of records in the ring
+        */
+        AsyncLogConnection::AsyncLogConnection( ILogConnectionPtr target, size_t capacity )
+            : mTarget(target)
+            , mRecords(NULL)
+            , mMask(0)
+            , mAppendPos(0)
+            , mWrittenPos(0)
+            , mReadPos(0)
+            , mDropsReported(0)
+            , mStopping(false)
+        {
+            Assert( mTarget );
+            size_t size = 2;
+            while( size < capacity )
+                size *= 2;
+            mRecords = new Record[size];
+            mMask = size - 1;
+            for( size_t i = 0; i < size; ++i )
+                mRecords[i].sequence.store(i, boost::memory_order_relaxed);
+            for( size_t i = 0; i < kLevelOff; ++i )
+                mDropped[i].store(0, boost::memory_order_relaxed);
+            mWriter = boost::thread( boost::bind(&AsyncLogConnection::writerLoop, this) );
+            mWriterId = mWriter.get_id();
+        }
+
+        /// dtor, writes out what is left and joins the writer thread
+        AsyncLogConnection::~AsyncLogConnection()
+        {
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                mStopping = true;
+            }
+            mWakeUp.notify_one();
+            mWriter.join();
+            delete [] mRecords;
+        }
+
+        /// log a debug message
+        void AsyncLogConnection::LogDebug( const char* msg )
+        {
+            append(kLevelDebug, msg);
+        }
+
+        /// log a message
+        void AsyncLogConnection::LogMsg( const char* msg )
+        {
+            append(kLevelMsg, msg);
+        }
+
+        /// log a warning
+        void AsyncLogConnection::LogWarning( const char* msg )
+        {
+            append(kLevelWarning, msg);
+        }
+
+        /// log an error
+        void AsyncLogConnection::LogError( const char* msg )
+        {
+            append(kLevelError, msg);
+        }
+
+        /// get the name of the connection
+        const std::string AsyncLogConnection::getConnectionName() const
+        {
+            return mTarget->getConnectionName();
+        }
+
+        /// wait until the messages logged so far have been written and flushed
+        void AsyncLogConnection::flush()
+        {
+            // the writer cannot wait for itself
+            if( boost::this_thread::get_id() == mWriterId )
+                return;
+
+            const size_t target = mAppendPos.load(boost::memory_order_acquire);
+            const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(kFlushTimeout);
+            boost::mutex::scoped_lock lock(mMutex);
+            mWakeUp.notify_one();
+            while( mWrittenPos.load(boost::memory_order_acquire) < target )
+            {
+                if( !mFlushed.timed_wait(lock, deadline) )
+                    break;
+            }
+        }
+
+        /// wait until the messages logged so far have been written, without
+        /// taking locks or signalling the writer (which wakes up by itself)
+        void AsyncLogConnection::flushOnCrash()
+        {
+            if( boost::this_thread::get_id() == mWriterId )
+                return;
+
+            const size_t target = mAppendPos.load(boost::memory_order_acquire);
+            const std::clock_t deadline = std::clock() + kFlushTimeout * CLOCKS_PER_SEC / 1000;
+            while( mWrittenPos.load(boost::memory_order_acquire) < target && std::clock() < deadline )
+                boost::this_thread::yield();
+        }
+
+        /// @return the number of messages of a level that were dropped
+        size_t AsyncLogConnection::getDropped( LogLevel level ) const
+        {
+            return level < kLevelOff ? mDropped[level].load(boost::memory_order_relaxed) : 0;
+        }
+
+        /// copy a message into the ring; when it is full, drop anything but
+        /// an error, and have errors wait for the writer to make room
+        void AsyncLogConnection::append( LogLevel level, const char* msg )
+        {
+            if( tryAppend(level, msg) )
+            {
+                // do not leave errors waiting for the writer to wake up
+                if( level == kLevelError )
+                    mWakeUp.notify_one();
+                return;
+            }
+
+            if( level == kLevelError && boost::this_thread::get_id() != mWriterId )
+            {
+                mWakeUp.notify_one();
+                while( !tryAppend(level, msg) )
+                    boost::this_thread::yield();
+                return;
+            }
+
+            mDropped[level].fetch_add(1, boost::memory_order_relaxed);
+        }
+
+        /// claim the next free record and copy a message into it
+        bool AsyncLogConnection::tryAppend( LogLevel level, const char* msg )
+        {
+            size_t pos = mAppendPos.load(boost::memory_order_relaxed);
+            Record* record;
+            for( ;; )
+            {
+                record = &mRecords[pos & mMask];
+                const size_t sequence = record->sequence.load(boost::memory_order_acquire);
+                if( sequence == pos )
+                {
+                    // the record is free: claim it unless another logger got there first
+                    if( mAppendPos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed) )
+                        break;
+                }
+                else if( sequence < pos )
+                {
+                    // the record still holds a message from the last time around
+                    return false;
+                }
+                else
+                {
+                    // another logger claimed it
+                    pos = mAppendPos.load(boost::memory_order_relaxed);
+                }
+            }
+
+            record->level = uint8_t(level);
+            const size_t length = std::min(strlen(msg), size_t(kMaxMessageLength));
+            memcpy(record->text, msg, length);
+            record->text[length] = 0;
+            record->sequence.store(pos + 1, boost::memory_order_release);
+            return true;
+        }
+
+        /// the body of the writer thread: write whatever is in the ring, then
+        /// sleep until woken up or until the next interval
+        void AsyncLogConnection::writerLoop()
+        {
+            for( ;; )
+            {
+                const size_t written = drain();
+                boost::mutex::scoped_lock lock(mMutex);
+                mFlushed.notify_all();
+                if( written == 0 )
+                {
+                    if( mStopping )
+                        break;
+                    mWakeUp.timed_wait(lock, boost::posix_time::milliseconds(kWriteInterval));
+                }
+            }
+        }
+
+        /// pass on the messages in the ring as one batch
+        size_t AsyncLogConnection::drain()
+        {
+            size_t written = 0;
+            for( ;; )
+            {
+                Record& record = mRecords[mReadPos & mMask];
+                if( record.sequence.load(boost::memory_order_acquire) != mReadPos + 1 )
+                    break;
+
+                switch( record.level )
+                {
+                    case kLevelDebug:   mTarget->LogDebug(record.text); break;
+                    case kLevelMsg:     mTarget->LogMsg(record.text); break;
+                    case kLevelWarning: mTarget->LogWarning(record.text); break;
+                    default:            mTarget->LogError(record.text); break;
+                }
+
+                // free the record for the next time around the ring
+                record.sequence.store(mReadPos + mMask + 1, boost::memory_order_release);
+                ++mReadPos;
+                ++written;
+            }
+
+            size_t dropped = 0;
+            for( size_t i = 0; i < kLevelOff; ++i )
+                dropped += mDropped[i].load(boost::memory_order_relaxed);
+            if( dropped != mDropsReported )
+            {
+                std::stringstream msg;
+                msg << " (*) [log] dropped " << dropped - mDropsReported << " messages while the log was full";
+                mTarget->LogWarning(msg.str().c_str());
+                mDropsReported = dropped;
+                ++written;
+            }
+
+            if( written > 0 )
+                mTarget->flush();
+            mWrittenPos.store(mReadPos, boost::memory_order_release);
+            return written;
+        }
+
         /// constructor
         PyLogConnection::PyLogConnection() : logging_object()
         {
@@ -8,6 +8,12 @@
 
 #include <assert.h>
 #include <fstream>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include "core/Preprocessor.h"
 #include "Log.h"
 #include "scripting/scriptIncludes.h"
@@ -21,6 +27,7 @@ namespace OpenNero
          * object for logging use. This "stream" type object must implement
          * operators << and >> for character streams. Specific overrides may
          * need to be created for the flush() method to provide proper flushing.
+         * Messages from different threads are written one at a time.
         */
         template <typename T>
         class StreamLogConnection : public ILogConnection
@@ -33,8 +40,14 @@ namespace OpenNero
             /// the name of the connection
             std::string mConnectionName;
 
+            /// whether to flush after every message
+            bool mFlushEachMessage;
+
         protected:
 
+            /// held while writing to or flushing the stream
+            boost::recursive_mutex mWriteMutex;
+
             /**
              * Dump a message into our stream
              * @param msg the character buffer to dump
@@ -45,6 +58,18 @@ namespace OpenNero
                 (*mStreamPtr) << msg << "\n";
             }
 
+            /**
+             * Dump a message and flush it, unless messages are flushed in batches
+             * @param msg the character buffer to write
+            */
+            void write( const char* msg )
+            {
+                boost::recursive_mutex::scoped_lock lock(mWriteMutex);
+                dump(msg);
+                if( mFlushEachMessage )
+                    flush();
+            }
+
         public:
 
             /// a flushing method that children can override or inherit
@@ -53,7 +78,8 @@ namespace OpenNero
             /// constructor
             StreamLogConnection( const std::string connectionName, T* streamPtr = 0 ) 
                 : mStreamPtr(streamPtr),
-                  mConnectionName(connectionName) {}          
+                  mConnectionName(connectionName),
+                  mFlushEachMessage(true) {}          
 
             /// destructor
             ~StreamLogConnection()
@@ -68,34 +94,37 @@ namespace OpenNero
                 mStreamPtr = streamPtr;
             }
 
+            /// set whether to flush after every message (the default) or
+            /// only when flush is called, as AsyncLogConnection does after a batch
+            void setFlushEachMessage( bool flushEachMessage )
+            {
+                mFlushEachMessage = flushEachMessage;
+            }
+
 			/// log a debug message
 			void LogDebug( const char* msg )
 			{
 #if NERO_DEBUG
-				dump(msg);
-                flush();
+				write(msg);
 #endif
 			}
 
             /// log a message
             void LogMsg( const char* msg )
             {
-                dump(msg);
-                flush();
+                write(msg);
             }
 
             /// log a warning
             void LogWarning( const char* msg )
             {
-                dump(msg);
-                flush();
+                write(msg);
             }
 
             /// log an error
             void LogError( const char* msg )
             {
-                dump(msg);
-                flush();
+                write(msg);
             }
 
             /// get the name of the connection
@@ -152,6 +181,100 @@ namespace OpenNero
             void flush();
         };
 
+        /**
+         * An ILogConnection that hands its messages to another connection on a
+         * background thread, so that the threads that log never wait for the
+         * disk or the console.
+         *
+         * Messages are copied into a fixed ring of records that any number of
+         * threads append to without taking a lock. The writer thread takes
+         * them out in order and passes them on in batches, flushing the other
+         * connection once per batch.
+         *
+         * The ring never grows. When it is full, debug messages, messages and
+         * warnings are dropped and counted (the writer reports the count), and
+         * errors wait for room. A message longer than a record is cut short.
+        */
+        class AsyncLogConnection : public ILogConnection, private boost::noncopyable
+        {
+        public:
+
+            /// the default number of records in the ring
+            static const size_t kDefaultCapacity = 2048;
+
+            /// the longest message a record holds
+            static const size_t kMaxMessageLength = 499;
+
+            /**
+             * Start the writer thread
+             * @param target the connection to pass the messages on to
+             * @param capacity the number of records (rounded up to a power of two)
+            */
+            explicit AsyncLogConnection( ILogConnectionPtr target, size_t capacity = kDefaultCapacity );
+
+            /// write out the messages left and stop the writer thread
+            ~AsyncLogConnection();
+
+			/// log a debug message
+			void LogDebug( const char* msg );
+
+            /// log a message
+            void LogMsg( const char* msg );
+
+            /// log a warning
+            void LogWarning( const char* msg );
+
+            /// log an error
+            void LogError( const char* msg );
+
+            /// get the name of the connection (that of the target)
+            const std::string getConnectionName() const;
+
+            /// wait until the messages logged so far have been written and flushed
+            void flush();
+
+            /// wait (for a second at most, and without locks) until the messages
+            /// logged so far have been written
+            void flushOnCrash();
+
+            /// @return the number of messages of a level that were dropped
+            size_t getDropped( LogLevel level ) const;
+
+        private:
+
+            /// a message in the ring
+            struct Record;
+
+            /// copy a message into the ring, or count it as dropped
+            void append( LogLevel level, const char* msg );
+
+            /// claim the next free record and copy a message into it
+            /// @return false if the ring is full
+            bool tryAppend( LogLevel level, const char* msg );
+
+            /// the body of the writer thread
+            void writerLoop();
+
+            /// pass on the messages in the ring and the count of dropped ones
+            /// @return the number of messages written
+            size_t drain();
+
+            ILogConnectionPtr           mTarget;        ///< the connection the messages go to
+            Record*                     mRecords;       ///< the ring
+            size_t                      mMask;          ///< the number of records less one
+            boost::atomic<size_t>       mAppendPos;     ///< the number of records claimed by loggers
+            boost::atomic<size_t>       mWrittenPos;    ///< the number of records written and flushed
+            boost::atomic<size_t>       mDropped[kLevelOff]; ///< the messages of each level dropped
+            size_t                      mReadPos;       ///< the next record to write (writer only)
+            size_t                      mDropsReported; ///< the drops written out so far (writer only)
+            boost::mutex                mMutex;         ///< guards the signals below
+            boost::condition_variable   mWakeUp;        ///< wakes the writer up early
+            boost::condition_variable   mFlushed;       ///< signals that a batch has been written
+            bool                        mStopping;      ///< set when the connection is destroyed
+            boost::thread::id           mWriterId;      ///< the writer thread
+            boost::thread               mWriter;        ///< the writer thread
+        };
+
         /// PyLogConnection allows us to send logs to a logging system implemented in Python
         /// This can be something in Python's logging module, or something that sends messages
         /// over the network.
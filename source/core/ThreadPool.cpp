@@ -0,0 +1,216 @@
+//--------------------------------------------------------
+// OpenNero : ThreadPool
+//  a pool of worker threads for data-parallel loops
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include <boost/bind.hpp>
+
+#include "ThreadPool.h"
+
+namespace OpenNero
+{
+    ThreadPool::ThreadPool(size_t num_threads)
+        : mTask(NULL)
+        , mGeneration(0)
+        , mBusy(0)
+        , mShutdown(false)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = boost::thread::hardware_concurrency();
+        }
+        if (num_threads == 0)
+        {
+            num_threads = 1;
+        }
+        for (size_t i = 0; i < num_threads; ++i)
+        {
+            mRanges.push_back(new Range());
+        }
+        // the calling thread is participant 0, so start one less worker
+        for (size_t i = 1; i < num_threads; ++i)
+        {
+            mThreads.create_thread(boost::bind(&ThreadPool::WorkerLoop, this, i));
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            mShutdown = true;
+        }
+        mWakeUp.notify_all();
+        mThreads.join_all();
+        for (size_t i = 0; i < mRanges.size(); ++i)
+        {
+            delete mRanges[i];
+        }
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const Task& task)
+    {
+        const size_t n = mRanges.size();
+
+        // nothing to share
+        if (n == 1 || count < 2)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            for (size_t w = 0; w < n; ++w)
+            {
+                boost::mutex::scoped_lock range_lock(mRanges[w]->lock);
+                mRanges[w]->begin = count * w / n;
+                mRanges[w]->end = count * (w + 1) / n;
+            }
+            mTask = &task;
+            mBusy = n - 1;
+            mError = boost::exception_ptr();
+            ++mGeneration;
+        }
+        mWakeUp.notify_all();
+
+        RunRange(0);
+
+        boost::exception_ptr error;
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            while (mBusy > 0)
+            {
+                mFinished.wait(lock);
+            }
+            mTask = NULL;
+            error = mError;
+            mError = boost::exception_ptr();
+        }
+        if (error)
+        {
+            boost::rethrow_exception(error);
+        }
+    }
+
+    void ThreadPool::WorkerLoop(size_t worker)
+    {
+        size_t seen = 0;
+        while (true)
+        {
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                while (!mShutdown && mGeneration == seen)
+                {
+                    mWakeUp.wait(lock);
+                }
+                if (mShutdown)
+                {
+                    return;
+                }
+                seen = mGeneration;
+            }
+
+            RunRange(worker);
+
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                --mBusy;
+            }
+            mFinished.notify_one();
+        }
+    }
+
+    void ThreadPool::RunRange(size_t worker)
+    {
+        try
+        {
+            size_t i;
+            while (true)
+            {
+                if (!Pop(worker, i))
+                {
+                    if (!Steal(worker))
+                    {
+                        break;
+                    }
+                    continue;
+                }
+                (*mTask)(i);
+            }
+        }
+        catch (...)
+        {
+            // stop this participant; the others steal what it had left
+            boost::mutex::scoped_lock lock(mMutex);
+            if (!mError)
+            {
+                mError = boost::current_exception();
+            }
+        }
+    }
+
+    bool ThreadPool::Pop(size_t worker, size_t& index)
+    {
+        Range& range = *mRanges[worker];
+        boost::mutex::scoped_lock lock(range.lock);
+        if (range.begin < range.end)
+        {
+            index = range.begin++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::Steal(size_t worker)
+    {
+        // look for the participant with the most work left
+        size_t victim = worker;
+        size_t most = 0;
+        for (size_t w = 0; w < mRanges.size(); ++w)
+        {
+            if (w == worker)
+            {
+                continue;
+            }
+            boost::mutex::scoped_lock lock(mRanges[w]->lock);
+            size_t left = mRanges[w]->end - mRanges[w]->begin;
+            if (left > most)
+            {
+                most = left;
+                victim = w;
+            }
+        }
+        if (victim == worker)
+        {
+            return false;
+        }
+
+        // take the back half of its range (it may have shrunk meanwhile)
+        size_t begin, end;
+        {
+            Range& range = *mRanges[victim];
+            boost::mutex::scoped_lock lock(range.lock);
+            if (range.begin >= range.end)
+            {
+                // lost the race, look again
+                return true;
+            }
+            begin = range.begin + (range.end - range.begin) / 2;
+            end = range.end;
+            range.end = begin;
+        }
+        {
+            Range& range = *mRanges[worker];
+            boost::mutex::scoped_lock lock(range.lock);
+            range.begin = begin;
+            range.end = end;
+        }
+        return true;
+    }
+
+} //end OpenNero
@@ -0,0 +1,80 @@
+//--------------------------------------------------------
+// OpenNero : ThreadPool
+//  a pool of worker threads for data-parallel loops
+//--------------------------------------------------------
+
+#ifndef _CORE_THREADPOOL_H_
+#define _CORE_THREADPOOL_H_
+
+#include "Common.h"
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/exception_ptr.hpp>
+
+namespace OpenNero
+{
+    /**
+     * A fixed set of worker threads that run the iterations of a loop in
+     * parallel. Every participant (the workers and the calling thread) starts
+     * with a contiguous block of the iteration range; a participant that runs
+     * out of work steals the back half of the largest block left to someone
+     * else, so uneven iterations still keep all the cores busy.
+     *
+     * Which thread runs which iteration is not deterministic, so iterations
+     * that need random numbers should seed their own stream from the index.
+     */
+    class ThreadPool : boost::noncopyable
+    {
+    public:
+        /// the body of a loop, called once with every index
+        typedef boost::function<void (size_t)> Task;
+
+        /// create a pool that runs loops on num_threads threads in total
+        /// (including the caller); 0 means one per hardware thread
+        explicit ThreadPool(size_t num_threads = 0);
+
+        /// stop and join the worker threads
+        ~ThreadPool();
+
+        /// number of threads that loops run on, including the caller
+        size_t GetNumThreads() const { return mRanges.size(); }
+
+        /// call task(i) for every i in [0, count) and wait until all are done.
+        /// If a task throws, the first exception is rethrown here once the
+        /// loop has drained.
+        void ParallelFor(size_t count, const Task& task);
+
+    private:
+        /// the part of the iteration range that one participant still owns
+        struct Range
+        {
+            boost::mutex lock;
+            size_t begin;
+            size_t end;
+            Range() : begin(0), end(0) {}
+        };
+
+        void WorkerLoop(size_t worker);
+        void RunRange(size_t worker);
+        bool Pop(size_t worker, size_t& index);
+        bool Steal(size_t worker);
+
+        std::vector<Range*> mRanges;            ///< one range per participant, 0 is the caller
+        boost::thread_group mThreads;           ///< the worker threads
+        boost::mutex mMutex;                    ///< guards everything below
+        boost::condition_variable mWakeUp;      ///< signals a new loop or shutdown
+        boost::condition_variable mFinished;    ///< signals that a worker is done
+        const Task* mTask;                      ///< the loop being run
+        size_t mGeneration;                     ///< incremented for every loop
+        size_t mBusy;                           ///< workers still in the current loop
+        bool mShutdown;                         ///< set when the pool is destroyed
+        boost::exception_ptr mError;            ///< first exception thrown by a task
+    };
+
+} //end OpenNero
+
+#endif // _CORE_THREADPOOL_H_
@@ -0,0 +1,382 @@
+//--------------------------------------------------------
+// OpenNero : CollisionResolver
+//  keeps sim entities from moving into each other
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include "game/CollisionResolver.h"
+#include "game/Simulation.h"
+#include "render/SceneObject.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace OpenNero
+{
+    namespace {
+        /// the footprint of an entity on the X-Y plane, from its bounding box
+        /// @param half half the lengths of the sides of the footprint
+        /// @param offset the middle of the footprint relative to the position, before the rotation
+        /// @param bottom the lowest point relative to the position
+        /// @param top the highest point relative to the position
+        /// @return false if the entity has no shape
+        bool GetFootprint(const SimEntityPtr& ent, Vector2f& half, Vector2f& offset, float32_t& bottom, float32_t& top)
+        {
+            SceneObjectPtr obj = ent->GetSceneObject();
+            if (!obj)
+                return false;
+            BBoxf box = obj->getBoundingBox();
+            Vector3f scale = obj->getScale();
+            box.MinEdge *= scale;
+            box.MaxEdge *= scale;
+            box.repair(); // in case of negative scales
+            Vector3f center = box.getCenter();
+            Vector3f extent = box.getExtent();
+            half = Vector2f(extent.X / 2, extent.Y / 2);
+            offset = Vector2f(center.X, center.Y);
+            bottom = box.MinEdge.Z;
+            top = box.MaxEdge.Z;
+            return true;
+        }
+
+        /// adds the obstacles (entities that do not collide themselves) as boxes
+        struct CollectBoxes
+        {
+            CollisionResolver& resolver; ///< where to add the boxes
+            explicit CollectBoxes(CollisionResolver& resolver) : resolver(resolver) {}
+            void operator()(const SimEntityPtr& ent)
+            {
+                if (ent->IsRemoved() || ent->GetCollision() != 0)
+                    return;
+                Vector2f half, offset;
+                float32_t bottom, top;
+                if (!GetFootprint(ent, half, offset, bottom, top))
+                    return;
+                const Vector3f& pos = ent->GetPosition();
+                float32_t yaw = ent->GetRotation().Z;
+                // the box may not be centered on the position of the entity
+                Vector2f shift(offset);
+                shift.rotateBy(yaw);
+                resolver.AddBox(CollisionBox(Vector2f(pos.X, pos.Y) + shift, yaw, half, pos.Z + bottom, pos.Z + top));
+            }
+        };
+
+        /// orders entities by id
+        bool IdLess(const SimEntityPtr& a, const SimEntityPtr& b)
+        {
+            return a->GetSimId() < b->GetSimId();
+        }
+    }
+
+    CollisionBox::CollisionBox()
+        : center()
+        , axis(1, 0)
+        , half()
+        , bottom(0)
+        , top(0)
+    {
+    }
+
+    CollisionBox::CollisionBox(const Vector2f& center, float32_t yaw, const Vector2f& half, float32_t bottom, float32_t top)
+        : center(center)
+        , axis(1, 0)
+        , half(half)
+        , bottom(bottom)
+        , top(top)
+    {
+        axis.rotateBy(yaw);
+    }
+
+    void CollisionBox::GetBounds( Vector2f& lo, Vector2f& hi ) const
+    {
+        float32_t dx = std::fabs(axis.X) * half.X + std::fabs(axis.Y) * half.Y;
+        float32_t dy = std::fabs(axis.Y) * half.X + std::fabs(axis.X) * half.Y;
+        lo = Vector2f(center.X - dx, center.Y - dy);
+        hi = Vector2f(center.X + dx, center.Y + dy);
+    }
+
+    bool CollisionBox::PushOut( Vector2f& point, float32_t radius ) const
+    {
+        // the point in the frame of the rectangle
+        Vector2f across(-axis.Y, axis.X);
+        Vector2f d = point - center;
+        float32_t u = d.dotProduct(axis);
+        float32_t v = d.dotProduct(across);
+
+        // the nearest point of the rectangle
+        float32_t cu = std::max(-half.X, std::min(half.X, u));
+        float32_t cv = std::max(-half.Y, std::min(half.Y, v));
+        float32_t du = u - cu, dv = v - cv;
+        float32_t distSQ = du * du + dv * dv;
+        if (distSQ >= radius * radius)
+            return false;
+
+        if (distSQ > 0)
+        {
+            // outside: move away from the nearest point
+            float32_t dist = std::sqrt(distSQ);
+            u = cu + du * radius / dist;
+            v = cv + dv * radius / dist;
+        }
+        else if (half.X - std::fabs(u) <= half.Y - std::fabs(v))
+        {
+            // inside: leave through the nearest side
+            u = (u < 0 ? -1.0f : 1.0f) * (half.X + radius);
+        }
+        else
+        {
+            v = (v < 0 ? -1.0f : 1.0f) * (half.Y + radius);
+        }
+        point = center + axis * u + across * v;
+        return true;
+    }
+
+    CollisionResolver::CollisionResolver( float32_t cellSize )
+        : mCellSize(cellSize)
+        , mBoxes()
+        , mCells()
+        , mLargeBoxes()
+        , mBoxesDirty(true)
+        , mBoxTypes(0)
+        , mMovers()
+        , mMoverIndex()
+        , mNearby()
+        , mCandidates()
+    {
+        AssertMsg( cellSize > 0, "The cells of a collision grid need a positive size, not " << cellSize );
+    }
+
+    bool CollisionResolver::NoteChange( uint32_t collision, uint32_t dirty_bits )
+    {
+        // what changes the box of an entity that does not collide itself
+        const uint32_t kBoxBits = SimEntityData::kDB_Position | SimEntityData::kDB_Rotation
+            | SimEntityData::kDB_Scale | SimEntityData::kDB_Type;
+        bool changed = (dirty_bits & SimEntityData::kDB_Collision) != 0
+            || (collision == 0 && (dirty_bits & kBoxBits) != 0);
+        if (changed)
+            mBoxesDirty = true;
+        return changed;
+    }
+
+    void CollisionResolver::ClearBoxes()
+    {
+        mBoxes.clear();
+        mCells.clear();
+        mLargeBoxes.clear();
+    }
+
+    void CollisionResolver::RebuildBoxes( const Simulation& sim, uint32_t types )
+    {
+        ClearBoxes();
+        CollectBoxes collect(*this);
+        sim.ForEachEntity(types, collect);
+        mBoxTypes = types;
+        mBoxesDirty = false;
+    }
+
+    size_t CollisionResolver::AddBox( const CollisionBox& box )
+    {
+        uint32_t index = static_cast<uint32_t>(mBoxes.size());
+        mBoxes.push_back(box);
+        Vector2f lo, hi;
+        box.GetBounds(lo, hi);
+        int32_t x0 = CellCoordinate(lo.X), x1 = CellCoordinate(hi.X);
+        int32_t y0 = CellCoordinate(lo.Y), y1 = CellCoordinate(hi.Y);
+        if (double(x1 - x0 + 1) * double(y1 - y0 + 1) > kMaxCellsPerBox)
+        {
+            mLargeBoxes.push_back(index);
+            return index;
+        }
+        for (int32_t x = x0; x <= x1; ++x)
+        {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                mCells[SpatialIndex::MakeKey(x, y)].push_back(index);
+            }
+        }
+        return index;
+    }
+
+    bool CollisionResolver::PushOut( Vector2f& point, float32_t radius, float32_t bottom, float32_t top ) const
+    {
+        if (mBoxes.empty())
+            return false;
+
+        // the boxes in the cells that the circle overlaps, each once and in
+        // the order they were added
+        mCandidates.assign(mLargeBoxes.begin(), mLargeBoxes.end());
+        int32_t x0 = CellCoordinate(point.X - radius), x1 = CellCoordinate(point.X + radius);
+        int32_t y0 = CellCoordinate(point.Y - radius), y1 = CellCoordinate(point.Y + radius);
+        for (int32_t x = x0; x <= x1; ++x)
+        {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                CellMap::const_iterator cell = mCells.find(SpatialIndex::MakeKey(x, y));
+                if (cell != mCells.end())
+                {
+                    mCandidates.insert(mCandidates.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+        std::sort(mCandidates.begin(), mCandidates.end());
+        mCandidates.erase(std::unique(mCandidates.begin(), mCandidates.end()), mCandidates.end());
+
+        // pushing out of one box can push into another, so go around a few times
+        bool pushed = false;
+        for (uint32_t iteration = 0; iteration < kMaxIterations; ++iteration)
+        {
+            bool moved = false;
+            for (size_t i = 0; i < mCandidates.size(); ++i)
+            {
+                const CollisionBox& box = mBoxes[mCandidates[i]];
+                if (box.top < bottom || box.bottom > top)
+                    continue;
+                moved = box.PushOut(point, radius) || moved;
+            }
+            if (!moved)
+                break;
+            pushed = true;
+        }
+        return pushed;
+    }
+
+    Vector2f CollisionResolver::Sweep( const Vector2f& start, const Vector2f& target, float32_t radius, float32_t bottom, float32_t top ) const
+    {
+        // take steps of at most half the radius
+        Vector2f delta = target - start;
+        float32_t length = delta.getLength();
+        uint32_t steps = 1;
+        if (radius > 0)
+        {
+            steps = static_cast<uint32_t>(std::min<float32_t>(kMaxSubsteps, std::ceil(2 * length / radius)));
+            steps = std::max<uint32_t>(steps, 1);
+        }
+        Vector2f step = delta / float32_t(steps);
+        Vector2f point = start;
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            point += step;
+            PushOut(point, radius, bottom, top);
+        }
+        return point;
+    }
+
+    void CollisionResolver::Resolve( Simulation& sim )
+    {
+        // find the entities that collide with things
+        mMovers.clear();
+        mMoverIndex.clear();
+        uint32_t masks = 0;
+        float32_t max_radius = 0;
+        const SimEntityVector& ents = sim.GetEntities();
+        for (SimEntityVector::const_iterator iter = ents.begin(); iter != ents.end(); ++iter)
+        {
+            const SimEntityPtr& ent = *iter;
+            if (ent->IsRemoved())
+            {
+                // a box that went away during the tick
+                if (ent->GetCollision() == 0)
+                    mBoxesDirty = true;
+                continue;
+            }
+            // only a scene node clears the dirty bits, and only an entity
+            // with one has a box
+            if (ent->GetSceneObject())
+                NoteChange(ent->GetCollision(), ent->GetState().GetDirtyBits());
+            if (ent->GetCollision() == 0)
+                continue;
+            Mover mover;
+            Vector2f half, offset;
+            if (!GetFootprint(ent, half, offset, mover.bottom, mover.top))
+                continue;
+            const Vector3f& pos = ent->GetPosition();
+            mover.ent = ent;
+            mover.pos = Vector2f(pos.X, pos.Y);
+            mover.z = pos.Z;
+            mover.radius = std::max(half.X, half.Y);
+            mover.bottom += pos.Z;
+            mover.top += pos.Z;
+            mover.type = ent->GetType();
+            mover.mask = ent->GetCollision();
+            // teleported entities are placed exactly where they were put
+            mover.moved = !ent->IsTeleported() && (pos != ent->GetState().GetPrevious().mPosition);
+            mMoverIndex[ent.get()] = mMovers.size();
+            mMovers.push_back(mover);
+            masks |= mover.mask;
+            max_radius = std::max(max_radius, mover.radius);
+        }
+        if (mMovers.empty())
+            return;
+
+        // the things that do not collide themselves do not move out of the
+        // way, so their boxes stay as they are until one of them changes
+        if (mBoxesDirty || masks != mBoxTypes)
+            RebuildBoxes(sim, masks);
+
+        // move the circles that moved from where they were, sliding along the boxes
+        for (size_t i = 0; i < mMovers.size(); ++i)
+        {
+            Mover& mover = mMovers[i];
+            if (!mover.moved || mBoxes.empty())
+                continue;
+            const Vector3f& prev = mover.ent->GetState().GetPrevious().mPosition;
+            Vector2f pos = Sweep(Vector2f(prev.X, prev.Y), mover.pos, mover.radius, mover.bottom, mover.top);
+            if (pos != mover.pos)
+            {
+                mover.pos = pos;
+                Place(mover);
+            }
+        }
+
+        // separate the circles that moved into each other
+        for (size_t i = 0; i < mMovers.size(); ++i)
+        {
+            Mover& mover = mMovers[i];
+            if (!mover.moved)
+                continue;
+            sim.GetEntitiesWithin(Vector3f(mover.pos.X, mover.pos.Y, mover.z),
+                                  mover.radius + max_radius, mover.mask, mNearby);
+            std::sort(mNearby.begin(), mNearby.end(), IdLess);
+            for (SimEntityVector::const_iterator iter = mNearby.begin(); iter != mNearby.end(); ++iter)
+            {
+                hash_map<const SimEntity*, size_t>::const_iterator other = mMoverIndex.find(iter->get());
+                if (other != mMoverIndex.end() && other->second != i)
+                {
+                    Separate(mover, mMovers[other->second]);
+                }
+            }
+        }
+    }
+
+    void CollisionResolver::Separate( Mover& mover, Mover& other )
+    {
+        if (other.top < mover.bottom || other.bottom > mover.top)
+            return;
+        Vector2f d = mover.pos - other.pos;
+        float32_t dist = d.getLength();
+        float32_t overlap = mover.radius + other.radius - dist;
+        if (overlap <= 0)
+            return;
+        Vector2f dir = (dist > 0) ? d / dist : Vector2f(1, 0);
+        if (other.moved && (mover.type & other.mask))
+        {
+            // both moved into each other, so both step back
+            mover.pos += dir * (overlap / 2);
+            other.pos -= dir * (overlap / 2);
+            PushOut(other.pos, other.radius, other.bottom, other.top);
+            Place(other);
+        }
+        else
+        {
+            mover.pos += dir * overlap;
+        }
+        PushOut(mover.pos, mover.radius, mover.bottom, mover.top);
+        Place(mover);
+    }
+
+    void CollisionResolver::Place( Mover& mover )
+    {
+        mover.ent->SetPosition(Vector3f(mover.pos.X, mover.pos.Y, mover.z));
+    }
+
+} //end OpenNero
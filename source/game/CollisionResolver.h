@@ -0,0 +1,150 @@
+//--------------------------------------------------------
+// OpenNero : CollisionResolver
+//  keeps sim entities from moving into each other
+//--------------------------------------------------------
+
+#ifndef _GAME_COLLISION_RESOLVER_H_
+#define _GAME_COLLISION_RESOLVER_H_
+
+#include <vector>
+#include "core/HashMap.h"
+#include "core/ONTypes.h"
+#include "core/IrrUtil.h"
+#include "game/SpatialIndex.h"
+
+namespace OpenNero
+{
+    /// @cond
+    class Simulation;
+    /// @endcond
+
+    /// The footprint of an obstacle on the X-Y plane: a rotated rectangle
+    /// with a vertical extent
+    struct CollisionBox
+    {
+        Vector2f center;        ///< the middle of the rectangle
+        Vector2f axis;          ///< unit vector along the first pair of sides
+        Vector2f half;          ///< half the lengths of the sides, along axis and across it
+        float32_t bottom;       ///< the lowest point of the obstacle
+        float32_t top;          ///< the highest point of the obstacle
+
+        CollisionBox();
+
+        /// @param center the middle of the rectangle
+        /// @param yaw the rotation of the rectangle around Z, in degrees
+        /// @param half half the lengths of the sides, before the rotation
+        /// @param bottom the lowest point of the obstacle
+        /// @param top the highest point of the obstacle
+        CollisionBox(const Vector2f& center, float32_t yaw, const Vector2f& half, float32_t bottom, float32_t top);
+
+        /// get the smallest axis-aligned box around the rectangle
+        void GetBounds( Vector2f& lo, Vector2f& hi ) const;
+
+        /// move a circle the shortest way out of the rectangle
+        /// @param point the center of the circle, moved if it overlaps
+        /// @param radius the radius of the circle
+        /// @return true if the circle overlapped the rectangle
+        bool PushOut( Vector2f& point, float32_t radius ) const;
+    };
+
+    /// Moves the entities that collide with something (the ones with a
+    /// collision mask) back out of what they moved into during a tick. The
+    /// entities they collide with that do not collide themselves are
+    /// treated as fixed boxes, found through a uniform grid that is only
+    /// rebuilt when they come, go or move; those that do collide are
+    /// treated as circles and pushed apart. The entities are
+    /// handled in the order of the simulation, so the result does not
+    /// depend on anything but the positions.
+    class CollisionResolver
+    {
+    public:
+        /// the most times to push a circle out of the boxes around it
+        static const uint32_t kMaxIterations = 4;
+
+        /// the most steps to split a move into, so that it does not skip over thin boxes
+        static const uint32_t kMaxSubsteps = 16;
+
+        /// the most grid cells a box can cover before it is checked against every move
+        static const size_t kMaxCellsPerBox = 1024;
+
+        /// Constructor
+        /// @param cellSize the side of a square cell of the grid
+        explicit CollisionResolver( float32_t cellSize = SpatialIndex::kDefaultCellSize );
+
+        /// move the entities of the simulation that moved into something
+        void Resolve( Simulation& sim );
+
+        /// collect the boxes again before the next Resolve
+        void Invalidate() { mBoxesDirty = true; }
+
+        /// collect the boxes again before the next Resolve if a change to an
+        /// entity moved a box, or turned an entity into a box or out of one
+        /// @param collision the types the entity collides with now (0 for a box)
+        /// @param dirty_bits what changed in the entity since its scene node was last updated
+        /// @return true if the change affects the boxes
+        bool NoteChange( uint32_t collision, uint32_t dirty_bits );
+
+        /// remove all the boxes
+        void ClearBoxes();
+
+        /// add a box to collide with
+        /// @return the index of the box
+        size_t AddBox( const CollisionBox& box );
+
+        /// move a circle out of the boxes around it
+        /// @param point the center of the circle, moved if it overlaps a box
+        /// @param radius the radius of the circle
+        /// @param bottom the lowest point of the object with the circle
+        /// @param top the highest point of the object with the circle
+        /// @return true if the circle overlapped a box
+        bool PushOut( Vector2f& point, float32_t radius, float32_t bottom, float32_t top ) const;
+
+        /// move a circle from start towards target, sliding along the boxes in the way
+        /// @return where the circle ends up
+        Vector2f Sweep( const Vector2f& start, const Vector2f& target, float32_t radius, float32_t bottom, float32_t top ) const;
+
+    private:
+        /// an entity that collides with things
+        struct Mover
+        {
+            SimEntityPtr ent;   ///< the entity
+            Vector2f pos;       ///< where it is
+            float32_t z;        ///< its height
+            float32_t radius;   ///< the radius of its circle
+            float32_t bottom;   ///< its lowest point
+            float32_t top;      ///< its highest point
+            uint32_t type;      ///< its type
+            uint32_t mask;      ///< the types it collides with
+            bool moved;         ///< whether it moved during the tick
+        };
+
+        /// boxes by cell of a grid laid out as the one of SpatialIndex (only non-empty cells are kept)
+        typedef hash_map<SpatialIndex::CellKey, std::vector<uint32_t> > CellMap;
+
+        /// @return the column or row of the grid containing a coordinate
+        int32_t CellCoordinate( float32_t x ) const { return SpatialIndex::CellCoordinate(x, mCellSize); }
+
+        /// collect the boxes again from the entities of these types that do not collide themselves
+        void RebuildBoxes( const Simulation& sim, uint32_t types );
+
+        /// push two movers apart if the first one moved into the second
+        void Separate( Mover& mover, Mover& other );
+
+        /// put a mover where it is now
+        static void Place( Mover& mover );
+
+        float32_t mCellSize;                    ///< the side of a cell of the grid
+        std::vector<CollisionBox> mBoxes;       ///< the boxes to collide with
+        CellMap mCells;                         ///< the boxes in each cell
+        std::vector<uint32_t> mLargeBoxes;      ///< boxes that cover too many cells to put in them
+        bool mBoxesDirty;                       ///< collect the boxes again before the next Resolve
+        uint32_t mBoxTypes;                     ///< the types the boxes were collected for
+        std::vector<Mover> mMovers;             ///< the entities that collide with things
+        hash_map<const SimEntity*, size_t> mMoverIndex; ///< the index of each entity in mMovers
+        SimEntityVector mNearby;                ///< reused between the range queries
+        mutable std::vector<uint32_t> mCandidates;  ///< reused between the box queries
+    };
+
+} //end OpenNero
+
+#endif // _GAME_COLLISION_RESOLVER_H_
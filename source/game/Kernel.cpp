@@ -151,8 +151,14 @@ namespace OpenNero
             float32_t dt = (curTime - prevTime)/1000.0f; // frame length in seconds
             float32_t fullDT = (curTime - prevFullFrameTime)/1000.0f; // full frame length
             float32_t frameDelay = mCurMod->context->GetFrameDelay(); // expected frame delay
+            float32_t timeStep = mCurMod->context->GetTimeStep(); // fixed frame length, if any
             
-            if (fullDT >= frameDelay) {
+            if (timeStep > 0) {
+                // fast forward: the simulation moves by fixed steps, no matter
+                // how long they take to compute
+                mCurMod->context->ProcessFixedTicks(timeStep, mCurMod->context->GetTicksPerFrame());
+                prevFullFrameTime = curTime;
+            } else if (fullDT >= frameDelay) {
                 mCurMod->context->ProcessTick(dt);
                 prevFullFrameTime = curTime;
             } else {
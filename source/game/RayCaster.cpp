@@ -0,0 +1,417 @@
+//--------------------------------------------------------
+// OpenNero : RayCaster
+//  finds the sim entities hit by rays
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include "game/RayCaster.h"
+#include "game/Simulation.h"
+#include "render/SceneObject.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <boost/bind.hpp>
+
+namespace OpenNero
+{
+    namespace {
+        /// most triangles in a leaf of a TriangleBVH
+        const size_t kLeafSize = 4;
+
+        /// orders triangle indices by one coordinate of their centers
+        struct CenterLess
+        {
+            const std::vector<Vector3f>& centers; ///< center of every triangle
+            int axis; ///< 0 for X, 1 for Y, 2 for Z
+            CenterLess(const std::vector<Vector3f>& centers, int axis) : centers(centers), axis(axis) {}
+            bool operator()(uint32_t a, uint32_t b) const
+            {
+                const Vector3f& ca = centers[a];
+                const Vector3f& cb = centers[b];
+                switch (axis)
+                {
+                    case 0: return ca.X < cb.X;
+                    case 1: return ca.Y < cb.Y;
+                    default: return ca.Z < cb.Z;
+                }
+            }
+        };
+
+        /// does the part of the line from start within maxDistance pass through the box?
+        bool LineHitsBox(const Vector3f& start, const Vector3f& direction, float32_t maxDistance, const BBoxf& box)
+        {
+            float32_t tmin = 0, tmax = maxDistance;
+            const float32_t s[3] = { start.X, start.Y, start.Z };
+            const float32_t d[3] = { direction.X, direction.Y, direction.Z };
+            const float32_t lo[3] = { box.MinEdge.X, box.MinEdge.Y, box.MinEdge.Z };
+            const float32_t hi[3] = { box.MaxEdge.X, box.MaxEdge.Y, box.MaxEdge.Z };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (d[axis] == 0)
+                {
+                    if (s[axis] < lo[axis] || s[axis] > hi[axis])
+                        return false;
+                    continue;
+                }
+                float32_t t1 = (lo[axis] - s[axis]) / d[axis];
+                float32_t t2 = (hi[axis] - s[axis]) / d[axis];
+                if (t1 > t2) std::swap(t1, t2);
+                tmin = std::max(tmin, t1);
+                tmax = std::min(tmax, t2);
+                if (tmin > tmax)
+                    return false;
+            }
+            return true;
+        }
+
+        /// collects the triangles of the entities a ray may hit
+        struct CollectTriangles
+        {
+            const RayCaster& caster;    ///< to tell the static entities
+            TriangleBVH& bvh;           ///< where to put the triangles
+            std::vector<SimEntityPtr>& owners; ///< where to put the entities
+            std::vector<Triangle3f> triangles; ///< scratch space
+            bool statics;               ///< collect the static entities rather than the others
+
+            CollectTriangles(const RayCaster& caster, TriangleBVH& bvh, std::vector<SimEntityPtr>& owners, bool statics)
+                : caster(caster), bvh(bvh), owners(owners), triangles(), statics(statics) {}
+
+            void operator()(const SimEntityPtr& ent)
+            {
+                // go by the type the entity is filed under, which only
+                // changes when the static hierarchy is invalidated
+                if (caster.IsStatic(TypeIndex::GetFiledType(*ent)) != statics)
+                    return;
+                SceneObjectPtr obj = ent->GetSceneObject();
+                if (!obj)
+                    return;
+                triangles.clear();
+                // static entities are indexed once, so make sure their
+                // nodes are where they should be
+                if (obj->AppendRayTriangles(triangles, NULL, statics) > 0)
+                {
+                    bvh.AddObject(obj->GetId(), triangles);
+                    owners.push_back(ent);
+                }
+            }
+        };
+    }
+
+    TriangleBVH::Hit::Hit()
+        : object(-1)
+        , distanceSQ(FLT_MAX)
+        , point()
+    {
+    }
+
+    TriangleBVH::TriangleBVH()
+        : mTriangles()
+        , mOwners()
+        , mObjectIds()
+        , mNodes()
+        , mBuilt(true)
+    {
+    }
+
+    void TriangleBVH::Clear()
+    {
+        mTriangles.clear();
+        mOwners.clear();
+        mObjectIds.clear();
+        mNodes.clear();
+        mBuilt = true;
+    }
+
+    size_t TriangleBVH::AddObject( int32_t id, const std::vector<Triangle3f>& triangles )
+    {
+        size_t object = mObjectIds.size();
+        mObjectIds.push_back(id);
+        mTriangles.insert(mTriangles.end(), triangles.begin(), triangles.end());
+        mOwners.resize(mTriangles.size(), static_cast<uint32_t>(object));
+        mBuilt = false;
+        return object;
+    }
+
+    void TriangleBVH::Build()
+    {
+        mNodes.clear();
+        mBuilt = true;
+        if (mTriangles.empty())
+            return;
+
+        std::vector<Vector3f> centers(mTriangles.size());
+        for (size_t i = 0; i < mTriangles.size(); ++i)
+        {
+            const Triangle3f& t = mTriangles[i];
+            centers[i] = (t.pointA + t.pointB + t.pointC) / 3.0f;
+        }
+        mNodes.reserve(2 * (mTriangles.size() / kLeafSize + 1));
+        mNodes.push_back(Node());
+        BuildNode(0, 0, mTriangles.size(), centers);
+    }
+
+    void TriangleBVH::BuildNode( size_t node, size_t first, size_t last, std::vector<Vector3f>& centers )
+    {
+        // bound the triangles and their centers
+        BBoxf box(mTriangles[first].pointA);
+        BBoxf middles(centers[first]);
+        for (size_t i = first; i < last; ++i)
+        {
+            box.addInternalPoint(mTriangles[i].pointA);
+            box.addInternalPoint(mTriangles[i].pointB);
+            box.addInternalPoint(mTriangles[i].pointC);
+            middles.addInternalPoint(centers[i]);
+        }
+        // pad the box so that rounding in the triangle test cannot put a
+        // collision point just outside of it
+        Vector3f extent = box.getExtent();
+        float32_t pad = 1e-4f * (1.0f + std::max(extent.X, std::max(extent.Y, extent.Z))
+                                 + std::max(box.MaxEdge.getLength(), box.MinEdge.getLength()));
+        box.MinEdge -= Vector3f(pad, pad, pad);
+        box.MaxEdge += Vector3f(pad, pad, pad);
+        mNodes[node].box = box;
+
+        if (last - first <= kLeafSize)
+        {
+            mNodes[node].first = static_cast<uint32_t>(first);
+            mNodes[node].count = static_cast<uint32_t>(last - first);
+            return;
+        }
+
+        // split at the median center along the longest axis of the centers
+        Vector3f spread = middles.getExtent();
+        int axis = (spread.X >= spread.Y && spread.X >= spread.Z) ? 0 : (spread.Y >= spread.Z ? 1 : 2);
+        std::vector<uint32_t> order(last - first);
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<uint32_t>(first + i);
+        size_t middle = order.size() / 2;
+        std::nth_element(order.begin(), order.begin() + middle, order.end(), CenterLess(centers, axis));
+
+        // put the triangles (and their owners and centers) in that order
+        std::vector<Triangle3f> triangles(order.size());
+        std::vector<uint32_t> owners(order.size());
+        std::vector<Vector3f> middles_sorted(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            triangles[i] = mTriangles[order[i]];
+            owners[i] = mOwners[order[i]];
+            middles_sorted[i] = centers[order[i]];
+        }
+        std::copy(triangles.begin(), triangles.end(), mTriangles.begin() + first);
+        std::copy(owners.begin(), owners.end(), mOwners.begin() + first);
+        std::copy(middles_sorted.begin(), middles_sorted.end(), centers.begin() + first);
+
+        size_t left = mNodes.size();
+        mNodes[node].first = static_cast<uint32_t>(left);
+        mNodes[node].count = 0;
+        mNodes.push_back(Node());
+        mNodes.push_back(Node());
+        BuildNode(left, first, first + middle, centers);
+        BuildNode(left + 1, first + middle, last, centers);
+    }
+
+    void TriangleBVH::Intersect( const Line3f& ray, int32_t bits, Hit& hit ) const
+    {
+        AssertMsg( mBuilt, "TriangleBVH::Build needs to be called after adding objects" );
+        if (mNodes.empty())
+            return;
+
+        // the same set up as CSceneCollisionManager::getCollisionPoint
+        const Vector3f linevect = ray.getVector().normalize();
+        const float32_t raylength = ray.getLengthSQ();
+        const float32_t minX = std::min(ray.start.X, ray.end.X);
+        const float32_t maxX = std::max(ray.start.X, ray.end.X);
+        const float32_t minY = std::min(ray.start.Y, ray.end.Y);
+        const float32_t maxY = std::max(ray.start.Y, ray.end.Y);
+        const float32_t minZ = std::min(ray.start.Z, ray.end.Z);
+        const float32_t maxZ = std::max(ray.start.Z, ray.end.Z);
+        const float32_t length = sqrtf(raylength);
+
+        uint32_t stack[64];
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = mNodes[stack[--top]];
+            float32_t reach = std::min(length, hit.distanceSQ < FLT_MAX ? sqrtf(hit.distanceSQ) : length);
+            if (!LineHitsBox(ray.start, linevect, reach, node.box))
+                continue;
+            if (node.count == 0)
+            {
+                Assert( top + 2 <= sizeof(stack) / sizeof(stack[0]) );
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+                continue;
+            }
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                if (bits != 0 && !(mObjectIds[mOwners[i]] & bits))
+                    continue;
+
+                const Triangle3f& triangle = mTriangles[i];
+                if (minX > triangle.pointA.X && minX > triangle.pointB.X && minX > triangle.pointC.X)
+                    continue;
+                if (maxX < triangle.pointA.X && maxX < triangle.pointB.X && maxX < triangle.pointC.X)
+                    continue;
+                if (minY > triangle.pointA.Y && minY > triangle.pointB.Y && minY > triangle.pointC.Y)
+                    continue;
+                if (maxY < triangle.pointA.Y && maxY < triangle.pointB.Y && maxY < triangle.pointC.Y)
+                    continue;
+                if (minZ > triangle.pointA.Z && minZ > triangle.pointB.Z && minZ > triangle.pointC.Z)
+                    continue;
+                if (maxZ < triangle.pointA.Z && maxZ < triangle.pointB.Z && maxZ < triangle.pointC.Z)
+                    continue;
+
+                Vector3f intersection;
+                if (triangle.getIntersectionWithLine(ray.start, linevect, intersection))
+                {
+                    const float32_t tmp = intersection.getDistanceFromSQ(ray.start);
+                    const float32_t tmp2 = intersection.getDistanceFromSQ(ray.end);
+                    if (tmp < raylength && tmp2 < raylength && tmp < hit.distanceSQ)
+                    {
+                        hit.object = static_cast<int32_t>(mOwners[i]);
+                        hit.distanceSQ = tmp;
+                        hit.point = intersection;
+                    }
+                }
+            }
+        }
+    }
+
+    RayCaster::RayCaster()
+        : mStaticTypes(0)
+        , mStaticDirty(false)
+        , mStatic()
+        , mDynamicReady(false)
+        , mDynamic()
+        , mMutex()
+        , mThreadPool()
+    {
+    }
+
+    void RayCaster::SetStaticTypes( uint32_t types )
+    {
+        if (types != mStaticTypes)
+        {
+            mStaticTypes = types;
+            mStaticDirty = true;
+        }
+    }
+
+    bool RayCaster::NoteChange( uint32_t filed_type, uint32_t type, uint32_t dirty_bits )
+    {
+        // what the scene node of an entity picks up from its data
+        const uint32_t kPoseBits = SimEntityData::kDB_Position | SimEntityData::kDB_Rotation
+            | SimEntityData::kDB_Scale | SimEntityData::kDB_Type;
+        bool changed;
+        if (type != filed_type)
+            changed = IsStatic(filed_type) || IsStatic(type);
+        else
+            changed = IsStatic(type) && (dirty_bits & kPoseBits) != 0;
+        if (changed)
+            mStaticDirty = true;
+        return changed;
+    }
+
+    void RayCaster::Refresh( const Simulation& sim )
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        if (!mStaticDirty)
+            return;
+        mStatic.bvh.Clear();
+        mStatic.owners.clear();
+        if (mStaticTypes != 0)
+        {
+            CollectTriangles collect(*this, mStatic.bvh, mStatic.owners, true);
+            sim.ForEachEntity(mStaticTypes, collect);
+        }
+        mStatic.bvh.Build();
+        mStaticDirty = false;
+        LOG_F_DEBUG("collision", "indexed " << mStatic.bvh.GetNumTriangles() << " triangles of "
+            << mStatic.bvh.GetNumObjects() << " static objects for ray casting");
+    }
+
+    void RayCaster::Collect( const Simulation& sim )
+    {
+        // animated nodes update their triangles when asked for them, so
+        // this is done once for all the casts of a tick
+        boost::mutex::scoped_lock lock(mMutex);
+        if (mDynamicReady)
+            return;
+        mDynamic.bvh.Clear();
+        mDynamic.owners.clear();
+        CollectTriangles collect(*this, mDynamic.bvh, mDynamic.owners, false);
+        const SimEntityVector& ents = sim.GetEntities();
+        for (SimEntityVector::const_iterator iter = ents.begin(); iter != ents.end(); ++iter)
+        {
+            collect(*iter);
+        }
+        mDynamic.bvh.Build();
+        mDynamicReady = true;
+    }
+
+    void RayCaster::Prepare( const Simulation& sim )
+    {
+        Refresh(sim);
+        Collect(sim);
+    }
+
+    void RayCaster::CastOne( const RayQuery& ray, const Snapshot& dynamic, RayHit& hit ) const
+    {
+        Line3f line(ConvertNeroToIrrlichtPosition(ray.origin), ConvertNeroToIrrlichtPosition(ray.target));
+        int32_t bits = static_cast<int32_t>(ray.types);
+        TriangleBVH::Hit staticHit, dynamicHit;
+        mStatic.bvh.Intersect(line, bits, staticHit);
+        dynamicHit.distanceSQ = staticHit.distanceSQ;
+        dynamic.bvh.Intersect(line, bits, dynamicHit);
+        if (dynamicHit.object >= 0)
+        {
+            hit.entity = dynamic.owners[dynamicHit.object];
+            hit.position = ConvertIrrlichtToNeroPosition(dynamicHit.point);
+        }
+        else if (staticHit.object >= 0)
+        {
+            hit.entity = mStatic.owners[staticHit.object];
+            hit.position = ConvertIrrlichtToNeroPosition(staticHit.point);
+        }
+        else
+        {
+            hit.entity.reset();
+            hit.position = ray.target;
+        }
+    }
+
+    void RayCaster::CastIndexed( const std::vector<RayQuery>* rays, const Snapshot* dynamic, std::vector<RayHit>* hits, size_t i ) const
+    {
+        CastOne((*rays)[i], *dynamic, (*hits)[i]);
+    }
+
+    bool RayCaster::Cast( const Simulation& sim, const RayQuery& ray, RayHit& hit )
+    {
+        // within a tick both are prepared, and this only reads
+        if (mStaticDirty || !mDynamicReady)
+            Prepare(sim);
+        CastOne(ray, mDynamic, hit);
+        return hit.entity != NULL;
+    }
+
+    void RayCaster::CastAll( const Simulation& sim, const std::vector<RayQuery>& rays, std::vector<RayHit>& hits, size_t num_threads )
+    {
+        hits.resize(rays.size());
+        if (rays.empty())
+            return;
+        if (mStaticDirty || !mDynamicReady)
+            Prepare(sim);
+
+        if (num_threads == 1 || rays.size() == 1)
+        {
+            for (size_t i = 0; i < rays.size(); ++i)
+                CastOne(rays[i], mDynamic, hits[i]);
+            return;
+        }
+        if (!mThreadPool || (num_threads != 0 && mThreadPool->GetNumThreads() != num_threads))
+            mThreadPool.reset(new ThreadPool(num_threads));
+        mThreadPool->ParallelFor(rays.size(), boost::bind(&RayCaster::CastIndexed, this, &rays, &mDynamic, &hits, _1));
+    }
+
+} //end OpenNero
@@ -0,0 +1,190 @@
+//--------------------------------------------------------
+// OpenNero : RayCaster
+//  finds the sim entities hit by rays
+//--------------------------------------------------------
+
+#ifndef _GAME_RAY_CASTER_H_
+#define _GAME_RAY_CASTER_H_
+
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "core/ONTypes.h"
+#include "core/IrrUtil.h"
+#include "core/ThreadPool.h"
+#include "game/SimEntity.h"
+
+namespace OpenNero
+{
+    /// @cond
+    class Simulation;
+    /// @endcond
+
+    /// A ray to cast into the simulation
+    struct RayQuery
+    {
+        Vector3f origin;    ///< where the ray starts
+        Vector3f target;    ///< where the ray ends
+        uint32_t types;     ///< bitmask of the objects to care about or 0 for 'check all'
+
+        RayQuery() : origin(), target(), types(0) {}
+        RayQuery(const Vector3f& origin, const Vector3f& target, uint32_t types)
+            : origin(origin), target(target), types(types) {}
+    };
+
+    /// The first object hit by a ray
+    struct RayHit
+    {
+        SimEntityPtr entity;    ///< the entity hit, empty if the ray did not hit anything
+        Vector3f position;      ///< where the ray hit it
+    };
+
+    /// A bounding volume hierarchy over the triangles of a set of objects
+    /// (in Irrlicht world coordinates). Rays are tested against the
+    /// triangles the same way the Irrlicht collision manager tests them, so
+    /// that both find the same collision points.
+    class TriangleBVH
+    {
+    public:
+        /// the closest hit found so far by one or more calls to Intersect
+        struct Hit
+        {
+            int32_t object;         ///< index of the object hit, or -1
+            float32_t distanceSQ;   ///< squared distance from the start of the ray
+            Vector3f point;         ///< the collision point
+            Hit();
+        };
+
+        TriangleBVH();
+
+        /// remove all the objects
+        void Clear();
+
+        /// add the triangles of an object, which will be indexed on the next Build
+        /// @param id the scene object id of the object, matched against the ray masks
+        /// @param triangles the triangles of the object
+        /// @return the index of the new object
+        size_t AddObject( int32_t id, const std::vector<Triangle3f>& triangles );
+
+        /// index the triangles of all the objects added so far
+        void Build();
+
+        /// @return the number of objects
+        size_t GetNumObjects() const { return mObjectIds.size(); }
+
+        /// @return the number of triangles
+        size_t GetNumTriangles() const { return mTriangles.size(); }
+
+        /// find the triangle nearest to the start of the ray, if it is nearer than the hit
+        /// @param ray the ray to cast
+        /// @param bits mask of the objects to consider, matched against their ids (0 for all)
+        /// @param hit the closest hit so far, updated if this finds a closer one
+        void Intersect( const Line3f& ray, int32_t bits, Hit& hit ) const;
+
+    private:
+        /// a box around a range of the triangles
+        struct Node
+        {
+            BBoxf box;          ///< bounds of the triangles, slightly padded
+            uint32_t first;     ///< the first triangle of a leaf, or the left child
+            uint32_t count;     ///< the number of triangles of a leaf, 0 for inner nodes
+        };
+
+        /// build the subtree for triangles [first, last) as node
+        void BuildNode( size_t node, size_t first, size_t last, std::vector<Vector3f>& centers );
+
+        std::vector<Triangle3f> mTriangles;     ///< the triangles, in tree order once built
+        std::vector<uint32_t> mOwners;          ///< the object of each triangle
+        std::vector<int32_t> mObjectIds;        ///< the scene object id of each object
+        std::vector<Node> mNodes;               ///< the tree, the root first
+        bool mBuilt;                            ///< whether the tree matches the triangles
+    };
+
+    /// Casts rays against the triangles of the entities in a simulation.
+    /// Entities with one of the static types are assumed to move rarely, so
+    /// their triangles are kept in a TriangleBVH that is only rebuilt when
+    /// entities of those types are added, removed, moved, turned or scaled,
+    /// or change type. The triangles of other entities are collected once
+    /// per tick, by Prepare or by the first cast after Expire, and every
+    /// cast until the next Expire reads them without locking.
+    class RayCaster
+    {
+    public:
+        RayCaster();
+
+        /// @return the bitmask of the types of the entities that do not move
+        uint32_t GetStaticTypes() const { return mStaticTypes; }
+
+        /// set the bitmask of the types of the entities that do not move
+        void SetStaticTypes( uint32_t types );
+
+        /// @return whether an entity of this type is kept in the static hierarchy
+        bool IsStatic( uint32_t type ) const { return (type & mStaticTypes) != 0; }
+
+        /// rebuild the static hierarchy before the next cast
+        void Invalidate() { mStaticDirty = true; }
+
+        /// collect the triangles of the moving entities again before the next
+        /// cast, because their scene nodes moved or entities came or went
+        void Expire() { mDynamicReady = false; }
+
+        /// bring both sets of triangles up to date for the casts to come.
+        /// Casts from several threads at once only read, so this has to be
+        /// called on one thread before they start.
+        /// @param sim the simulation with the entities
+        void Prepare( const Simulation& sim );
+
+        /// rebuild the static hierarchy before the next cast if a change to an
+        /// entity moved triangles into, out of or within it
+        /// @param filed_type the type the simulation files the entity under
+        /// @param type the type of the entity now
+        /// @param dirty_bits what changed in the entity since its scene node was last updated
+        /// @return true if the change affects the static hierarchy
+        bool NoteChange( uint32_t filed_type, uint32_t type, uint32_t dirty_bits );
+
+        /// find the entity hit first by a ray
+        /// @param sim the simulation with the entities
+        /// @param ray the ray to cast (NERO coordinates)
+        /// @param hit the result (NERO coordinates)
+        /// @return true if the ray hit an entity
+        bool Cast( const Simulation& sim, const RayQuery& ray, RayHit& hit );
+
+        /// find the entities hit first by a number of rays
+        /// @param sim the simulation with the entities
+        /// @param rays the rays to cast (NERO coordinates)
+        /// @param hits the results, one per ray (NERO coordinates)
+        /// @param num_threads threads to cast on (0 for one per core)
+        void CastAll( const Simulation& sim, const std::vector<RayQuery>& rays, std::vector<RayHit>& hits, size_t num_threads = 1 );
+
+    private:
+        /// the triangles of some entities
+        struct Snapshot
+        {
+            TriangleBVH bvh;                    ///< the triangles
+            std::vector<SimEntityPtr> owners;   ///< the entity of each object of the bvh
+        };
+
+        /// rebuild the static hierarchy if needed
+        void Refresh( const Simulation& sim );
+
+        /// collect the triangles of the entities that are not static if needed
+        void Collect( const Simulation& sim );
+
+        /// cast one ray against the static and the collected triangles
+        void CastOne( const RayQuery& ray, const Snapshot& dynamic, RayHit& hit ) const;
+
+        /// cast the i'th ray of a batch, called on a thread of the pool
+        void CastIndexed( const std::vector<RayQuery>* rays, const Snapshot* dynamic, std::vector<RayHit>* hits, size_t i ) const;
+
+        uint32_t mStaticTypes;                  ///< types of the entities that do not move
+        bool mStaticDirty;                      ///< rebuild the static hierarchy before the next cast
+        Snapshot mStatic;                       ///< the triangles of the entities that do not move
+        bool mDynamicReady;                     ///< whether mDynamic holds the moving entities of this tick
+        Snapshot mDynamic;                      ///< the triangles of the other entities
+        boost::mutex mMutex;                    ///< guards rebuilding the snapshots
+        boost::scoped_ptr<ThreadPool> mThreadPool; ///< created for the first parallel batch
+    };
+
+} //end OpenNero
+
+#endif // _GAME_RAY_CASTER_H_
@@ -70,6 +70,8 @@ namespace OpenNero
     SimContext::SimContext()
         : mClearColor(255, 100, 101, 140)
         , mInputReceiver( kIR_Game )
+        , mAnimationTime(0)
+        , mLogicalClock(false)
     {}
 
     /// basic destructor
@@ -145,6 +147,21 @@ namespace OpenNero
         return true;
     }
 
+    WorldSnapshotPtr SimContext::TakeSnapshot() const
+    {
+        Assert( mpSimulation );
+        WorldSnapshotPtr snapshot(new WorldSnapshot());
+        snapshot->Capture(*mpSimulation);
+        return snapshot;
+    }
+
+    bool SimContext::RestoreSnapshot( WorldSnapshotPtr snapshot )
+    {
+        Assert( mpSimulation );
+        AssertMsg( snapshot, "Restoring the world from a null snapshot" );
+        return snapshot->Restore(*mpSimulation, shared_from_this());
+    }
+
     /// Add a set of cartesian axes to the world
     void SimContext::AddAxes()
     {
@@ -218,6 +235,9 @@ namespace OpenNero
     /// onPop - destruction code for teh state
     bool SimContext::onPop()
     {
+        // leave the device's timer running for whatever comes next
+        UseWallClock();
+
         // --- clear out our stuff
         FlushContext();
 
@@ -267,6 +287,8 @@ namespace OpenNero
     /// @param dt the time to increment by
     void SimContext::ProcessTick(float32_t dt)
     {
+        UseWallClock();
+
         // This will cause Irrlicht to render the objects
         UpdateRenderSystem(dt);
         
@@ -278,6 +300,42 @@ namespace OpenNero
         // potentially change a lot of things such as which mod we want to run.
         UpdateInputSystem(dt);
 
+        UpdateWorld(dt);
+    }
+
+    /// Move the world forward by a fixed number of ticks of the same
+    /// length, independent of the clock. Only the first tick renders; the
+    /// others (and all of them when headless) only run the scene animators.
+    /// The animators see the time of the ticks rather than of the clock.
+    /// @param dt the time to increment by in every tick
+    /// @param ticks the number of ticks
+    void SimContext::ProcessFixedTicks(float32_t dt, uint32_t ticks)
+    {
+        UseLogicalClock();
+        ITimer* timer = mIrr.getDevice()->getTimer();
+        for (uint32_t i = 0; i < ticks; ++i)
+        {
+            timer->setTime(uint32_t(mAnimationTime));
+            if (i == 0)
+            {
+                UpdateRenderSystem(dt);
+                LineSet::instance().ClearSegments();
+                UpdateInputSystem(dt);
+            }
+            else
+            {
+                AnimateScene();
+                LineSet::instance().ClearSegments();
+            }
+            UpdateWorld(dt);
+            mAnimationTime += dt * 1000.0;
+        }
+    }
+
+    /// Tick everything but the rendering and the input
+    /// @param dt the time to increment by
+    void SimContext::UpdateWorld(float32_t dt)
+    {
         // Call the ProcessTick method of the global AI manager
         AIManager::instance().ProcessTick(dt);
 
@@ -295,6 +353,8 @@ namespace OpenNero
     /// @param dt the time to increment by
     void SimContext::ProcessAnimationTick(float32_t dt, float32_t frac)
     {
+        UseWallClock();
+
         // This will cause Irrlicht to render the objects
         UpdateRenderSystem(dt);
 
@@ -323,6 +383,13 @@ namespace OpenNero
     /// Update the rendering system
     void SimContext::UpdateRenderSystem(float32_t dt)
     {
+        // without a display, there is nothing to draw to
+        if (mIrr.getVideoDriver()->getDriverType() == irr::video::EDT_NULL)
+        {
+            AnimateScene();
+            return;
+        }
+
         // draw the scene
         static bool sClearBackBuffer = true;
         static bool sClearZBuffer    = true;
@@ -340,6 +407,36 @@ namespace OpenNero
 
     }
 
+    /// Run the animators of the scene nodes (which is also the first thing
+    /// that drawing the scene does) at the time of the device's timer
+    void SimContext::AnimateScene()
+    {
+        mIrr.getSceneManager()->getRootSceneNode()->OnAnimate(mIrr.getDevice()->getTimer()->getTime());
+    }
+
+    /// Stop the device's timer where it is, so that only the fixed ticks
+    /// move it (and drawing and AnimateScene go by the simulated time)
+    void SimContext::UseLogicalClock()
+    {
+        if (!mLogicalClock)
+        {
+            ITimer* timer = mIrr.getDevice()->getTimer();
+            mAnimationTime = timer->getTime();
+            timer->stop();
+            mLogicalClock = true;
+        }
+    }
+
+    /// Let the device's timer run again, from the time the fixed ticks reached
+    void SimContext::UseWallClock()
+    {
+        if (mLogicalClock)
+        {
+            mIrr.getDevice()->getTimer()->start();
+            mLogicalClock = false;
+        }
+    }
+
     /// Update the scripting system by a bit
     void SimContext::UpdateScriptingSystem(float32_t dt)
     {
@@ -444,29 +541,18 @@ namespace OpenNero
                                 const SColor& noneColor
                               )
 	{
-        ISceneCollisionManager* collider = mIrr.getSceneManager()->getSceneCollisionManager();
-        Assert(collider);
-        Line3f ray(ConvertNeroToIrrlichtPosition(origin), ConvertNeroToIrrlichtPosition(target));
-        Triangle3f outTriangle;
-        ISceneNode* node = collider->getSceneNodeAndCollisionPointFromRay
-            (ray, hitPos, outTriangle, type);
-        // convert back into our coord system
-        hitPos = ConvertIrrlichtToNeroPosition(hitPos);
-        if (node && node->getID() >= kFirstSimId)
+        RayHit hit;
+        if (getSimulation()->FindInRay(RayQuery(origin, target, type), hit))
         {
-            // we found a sim node, so return its data
-            SimEntityPtr ent = getSimulation()->FindBySceneObjectId(node->getID());
-            if (ent)
+            // return the result: (sim, hit)
+            hitEntity = hit.entity->GetState();
+            hitPos = hit.position;
+            // draw a ray if requested
+            if (vis)
             {
-                // return the result: (sim, hit)
-                hitEntity = ent->GetState();
-                // draw a ray if requested
-                if (vis)
-                {
-                    LineSet::instance().AddSegment(origin, hitPos, foundColor);
-                }
-                return true;
+                LineSet::instance().AddSegment(origin, hitPos, foundColor);
             }
+            return true;
         }
         if (vis)
         {
@@ -496,6 +582,79 @@ namespace OpenNero
         }        
     }
 
+    namespace {
+        /// appends the ids of the visited entities to a python list
+        struct AppendEntityIds
+        {
+            boost::python::list& ids; ///< the list to append to
+            explicit AppendEntityIds(boost::python::list& ids) : ids(ids) {}
+            void operator()(const SimEntityPtr& ent) { ids.append(ent->GetSimId()); }
+        };
+    }
+
+    /// @param types bitmask of the types of the entities to list
+    /// @return python list of the SimIds of the matching entities
+    boost::python::list SimContext::PyGetEntityIds( uint32_t types ) const
+    {
+        boost::python::list ids;
+        AppendEntityIds append(ids);
+        mpSimulation->ForEachEntity(types, append);
+        return ids;
+    }
+
+    /// @param rays python list of (origin, target) tuples of Vector3f
+    /// @param type bitmask of the objects to care about or 0 for 'check all'
+    /// @param threads the number of threads to cast on (0 for one per core)
+    /// @param vis draw the rays, up to what they hit, like findInRay
+    /// @param foundColor the color of the rays that hit something
+    /// @param noneColor the color of the rays that hit nothing
+    /// @return python list with a (sim, hit) tuple or () for every ray, like findInRay
+    boost::python::list SimContext::PyFindInRays( const boost::python::list& rays,
+                                                  const uint32_t& type,
+                                                  size_t threads,
+                                                  const bool vis,
+                                                  const SColor& foundColor,
+                                                  const SColor& noneColor )
+    {
+        std::vector<RayQuery> queries(boost::python::len(rays));
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            boost::python::object ray = rays[i];
+            queries[i] = RayQuery(boost::python::extract<Vector3f>(ray[0]),
+                                  boost::python::extract<Vector3f>(ray[1]),
+                                  type);
+        }
+        std::vector<RayHit> hits;
+        getSimulation()->FindInRays(queries, hits, threads);
+        boost::python::list result;
+        for (size_t i = 0; i < hits.size(); ++i)
+        {
+            if (hits[i].entity)
+            {
+                result.append(boost::python::make_tuple(hits[i].entity->GetState(), hits[i].position));
+                if (vis)
+                {
+                    LineSet::instance().AddSegment(queries[i].origin, hits[i].position, foundColor);
+                }
+            }
+            else
+            {
+                result.append(boost::python::make_tuple());
+                if (vis)
+                {
+                    LineSet::instance().AddSegment(queries[i].origin, queries[i].target, noneColor);
+                }
+            }
+        }
+        return result;
+    }
+
+    /// @param types bitmask of the types of the objects that do not move once added
+    void SimContext::SetStaticRayTypes( uint32_t types )
+    {
+        getSimulation()->SetStaticRayTypes(types);
+    }
+
     /// @param x screen x-coordinate for active camera
     /// @param y screen y-coordinate for active camera
     /// @return Approximate 3d position of the click
@@ -13,6 +13,7 @@
 #include "game/Kernel.h"
 #include "game/Mod.h"
 #include "game/Simulation.h"
+#include "game/WorldSnapshot.h"
 #include "input/IOMapping.h"
 #include "render/SceneObject.h"
 #include "render/FPSCounter.h"
@@ -119,6 +120,17 @@ namespace OpenNero
                                           const SColor& noneColor = SColor(255,255,255,0)
                                         );
 
+        /// Find the first object that intersects each of a list of (origin, target) rays
+        boost::python::list PyFindInRays( const boost::python::list& rays,
+                                          const uint32_t& type = 0,
+                                          size_t threads = 1,
+                                          const bool vis = false,
+                                          const SColor& foundColor = SColor(255,255,0,0),
+                                          const SColor& noneColor = SColor(255,255,255,0) );
+
+        /// Set the types of the objects that rays can treat as never moving
+        void SetStaticRayTypes( uint32_t types );
+
         /// Get (approximate) 3d position of the click
         Vector3f GetClickedPosition(const int32_t& x, const int32_t& y);
 
@@ -131,6 +143,9 @@ namespace OpenNero
         /// Get the current position of the mouse on the screen
         Pos2i GetMousePosition();
 
+        /// Get the ids of all the entities that have any of the types in the mask
+        boost::python::list PyGetEntityIds( uint32_t types ) const;
+
         /// These methods call the corresponding methods of SimEntity specified by the id
         /// @{
         void SetObjectPosition( SimId id, const Vector3f& pos );
@@ -185,6 +200,24 @@ namespace OpenNero
         /// How long, in seconds, to wait between executing AI frames
         void SetFrameDelay(float32_t delay) { mpSimulation->SetFrameDelay(delay); }
 
+        /// The fixed length, in seconds, of an AI frame, or 0 to follow the clock
+        float32_t GetTimeStep() const { return mpSimulation->GetTimeStep(); }
+
+        /// The fixed length, in seconds, of an AI frame, or 0 to follow the clock
+        void SetTimeStep(float32_t step) { mpSimulation->SetTimeStep(step); }
+
+        /// How many AI frames to run for every rendered frame when the time step is fixed
+        uint32_t GetTicksPerFrame() const { return mpSimulation->GetTicksPerFrame(); }
+
+        /// How many AI frames to run for every rendered frame when the time step is fixed
+        void SetTicksPerFrame(uint32_t ticks) { mpSimulation->SetTicksPerFrame(ticks); }
+
+        /// Capture the whole world, to roll back to later
+        WorldSnapshotPtr TakeSnapshot() const;
+
+        /// Put the world back the way it was when the snapshot was taken
+        bool RestoreSnapshot( WorldSnapshotPtr snapshot );
+
         /// @}
 
         /// return the active camera
@@ -199,6 +232,10 @@ namespace OpenNero
         /// process the animation frame thats frac between two AI frames
         void ProcessAnimationTick(float32_t dt, float32_t frac);
 
+        /// move the world forward by a number of ticks of length dt while
+        /// rendering at most one frame
+        void ProcessFixedTicks(float32_t dt, uint32_t ticks);
+
         /// return the simulation
         SimulationPtr getSimulation() { return mpSimulation; }
 
@@ -217,6 +254,14 @@ namespace OpenNero
         void UpdateInputSystem(float32_t dt);
 		/// render graphics
         void UpdateRenderSystem(float32_t dt);
+		/// run the scene animators without drawing
+        void AnimateScene();
+		/// move the scene animators by the logical clock of the fixed ticks
+        void UseLogicalClock();
+		/// move the scene animators by the wall clock again
+        void UseWallClock();
+		/// tick the AI, the simulation and the scripts
+        void UpdateWorld(float32_t dt);
 		/// update scripting objects
         void UpdateScriptingSystem(float32_t dt);
 		/// update simulation
@@ -257,6 +302,9 @@ namespace OpenNero
         InputReceiver       mInputReceiver;             ///< The current input receiver
 
         FPSCounter          mFPSCounter;                ///< Frames Per Second counter
+
+        float64_t           mAnimationTime;             ///< Time (ms) of the scene animators during fixed ticks
+        bool                mLogicalClock;              ///< Whether the animators follow mAnimationTime
     };
 
     /**
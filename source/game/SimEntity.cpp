@@ -23,7 +23,9 @@ namespace OpenNero
 		mSceneObject(),
 		mSharedData(data),
 		mCreationTemplate(templateName),
-        mRemoved(false)
+        mRemoved(false),
+        mTeleported(false),
+        mFiledType(0)
 	{
 	}
 
@@ -92,6 +94,7 @@ namespace OpenNero
 
         // we tick the shared data so that it can remember where it was
         mSharedData.ProcessTick(incAmt);
+        mTeleported = false;
     }
 
     void SimEntity::TickScene(float32_t incAmt)
@@ -278,11 +281,17 @@ namespace OpenNero
         mSharedData.SetCollision(mask);
     }
 
+    void SimEntity::SetType(uint32_t type)
+    {
+        mSharedData.SetType(type);
+    }
+
     void SimEntity::UpdateImmediately()
     {
         // set all the bits to indicate that the information was updated
         mSharedData.SetAllDirtyBits();
         mSceneObject->DisregardCollisions();
+        mTeleported = true;
     }
 
     /// output SimEntity to stream
@@ -45,6 +45,10 @@ namespace OpenNero
     {
         // Allow Simulation to manage SimEntity ids and parent sim.
         friend class Simulation;
+        // Allow SpatialIndex to follow the moves of the SimEntity.
+        friend class SpatialIndex;
+        // Allow TypeIndex to remember the type the SimEntity is filed under.
+        friend class TypeIndex;
 
     public:
         /// Create a new sim entity using given creation data
@@ -124,12 +128,16 @@ namespace OpenNero
         void SetLabel( const std::string& label );
         void SetColor( const SColor& color );
         void SetCollision( uint32_t mask );
+        void SetType( uint32_t type );
         /// @}
 
         /// Make the state update immediate, "teleporting" the agent
         /// to the current state and ignoring collisions
         void UpdateImmediately();
 
+        /// Was the object teleported (see UpdateImmediately) since the start of the tick
+        bool IsTeleported() const { return mTeleported; }
+
         /// Is the object marked for removal
         bool IsRemoved() const { return mRemoved; }
 
@@ -163,6 +171,12 @@ namespace OpenNero
 
         /// removed flag
         bool            mRemoved;
+
+        /// teleported during this tick flag
+        bool            mTeleported;
+
+        /// the type the simulation files this entity under
+        uint32_t        mFiledType;
     };
 
 } //end OpenNero
@@ -7,6 +7,7 @@
 #include "game/SimEntityData.h"
 #include "game/Kernel.h"
 #include "game/SimContext.h"
+#include "game/SpatialIndex.h"
 #include "core/IrrSerialize.h"
 
 namespace OpenNero 
@@ -47,6 +48,7 @@ namespace OpenNero
         , mDirtyBits(uint32_t(-1))
         , mPrevious()
         , mCurrent()
+        , mSpatialIndex(NULL)
     {
     }
     
@@ -62,8 +64,39 @@ namespace OpenNero
         , mDirtyBits(uint32_t(-1))
         , mPrevious(pos, rot, scale, label, t, collision)
         , mCurrent(pos, rot, scale, label, t, collision)
+        , mSpatialIndex(NULL)
     {
     }
+
+    SimEntityData::SimEntityData(const SimEntityData& data)
+        : mId(data.mId)
+        , mDirtyBits(data.mDirtyBits)
+        , mPrevious(data.mPrevious)
+        , mCurrent(data.mCurrent)
+        , mSpatialIndex(NULL)
+    {
+    }
+
+    SimEntityData::~SimEntityData()
+    {
+        if (mSpatialIndex)
+        {
+            mSpatialIndex->Remove(*this);
+        }
+    }
+
+    SimEntityData& SimEntityData::operator=(const SimEntityData& data)
+    {
+        mId = data.mId;
+        mDirtyBits = data.mDirtyBits;
+        mPrevious = data.mPrevious;
+        mCurrent = data.mCurrent;
+        if (mSpatialIndex)
+        {
+            mSpatialIndex->Update(*this);
+        }
+        return *this;
+    }
     
     void SimEntityData::SetPosition( const Vector3f& pos )
     {
@@ -71,6 +104,10 @@ namespace OpenNero
         {
             mCurrent.mPosition = pos;
             mDirtyBits |= kDB_Position;
+            if (mSpatialIndex)
+            {
+                mSpatialIndex->Update(*this);
+            }
         }
     }
 
@@ -274,4 +311,43 @@ namespace OpenNero
 		return stream;
 	}
 
+    namespace {
+        /// write the state of an entity at one point in time to a bitstream
+        void WriteInternals(Bitstream& stream, const SimEntityData::SimEntityInternals& state)
+        {
+            stream << state.mPosition << state.mRotation << state.mVelocity
+                   << state.mScale << state.mAcceleration << state.mLabel
+                   << state.mColor.color << state.mType << state.mCollision;
+        }
+
+        /// read the state written by WriteInternals
+        void ReadInternals(Bitstream& stream, SimEntityData::SimEntityInternals& state)
+        {
+            stream >> state.mPosition >> state.mRotation >> state.mVelocity
+                   >> state.mScale >> state.mAcceleration >> state.mLabel
+                   >> state.mColor.color >> state.mType >> state.mCollision;
+        }
+    }
+
+    Bitstream& operator<<(Bitstream& stream, const SimEntityData& data)
+    {
+        stream << data.mId;
+        WriteInternals(stream, data.mCurrent);
+        WriteInternals(stream, data.mPrevious);
+        return stream;
+    }
+
+    Bitstream& operator>>(Bitstream& stream, SimEntityData& data)
+    {
+        stream >> data.mId;
+        ReadInternals(stream, data.mCurrent);
+        ReadInternals(stream, data.mPrevious);
+        data.mDirtyBits = uint32_t(-1);
+        if (data.mSpatialIndex)
+        {
+            data.mSpatialIndex->Update(data);
+        }
+        return stream;
+    }
+
 } //end OpenNero
@@ -19,6 +19,8 @@ namespace OpenNero
     BOOST_PTR_DECL(SimEntityData);
     /// @endcond
 
+    class SpatialIndex;
+
     /// SimEntityData stores mutable data 
     class SimEntityData
     {
@@ -75,6 +77,15 @@ namespace OpenNero
                       uint32_t collision,
                       SimId id);
 
+        /// Copy constructor - the copy is not in any spatial index
+        SimEntityData(const SimEntityData& data);
+
+        /// Destructor - leaves the spatial index, if any
+        ~SimEntityData();
+
+        /// Assignment - stays in the same spatial index, if any
+        SimEntityData& operator=(const SimEntityData& data);
+
         void SetPosition( const Vector3f& pos );      ///< Set position of entity
         void SetRotation( const Vector3f& rot );      ///< Set rotation of entity
         void SetVelocity( const Vector3f& vel );      ///< Set velocity of entity
@@ -116,6 +127,10 @@ namespace OpenNero
         bool operator!= ( SimEntityData const& x );
 
     private:
+        friend class SpatialIndex;
+        friend Bitstream& operator<<(Bitstream& stream, const SimEntityData& data);
+        friend Bitstream& operator>>(Bitstream& stream, SimEntityData& data);
+
         /// The id of the object
         SimId mId;
 
@@ -127,6 +142,9 @@ namespace OpenNero
 
         /// Current state
         SimEntityInternals mCurrent;
+
+        /// The spatial index that tracks the position of this object (if any)
+        SpatialIndex* mSpatialIndex;
         
     };
 
@@ -136,6 +154,13 @@ namespace OpenNero
 	/// output SimEntityData to stream
 	std::ostream& operator<<(std::ostream& stream, const SimEntityData& data);
 
+    /// write the id and the current and previous state to a bitstream
+    Bitstream& operator<<(Bitstream& stream, const SimEntityData& data);
+
+    /// read data written to a bitstream, staying in the same spatial index
+    /// (if any) and marking everything dirty
+    Bitstream& operator>>(Bitstream& stream, SimEntityData& data);
+
 } //end OpenNero
 
 #endif // _GAME_SIMENTITY_DATA_H_
@@ -1,7 +1,9 @@
 #include "core/Common.h"
 #include "utils/Config.h"
 
+#include <map>
 #include <vector>
+#include <algorithm>
 
 #include "game/Simulation.h"
 #include "game/SimEntity.h"
@@ -12,20 +14,100 @@
 #include "ai/AIObject.h"
 #include "ai/AgentBrain.h"
 
+#include "math/Random.h"
+
 namespace OpenNero
 {
     /// Constructor - initialize variables
     Simulation::Simulation( const IrrHandles& irr )
         : mIrr(irr)
+        , mSpatialIndex()
+        , mRayCaster()
+        , mCollisions()
+        , mNativeCollisions(GetAppConfig().NativeCollisions)
+        , mAIThreadPool()
         , mMaxId(kFirstSimId)
         , mFrameDelay(GetAppConfig().FrameDelay)
+        , mTimeStep(GetAppConfig().TimeStep)
+        , mTicksPerFrame(GetAppConfig().TicksPerFrame)
     {
-        // initialize entity types
-        for (size_t i = 0; i < sizeof(uint32_t); ++i)
+    }
+
+    namespace {
+        /// whether an entity is marked for removal
+        bool IsRemoved(const SimEntityPtr& ent)
         {
-            SimEntitySet entitites;
-            mEntityTypes[1 << i] = entitites;
+            return ent->IsRemoved();
         }
+
+        /// adds the visited entities to a set
+        struct CollectEntities
+        {
+            SimEntitySet& result; ///< the set to add to
+            explicit CollectEntities(SimEntitySet& result) : result(result) {}
+            void operator()(const SimEntityPtr& ent) { result.insert(ent); }
+        };
+
+        /// adds the triangles of the visited entities to a meta selector
+        struct CollectTriangles
+        {
+            IMetaTriangleSelector_IPtr selector; ///< the selector to add to
+            explicit CollectTriangles(IMetaTriangleSelector_IPtr selector) : selector(selector) {}
+            void operator()(const SimEntityPtr& ent)
+            {
+                ITriangleSelector_IPtr tri_selector = ent->GetSceneObject()->GetTriangleSelector();
+                selector->addTriangleSelector(tri_selector.get());
+            }
+        };
+
+        /// an agent with a C++ brain, ticked in phases
+        struct PhasedAgent
+        {
+            SimEntityPtr ent;       ///< the entity of the agent
+            AIObjectPtr ai;         ///< its AI
+            bool acts;              ///< whether it senses and acts this tick
+            bool native_world;      ///< whether its environment can sense off the main thread
+            bool serial;            ///< whether it decides on the main thread, in order
+            uint32_t seed;          ///< seeds the random numbers of its decision
+        };
+
+        /// reads the sensors of an agent (and decides, if that needs no Python)
+        struct SenseAgent
+        {
+            std::vector<PhasedAgent>& agents; ///< the agents of this tick
+            float32_t dt; ///< the length of the tick
+            SenseAgent(std::vector<PhasedAgent>& agents, float32_t dt) : agents(agents), dt(dt) {}
+            void operator()(size_t i) const
+            {
+                const PhasedAgent& agent = agents[i];
+                if (!agent.acts)
+                    return;
+                agent.ai->SenseSensors();
+                if (agent.native_world && !agent.serial)
+                {
+                    ScopedRandomStream stream(agent.seed);
+                    agent.ai->SenseWorld();
+                    agent.ai->Decide(dt);
+                }
+            }
+        };
+
+        /// decides for an agent that the environment sensed for on the main thread
+        struct DecideAgent
+        {
+            std::vector<PhasedAgent>& agents; ///< the agents of this tick
+            float32_t dt; ///< the length of the tick
+            DecideAgent(std::vector<PhasedAgent>& agents, float32_t dt) : agents(agents), dt(dt) {}
+            void operator()(size_t i) const
+            {
+                const PhasedAgent& agent = agents[i];
+                if (agent.acts && !agent.native_world && !agent.serial)
+                {
+                    ScopedRandomStream stream(agent.seed);
+                    agent.ai->Decide(dt);
+                }
+            }
+        };
     }
 
     /// Deconstructor - remove everything
@@ -44,31 +126,25 @@ namespace OpenNero
     {
         AssertMsg( ent, "Adding a null entity to the simulation!" );
         AssertMsg( !Find( ent->GetSimId() ), "Entity with id " << ent->GetSimId() << " already exists in the simulation" );
-        mSimIdHashedEntities[ ent->GetSimId() ] = ent;
-        mEntities.insert(ent);
+        // the entity takes the next slot; iterating up to the slots that
+        // were taken before a tick started does not see it
+        mSlots[ ent->GetSimId() ] = mEntities.size();
+        mEntities.push_back(ent);
         mEntitiesAdded.push_back(ent);
+        mSpatialIndex.Insert(ent);
         uint32_t ent_type = ent->GetType();
-        for (size_t i = 0; i < sizeof(uint32_t); ++i) {
-            uint32_t t = 1 << i;
-            if (t > ent_type) break; // shortcut
-            if (ent_type & t) {
-                mEntityTypes[t].insert(ent);
-            }
+        if (mRayCaster.IsStatic(ent_type)) {
+            mRayCaster.Invalidate();
         }
-
-        { // also make sure to add the triangle selector for this object to 
-          // all relevant meta selectors
-            hash_map<uint32_t, IMetaTriangleSelector_IPtr>::iterator iter;
-            for (iter = mCollisionSelectors.begin(); iter != mCollisionSelectors.end(); ++iter) {
-                // if the entity type matches the stored mask
-                if (iter->first & ent_type) {
-                    // add the triangles to that selector
-                    ITriangleSelector_IPtr tri_selector = ent->GetSceneObject()->GetTriangleSelector();
-                    iter->second->addTriangleSelector(tri_selector.get());
-                    LOG_F_DEBUG("collision", "added " << tri_selector->getTriangleCount() << " triangles for a total of " << iter->second->getTriangleCount() << " triangles that collide with type " << iter->first);
-                }
-            }
+        mRayCaster.Expire();
+        if (ent->GetCollision() == 0) {
+            mCollisions.Invalidate();
         }
+        mEntityTypes.Insert(ent);
+
+        // also make sure to add the triangle selector for this object to
+        // all relevant meta selectors
+        UpdateCollisionSelectors(ent, 0, ent_type);
         
         GetCollisionTriangleSelector(ent_type);
         AssertMsg( Find(ent->GetSimId()) == ent, "The entity with id " << ent->GetSimId() << " could not be properly added" );
@@ -76,7 +152,7 @@ namespace OpenNero
 
     /**
      * Request a SimEntity to be removed from the simulation.
-     * The actual removal takes place during the RemoveNow call at
+     * The actual removal takes place during the RemoveMarked call at
      * the end of the next ProcessTick.
      */
     void Simulation::Remove( SimId id )
@@ -92,11 +168,18 @@ namespace OpenNero
     {
         // clear our internal containers
 
-        // clear out entities hashed by id
-        mSimIdHashedEntities.clear();
+        // clear out the slots by id
+        mSlots.clear();
 
-        // clear out iteration order list
+        // clear out the entities and the ones waiting for their first tick
         mEntities.clear();
+        mEntitiesAdded.clear();
+
+        // clear out the positions
+        mSpatialIndex.Clear();
+        mRayCaster.Invalidate();
+        mRayCaster.Expire();
+        mCollisions.Invalidate();
 
         // clear out triangle selector cache
         {
@@ -107,14 +190,8 @@ namespace OpenNero
             mCollisionSelectors.clear();
         }
 
-        // clear out type set cache
-        {
-            hash_map<uint32_t, SimEntitySet>::iterator iter;
-            for (iter = mEntityTypes.begin(); iter != mEntityTypes.end(); ++iter) {
-                iter->second.clear();
-            }
-            mEntityTypes.clear();
-        }
+        // clear out type index
+        mEntityTypes.Clear();
     }
 
     /**
@@ -124,8 +201,8 @@ namespace OpenNero
     */
     SimEntityPtr Simulation::Find( SimId id ) const
     {
-        SimIdHashMap::const_iterator itr = mSimIdHashedEntities.find(id);
-        return ( itr == mSimIdHashedEntities.end() ) ? SimEntityPtr() : itr->second;
+        SlotMap::const_iterator itr = mSlots.find(id);
+        return ( itr == mSlots.end() ) ? SimEntityPtr() : mEntities[itr->second];
     }
 
     /**
@@ -142,27 +219,44 @@ namespace OpenNero
     /// move the simulation forward by time dt
     void Simulation::ProcessTick( float32_t dt )
     {
-        // this step will allow mSimIdHashedEntities to be modified during the ticks
-        SimIdHashMap entities_to_tick(mSimIdHashedEntities.begin(), mSimIdHashedEntities.end());
-        SimIdHashMap::const_iterator itr;
-        
+        // entities added during the tick go to the end of mEntities (and to
+        // mEntitiesAdded), so only look at the ones that were here before
+        const size_t count = mEntities.size();
+
         // render all objects
-        for(itr = entities_to_tick.begin() ; itr != entities_to_tick.end(); ++itr ) {
-			SimEntityPtr ent = itr->second;
+        for (size_t i = 0; i < count && i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
             if (!ent->IsRemoved()) {
+                // the scene node is about to follow the changes of the last
+                // tick, so rays need to see the static entities that moved
+                uint32_t filed = TypeIndex::GetFiledType(*ent);
+                if (ent->GetSceneObject()) {
+                    mRayCaster.NoteChange(filed, ent->GetType(), ent->GetState().GetDirtyBits());
+                    mCollisions.NoteChange(ent->GetCollision(), ent->GetState().GetDirtyBits());
+                }
+                // entities that changed type during the last tick go under the new type
+                if (ent->GetType() != filed) {
+                    Refile(ent);
+                }
                 ent->BeforeTick(dt);
                 ent->TickScene(dt);
             }
         }
+        // the scene nodes moved, so the rays of this tick see them anew
+        mRayCaster.Expire();
         
         // make AI decisions
         if (AIManager::instance().IsEnabled())
         {
-            for(itr = entities_to_tick.begin() ; itr != entities_to_tick.end(); ++itr ) {
-                SimEntityPtr ent = itr->second;
-                if (!ent->IsRemoved()) {
-                    ent->TickAI(dt);
+            if (!AIManager::instance().IsPhased()) {
+                for (size_t i = 0; i < count && i < mEntities.size(); ++i) {
+                    SimEntityPtr ent = mEntities[i];
+                    if (!ent->IsRemoved()) {
+                        ent->TickAI(dt);
+                    }
                 }
+            } else {
+                ProcessAIPhases(count, dt);
             }
             SimEntityList::const_iterator added_itr;
             
@@ -178,70 +272,349 @@ namespace OpenNero
             }
         }                
         
+        // keep the entities that moved during the tick out of each other
+        if (mNativeCollisions)
+        {
+            mCollisions.Resolve(*this);
+        }
+        
         mEntitiesAdded.clear();
         
-        // iterate over all the entities deleting those marked for removal
-        for (itr = entities_to_tick.begin(); itr != entities_to_tick.end(); ++itr) {
-            SimId id = itr->first;
-            SimEntityPtr ent = itr->second;
+        // delete the entities marked for removal
+        RemoveMarked();
+    }
+
+    void Simulation::SaveState( Bitstream& stream ) const
+    {
+        // most entities share a few templates, so the names go first and
+        // the entities refer to them by index
+        std::vector<std::string> templates;
+        std::map<std::string, uint32_t> template_index;
+        std::vector<uint32_t> entity_templates;
+        entity_templates.reserve(mEntities.size());
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            if (mEntities[i]->IsRemoved()) {
+                continue;
+            }
+            const std::string& name = mEntities[i]->mCreationTemplate;
+            std::map<std::string, uint32_t>::const_iterator found = template_index.find(name);
+            if (found == template_index.end()) {
+                found = template_index.insert(std::make_pair(name, uint32_t(templates.size()))).first;
+                templates.push_back(name);
+            }
+            entity_templates.push_back(found->second);
+        }
+        stream << mMaxId << templates << uint32_t(entity_templates.size());
+
+        // brains that share what they learn write it once
+        BrainSavePass pass;
+        Bitstream brain;
+        size_t saved = 0;
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
             if (ent->IsRemoved()) {
-                SimIdHashMap::iterator simItr = mSimIdHashedEntities.find(id);
-                
-                if( simItr != mSimIdHashedEntities.end() ) {
-                    SimEntityPtr simE = simItr->second;
-					AIObjectPtr brain = simE->GetAIObject();
-					if (brain) {
-						brain->getBrain()->destroy();
-					}
-                    AssertMsg( simE, "Invalid SimEntity on delete, id: " << id );
-                    // remove also from entities set
-                    SimEntitySet::iterator simInSet = mEntities.find(simE);
-                    if (simInSet != mEntities.end()) {
-                        mEntities.erase(simInSet);
-                    }
-                    
-                    // remove also from the type-indexed set
-                    uint32_t ent_type = simE->GetType();
-                    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
-                        uint32_t t = 1 << i;
-                        if (t > ent_type) break; // shortcut
-                        if (ent_type & t) {
-                            simInSet = mEntityTypes[t].find(simE);
-                            if (simInSet != mEntityTypes[t].end()) {
-                                mEntityTypes[t].erase(simE);
-                            }
-                        }
-                    }
+                continue;
+            }
+            stream << entity_templates[saved++] << ent->mSharedData;
 
-                    { // also make sure to remove the triangle selector for this object from 
-                      // all relevant meta selectors
-                        hash_map<uint32_t, IMetaTriangleSelector_IPtr>::iterator iter;
-                        for (iter = mCollisionSelectors.begin(); iter != mCollisionSelectors.end(); ++iter) {
-                            // if the entity type matches the stored mask
-                            if (iter->first & ent_type) {
-                                // remove the triangles from that selector
-                                iter->second->removeTriangleSelector(ent->GetSceneObject()->GetTriangleSelector().get());
-                            }
-                        }
-                    }
+            // the brain goes with its length, so that one that does not fit
+            // any more can be skipped
+            brain.Clear();
+            AIObjectPtr ai = ent->GetAIObject();
+            if (ai && ai->getBrain()) {
+                ai->SaveState(brain);
+            }
+            stream << brain.ByteLength() << brain;
+        }
+    }
 
-                    mSimIdHashedEntities.erase(simItr);
+    bool Simulation::ReadState( Bitstream& stream, SavedWorld& world )
+    {
+        uint32_t count;
+        stream >> world.max_id >> world.templates >> count;
+        // every entity takes more than a byte, so a corrupt count shows here
+        if (stream.Failed() || count > stream.ByteLength()) {
+            LOG_F_ERROR("game", "the world snapshot is cut short before its entities");
+            return false;
+        }
+
+        world.entities.clear();
+        world.entities.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            SavedWorld::Entity& saved = world.entities[i];
+            uint32_t length;
+            stream >> saved.template_index >> saved.data >> length;
+            if (stream.Failed() || length > stream.ByteLength()) {
+                LOG_F_ERROR("game", "the world snapshot ends after " << i << " of " << count << " entities");
+                return false;
+            }
+            if (saved.template_index >= world.templates.size()) {
+                LOG_F_ERROR("game", "entity " << saved.data.GetId() << " of the world snapshot has no template");
+                return false;
+            }
+            // the brain goes with its length, so that one that does not fit
+            // any more can be skipped
+            if (length > 0) {
+                std::vector<uint8_t> bytes(length);
+                stream.PopBytes(&bytes[0], length);
+                saved.brain.PushBytes(&bytes[0], length);
+            }
+        }
+        return true;
+    }
+
+    bool Simulation::LoadState( Bitstream& stream, SimContextPtr context )
+    {
+        SavedWorld world;
+        if (!ReadState(stream, world)) {
+            return false;
+        }
+        return LoadState(world, context);
+    }
+
+    bool Simulation::LoadState( const SavedWorld& world, SimContextPtr context )
+    {
+        // whatever is not in the world goes
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            mEntities[i]->SetRemoved();
+        }
+
+        bool complete = true;
+        SimEntityVector restored;
+        restored.reserve(world.entities.size());
+        for (size_t i = 0; i < world.entities.size(); ++i) {
+            const SavedWorld::Entity& saved = world.entities[i];
+            SimEntityData data = saved.data;
+            const std::string& template_name = world.templates[saved.template_index];
+
+            SimEntityPtr ent = Find(data.GetId());
+            if (ent) {
+                ent->mRemoved = false;
+            } else {
+                ent = SimEntity::CreateSimEntity(data, template_name, context);
+                if (ent) {
+                    AddSimEntity(ent);
+                } else {
+                    LOG_F_ERROR("game", "could not create entity " << data.GetId() << " again from " << template_name);
+                    complete = false;
+                }
+            }
+            if (ent) {
+                // the jump back is not a move to collide on the way, and the
+                // saved state replaces whatever the template set up
+                if (ent->mSceneObject) {
+                    ent->UpdateImmediately();
                 }
+                ent->mSharedData = data;
+                ent->mTeleported = true;
+                restored.push_back(ent);
+            }
+
+            if (!saved.brain.IsEmpty()) {
+                // read a copy, so that the world can be loaded again
+                Bitstream brain(saved.brain);
+                AIObjectPtr ai = ent ? ent->GetAIObject() : AIObjectPtr();
+                if (!ai || !ai->getBrain() || !ai->LoadState(brain)) {
+                    LOG_F_WARNING("game", "the brain of entity " << data.GetId() << " could not take its saved state");
+                    complete = false;
+                }
+            }
+        }
+        RemoveMarked();
+
+        // never hand out an id again, not even one given out after the
+        // snapshot: Python may still hold it, and it must not find a new entity
+        mMaxId = std::max(mMaxId, world.max_id);
+
+        // tick in the saved order, with nothing waiting for its first tick
+        mEntities.swap(restored);
+        mEntitiesAdded.clear();
+        mSlots.clear();
+        mEntityTypes.Clear();
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
+            mSlots[ent->GetSimId()] = i;
+            // the saved type may not be the one the entity was filed under
+            uint32_t filed = TypeIndex::GetFiledType(*ent);
+            mEntityTypes.Insert(ent);
+            UpdateCollisionSelectors(ent, filed, ent->GetType());
+        }
+        mRayCaster.Invalidate();
+        mRayCaster.Expire();
+        mCollisions.Invalidate();
+        return complete;
+    }
+
+    /**
+     * Take the entities marked for removal out of the simulation, all at
+     * once. The entities that stay keep their order.
+     */
+    void Simulation::RemoveMarked()
+    {
+        SimEntityVector::iterator first_removed = std::find_if(mEntities.begin(), mEntities.end(), IsRemoved);
+        if (first_removed == mEntities.end()) {
+            return;
+        }
+
+        // close the gaps, moving the entities that stay to their new slots
+        SimEntityVector removed;
+        size_t kept = first_removed - mEntities.begin();
+        for (size_t i = kept; i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
+            if (ent->IsRemoved()) {
+                removed.push_back(ent);
+            } else {
+                mSlots[ent->GetSimId()] = kept;
+                mEntities[kept++] = ent;
+            }
+        }
+        mEntities.resize(kept);
+
+        // remove also from the type index and from the rays
+        mEntityTypes.RemoveMarked();
+        mRayCaster.Expire();
+
+        SimEntityVector::const_iterator iter;
+        for (iter = removed.begin(); iter != removed.end(); ++iter) {
+            SimEntityPtr ent = *iter;
+            AIObjectPtr brain = ent->GetAIObject();
+            if (brain) {
+                brain->getBrain()->destroy();
+            }
+
+            mSlots.erase(ent->GetSimId());
+
+            // remove also from the spatial index
+            mSpatialIndex.Remove(ent);
+
+            // the static hierarchy holds the entity by the type it is filed under
+            if (mRayCaster.IsStatic(TypeIndex::GetFiledType(*ent))) {
+                mRayCaster.Invalidate();
+            }
+            if (ent->GetCollision() == 0) {
+                mCollisions.Invalidate();
+            }
+
+            // also make sure to remove the triangle selector for this object from
+            // all relevant meta selectors
+            UpdateCollisionSelectors(ent, TypeIndex::GetFiledType(*ent), 0);
+
+            AssertMsg( !Find(ent->GetSimId()), "Did not properly remove entity from simulation!" );
+        }
+    }
+
+    /**
+     * File an entity whose type changed under its new type, in the type
+     * index and in the collision selectors.
+     */
+    void Simulation::Refile( SimEntityPtr ent )
+    {
+        uint32_t filed = mEntityTypes.Refile(ent);
+        UpdateCollisionSelectors(ent, filed, ent->GetType());
+    }
+
+    void Simulation::UpdateCollisionSelectors( SimEntityPtr ent, uint32_t old_type, uint32_t new_type )
+    {
+        hash_map<uint32_t, IMetaTriangleSelector_IPtr>::iterator iter;
+        for (iter = mCollisionSelectors.begin(); iter != mCollisionSelectors.end(); ++iter) {
+            // only the selectors whose mask matches one type but not the other
+            bool was_selected = (iter->first & old_type) != 0;
+            bool is_selected = (iter->first & new_type) != 0;
+            if (was_selected == is_selected) {
+                continue;
+            }
+            ITriangleSelector_IPtr tri_selector = ent->GetSceneObject()->GetTriangleSelector();
+            if (is_selected) {
+                // add the triangles to that selector
+                iter->second->addTriangleSelector(tri_selector.get());
+                LOG_F_DEBUG("collision", "added " << tri_selector->getTriangleCount() << " triangles for a total of " << iter->second->getTriangleCount() << " triangles that collide with type " << iter->first);
+            } else {
+                // remove the triangles from that selector
+                iter->second->removeTriangleSelector(tri_selector.get());
+            }
+        }
+    }
 
-                AssertMsg( !Find(id), "Did not properly remove entity from simulation!" );
+    /**
+     * Tick the AI of the entities in phases. The agents with C++ brains and
+     * sensors all sense and decide against the world as it is at the start
+     * of the phase, in parallel, and then act one at a time. Everything that
+     * changes the world or needs Python happens on this thread in the order
+     * of the entities, and every decision draws from its own random stream,
+     * so the result does not depend on the number of threads. Brains that
+     * learn into state shared with other brains decide on this thread too,
+     * in the order of the entities, so that what they learn does not depend
+     * on how the threads were scheduled.
+     * @param count the number of entities (from the first) to tick
+     * @param dt the length of the tick
+     */
+    void Simulation::ProcessAIPhases( size_t count, float32_t dt )
+    {
+        size_t num_threads = AIManager::instance().GetNumThreads();
+        if (!mAIThreadPool || (num_threads != 0 && mAIThreadPool->GetNumThreads() != num_threads))
+            mAIThreadPool.reset(new ThreadPool(num_threads));
+
+        // end the episodes that are over
+        std::vector<PhasedAgent> agents;
+        bool python_world = false;
+        bool any_serial = false;
+        for (size_t i = 0; i < count && i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
+            AIObjectPtr ai = ent->GetAIObject();
+            if (ent->IsRemoved() || !ai || !ai->IsNative())
+                continue;
+            PhasedAgent agent;
+            agent.ent = ent;
+            agent.ai = ai;
+            agent.acts = ai->BeginTick(dt);
+            agent.native_world = ai->HasNativeWorld();
+            agent.serial = ai->getBrain() && ai->getBrain()->SharesState();
+            agent.seed = RANDOM.randI();
+            python_world = python_world || (agent.acts && !agent.native_world);
+            any_serial = any_serial || (agent.acts && agent.serial);
+            agents.push_back(agent);
+        }
+
+        // sense and decide, with the rays only reading what was collected here
+        mRayCaster.Prepare(*this);
+        mAIThreadPool->ParallelFor(agents.size(), SenseAgent(agents, dt));
+        if (python_world) {
+            for (size_t i = 0; i < agents.size(); ++i) {
+                if (agents[i].acts && !agents[i].native_world)
+                    agents[i].ai->SenseWorld();
+            }
+            mRayCaster.Prepare(*this);
+            mAIThreadPool->ParallelFor(agents.size(), DecideAgent(agents, dt));
+        }
+        if (any_serial) {
+            for (size_t i = 0; i < agents.size(); ++i) {
+                if (!agents[i].acts || !agents[i].serial)
+                    continue;
+                ScopedRandomStream stream(agents[i].seed);
+                if (agents[i].native_world)
+                    agents[i].ai->SenseWorld();
+                agents[i].ai->Decide(dt);
+            }
+        }
+
+        // act, in the same order as the other entities tick
+        size_t next = 0;
+        for (size_t i = 0; i < count && i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
+            if (next < agents.size() && agents[next].ent == ent) {
+                if (agents[next].acts && !ent->IsRemoved())
+                    agents[next].ai->EndTick();
+                ++next;
+            } else if (!ent->IsRemoved()) {
+                ent->TickAI(dt);
             }
         }
     }
     
     void Simulation::ProcessAnimationTick( float32_t frac )
     {
-        // this step will allow mSimIdHashedEntities to be modified during the ticks
-        SimIdHashMap entities_to_tick(mSimIdHashedEntities.begin(), mSimIdHashedEntities.end());
-        SimIdHashMap::const_iterator itr = entities_to_tick.begin();
-        SimIdHashMap::const_iterator end = entities_to_tick.end();
-        
-        for( ; itr != end; ++itr ) {
-			SimEntityPtr ent = itr->second;
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            SimEntityPtr ent = mEntities[i];
             ent->ProcessAnimationTick(frac); // tick only if not removed
         }
     }
@@ -249,16 +622,8 @@ namespace OpenNero
     const SimEntitySet Simulation::GetEntities(size_t types) const
     {
         SimEntitySet result;
-        for (size_t i = 0; i < sizeof(uint32_t); ++i) {
-            uint32_t t = 1 << i;
-            // gone past the possible type masks?
-            if (t > types) break;
-            if (types & t) {
-                hash_map<uint32_t, SimEntitySet>::const_iterator type_set = mEntityTypes.find(t);
-                Assert(type_set != mEntityTypes.end());
-                result.insert(type_set->second.begin(), type_set->second.end());
-            }
-        }
+        CollectEntities collect(result);
+        ForEachEntity(types, collect);
         return result;
     }
     
@@ -277,14 +642,9 @@ namespace OpenNero
         } else {
             // if not found, create the selector
             meta_selector = mIrr.getSceneManager()->createMetaTriangleSelector();
-            SimEntitySet ents = GetEntities(types);
             // iterate over all entities of that type and add them to the selector
-            for (SimEntitySet::const_iterator iter = ents.begin(); iter != ents.end(); ++iter)
-            {
-                SimEntityPtr ent = *iter;
-                ITriangleSelector_IPtr tri_selector = ent->GetSceneObject()->GetTriangleSelector();
-                meta_selector->addTriangleSelector(tri_selector.get());
-            }
+            CollectTriangles collect(meta_selector);
+            ForEachEntity(types, collect);
             // remember for future reuse
             mCollisionSelectors[types] = meta_selector;
             LOG_F_DEBUG("collision", "created triangle selector for mask " 
@@ -3,10 +3,17 @@
 
 #include <set>
 #include <list>
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
 #include "core/HashMap.h"
 #include "core/Common.h"
 #include "core/IrrUtil.h"
+#include "core/ThreadPool.h"
 #include "game/SimEntity.h"
+#include "game/SpatialIndex.h"
+#include "game/TypeIndex.h"
+#include "game/RayCaster.h"
+#include "game/CollisionResolver.h"
 #include "render/SceneObject.h"
 
 namespace OpenNero
@@ -51,13 +58,50 @@ namespace OpenNero
         /// find an entity by its SceneObject ID
         SimEntityPtr FindBySceneObjectId( SceneObjectId id ) const;
 
-        /// Get the set of all the entities in the simulation
-        const SimEntitySet GetEntities() const { return mEntities; }
+        /// Get all the entities in the simulation, in the order they tick in.
+        /// Entities marked for removal stay until the end of the tick.
+        const SimEntityVector& GetEntities() const { return mEntities; }
 
-        /// Get the set of all the entities of the specified type
+        /// Get the set of all the entities of the specified type. This builds
+        /// a new set on every call, ForEachEntity does not.
         const SimEntitySet GetEntities( size_t types ) const;
 
-        /// Get the next free SimId
+        /// the number of distinct type bits an entity can have
+        static const uint32_t kNumTypeBits = TypeIndex::kNumTypeBits;
+
+        /// Get the entities that have a single type bit set. An entity whose
+        /// type changes is listed under its new type from the next tick on.
+        /// @param bit the index of the type bit (0 for type 1, 1 for type 2, etc.)
+        /// @return the entities in no particular order, valid until one is added, removed or changes type
+        const SimEntityVector& GetEntitiesOfType( uint32_t bit ) const
+        {
+            return mEntityTypes.Get(bit);
+        }
+
+        /// Call visit(ent) once for every entity that has any of the types in the mask.
+        /// An entity whose type changes is visited by its new type from the next tick on.
+        /// The visitor must not add entities to the simulation.
+        /// @param types the type mask of the entities to visit
+        /// @param visit a function or function object that takes a const SimEntityPtr&
+        template <typename Visitor>
+        void ForEachEntity( uint32_t types, Visitor& visit ) const
+        {
+            mEntityTypes.ForEach(types, visit);
+        }
+
+        /// Get the entities of the specified type within a distance of a point
+        /// @param center the point to look around
+        /// @param radius the greatest distance from the center to include
+        /// @param types the type mask of the entities to include
+        /// @param result cleared, then filled with the matching entities
+        void GetEntitiesWithin( const Vector3f& center, float32_t radius, size_t types, SimEntityVector& result ) const
+        {
+            mSpatialIndex.GetEntitiesWithin(center, radius, types, result);
+        }
+
+        /// Get the next free SimId. Ids only go up, even when a snapshot is
+        /// restored, so they are never reused: a stale id finds no entity
+        /// rather than a new one, and mSlots needs no generation checks.
         SimId ReserveNewId() { mMaxId += 1; return mMaxId; }
 
         ///@}
@@ -68,34 +112,130 @@ namespace OpenNero
         /// update for animation only
         void ProcessAnimationTick( float32_t frac );
 
+        /// write the entities (in the order they tick), the state of their
+        /// brains and the last SimId handed out to a stream
+        void SaveState( Bitstream& stream ) const;
+
+        /// a world written by SaveState, read back and checked but not yet put in place
+        struct SavedWorld
+        {
+            /// one entity of the world, in tick order
+            struct Entity
+            {
+                uint32_t template_index;    ///< index of its template in templates
+                SimEntityData data;         ///< its shared data
+                Bitstream brain;            ///< the state of its brain, empty if it has none
+            };
+
+            SimId max_id;                           ///< the last SimId handed out
+            std::vector<std::string> templates;     ///< the templates the entities were created from
+            std::vector<Entity> entities;           ///< the entities
+        };
+
+        /// read a world written by SaveState without changing this one
+        /// @return false if the stream is cut short or corrupt
+        static bool ReadState( Bitstream& stream, SavedWorld& world );
+
+        /// Put the world back the way SaveState found it. The entities that
+        /// are still here take their saved state, the ones that were removed
+        /// since are created again from their (already loaded) templates and
+        /// the ones that were added since are removed. The ids handed out
+        /// since are not handed out again. Call between ticks.
+        /// @return false if an entity could not be created again or a brain could not take its state
+        bool LoadState( const SavedWorld& world, SimContextPtr context );
+
+        /// read a world with ReadState and put it in place with LoadState
+        /// @return false if the stream is cut short or corrupt (and the world
+        /// is left alone), or if the world could not be restored completely
+        bool LoadState( Bitstream& stream, SimContextPtr context );
+
         /// get the time (in seconds) to animate for between AI frames
         float32_t GetFrameDelay() const { return mFrameDelay; }
 
         /// set the time (in seconds) to animate for between AI frames
         void SetFrameDelay(float32_t delay) { mFrameDelay = delay; }
+
+        /// get the fixed length (in seconds) of an AI frame, 0 if it follows the clock
+        float32_t GetTimeStep() const { return mTimeStep; }
+
+        /// set the fixed length (in seconds) of an AI frame, 0 to follow the clock
+        void SetTimeStep(float32_t step) { mTimeStep = std::max(0.0f, step); }
+
+        /// get the number of AI frames per rendered frame when the time step is fixed
+        uint32_t GetTicksPerFrame() const { return mTicksPerFrame; }
+
+        /// set the number of AI frames per rendered frame when the time step is fixed
+        void SetTicksPerFrame(uint32_t ticks) { mTicksPerFrame = std::max<uint32_t>(1, ticks); }
         
         /// get a triangle selector for all the objects matching the types mask
         IMetaTriangleSelector_IPtr GetCollisionTriangleSelector( size_t types );
 
+        /// find the entity hit first by a ray
+        /// @param ray the ray to cast
+        /// @param hit the entity hit and where, if any
+        /// @return true if the ray hit an entity
+        bool FindInRay( const RayQuery& ray, RayHit& hit ) { return mRayCaster.Cast(*this, ray, hit); }
+
+        /// find the entities hit first by a number of rays
+        /// @param rays the rays to cast
+        /// @param hits the results, one per ray
+        /// @param num_threads threads to cast on (0 for one per core)
+        void FindInRays( const std::vector<RayQuery>& rays, std::vector<RayHit>& hits, size_t num_threads = 1 )
+        {
+            mRayCaster.CastAll(*this, rays, hits, num_threads);
+        }
+
+        /// get the types of the entities that rays treat as never moving
+        uint32_t GetStaticRayTypes() const { return mRayCaster.GetStaticTypes(); }
+
+        /// set the types of the entities that rays treat as never moving
+        void SetStaticRayTypes( uint32_t types ) { mRayCaster.SetStaticTypes(types); }
+
     protected:
 
-        /// hash map of SimEntities indexed by SimId
-        typedef hash_map< SimId, SimEntityPtr > SimIdHashMap;
+        /// slots in mEntities indexed by SimId
+        typedef hash_map< SimId, size_t > SlotMap;
 
         /// a set of simulation IDs
         typedef std::set<SimId> SimIdSet;
 
+        /// tick the AI of the first count entities with C++ brains in phases,
+        /// sensing and deciding in parallel, and the AI of the others one at a time
+        void ProcessAIPhases( size_t count, float32_t dt );
+
+        /// take the entities marked for removal out of the simulation
+        void RemoveMarked();
+
+        /// file an entity whose type changed under its new type
+        void Refile( SimEntityPtr ent );
+
+        /// move an entity between the collision selectors when its type changes
+        /// @param ent the entity
+        /// @param old_type the type its triangles are selected by now, 0 if by none
+        /// @param new_type the type to select them by, 0 for none
+        void UpdateCollisionSelectors( SimEntityPtr ent, uint32_t old_type, uint32_t new_type );
+
     protected:
 
         IrrHandles          mIrr;                   ///< Copy of Irrlicht handles
 
-        SimIdHashMap        mSimIdHashedEntities;   ///< Our entities hashed by SimId
+        SimEntityVector     mEntities;              ///< All the sim entities, densely packed in tick order
 
-        SimEntitySet        mEntities;              ///< Set of all the sim entities
+        SlotMap             mSlots;                 ///< The slot of each entity in mEntities, by SimId
 
         SimEntityList       mEntitiesAdded;         ///< Entities are added to this list at first, so that they can be ticked immediately
 
-        hash_map<uint32_t, SimEntitySet> mEntityTypes; ///< entity sets by type
+        TypeIndex           mEntityTypes;           ///< Entities by type bit
+
+        SpatialIndex        mSpatialIndex;          ///< Entities by position, for proximity queries
+
+        RayCaster           mRayCaster;             ///< Finds the entities hit by rays
+
+        CollisionResolver   mCollisions;            ///< Moves entities back out of what they ran into
+
+        bool                mNativeCollisions;      ///< Whether to use mCollisions instead of the Irrlicht animators
+
+        boost::scoped_ptr<ThreadPool> mAIThreadPool; ///< Runs the parallel AI phases, created when first needed
 
         /// the triangle selectors for objects to collide with (by type)
         mutable hash_map<uint32_t, IMetaTriangleSelector_IPtr> mCollisionSelectors;
@@ -106,6 +246,10 @@ namespace OpenNero
 
         float32_t           mFrameDelay;            ///< The time (in seconds) to animate for between AI frames
 
+        float32_t           mTimeStep;              ///< The fixed length (in seconds) of an AI frame, 0 to follow the clock
+
+        uint32_t            mTicksPerFrame;         ///< AI frames per rendered frame when the time step is fixed
+
     };
 
 } //end OpenNero
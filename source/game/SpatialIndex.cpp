@@ -0,0 +1,176 @@
+//--------------------------------------------------------
+// OpenNero : SpatialIndex
+//  a uniform grid of sim entities for proximity queries
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include "game/SpatialIndex.h"
+#include "game/SimEntityData.h"
+
+#include <cmath>
+
+namespace OpenNero
+{
+    const float32_t SpatialIndex::kDefaultCellSize = 50.0f;
+
+    SpatialIndex::SpatialIndex( float32_t cellSize )
+        : mCellSize(cellSize)
+        , mCells()
+        , mSlots()
+    {
+        AssertMsg( cellSize > 0, "The cells of a spatial index need a positive size, not " << cellSize );
+    }
+
+    SpatialIndex::~SpatialIndex()
+    {
+        Clear();
+    }
+
+    void SpatialIndex::Insert( SimEntityPtr ent )
+    {
+        AssertMsg( ent, "Adding a null entity to the spatial index!" );
+        SimEntityData& data = ent->mSharedData;
+        AssertMsg( !data.mSpatialIndex, "Entity " << data.GetId() << " is already in a spatial index" );
+        Member member;
+        member.ent = ent;
+        member.data = &data;
+        Link(member, CellOf(data.GetPosition()));
+        data.mSpatialIndex = this;
+    }
+
+    void SpatialIndex::Remove( SimEntityPtr ent )
+    {
+        Remove(ent->mSharedData);
+    }
+
+    void SpatialIndex::Remove( SimEntityData& data )
+    {
+        SlotMap::iterator found = mSlots.find(&data);
+        if (found != mSlots.end())
+        {
+            // the entity may go away with our reference to it, so hold on
+            // to it until we are done
+            Member member = Unlink(found->second);
+            mSlots.erase(found);
+            data.mSpatialIndex = NULL;
+        }
+    }
+
+    void SpatialIndex::Update( const SimEntityData& data )
+    {
+        SlotMap::iterator found = mSlots.find(&data);
+        if (found == mSlots.end())
+            return;
+        CellKey cell = CellOf(data.GetPosition());
+        if (cell != found->second.cell)
+        {
+            Link(Unlink(found->second), cell);
+        }
+    }
+
+    void SpatialIndex::Clear()
+    {
+        SlotMap::iterator iter;
+        for (iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+        {
+            const_cast<SimEntityData*>(iter->first)->mSpatialIndex = NULL;
+        }
+        mSlots.clear();
+        mCells.clear();
+    }
+
+    void SpatialIndex::GetEntitiesWithin( const Vector3f& center, float32_t radius, uint32_t types, SimEntityVector& result ) const
+    {
+        result.clear();
+        if (!(radius >= 0) || mSlots.empty())
+            return;
+
+        // visit the cells overlapped by the bounding square of the circle,
+        // unless there are more of those than there are occupied cells
+        double columns = std::floor((center.X + radius) / mCellSize) - std::floor((center.X - radius) / mCellSize) + 1;
+        double rows = std::floor((center.Y + radius) / mCellSize) - std::floor((center.Y - radius) / mCellSize) + 1;
+        if (columns * rows > mCells.size())
+        {
+            CellMap::const_iterator cell;
+            for (cell = mCells.begin(); cell != mCells.end(); ++cell)
+            {
+                Collect(cell->second, center, radius, types, result);
+            }
+            return;
+        }
+
+        int32_t x0 = CellCoordinate(center.X - radius, mCellSize), x1 = CellCoordinate(center.X + radius, mCellSize);
+        int32_t y0 = CellCoordinate(center.Y - radius, mCellSize), y1 = CellCoordinate(center.Y + radius, mCellSize);
+        for (int32_t x = x0; x <= x1; ++x)
+        {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                CellMap::const_iterator cell = mCells.find(MakeKey(x, y));
+                if (cell != mCells.end())
+                {
+                    Collect(cell->second, center, radius, types, result);
+                }
+            }
+        }
+    }
+
+    int32_t SpatialIndex::CellCoordinate( float32_t x, float32_t cellSize )
+    {
+        return static_cast<int32_t>(std::floor(x / cellSize));
+    }
+
+    SpatialIndex::CellKey SpatialIndex::CellOf( const Vector3f& pos ) const
+    {
+        return MakeKey(CellCoordinate(pos.X, mCellSize), CellCoordinate(pos.Y, mCellSize));
+    }
+
+    SpatialIndex::CellKey SpatialIndex::MakeKey( int32_t x, int32_t y )
+    {
+        return (CellKey(uint32_t(x)) << 32) | CellKey(uint32_t(y));
+    }
+
+    void SpatialIndex::Link( const Member& member, CellKey cell )
+    {
+        std::vector<Member>& members = mCells[cell];
+        Slot& slot = mSlots[member.data];
+        slot.cell = cell;
+        slot.index = members.size();
+        members.push_back(member);
+    }
+
+    SpatialIndex::Member SpatialIndex::Unlink( const Slot& slot )
+    {
+        CellMap::iterator cell = mCells.find(slot.cell);
+        Assert( cell != mCells.end() );
+        std::vector<Member>& members = cell->second;
+        Member member = members[slot.index];
+
+        // move the last member of the cell into the hole
+        if (slot.index + 1 != members.size())
+        {
+            members[slot.index] = members.back();
+            mSlots[members[slot.index].data].index = slot.index;
+        }
+        members.pop_back();
+        if (members.empty())
+        {
+            mCells.erase(cell);
+        }
+        return member;
+    }
+
+    void SpatialIndex::Collect( const std::vector<Member>& members, const Vector3f& center, float32_t radius, uint32_t types, SimEntityVector& result ) const
+    {
+        float32_t radiusSq = radius * radius;
+        std::vector<Member>::const_iterator iter;
+        for (iter = members.begin(); iter != members.end(); ++iter)
+        {
+            if ((iter->data->GetType() & types) &&
+                iter->data->GetPosition().getDistanceFromSQ(center) <= radiusSq)
+            {
+                result.push_back(iter->ent);
+            }
+        }
+    }
+
+} //end OpenNero
@@ -0,0 +1,115 @@
+//--------------------------------------------------------
+// OpenNero : SpatialIndex
+//  a uniform grid of sim entities for proximity queries
+//--------------------------------------------------------
+
+#ifndef _GAME_SPATIAL_INDEX_H_
+#define _GAME_SPATIAL_INDEX_H_
+
+#include <vector>
+#include "core/HashMap.h"
+#include "core/ONTypes.h"
+#include "core/IrrUtil.h"
+#include "game/SimEntity.h"
+
+namespace OpenNero
+{
+    /// Vector of SimEntities
+    typedef std::vector<SimEntityPtr> SimEntityVector;
+
+    /// A uniform grid over the X-Y plane that buckets the entities of the
+    /// simulation by position, so that the entities near a point can be
+    /// found without looking at all of them. The index is told about moves by
+    /// the SimEntityData of each entity it holds, so it is always up to date.
+    class SpatialIndex
+    {
+    public:
+        /// the side of a cell of the grid used unless otherwise specified
+        static const float32_t kDefaultCellSize;
+
+        /// Constructor
+        /// @param cellSize the side of a square cell of the grid
+        explicit SpatialIndex( float32_t cellSize = kDefaultCellSize );
+
+        /// Destructor - detaches from all the entities still in the index
+        ~SpatialIndex();
+
+        /// start tracking an entity
+        void Insert( SimEntityPtr ent );
+
+        /// stop tracking an entity
+        void Remove( SimEntityPtr ent );
+
+        /// stop tracking the entity with this shared data
+        void Remove( SimEntityData& data );
+
+        /// called by SimEntityData when the position of a tracked entity changes
+        void Update( const SimEntityData& data );
+
+        /// stop tracking all entities
+        void Clear();
+
+        /// @return the number of entities in the index
+        size_t Size() const { return mSlots.size(); }
+
+        /// @return the side of a cell of the grid
+        float32_t GetCellSize() const { return mCellSize; }
+
+        /// find the entities of the specified type within a distance of a point
+        /// @param center the point to look around
+        /// @param radius the greatest distance (in 3D) from the center to include
+        /// @param types the type mask of the entities to include
+        /// @param result cleared, then filled with the matching entities
+        void GetEntitiesWithin( const Vector3f& center, float32_t radius, uint32_t types, SimEntityVector& result ) const;
+
+        /// key of a cell of the grid
+        typedef uint64_t CellKey;
+
+        /// @return the column or row of a grid of cells of this size containing a coordinate
+        static int32_t CellCoordinate( float32_t x, float32_t cellSize );
+
+        /// @return the cell in column x and row y of the grid
+        static CellKey MakeKey( int32_t x, int32_t y );
+
+    private:
+
+        /// an entity in a cell
+        struct Member
+        {
+            SimEntityPtr ent;           ///< the entity
+            const SimEntityData* data;  ///< its shared data
+        };
+
+        /// where an entity is in the grid
+        struct Slot
+        {
+            CellKey cell;               ///< the cell the entity is in
+            size_t index;               ///< its position in the cell
+        };
+
+        /// entities by cell (only non-empty cells are kept)
+        typedef hash_map<CellKey, std::vector<Member> > CellMap;
+
+        /// cells by shared data of the entities
+        typedef hash_map<const SimEntityData*, Slot> SlotMap;
+
+        /// @return the cell containing a position
+        CellKey CellOf( const Vector3f& pos ) const;
+
+        /// put an entity at the end of a cell
+        void Link( const Member& member, CellKey cell );
+
+        /// take an entity out of its cell
+        Member Unlink( const Slot& slot );
+
+        /// add the matching members of a cell to the result
+        void Collect( const std::vector<Member>& members, const Vector3f& center, float32_t radius, uint32_t types, SimEntityVector& result ) const;
+
+        float32_t   mCellSize;      ///< the side of a cell of the grid
+        CellMap     mCells;         ///< the non-empty cells
+        SlotMap     mSlots;         ///< where each entity is
+    };
+
+} //end OpenNero
+
+#endif // _GAME_SPATIAL_INDEX_H_
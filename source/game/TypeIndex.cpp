@@ -0,0 +1,70 @@
+//--------------------------------------------------------
+// OpenNero : TypeIndex
+//  the sim entities filed under each type bit
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include "game/TypeIndex.h"
+
+#include <algorithm>
+
+namespace OpenNero
+{
+    namespace {
+        /// whether an entity is marked for removal
+        bool IsRemoved(const SimEntityPtr& ent)
+        {
+            return ent->IsRemoved();
+        }
+    }
+
+    void TypeIndex::Insert( SimEntityPtr ent )
+    {
+        AssertMsg( ent, "Adding a null entity to the type index!" );
+        uint32_t ent_type = ent->GetType();
+        for (uint32_t bit = 0; bit < kNumTypeBits; ++bit) {
+            uint32_t t = uint32_t(1) << bit;
+            if (t > ent_type) break; // shortcut
+            if (ent_type & t) {
+                mEntities[bit].push_back(ent);
+            }
+        }
+        ent->mFiledType = ent_type;
+    }
+
+    uint32_t TypeIndex::Refile( SimEntityPtr ent )
+    {
+        uint32_t filed = ent->mFiledType;
+        uint32_t ent_type = ent->GetType();
+        if (filed == ent_type) {
+            return filed;
+        }
+        for (uint32_t bit = 0; bit < kNumTypeBits; ++bit) {
+            uint32_t t = uint32_t(1) << bit;
+            if ((filed & t) && !(ent_type & t)) {
+                SimEntityVector& ents = mEntities[bit];
+                ents.erase(std::find(ents.begin(), ents.end(), ent));
+            } else if ((ent_type & t) && !(filed & t)) {
+                mEntities[bit].push_back(ent);
+            }
+        }
+        ent->mFiledType = ent_type;
+        return filed;
+    }
+
+    void TypeIndex::RemoveMarked()
+    {
+        for (uint32_t bit = 0; bit < kNumTypeBits; ++bit) {
+            SimEntityVector& ents = mEntities[bit];
+            ents.erase(std::remove_if(ents.begin(), ents.end(), IsRemoved), ents.end());
+        }
+    }
+
+    void TypeIndex::Clear()
+    {
+        for (uint32_t bit = 0; bit < kNumTypeBits; ++bit) {
+            mEntities[bit].clear();
+        }
+    }
+
+} //end OpenNero
@@ -0,0 +1,79 @@
+//--------------------------------------------------------
+// OpenNero : TypeIndex
+//  the sim entities filed under each type bit
+//--------------------------------------------------------
+
+#ifndef _GAME_TYPE_INDEX_H_
+#define _GAME_TYPE_INDEX_H_
+
+#include <vector>
+#include "core/ONTypes.h"
+#include "game/SimEntity.h"
+#include "game/SpatialIndex.h"
+
+namespace OpenNero
+{
+    /// Lists of the entities of the simulation by type bit. Each entity is
+    /// filed under the type it had when it was inserted or last refiled, so
+    /// that a type change only shows up once the entity is refiled.
+    class TypeIndex
+    {
+    public:
+        /// the number of distinct type bits an entity can have
+        static const uint32_t kNumTypeBits = 32;
+
+        /// file an entity under its type
+        void Insert( SimEntityPtr ent );
+
+        /// file an entity under its type again if the type changed
+        /// @return the type the entity was filed under before
+        uint32_t Refile( SimEntityPtr ent );
+
+        /// take the entities marked for removal out of the index
+        void RemoveMarked();
+
+        /// take all the entities out of the index
+        void Clear();
+
+        /// @return the type an entity is filed under
+        static uint32_t GetFiledType( const SimEntity& ent ) { return ent.mFiledType; }
+
+        /// @param bit the index of the type bit (0 for type 1, 1 for type 2, etc.)
+        /// @return the entities filed under that bit, in no particular order
+        const SimEntityVector& Get( uint32_t bit ) const
+        {
+            AssertMsg( bit < kNumTypeBits, "type bit " << bit << " out of " << kNumTypeBits );
+            return mEntities[bit];
+        }
+
+        /// Call visit(ent) once for every entity filed under any of the types in the mask.
+        /// @param types the type mask of the entities to visit
+        /// @param visit a function or function object that takes a const SimEntityPtr&
+        template <typename Visitor>
+        void ForEach( uint32_t types, Visitor& visit ) const
+        {
+            for (uint32_t bit = 0; bit < kNumTypeBits; ++bit)
+            {
+                uint32_t t = uint32_t(1) << bit;
+                if (t > types) break; // gone past the possible type masks
+                if (!(types & t)) continue;
+                // entities filed under a lower type in the mask were visited for that type
+                uint32_t lower = types & (t - 1);
+                const SimEntityVector& ents = mEntities[bit];
+                for (SimEntityVector::const_iterator iter = ents.begin(); iter != ents.end(); ++iter)
+                {
+                    if (!((*iter)->mFiledType & lower))
+                    {
+                        visit(*iter);
+                    }
+                }
+            }
+        }
+
+    private:
+        SimEntityVector mEntities[kNumTypeBits]; ///< entities by type bit
+    };
+
+} //end OpenNero
+
+#endif // _GAME_TYPE_INDEX_H_
@@ -0,0 +1,142 @@
+//--------------------------------------------------------
+// OpenNero : WorldSnapshot
+//  a binary image of the simulated world
+//--------------------------------------------------------
+
+#include "core/Common.h"
+#include "game/WorldSnapshot.h"
+#include "game/Kernel.h"
+#include "game/Simulation.h"
+#include "ai/AIManager.h"
+#include "math/Random.h"
+#include "rtneat/neat.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace OpenNero
+{
+    namespace {
+        /// the first word of every snapshot ("ONWS")
+        const uint32_t kMagic = 0x4F4E5753;
+
+        /// the layout of the snapshot (increment with every change)
+        const uint32_t kVersion = 2;
+
+        /// write the state of the NEAT random number generator
+        void SaveNEATRandom(Bitstream& stream)
+        {
+            MTRand::uint32 state[MTRand::SAVE];
+            NEAT::NEATRandGen.save(state);
+            for (size_t i = 0; i < MTRand::SAVE; ++i)
+            {
+                stream << uint32_t(state[i]);
+            }
+        }
+
+        /// read a state of the NEAT random number generator
+        /// @return false if the stream ends first
+        bool ReadNEATRandom(Bitstream& stream, MTRand::uint32 state[MTRand::SAVE])
+        {
+            for (size_t i = 0; i < MTRand::SAVE; ++i)
+            {
+                uint32_t word;
+                stream >> word;
+                state[i] = word;
+            }
+            return !stream.Failed();
+        }
+
+        /// write a stream to a file
+        bool WriteFile(const std::string& filename, const Bitstream& data)
+        {
+            std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+            if (!file)
+                return false;
+            if (data.IsEmpty())
+                return true;
+            file.write(reinterpret_cast<const char*>(data.Stream()), data.ByteLength());
+            return bool(file);
+        }
+    }
+
+    WorldSnapshot::WorldSnapshot()
+        : mData()
+    {
+    }
+
+    void WorldSnapshot::Capture( const Simulation& sim )
+    {
+        mData.Clear();
+        mData << kMagic << kVersion;
+        RANDOM.SaveState(mData);
+        SaveNEATRandom(mData);
+        AIManager::const_instance().SaveState(mData);
+        sim.SaveState(mData);
+    }
+
+    bool WorldSnapshot::Restore( Simulation& sim, SimContextPtr context ) const
+    {
+        // read a copy, so that the snapshot can be restored again
+        Bitstream stream(mData);
+        if (stream.ByteLength() < 2 * sizeof(uint32_t))
+        {
+            LOG_F_ERROR("game", "cannot restore an empty world snapshot");
+            return false;
+        }
+        uint32_t magic, version;
+        stream >> magic >> version;
+        if (magic != kMagic || version != kVersion)
+        {
+            LOG_F_ERROR("game", "cannot restore a world snapshot of version " << version << ", expected " << kVersion);
+            return false;
+        }
+
+        // read and check everything before any of it replaces the world
+        RandomNumberGenerator random;
+        MTRand::uint32 neat_random[MTRand::SAVE];
+        AIManager::SavedAIs ais;
+        Simulation::SavedWorld world;
+        if (!random.LoadState(stream) || !ReadNEATRandom(stream, neat_random)
+            || !AIManager::ReadState(stream, ais) || !Simulation::ReadState(stream, world))
+        {
+            LOG_F_ERROR("game", "cannot restore a truncated or corrupt world snapshot");
+            return false;
+        }
+        RANDOM = random;
+        NEAT::NEATRandGen.load(neat_random);
+        bool complete = AIManager::instance().LoadState(ais);
+        return sim.LoadState(world, context) && complete;
+    }
+
+    bool WorldSnapshot::Save( const std::string& filename ) const
+    {
+        if (WriteFile(filename, mData))
+            return true;
+        std::string fname = Kernel::findResource(filename, false);
+        if (WriteFile(fname, mData))
+            return true;
+        LOG_F_ERROR("game", "could not write the world snapshot to " << fname);
+        return false;
+    }
+
+    bool WorldSnapshot::Load( const std::string& filename )
+    {
+        std::string fname = Kernel::findResource(filename, false);
+        std::ifstream file(fname.c_str(), std::ios::in | std::ios::binary);
+        if (!file)
+        {
+            LOG_F_ERROR("game", "could not read a world snapshot from " << fname);
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        mData.Clear();
+        if (!bytes.empty())
+        {
+            mData.PushBytes(reinterpret_cast<const uint8_t*>(&bytes[0]), (uint32_t)bytes.size());
+        }
+        return true;
+    }
+
+} //end OpenNero
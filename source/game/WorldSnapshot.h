@@ -0,0 +1,63 @@
+//--------------------------------------------------------
+// OpenNero : WorldSnapshot
+//  a binary image of the simulated world
+//--------------------------------------------------------
+
+#ifndef _GAME_WORLD_SNAPSHOT_H_
+#define _GAME_WORLD_SNAPSHOT_H_
+
+#include <string>
+#include "core/Common.h"
+#include "core/Bitstream.h"
+#include "core/BoostCommon.h"
+
+namespace OpenNero
+{
+    /// @cond
+    BOOST_SHARED_DECL( WorldSnapshot );
+    BOOST_SHARED_DECL( Simulation );
+    BOOST_SHARED_DECL( SimContext );
+    /// @endcond
+
+    /// A WorldSnapshot is a binary image of a running simulation: the shared
+    /// data of every entity, the state of the C++ brains, the last SimId
+    /// handed out (restoring does not roll ids back), the global random number generators (RANDOM and
+    /// NEATRandGen) and the random streams of the rtNEAT populations
+    /// registered with the AIManager. Restoring it puts the same entities back in place
+    /// without reading their templates again, so that a run can be rolled
+    /// back and repeated from exactly the same state.
+    ///
+    /// Python brains and environments keep their own state; only the
+    /// counters of their brains (episode, step, fitness) are captured.
+    class WorldSnapshot
+    {
+    public:
+        /// an empty snapshot
+        WorldSnapshot();
+
+        /// capture the world as it is now
+        void Capture( const Simulation& sim );
+
+        /// put the world back the way it was when it was captured
+        /// @return false if the snapshot is empty, from another version or
+        /// could not be restored completely
+        bool Restore( Simulation& sim, SimContextPtr context ) const;
+
+        /// @return the size of the snapshot in bytes
+        uint32_t ByteLength() const { return mData.ByteLength(); }
+
+        /// write the snapshot to a file
+        /// @return false if the file could not be written
+        bool Save( const std::string& filename ) const;
+
+        /// read a snapshot written by Save
+        /// @return false if the file could not be read
+        bool Load( const std::string& filename );
+
+    private:
+        Bitstream mData;    ///< the image of the world
+    };
+
+} //end OpenNero
+
+#endif // _GAME_WORLD_SNAPSHOT_H_
@@ -8,7 +8,11 @@
 #include <cmath>
 #include <cstdlib>
 #include "Random.h"
+#include "core/Bitstream.h"
 #include <boost/random.hpp> 
+#include <boost/thread/tss.hpp>
+#include <sstream>
+#include <vector>
 
 namespace OpenNero 
 {   
@@ -58,6 +62,44 @@ namespace OpenNero
     {
         return generate<boost::uniform_real<double>, double>(_randomness, n);
     }
+
+    void RandomNumberGenerator::SaveState(Bitstream& stream) const
+    {
+        // the twister only shows its state as text, so pack the words of it
+        std::stringstream text;
+        text << _randomness;
+        std::vector<uint32_t> words;
+        uint32_t word;
+        while (text >> word)
+        {
+            words.push_back(word);
+        }
+        stream << words;
+    }
+
+    bool RandomNumberGenerator::LoadState(Bitstream& stream)
+    {
+        std::vector<uint32_t> words;
+        stream >> words;
+        if (stream.Failed())
+        {
+            return false;
+        }
+        std::stringstream text;
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            text << words[i] << ' ';
+        }
+        boost::mt19937 loaded;
+        text >> loaded;
+        if (!text)
+        {
+            stream.SetFailed();
+            return false;
+        }
+        _randomness = loaded;
+        return true;
+    }
     
     /// normal real number with mean and variance
     float32_t    RandomNumberGenerator::normalF(const float32_t& mu, const float32_t& sigma) const
@@ -82,5 +124,33 @@ namespace OpenNero
     {
         RANDOM.seed(seed);
     }
+
+    namespace
+    {
+        /// streams belong to their ScopedRandomStream, so do not delete them
+        void keepStream(RandomNumberGenerator*)
+        {
+        }
+
+        boost::thread_specific_ptr<RandomNumberGenerator> s_ThreadStream(&keepStream);
+    }
+
+    RandomNumberGenerator& ThreadRandom()
+    {
+        RandomNumberGenerator* stream = s_ThreadStream.get();
+        return stream ? *stream : RANDOM;
+    }
+
+    ScopedRandomStream::ScopedRandomStream( const boost::uint32_t& seed )
+        : mStream(seed)
+        , mPrevious(s_ThreadStream.get())
+    {
+        s_ThreadStream.reset(&mStream);
+    }
+
+    ScopedRandomStream::~ScopedRandomStream()
+    {
+        s_ThreadStream.reset(mPrevious);
+    }
     
 } //end OpenNero
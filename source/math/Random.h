@@ -10,9 +10,14 @@
 #include "core/Common.h"
 #include "core/ONTypes.h"
 #include <boost/random/mersenne_twister.hpp>
+#include <boost/noncopyable.hpp>
 
 namespace OpenNero 
 {
+    /// @cond
+    class Bitstream;
+    /// @endcond
+
     /// Custom random number generator
     class RandomNumberGenerator
     {
@@ -39,6 +44,11 @@ namespace OpenNero
         double       normalD(const double& mu, const double& sigma) const;
         /// seed with a value
         void seed(const boost::uint32_t& seed) { _randomness.seed(seed); }
+        /// write the state of the generator to a stream
+        void SaveState(Bitstream& stream) const;
+        /// continue from a state written by SaveState
+        /// @return false (and keep the current state) if the stream does not hold one
+        bool LoadState(Bitstream& stream);
     private:
         /// random number generator
         mutable boost::mt19937 _randomness;
@@ -46,6 +56,23 @@ namespace OpenNero
     
     extern RandomNumberGenerator RANDOM;
 
+    /// the random number generator of the calling thread: the stream set up
+    /// by the innermost ScopedRandomStream on this thread, or RANDOM
+    RandomNumberGenerator& ThreadRandom();
+
+    /// Gives the calling thread its own seeded random stream while it lives.
+    /// Parallel tasks create one seeded from their index so that what they
+    /// draw does not depend on which thread runs them.
+    class ScopedRandomStream : boost::noncopyable
+    {
+    public:
+        explicit ScopedRandomStream( const boost::uint32_t& seed );
+        ~ScopedRandomStream();
+    private:
+        RandomNumberGenerator mStream;          ///< the stream of this scope
+        RandomNumberGenerator* mPrevious;       ///< the stream to restore
+    };
+
 } //end OpenNero
 
 #endif // _OPENNERO_MATH_RANDOM_H_
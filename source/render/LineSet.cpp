@@ -34,12 +34,14 @@ namespace OpenNero
     /// Add a line segment to our list
     void LineSet::AddSegment( const Vector3f& start, const Vector3f& end, const LineColor& color )
     {
+        boost::mutex::scoped_lock lock(mMutex);
         mLineSegments.push_back( LineSegment(start,end,color) );
     }
 
     /// Remove all of the currently stored line segments
     void LineSet::ClearSegments()
     {
+        boost::mutex::scoped_lock lock(mMutex);
         mLineSegments.clear();
     }
 
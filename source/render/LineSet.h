@@ -9,6 +9,7 @@
 #include "core/ONTypes.h"
 #include "core/IrrUtil.h"
 #include <vector>
+#include <boost/thread/mutex.hpp>
 
 namespace OpenNero
 {   
@@ -59,6 +60,9 @@ namespace OpenNero
 
         /// the material to use for our line segments
         irr::video::SMaterial   mMaterial;
+
+        /// guards the segments, which sensors may add from several threads
+        boost::mutex            mMutex;
     };
 
 };//end OpenNero
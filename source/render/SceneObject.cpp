@@ -16,6 +16,7 @@
 #include "game/SimContext.h"
 #include "math/Random.h"
 #include "game/Simulation.h"
+#include "utils/Config.h"
 
 #include <sstream>
 #include <list>
@@ -595,8 +596,9 @@ namespace OpenNero
             }
             //}
 
-            // additionally, add a collision response animator
-            if (canCollide()) {
+            // additionally, add a collision response animator, unless the
+            // simulation resolves the collisions itself
+            if (canCollide() && !GetAppConfig().NativeCollisions) {
                 // the world will return the triangles that match the type mask
                 ITriangleSelector* world = new CollideByTypeTriangleSelector(mSceneObjectTemplate->mCollisionMask);
                 // get the axis-aligned bounding box for the node
@@ -959,6 +961,28 @@ namespace OpenNero
         }
     }
 
+    /// append the triangles that rays can hit (in Irrlicht world coordinates)
+    size_t SceneObject::AppendRayTriangles( std::vector<Triangle3f>& triangles, const BBoxf* within, bool refresh )
+    {
+        // the collision manager only looks at visible nodes
+        if (!mSceneNode || !mSceneNode->isVisible())
+            return 0;
+        if (refresh)
+            mSceneNode->updateAbsolutePosition();
+        if (within && !mSceneNode->getTransformedBoundingBox().intersectsWithBox(*within))
+            return 0;
+        ITriangleSelector_IPtr tri_selector = GetTriangleSelector();
+        s32 count = tri_selector ? tri_selector->getTriangleCount() : 0;
+        if (count <= 0)
+            return 0;
+        size_t first = triangles.size();
+        triangles.resize(first + count);
+        s32 written = 0;
+        tri_selector->getTriangles(&triangles[first], count, written);
+        triangles.resize(first + written);
+        return written;
+    }
+
     /// make sure that the new position assigned to this object
     /// actually gets assigned (disregard collisions for one step)
     void SceneObject::DisregardCollisions()
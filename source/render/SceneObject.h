@@ -11,6 +11,7 @@
 #include "core/IrrUtil.h"
 
 #include <list>
+#include <vector>
 
 namespace OpenNero
 {
@@ -184,6 +185,13 @@ namespace OpenNero
         /// get the triangle selector for this scene node, creating it if needed
         ITriangleSelector_IPtr GetTriangleSelector();
 
+        /// append the triangles that rays can hit (in Irrlicht world coordinates)
+        /// @param triangles the vector to append to
+        /// @param within skip the object unless its bounds overlap this box (Irrlicht world coordinates), if given
+        /// @param refresh bring the world transformation of the node up to date first
+        /// @return the number of triangles appended
+        size_t AppendRayTriangles( std::vector<Triangle3f>& triangles, const BBoxf* within = NULL, bool refresh = false );
+
         /// return true if a collision was detected
         bool collisionOccurred();
 
@@ -0,0 +1,63 @@
+#include "core/Common.h"
+#include "compatibility.h"
+#include "genome.h"
+
+using namespace std;
+using namespace NEAT;
+
+CompatibilityCache::CompatibilityCache(size_t capacity)
+    : capacity(capacity)
+    , entries()
+    , num_misses(0)
+{
+}
+
+bool CompatibilityCache::in_order(const GenomePtr& a, const GenomePtr& b)
+{
+    if (a->genome_id != b->genome_id)
+        return a->genome_id < b->genome_id;
+    return a->get_signature().get_revision() <= b->get_signature().get_revision();
+}
+
+F64 CompatibilityCache::compatibility(const GenomePtr& a, const GenomePtr& b)
+{
+    // packs both genomes if they changed
+    const GeneSignature& sa = a->get_signature();
+    const GeneSignature& sb = b->get_signature();
+    F64 distance;
+    if (!find(a, b, distance))
+    {
+        distance = GeneSignature::compatibility(sa, sb);
+        insert(a, b, distance);
+    }
+    return distance;
+}
+
+bool CompatibilityCache::find(const GenomePtr& a, const GenomePtr& b, F64& distance) const
+{
+    if (!in_order(a, b))
+        return find(b, a, distance);
+    EntryMap::const_iterator found = entries.find(Key(a->genome_id, b->genome_id));
+    if (found == entries.end()
+        || found->second.first_revision != a->get_signature().get_revision()
+        || found->second.second_revision != b->get_signature().get_revision())
+        return false;
+    distance = found->second.distance;
+    return true;
+}
+
+void CompatibilityCache::insert(const GenomePtr& a, const GenomePtr& b, F64 distance)
+{
+    if (!in_order(a, b))
+    {
+        insert(b, a, distance);
+        return;
+    }
+    ++num_misses;
+    if (entries.size() >= capacity)
+        entries.clear();
+    Entry& entry = entries[Key(a->genome_id, b->genome_id)];
+    entry.first_revision = a->get_signature().get_revision();
+    entry.second_revision = b->get_signature().get_revision();
+    entry.distance = distance;
+}
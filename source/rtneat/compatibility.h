@@ -0,0 +1,64 @@
+#ifndef _COMPATIBILITY_H_
+#define _COMPATIBILITY_H_
+
+#include <utility>
+#include <boost/unordered_map.hpp>
+#include "neat.h"
+
+namespace NEAT
+{
+    /// A COMPATIBILITY CACHE remembers the compatibility of pairs of genomes,
+    ///   keyed by their genome ids.  Real-time speciation compares every
+    ///   organism with the first member of each species over and over while
+    ///   most of the genomes stay the same, so most comparisons are lookups.
+    /// An entry also keeps the revisions of the signatures of both genomes
+    ///   (see GeneSignature), so it is recomputed once either genome mutates
+    ///   and genomes that share an id cannot be mistaken for each other.
+    /// The cache forgets everything when it grows past its capacity.
+    class CompatibilityCache
+    {
+        public:
+            explicit CompatibilityCache(size_t capacity = 1 << 16);
+
+            /// The compatibility of two genomes, from the cache if it is current
+            F64 compatibility(const GenomePtr& a, const GenomePtr& b);
+
+            /// Look up the compatibility of two packed genomes without
+            /// changing the cache, so several threads can look up at once
+            bool find(const GenomePtr& a, const GenomePtr& b, F64& distance) const;
+
+            /// Remember the compatibility of two packed genomes
+            void insert(const GenomePtr& a, const GenomePtr& b, F64 distance);
+
+            /// Forget all the pairs
+            void clear() { entries.clear(); }
+
+            /// Number of pairs remembered
+            size_t size() const { return entries.size(); }
+
+            /// Number of distances that were not found and had to be computed
+            size_t misses() const { return num_misses; }
+
+        private:
+            typedef std::pair<S32, S32> Key;
+
+            struct Entry
+            {
+                U64 first_revision;
+                U64 second_revision;
+                F64 distance;
+            };
+
+            typedef boost::unordered_map<Key, Entry> EntryMap;
+
+            // compatibility is symmetric, so order the pair by id (and revision)
+            static bool in_order(const GenomePtr& a, const GenomePtr& b);
+
+            size_t capacity;
+            EntryMap entries;
+            size_t num_misses;
+    };
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,241 @@
+#include "core/Common.h"
+#include <map>
+
+#include "compilednetwork.h"
+#include "nnode.h"
+#include "link.h"
+
+using namespace NEAT;
+using namespace std;
+
+CompiledNetwork::CompiledNetwork(const vector<NNodePtr>& all,
+                                 const vector<NNodePtr>& in,
+                                 const vector<NNodePtr>& out)
+{
+    map<const NNode*, S32> index;
+    const size_t n = all.size();
+
+    activesum.resize(n);
+    activation.resize(n);
+    last_activation.resize(n);
+    last_activation2.resize(n);
+    override_value.resize(n);
+    activation_count.resize(n);
+    active_flag.resize(n);
+    overridden.resize(n);
+    sensor.resize(n);
+    ftype.resize(n);
+    link_start.resize(n + 1);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        index[all[i].get()] = static_cast<S32>(i);
+        sensor[i] = (all[i]->type == SENSOR);
+        ftype[i] = static_cast<char>(all[i]->ftype);
+    }
+
+    // lay the incoming links out row by row, keeping their order so that
+    // the activation sums are accumulated exactly as in Network::activate
+    for (size_t i = 0; i < n; ++i)
+    {
+        link_start[i] = static_cast<S32>(link_in.size());
+        if (sensor[i])
+            continue;
+        vector<LinkPtr>::const_iterator curlink;
+        for (curlink = all[i]->incoming.begin(); curlink != all[i]->incoming.end(); ++curlink)
+        {
+            map<const NNode*, S32>::const_iterator found = index.find((*curlink)->get_in_node().get());
+            AssertMsg(found != index.end(), "link from a node outside of the network");
+            link_in.push_back(found->second);
+            link_weight.push_back((*curlink)->weight);
+            link_delay.push_back((*curlink)->time_delay);
+        }
+    }
+    link_start[n] = static_cast<S32>(link_in.size());
+
+    for (size_t i = 0; i < in.size(); ++i)
+        input_index.push_back(index[in[i].get()]);
+    for (size_t i = 0; i < out.size(); ++i)
+        output_index.push_back(index[out[i].get()]);
+
+    load_nodes(all);
+}
+
+// Mirrors NNode::sensor_load
+void CompiledNetwork::load_input(size_t i, F64 value)
+{
+    S32 node = input_index[i];
+    if (sensor[node])
+    {
+        last_activation2[node] = last_activation[node];
+        last_activation[node] = activation[node];
+        activation_count[node]++;
+        activation[node] = value;
+    }
+}
+
+void CompiledNetwork::load_sensors(const F64* sensvals)
+{
+    for (size_t i = 0; i < input_index.size(); ++i)
+    {
+        if (sensor[input_index[i]])
+        {
+            load_input(i, *sensvals);
+            sensvals++;
+        }
+    }
+}
+
+void CompiledNetwork::load_sensors(const vector<F64>& sensvals)
+{
+    AssertMsg
+        (sensvals.size() == input_index.size(), "Got " << sensvals.size()
+        << " sensors for a network with " << input_index.size()
+        << " inputs");
+
+    for (size_t i = 0; i < input_index.size() && i < sensvals.size(); ++i)
+    {
+        load_input(i, sensvals[i]);
+    }
+}
+
+bool CompiledNetwork::nodesoff() const
+{
+    for (size_t i = 0; i < activation_count.size(); ++i)
+    {
+        if (activation_count[i] == 0)
+            return true;
+    }
+    return false;
+}
+
+bool CompiledNetwork::activate()
+{
+    const size_t n = activation.size();
+    bool onetime = false;
+    S32 abortcount = 0;
+
+    while (nodesoff() || !onetime)
+    {
+        ++abortcount;
+
+        if (abortcount == 20)
+            return false;
+
+        // Sum the incoming activation of every neuron.  The active flag of a
+        // node is reset before its own links are visited, and later nodes see
+        // the updated flag, exactly as in the pointer-based sweep.
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (sensor[i])
+                continue;
+
+            F64 sum = 0;
+            active_flag[i] = false;
+
+            for (S32 l = link_start[i]; l < link_start[i + 1]; ++l)
+            {
+                S32 j = link_in[l];
+                if (!link_delay[l])
+                {
+                    sum += link_weight[l] * (activation_count[j] > 0 ? activation[j] : 0.0);
+                    if (active_flag[j] || sensor[j])
+                        active_flag[i] = true;
+                }
+                else
+                {
+                    sum += link_weight[l] * (activation_count[j] > 1 ? last_activation[j] : 0.0);
+                }
+            }
+
+            activesum[i] = sum;
+        }
+
+        // Now activate all the neurons that received some active input
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (sensor[i] || !active_flag[i])
+                continue;
+
+            last_activation2[i] = last_activation[i];
+            last_activation[i] = activation[i];
+
+            if (overridden[i])
+            {
+                activation[i] = override_value[i];
+                overridden[i] = false;
+            }
+            else if (ftype[i] == SIGMOID)
+            {
+                activation[i] = fsigmoid(activesum[i], 4.924273, 2.4621365);
+            }
+            else if (ftype[i] == LINEAR)
+            {
+                activation[i] = flinear(activesum[i], 1.0, 0.0);
+            }
+
+            activation_count[i]++;
+        }
+
+        onetime = true;
+    }
+
+    return true;
+}
+
+void CompiledNetwork::store_nodes(const vector<NNodePtr>& all) const
+{
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        NNodePtr node = all[i];
+        node->active_flag = (active_flag[i] != 0);
+        node->activesum = activesum[i];
+        node->activation = activation[i];
+        node->last_activation = last_activation[i];
+        node->last_activation2 = last_activation2[i];
+        node->activation_count = activation_count[i];
+        node->override = (overridden[i] != 0);
+        node->override_value = override_value[i];
+    }
+}
+
+void CompiledNetwork::store_outputs(const vector<NNodePtr>& out) const
+{
+    for (size_t k = 0; k < out.size(); ++k)
+    {
+        NNodePtr node = out[k];
+        S32 i = output_index[k];
+        node->active_flag = (active_flag[i] != 0);
+        node->activesum = activesum[i];
+        node->activation = activation[i];
+        node->last_activation = last_activation[i];
+        node->last_activation2 = last_activation2[i];
+        node->activation_count = activation_count[i];
+        node->override = (overridden[i] != 0);
+    }
+}
+
+void CompiledNetwork::load_nodes(const vector<NNodePtr>& all)
+{
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        NNodePtr node = all[i];
+        active_flag[i] = node->active_flag;
+        activesum[i] = node->activesum;
+        activation[i] = node->activation;
+        last_activation[i] = node->last_activation;
+        last_activation2[i] = node->last_activation2;
+        activation_count[i] = node->activation_count;
+        overridden[i] = node->override;
+        override_value[i] = node->override_value;
+
+        // weights may have been changed by backprop or adaptation
+        if (!sensor[i])
+        {
+            S32 l = link_start[i];
+            vector<LinkPtr>::const_iterator curlink;
+            for (curlink = node->incoming.begin(); curlink != node->incoming.end(); ++curlink, ++l)
+                link_weight[l] = (*curlink)->weight;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef _COMPILEDNETWORK_H_
+#define _COMPILEDNETWORK_H_
+
+#include <vector>
+#include "neat.h"
+
+namespace NEAT
+{
+    /// A COMPILED NETWORK is a flat copy of a Network's phenotype that can be
+    ///   activated without chasing shared_ptrs.  Node state is kept in
+    ///   contiguous arrays indexed in the same order as Network::all_nodes
+    ///   and the incoming links of every node are stored in CSR form
+    ///   (row offsets plus parallel in-index/weight arrays).
+    /// The activation rule is exactly the one in Network::activate(),
+    ///   including time-delayed links and the order-dependent propagation
+    ///   of active flags, so outputs are bit-identical to the pointer path.
+    class CompiledNetwork
+    {
+        public:
+            /// Flatten the given nodes; every link must come from a node in all
+            CompiledNetwork(const std::vector<NNodePtr>& all,
+                            const std::vector<NNodePtr>& in,
+                            const std::vector<NNodePtr>& out);
+
+            /// Load sensor values into the SENSOR inputs only (see Network::load_sensors)
+            void load_sensors(const F64* sensvals);
+
+            /// Load sensor values into the SENSOR inputs, skipping values of non-SENSOR inputs
+            void load_sensors(const std::vector<F64>& sensvals);
+
+            /// Load a single value into the i-th input if it is a SENSOR
+            void load_input(size_t i, F64 value);
+
+            /// Activate the network until all nodes have been reached
+            bool activate();
+
+            /// If any node has never been activated return true
+            bool nodesoff() const;
+
+            /// Number of inputs in the network
+            size_t num_inputs() const { return input_index.size(); }
+
+            /// Number of outputs in the network
+            size_t num_outputs() const { return output_index.size(); }
+
+            /// Activation of the i-th output, or 0 if it has never been activated
+            F64 get_output(size_t i) const
+            {
+                S32 n = output_index[i];
+                return activation_count[n] > 0 ? activation[n] : 0.0;
+            }
+
+            /// Copy the activation state of every node into the NNode objects
+            void store_nodes(const std::vector<NNodePtr>& all) const;
+
+            /// Copy the activation state of the output nodes into the NNode objects
+            void store_outputs(const std::vector<NNodePtr>& out) const;
+
+            /// Reload activation state and link weights from the NNode objects
+            void load_nodes(const std::vector<NNodePtr>& all);
+
+        private:
+            // per-node state, in all_nodes order
+            std::vector<F64> activesum;
+            std::vector<F64> activation;
+            std::vector<F64> last_activation;
+            std::vector<F64> last_activation2;
+            std::vector<F64> override_value;
+            std::vector<S32> activation_count;
+            std::vector<char> active_flag;
+            std::vector<char> overridden;
+            std::vector<char> sensor;
+            std::vector<char> ftype;
+
+            // incoming links of node i are [link_start[i], link_start[i+1])
+            std::vector<S32> link_start;
+            std::vector<S32> link_in;
+            std::vector<F64> link_weight;
+            std::vector<char> link_delay;
+
+            std::vector<S32> input_index; ///< node index of each input
+            std::vector<S32> output_index; ///< node index of each output
+    };
+
+    typedef boost::shared_ptr<CompiledNetwork> CompiledNetworkPtr;
+
+} // namespace NEAT
+
+#endif
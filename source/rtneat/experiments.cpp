@@ -14,6 +14,26 @@ using namespace std;
 // Double pole balacing                                               
 // ------------------------------------------------------------------ 
 
+namespace
+{
+    // Evaluates an organism on its own copy of the cart, so that the
+    // population can be evaluated in parallel (see Population::evaluate_all)
+    struct Pole2Evaluator
+    {
+        bool velocity;
+        const CartPole* thecart;
+
+        Pole2Evaluator(bool v, const CartPole* cart) : velocity(v), thecart(cart) {}
+
+        bool operator()(OrganismPtr org) const
+        {
+            assert(org->gnome);
+            CartPole cart(*thecart);
+            return pole2_evaluate(org, velocity, &cart);
+        }
+    };
+}
+
 //Perform evolution on double pole balacing, for gens generations
 //If velocity is false, then velocity information will be withheld from the 
 //network population (non-Markov)
@@ -167,8 +187,6 @@ double CartPole::evalNet(NetworkPtr net, int thresh)
 
 void CartPole::init(bool randomize)
 {
-    static int first_time = 1;
-
     if (!MARKOV)
     {
         //Clear all fitness records
@@ -204,12 +222,6 @@ void CartPole::init(bool randomize)
     }
 
     //}
-    if (first_time)
-    {
-        //cout<<"Initial Long pole angle = %f\n"<<state[2]<<endl;
-        //cout<<"Initial Short pole length = %f\n"<<LENGTH_2<<endl;
-        first_time = 0;
-    }
 }
 
 void CartPole::performAction(double output)
@@ -664,16 +676,8 @@ int NEAT::pole2_epoch(PopulationPtr pop, int generation,
     thecart->nmarkov_long=false;
     thecart->generalization_test=false;
 
-    //Evaluate each organism on a test
-    for (curorg=(pop->organisms).begin(); curorg!=(pop->organisms).end(); ++curorg)
-    {
-
-    	assert((*curorg)->gnome);
-
-        if (pole2_evaluate(OrganismPtr(*curorg), velocity, thecart))
-            win=true;
-
-    }
+    //Evaluate each organism on a test, in parallel
+    win = pop->evaluate_all(Pole2Evaluator(velocity, thecart));
 
     //Average and max their fitnesses for dumping to file and snapshot
     for (curspecies=(pop->species).begin(); curspecies!=(pop->species).end(); ++curspecies)
@@ -867,17 +871,8 @@ int NEAT::pole2_epoch_realtime(PopulationPtr pop, int generation,
     thecart->generalization_test=false;
 
     //Initially, we evaluate the whole population
-    //Evaluate each organism on a test
-    for (curorg=(pop->organisms).begin(); curorg!=(pop->organisms).end(); ++curorg)
-    {
-
-        //shouldn't happen
-    	assert((*curorg)->gnome);
-
-        if (pole2_evaluate(OrganismPtr(*curorg), velocity, thecart))
-            win=true;
-
-    }
+    //Evaluate each organism on a test, in parallel
+    win = pop->evaluate_all(Pole2Evaluator(velocity, thecart));
 
     //Now create offspring one at a time, testing each offspring,
     // and replacing the worst with the new offspring if its better
@@ -910,7 +905,7 @@ int NEAT::pole2_epoch_realtime(PopulationPtr pop, int generation,
             win = true;
 
         //Reestimate the baby's species fitness
-        new_org->species.lock()->estimate_average();
+        new_org->species.lock()->estimate_average(pop->params.time_alive_minimum);
 
         //Remove the worst organism
         pop->remove_worst();
@@ -32,6 +32,12 @@ namespace NEAT
         /// Print this factor to a population file
         void print_to_file(std::ofstream &outFile);
 
+        /// @return the id of this factor
+        int get_id() const { return _id; }
+
+        /// @return the content of this factor
+        const std::string& get_record() const { return _record; }
+
         /// serialize this factor to/from a Boost ser. archive
         template<class Archive> void serialize
             (Archive & ar, const unsigned int version) {
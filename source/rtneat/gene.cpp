@@ -6,21 +6,21 @@
 using namespace NEAT;
 using namespace std;
 
-Gene::Gene(double w, NNodePtr inode, NNodePtr onode, bool recur, double innov,
+Gene::Gene(double w, const NNodePtr& inode, const NNodePtr& onode, bool recur, double innov,
            double mnum) :
     lnk(new Link(w, inode, onode, recur)), innovation_num(innov), mutation_num(mnum),
         enable(true), frozen(false)
 {
 }
 
-Gene::Gene(TraitPtr tp, double w, const NNodePtr inode, const NNodePtr onode,
+Gene::Gene(const TraitPtr& tp, double w, const NNodePtr& inode, const NNodePtr& onode,
            bool recur, double innov, double mnum) :
     lnk(new Link(tp,w,inode,onode,recur)), innovation_num(innov), mutation_num(mnum),
         enable(true), frozen(false)
 {
 }
 
-Gene::Gene(GenePtr g, TraitPtr tp, const NNodePtr inode, const NNodePtr onode) :
+Gene::Gene(const GenePtr& g, const TraitPtr& tp, const NNodePtr& inode, const NNodePtr& onode) :
     lnk(new Link(tp,(g->lnk)->weight,inode,onode,(g->lnk)->is_recurrent)), innovation_num(g->innovation_num),
         mutation_num(g->mutation_num), enable(g->enable), frozen(g->frozen)
 {
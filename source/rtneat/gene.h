@@ -6,11 +6,12 @@
 #include "link.h"
 #include "network.h"
 #include "XMLSerializable.h"
+#include "pooled.h"
 
 namespace NEAT
 {
 
-    class Gene : public XMLSerializable
+    class Gene : public XMLSerializable, public Pooled<Gene>
     {
             friend class boost::serialization::access;
 
@@ -26,16 +27,16 @@ namespace NEAT
             Gene();
 
             //Construct a gene with no trait
-            Gene(double w, const NNodePtr inode, const NNodePtr onode,
+            Gene(double w, const NNodePtr& inode, const NNodePtr& onode,
                  bool recur, double innov, double mnum);
 
             //Construct a gene with a trait
-            Gene(TraitPtr tp, double w, const NNodePtr inode,
-                 const NNodePtr onode, bool recur, double innov, double mnum);
+            Gene(const TraitPtr& tp, double w, const NNodePtr& inode,
+                 const NNodePtr& onode, bool recur, double innov, double mnum);
 
             //Construct a gene off of another gene as a duplicate
-            Gene(GenePtr g, TraitPtr tp, const NNodePtr inode,
-                 const NNodePtr onode);
+            Gene(const GenePtr& g, const TraitPtr& tp, const NNodePtr& inode,
+                 const NNodePtr& onode);
 
             //Construct a gene from a file spec given traits and nodes
             Gene(std::istream &iFile, std::vector<TraitPtr> &traits,
@@ -8,20 +8,63 @@
 #include <sstream>
 #include <set>
 #include <boost/tokenizer.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/atomic.hpp>
 
 using namespace NEAT;
 using namespace std;
 
+namespace
+{
+    // the next GeneSignature revision; genomes are built on several threads
+    boost::atomic<U64> next_revision(1);
+}
+
 // combine two lineages of factors
 void combine_factors(vector<FactorPtr>& newfactors, const vector<FactorPtr>& factors1, const vector<FactorPtr>& factors2);
 
+namespace
+{
+    // The links of the genes chosen for a baby during mating, so that a
+    // duplicate can be rejected without rescanning (and locking the nodes
+    // of) every gene chosen so far
+    class ChosenLinks
+    {
+        public:
+            // A gene conflicts with a chosen one if it connects the same nodes
+            // with the same recurrency, or if both are non-recurrent and it
+            // connects them the other way around
+            bool conflicts(const GenePtr& gene) const
+            {
+                S32 in = gene->lnk->get_in_node()->node_id;
+                S32 out = gene->lnk->get_out_node()->node_id;
+                bool recur = gene->lnk->is_recurrent;
+                return links.count(Key(make_pair(in, out), recur)) > 0
+                    || (!recur && links.count(Key(make_pair(out, in), false)) > 0);
+            }
+
+            void add(const GenePtr& gene)
+            {
+                links.insert(Key(make_pair(gene->lnk->get_in_node()->node_id,
+                                           gene->lnk->get_out_node()->node_id),
+                                 gene->lnk->is_recurrent));
+            }
+
+        private:
+            typedef pair<pair<S32, S32>, bool> Key;
+            boost::unordered_set<Key> links;
+    };
+}
+
 Genome::Genome(S32 id, vector<TraitPtr> t, vector<NNodePtr> n, vector<GenePtr> g, vector<FactorPtr> f)
     : genome_id(id)
-    , traits(t)
-    , nodes(n)
-    , genes(g)
-    , factors(f)
 {
+    // the arguments are already copies, take them over instead of copying
+    // every shared pointer once more
+    traits.swap(t);
+    nodes.swap(n);
+    genes.swap(g);
+    factors.swap(f);
 }
 
 Genome::Genome(S32 id, vector<TraitPtr> t, vector<NNodePtr> n, vector<LinkPtr> links)
@@ -601,6 +644,8 @@ NetworkPtr Genome::genesis(S32 id)
     //The new network
     NetworkPtr newnet;
 
+    all_list.reserve(nodes.size());
+
     //Create the nodes
     for (curnode=nodes.begin(); curnode!=nodes.end(); ++curnode)
     {
@@ -666,6 +711,9 @@ NetworkPtr Genome::genesis(S32 id)
 
     newnet->maxweight=maxweight;
 
+    //Flatten the phenotype for fast activation
+    newnet->compile();
+
     return newnet;
 
 }
@@ -878,6 +926,11 @@ GenomePtr Genome::duplicate(S32 new_id)
     NNodePtr onode; //For forming a gene
     TraitPtr traitptr;
 
+    traits_dup.reserve(traits.size());
+    nodes_dup.reserve(nodes.size());
+    genes_dup.reserve(genes.size());
+    factors_dup.reserve(factors.size());
+
     //Duplicate the traits
     for (curtrait=traits.begin(); curtrait!=traits.end(); ++curtrait)
     {
@@ -1144,6 +1197,8 @@ void Genome::mutate_link_weights(F64 power, F64 rate, mutator mut_type)
 
     } //end for loop
 
+    genes_changed();
+
 
 }
 
@@ -1207,7 +1262,7 @@ void Genome::mutate_gene_reenable()
 
 }
 
-bool Genome::mutate_add_node(vector<InnovationPtr> &innovs, S32 &curnode_id,
+bool Genome::mutate_add_node(InnovationRegistry &innovs, S32 &curnode_id,
                              F64 &curinnov)
 {
     vector<GenePtr>::iterator thegene; //random gene containing the original link
@@ -1216,8 +1271,7 @@ bool Genome::mutate_add_node(vector<InnovationPtr> &innovs, S32 &curnode_id,
     NNodePtr out_node;
     LinkPtr thelink; //The link inside the random gene
 
-    vector<InnovationPtr>::iterator theinnov; //For finding a historical match
-    bool done=false;
+    InnovationPtr theinnov; //For finding a historical match
 
     GenePtr newgene1; //The new Genes
     GenePtr newgene2;
@@ -1311,84 +1365,67 @@ bool Genome::mutate_add_node(vector<InnovationPtr> &innovs, S32 &curnode_id,
     //Innovations are used to make sure the same innovation in
     //two separate genomes in the same generation receives
     //the same innovation number.
-    theinnov=innovs.begin();
+    theinnov=innovs.find_node(in_node->node_id,out_node->node_id,(*thegene)->innovation_num);
 
-    while (!done)
+    if (!theinnov)
     {
 
-        if (theinnov==innovs.end())
-        {
+        //The innovation is totally novel
 
-            //The innovation is totally novel
+        //Get the old link's trait
+        traitptr=thelink->linktrait;
 
-            //Get the old link's trait
-            traitptr=thelink->linktrait;
+        //Create the new NNode
+        //By convention, it will point to the first trait
+        newnode.reset(new NNode(NEURON,curnode_id++,HIDDEN));
+        newnode->nodetrait=(*(traits.begin()));
 
-            //Create the new NNode
-            //By convention, it will point to the first trait
-            newnode.reset(new NNode(NEURON,curnode_id++,HIDDEN));
-            newnode->nodetrait=(*(traits.begin()));
-
-            //Create the new Genes
-            if (thelink->is_recurrent)
-            {
-                newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,true,curinnov,0));
-                newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,curinnov+1,0));
-                curinnov+=2.0;
-            }
-            else
-            {
-                newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,false,curinnov,0));
-                newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,curinnov+1,0));
-                curinnov+=2.0;
-            }
-
-            //Add the innovations (remember what was done)
-            InnovationPtr
-                p(new Innovation(in_node->node_id,out_node->node_id,curinnov-2.0,curinnov-1.0,newnode->node_id,(*thegene)->innovation_num));
-            innovs.push_back(p);
-
-            done=true;
+        //Create the new Genes
+        if (thelink->is_recurrent)
+        {
+            newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,true,curinnov,0));
+            newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,curinnov+1,0));
+            curinnov+=2.0;
         }
-
-        // We check to see if an innovation already occured that was:
-        //   -A new node
-        //   -Stuck between the same nodes as were chosen for this mutation
-        //   -Splitting the same gene as chosen for this mutation 
-        //   If so, we know this mutation is not a novel innovation
-        //   in this generation
-        //   so we make it match the original, identical mutation which occured
-        //   elsewhere in the population by coincidence 
-        else if (((*theinnov)->innovation_type==NEWNODE)&&((*theinnov)->node_in_id==(in_node->node_id))&&((*theinnov)->node_out_id==(out_node->node_id))&&((*theinnov)->old_innov_num==(*thegene)->innovation_num))
+        else
         {
+            newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,false,curinnov,0));
+            newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,curinnov+1,0));
+            curinnov+=2.0;
+        }
 
-            //Here, the innovation has been done before
+        //Add the innovations (remember what was done)
+        InnovationPtr
+            p(new Innovation(in_node->node_id,out_node->node_id,curinnov-2.0,curinnov-1.0,newnode->node_id,(*thegene)->innovation_num));
+        innovs.add(p);
+    }
+    else
+    {
 
-            //Get the old link's trait
-            traitptr=thelink->linktrait;
+        //Here, the innovation has been done before: it was a new node
+        //stuck between the same nodes, splitting the same gene, so we
+        //make it match the original, identical mutation
 
-            //Create the new NNode
-            newnode.reset(new NNode(NEURON,(*theinnov)->newnode_id,HIDDEN));
-            //By convention, it will point to the first trait
-            //Note: In future may want to change this
-            newnode->nodetrait=(*(traits.begin()));
+        //Get the old link's trait
+        traitptr=thelink->linktrait;
 
-            //Create the new Genes
-            if (thelink->is_recurrent)
-            {
-                newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,true,(*theinnov)->innovation_num1,0));
-                newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,(*theinnov)->innovation_num2,0));
-            }
-            else
-            {
-                newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,false,(*theinnov)->innovation_num1,0));
-                newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,(*theinnov)->innovation_num2,0));
-            }
+        //Create the new NNode
+        newnode.reset(new NNode(NEURON,theinnov->newnode_id,HIDDEN));
+        //By convention, it will point to the first trait
+        //Note: In future may want to change this
+        newnode->nodetrait=(*(traits.begin()));
 
-            done=true;
+        //Create the new Genes
+        if (thelink->is_recurrent)
+        {
+            newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,true,theinnov->innovation_num1,0));
+            newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,theinnov->innovation_num2,0));
         }
         else
-            ++theinnov;
+        {
+            newgene1.reset(new Gene(traitptr,1.0,in_node,newnode,false,theinnov->innovation_num1,0));
+            newgene2.reset(new Gene(traitptr,oldweight*0.3,newnode,out_node,false,theinnov->innovation_num2,0));
+        }
     }
 
     //Now add the new NNode and new Genes to the Genome
@@ -1402,7 +1439,7 @@ bool Genome::mutate_add_node(vector<InnovationPtr> &innovs, S32 &curnode_id,
 
 }
 
-bool Genome::mutate_add_link(vector<InnovationPtr> &innovs, F64 &curinnov,
+bool Genome::mutate_add_link(InnovationRegistry &innovs, F64 &curinnov,
                              S32 tries)
 {
 
@@ -1414,7 +1451,7 @@ bool Genome::mutate_add_link(vector<InnovationPtr> &innovs, F64 &curinnov,
     NNodePtr nodep2; //Pointers to the nodes
     vector<GenePtr>::iterator thegene; //Searches for existing link
     bool found=false; //Tells whether an open pair was found
-    vector<InnovationPtr>::iterator theinnov; //For finding a historical match
+    InnovationPtr theinnov; //For finding a historical match
     S32 recurflag; //Indicates whether proposed link is recurrent
     GenePtr newgene; //The new Gene
 
@@ -1423,7 +1460,6 @@ bool Genome::mutate_add_link(vector<InnovationPtr> &innovs, F64 &curinnov,
 
     F64 newweight; //The new weight for the new link
 
-    bool done;
     bool do_recur;
     bool loop_recur;
     S32 first_nonsensor;
@@ -1610,86 +1646,67 @@ bool Genome::mutate_add_link(vector<InnovationPtr> &innovs, F64 &curinnov,
     if (found)
     {
 
-        //Check to see if this innovation already occured in the population
-        theinnov=innovs.begin();
-
         //If it was supposed to be recurrent, make sure it gets labeled that way
         if (do_recur)
             recurflag=1;
 
-        done=false;
+        //Check to see if this innovation already occured in the population
+        theinnov=innovs.find_link(nodep1->node_id,nodep2->node_id,recurflag != 0);
 
-        while (!done)
+        //The innovation is totally novel
+        if (!theinnov)
         {
 
-            //The innovation is totally novel
-            if (theinnov==innovs.end())
-            {
-
-                Assert(phenotype.lock());
-
-                //Useful for debugging
-                //cout<<"nodep1 id: "<<nodep1->node_id<<endl;
-                //cout<<"nodep1: "<<nodep1<<endl;
-                //cout<<"nodep1 analogue: "<<nodep1->analogue<<endl;
-                //cout<<"nodep2 id: "<<nodep2->node_id<<endl;
-                //cout<<"nodep2: "<<nodep2<<endl;
-                //cout<<"nodep2 analogue: "<<nodep2->analogue<<endl;
-                //cout<<"recurflag: "<<recurflag<<endl;
+            Assert(phenotype.lock());
 
-                //NOTE: Something like this could be used for time delays,
-                //      which are not yet supported.  However, this does not
-                //      have an application with recurrency.
-                //If not recurrent, randomize recurrency
-                //if (!recurflag) 
-                //  if (randfloat()<recur_prob) recurflag=1;
-
-                //Choose a random trait
-                traitnum=randint(0, static_cast<S32>(traits.size())-1);
-                thetrait=traits.begin();
+            //Useful for debugging
+            //cout<<"nodep1 id: "<<nodep1->node_id<<endl;
+            //cout<<"nodep1: "<<nodep1<<endl;
+            //cout<<"nodep1 analogue: "<<nodep1->analogue<<endl;
+            //cout<<"nodep2 id: "<<nodep2->node_id<<endl;
+            //cout<<"nodep2: "<<nodep2<<endl;
+            //cout<<"nodep2 analogue: "<<nodep2->analogue<<endl;
+            //cout<<"recurflag: "<<recurflag<<endl;
 
-                //Choose the new weight
-                //newweight=(gaussrand())/1.5;  //Could use a gaussian
-                newweight=randposneg()*randfloat()*1.0; //used to be 10.0
+            //NOTE: Something like this could be used for time delays,
+            //      which are not yet supported.  However, this does not
+            //      have an application with recurrency.
+            //If not recurrent, randomize recurrency
+            //if (!recurflag) 
+            //  if (randfloat()<recur_prob) recurflag=1;
 
-                //Create the new gene
-                newgene.reset(new Gene(((thetrait[traitnum])),newweight,nodep1,nodep2,recurflag != 0,curinnov,newweight));
+            //Choose a random trait
+            traitnum=randint(0, static_cast<S32>(traits.size())-1);
+            thetrait=traits.begin();
 
-                //Add the innovation
-                InnovationPtr
-                    p(new Innovation(nodep1->node_id,nodep2->node_id,curinnov,newweight,traitnum));
-                innovs.push_back(p);
+            //Choose the new weight
+            //newweight=(gaussrand())/1.5;  //Could use a gaussian
+            newweight=randposneg()*randfloat()*1.0; //used to be 10.0
 
-                curinnov=curinnov+1.0;
+            //Create the new gene
+            newgene.reset(new Gene(((thetrait[traitnum])),newweight,nodep1,nodep2,recurflag != 0,curinnov,newweight));
 
-                done=true;
-            }
-            //OTHERWISE, match the innovation in the innovs list
-            else if ( (*theinnov)->innovation_type ==NEWLINK && 
-                      (*theinnov)->node_in_id == nodep1->node_id && 
-                      (*theinnov)->node_out_id == nodep2->node_id && 
-                      (*theinnov)->recur_flag == (recurflag != 0) )
-            {
-
-                thetrait=traits.begin();
+            //Add the innovation
+            InnovationPtr
+                p(new Innovation(nodep1->node_id,nodep2->node_id,curinnov,newweight,traitnum));
+            innovs.add(p);
 
-                //Create new gene
-                newgene.reset(new Gene(
-                    thetrait[(*theinnov)->new_traitnum],
-                    (*theinnov)->new_weight,
-                    nodep1, nodep2, 
-                    recurflag != 0,
-                    (*theinnov)->innovation_num1,
-                    0));
+            curinnov=curinnov+1.0;
+        }
+        //OTHERWISE, match the innovation in the registry
+        else
+        {
 
-                done=true;
+            thetrait=traits.begin();
 
-            }
-            else
-            {
-                //Keep looking for a matching innovation from this generation
-                ++theinnov;
-            }
+            //Create new gene
+            newgene.reset(new Gene(
+                thetrait[theinnov->new_traitnum],
+                theinnov->new_weight,
+                nodep1, nodep2, 
+                recurflag != 0,
+                theinnov->innovation_num1,
+                0));
         }
 
         //Now add the new Genes to the Genome
@@ -1705,7 +1722,7 @@ bool Genome::mutate_add_link(vector<InnovationPtr> &innovs, F64 &curinnov,
 
 }
 
-void Genome::mutate_add_sensor(vector<InnovationPtr> &innovs, double &curinnov)
+void Genome::mutate_add_sensor(InnovationRegistry &innovs, double &curinnov)
 {
 
     vector<NNodePtr> sensors;
@@ -1720,14 +1737,12 @@ void Genome::mutate_add_sensor(vector<InnovationPtr> &innovs, double &curinnov)
 
     bool found;
 
-    bool done;
-
     size_t outputConnections;
 
     vector<TraitPtr>::iterator thetrait;
     int traitnum;
 
-    vector<InnovationPtr>::iterator theinnov; //For finding a historical match
+    InnovationPtr theinnov; //For finding a historical match
 
     //Find all the sensors and outputs
     for (size_t i = 0; i < nodes.size(); i++)
@@ -1787,59 +1802,46 @@ void Genome::mutate_add_sensor(vector<InnovationPtr> &innovs, double &curinnov)
         //Record the innovation
         if (!found)
         {
-            theinnov=innovs.begin();
-            done=false;
+            theinnov=innovs.find_link(sensor->node_id,output->node_id,false);
 
-            while (!done)
+            //The innovation is novel
+            if (!theinnov)
             {
-                //The innovation is novel
-                if (theinnov==innovs.end())
-                {
 
-                    //Choose a random trait
-                    traitnum=randint(0, static_cast<S32>(traits.size())-1);
-                    thetrait=traits.begin();
-
-                    //Choose the new weight
-                    //newweight=(gaussrand())/1.5;  //Could use a gaussian
-                    newweight=randposneg()*randfloat()*3.0; //used to be 10.0
-                    // The above value of 3.0 is not changed to NEAT::max_link_weight, which is set
-                    // large enough to protect weights of advice network, since we don't want such
-                    // large changes in weight mutations.
-
-                    //Create the new gene
-                    newgene.reset(new Gene(((thetrait[traitnum])),
-                        newweight,sensor,output,false,
-                        curinnov,newweight));
-
-                    //Add the innovation
-                    InnovationPtr
-                        p(new Innovation(sensor->node_id,output->node_id,curinnov,newweight,traitnum));
-                    innovs.push_back(p);
-
-                    curinnov=curinnov+1.0;
-
-                    done=true;
-                } //end novel innovation case
-                //OTHERWISE, match the innovation in the innovs list
-                else if (((*theinnov)->innovation_type==NEWLINK)&&((*theinnov)->node_in_id==(sensor->node_id))&&((*theinnov)->node_out_id==(output->node_id))&&((*theinnov)->recur_flag==false))
-                {
+                //Choose a random trait
+                traitnum=randint(0, static_cast<S32>(traits.size())-1);
+                thetrait=traits.begin();
+
+                //Choose the new weight
+                //newweight=(gaussrand())/1.5;  //Could use a gaussian
+                newweight=randposneg()*randfloat()*3.0; //used to be 10.0
+                // The above value of 3.0 is not changed to NEAT::max_link_weight, which is set
+                // large enough to protect weights of advice network, since we don't want such
+                // large changes in weight mutations.
 
-                    thetrait=traits.begin();
+                //Create the new gene
+                newgene.reset(new Gene(((thetrait[traitnum])),
+                    newweight,sensor,output,false,
+                    curinnov,newweight));
 
-                    //Create new gene
-                    newgene.reset(new Gene(((thetrait[(*theinnov)->new_traitnum])),
-                        (*theinnov)->new_weight,sensor,output,
-                        false,(*theinnov)->innovation_num1,0));
+                //Add the innovation
+                InnovationPtr
+                    p(new Innovation(sensor->node_id,output->node_id,curinnov,newweight,traitnum));
+                innovs.add(p);
 
-                    done=true;
+                curinnov=curinnov+1.0;
+            } //end novel innovation case
+            //OTHERWISE, match the innovation in the registry
+            else
+            {
 
-                } //end prior innovation case
-                //Keep looking for matching innovation
-                else
-                    ++theinnov;
+                thetrait=traits.begin();
 
-            } //end while
+                //Create new gene
+                newgene.reset(new Gene(((thetrait[theinnov->new_traitnum])),
+                    theinnov->new_weight,sensor,output,
+                    false,theinnov->innovation_num1,0));
+            } //end prior innovation case
 
             //genes.push_back(newgene);
             add_gene(genes, newgene); //adds the gene in correct order
@@ -1866,6 +1868,7 @@ void Genome::add_gene(vector<GenePtr> &glist, GenePtr g)
 
     glist.insert(curgene, g);
 
+    genes_changed();
 }
 
 void Genome::node_insert(vector<NNodePtr> &nlist, NNodePtr n)
@@ -1891,7 +1894,7 @@ GenomePtr Genome::mate_multipoint(GenomePtr g, S32 genomeid, F64 fitness1,
     vector<GenePtr> newgenes;
     GenomePtr new_genome;
 
-    vector<GenePtr>::iterator curgene2; //Checks for link duplication
+    ChosenLinks chosen_links; //Checks for link duplication
 
     //iterators for moving through the two parents' traits
     vector<TraitPtr>::iterator p1trait;
@@ -1921,6 +1924,11 @@ GenomePtr Genome::mate_multipoint(GenomePtr g, S32 genomeid, F64 fitness1,
 
     bool skip;
 
+    //The baby is at most as large as both parents together
+    newtraits.reserve(traits.size());
+    newnodes.reserve(nodes.size()+(g->nodes).size());
+    newgenes.reserve(genes.size()+(g->genes).size());
+
     //First, average the Traits from the 2 parents to form the baby's Traits
     //It is assumed that trait lists are the same length
     //In the future, may decide on a different method for trait mating
@@ -2043,13 +2051,7 @@ GenomePtr Genome::mate_multipoint(GenomePtr g, S32 genomeid, F64 fitness1,
 
         //Check to see if the chosengene conflicts with an already chosen gene
         //i.e. do they represent the same link    
-        curgene2=newgenes.begin();
-        while ((curgene2!=newgenes.end())&&(!((((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&((((*curgene2)->lnk)->is_recurrent)== (((chosengene)->lnk)->is_recurrent))))&&(!((((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&(((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(!((((*curgene2)->lnk)->is_recurrent)))&&(!((((chosengene)->lnk)->is_recurrent))))))
-        {
-            ++curgene2;
-        }
-
-        if (curgene2!=newgenes.end())
+        if (chosen_links.conflicts(chosengene))
             skip=true; //Links conflicts, abort adding
 
         if (!skip)
@@ -2185,6 +2187,7 @@ GenomePtr Genome::mate_multipoint(GenomePtr g, S32 genomeid, F64 fitness1,
                 disable=false;
             }
             newgenes.push_back(newgene);
+            chosen_links.add(newgene);
         }
 
     }
@@ -2213,7 +2216,7 @@ GenomePtr Genome::mate_multipoint_avg(GenomePtr g, S32 genomeid, F64 fitness1,
     vector<TraitPtr>::iterator p1trait;
     vector<TraitPtr>::iterator p2trait;
 
-    vector<GenePtr>::iterator curgene2; //Checking for link duplication
+    ChosenLinks chosen_links; //Checking for link duplication
 
     //iterators for moving through the two parents' genes
     vector<GenePtr>::iterator p1gene;
@@ -2236,6 +2239,11 @@ GenomePtr Genome::mate_multipoint_avg(GenomePtr g, S32 genomeid, F64 fitness1,
 
     bool p1better; //Designate the better genome
 
+    //The baby is at most as large as both parents together
+    newtraits.reserve(traits.size());
+    newnodes.reserve(nodes.size()+(g->nodes).size());
+    newgenes.reserve(genes.size()+(g->genes).size());
+
     //First, average the Traits from the 2 parents to form the baby's Traits
     //It is assumed that trait lists are the same length
     //In future, could be done differently
@@ -2383,18 +2391,8 @@ GenomePtr Genome::mate_multipoint_avg(GenomePtr g, S32 genomeid, F64 fitness1,
 
         //Check to see if the chosengene conflicts with an already chosen gene
         //i.e. do they represent the same link    
-        curgene2=newgenes.begin();
-        while ((curgene2!=newgenes.end()))
-
-        {
-
-            if (((((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&((((*curgene2)->lnk)->is_recurrent)== (((chosengene)->lnk)->is_recurrent)))||((((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&(!((((*curgene2)->lnk)->is_recurrent)))&&(!((((chosengene)->lnk)->is_recurrent)))))
-            {
-                skip=true;
-
-            }
-            ++curgene2;
-        }
+        if (chosen_links.conflicts(chosengene))
+            skip=true;
 
         if (!skip)
         {
@@ -2518,6 +2516,7 @@ GenomePtr Genome::mate_multipoint_avg(GenomePtr g, S32 genomeid, F64 fitness1,
             GenePtr newgene(new Gene(chosengene,newtraits[traitnum],new_inode,new_onode));
 
             newgenes.push_back(newgene);
+            chosen_links.add(newgene);
 
         } //End if which checked for link duplicationb
 
@@ -2543,7 +2542,7 @@ GenomePtr Genome::mate_singlepoint(GenomePtr g, S32 genomeid)
     vector<TraitPtr>::iterator p2trait;
     TraitPtr newtrait;
 
-    vector<GenePtr>::iterator curgene2; //Check for link duplication
+    ChosenLinks chosen_links; //Check for link duplication
 
     //iterators for moving through the two parents' genes
     vector<GenePtr>::iterator p1gene;
@@ -2569,6 +2568,11 @@ GenomePtr Genome::mate_singlepoint(GenomePtr g, S32 genomeid)
     S32 genecounter; //Counts up to the crosspoint
     bool skip; //Used for skipping unwanted genes
 
+    //The baby is at most as large as both parents together
+    newtraits.reserve(traits.size());
+    newnodes.reserve(nodes.size()+(g->nodes).size());
+    newgenes.reserve(genes.size()+(g->genes).size());
+
     //First, average the Traits from the 2 parents to form the baby's Traits
     //It is assumed that trait lists are the same length
     p2trait=(g->traits).begin();
@@ -2711,15 +2715,7 @@ GenomePtr Genome::mate_singlepoint(GenomePtr g, S32 genomeid)
 
         //Check to see if the chosengene conflicts with an already chosen gene
         //i.e. do they represent the same link    
-        curgene2=newgenes.begin();
-
-        while ((curgene2!=newgenes.end())&&(!((((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&((((*curgene2)->lnk)->is_recurrent)== (((chosengene)->lnk)->is_recurrent))))&&(!((((((*curgene2)->lnk)->get_in_node())->node_id)==((((chosengene)->lnk)->get_out_node())->node_id))&&(((((*curgene2)->lnk)->get_out_node())->node_id)==((((chosengene)->lnk)->get_in_node())->node_id))&&(!((((*curgene2)->lnk)->is_recurrent)))&&(!((((chosengene)->lnk)->is_recurrent))))))
-        {
-
-            ++curgene2;
-        }
-
-        if (curgene2!=newgenes.end())
+        if (chosen_links.conflicts(chosengene))
             skip=true; //Link is a duplicate
 
         if (!skip)
@@ -2839,6 +2835,7 @@ GenomePtr Genome::mate_singlepoint(GenomePtr g, S32 genomeid)
             //Add the Gene
             GenePtr p(new Gene(chosengene,newtraits[traitnum],new_inode,new_onode));
             newgenes.push_back(p);
+            chosen_links.add(p);
 
         } //End of if (!skip)
 
@@ -2857,80 +2854,102 @@ GenomePtr Genome::mate_singlepoint(GenomePtr g, S32 genomeid)
 F64 Genome::compatibility(GenomePtr g)
 {
 	assert(g);
-	
-    //iterators for moving through the two potential parents' Genes
-    vector<GenePtr>::iterator p1gene;
-    vector<GenePtr>::iterator p2gene;
 
-    //Innovation numbers
-    F64 p1innov;
-    F64 p2innov;
+    return GeneSignature::compatibility(get_signature(), g->get_signature());
+}
+
+const GeneSignature& Genome::get_signature()
+{
+    signature.pack(genes);
+    return signature;
+}
+
+GeneSignature::GeneSignature()
+    : entries()
+    , revision(next_revision++)
+    , packed(false)
+{
+}
+
+GeneSignature::GeneSignature(const GeneSignature& /* other */)
+    : entries()
+    , revision(next_revision++)
+    , packed(false)
+{
+}
+
+GeneSignature& GeneSignature::operator=(const GeneSignature& other)
+{
+    if (this != &other)
+        invalidate();
+    return *this;
+}
+
+void GeneSignature::pack(const vector<GenePtr>& genes)
+{
+    if (packed)
+        return;
+    entries.resize(genes.size());
+    for (size_t i = 0; i < genes.size(); ++i)
+    {
+        entries[i].innovation_num = genes[i]->innovation_num;
+        entries[i].mutation_num = genes[i]->mutation_num;
+    }
+    packed = true;
+}
+
+void GeneSignature::invalidate()
+{
+    packed = false;
+    revision = next_revision++;
+}
+
+F64 GeneSignature::compatibility(const GeneSignature& a, const GeneSignature& b)
+{
+    assert(a.packed && b.packed);
 
-    //Intermediate value
-    F64 mut_diff;
+    //Pointers for moving through the two potential parents' Genes
+    const Entry* p1gene = a.entries.empty() ? NULL : &a.entries[0];
+    const Entry* p1end = p1gene + a.entries.size();
+    const Entry* p2gene = b.entries.empty() ? NULL : &b.entries[0];
+    const Entry* p2end = p2gene + b.entries.size();
 
     //Set up the counters
     F64 num_disjoint=0.0;
-    F64 num_excess=0.0;
     F64 mut_diff_total=0.0;
     F64 num_matching=0.0; //Used to normalize mutation_num differences
 
-    F64 max_genome_size; //Size of larger Genome
-
-    //Get the length of the longest Genome for percentage computations
-    if (genes.size() < g->genes.size())
-        max_genome_size=(g->genes).size();
-    else
-        max_genome_size=static_cast<S32>(genes.size());
-
     //Now move through the Genes of each potential parent 
-    //until both Genomes end
-    p1gene=genes.begin();
-    p2gene=(g->genes).begin();
-    while (!((p1gene==genes.end())&&(p2gene==(g->genes).end())))
+    //until one of the Genomes ends
+    while (p1gene != p1end && p2gene != p2end)
     {
+        //Extract current innovation numbers
+        F64 p1innov=p1gene->innovation_num;
+        F64 p2innov=p2gene->innovation_num;
 
-        if (p1gene==genes.end())
+        if (p1innov==p2innov)
         {
+            num_matching+=1.0;
+            //mut_diff+=trait_compare((*p1gene)->lnk->linktrait,(*p2gene)->lnk->linktrait); //CONSIDER TRAIT DIFFERENCES
+            mut_diff_total+=fabs(p1gene->mutation_num-p2gene->mutation_num);
+            ++p1gene;
             ++p2gene;
-            num_excess+=1.0;
         }
-        else if (p2gene==(g->genes).end())
+        else if (p1innov<p2innov)
         {
             ++p1gene;
-            num_excess+=1.0;
+            num_disjoint+=1.0;
         }
         else
         {
-            //Extract current innovation numbers
-            p1innov=(*p1gene)->innovation_num;
-            p2innov=(*p2gene)->innovation_num;
-
-            if (p1innov==p2innov)
-            {
-                num_matching+=1.0;
-                mut_diff=((*p1gene)->mutation_num)-((*p2gene)->mutation_num);
-                if (mut_diff<0.0)
-                    mut_diff=0.0-mut_diff;
-                //mut_diff+=trait_compare((*p1gene)->lnk->linktrait,(*p2gene)->lnk->linktrait); //CONSIDER TRAIT DIFFERENCES
-                mut_diff_total+=mut_diff;
-
-                ++p1gene;
-                ++p2gene;
-            }
-            else if (p1innov<p2innov)
-            {
-                ++p1gene;
-                num_disjoint+=1.0;
-            }
-            else if (p2innov<p1innov)
-            {
-                ++p2gene;
-                num_disjoint+=1.0;
-            }
+            ++p2gene;
+            num_disjoint+=1.0;
         }
     } //End while
 
+    //Whatever is left of the longer Genome is excess
+    F64 num_excess=static_cast<F64>((p1end-p1gene)+(p2end-p2gene));
+
     //Return the compatibility number using compatibility formula
     //Note that mut_diff_total/num_matching gives the AVERAGE
     //difference between mutation_nums for any two matching Genes
@@ -2944,8 +2963,6 @@ F64 Genome::compatibility(GenomePtr g)
 
     //Look at disjointedness and excess in the absolute (ignoring size)
 
-    //cout<<"COMPAT: size = "<<max_genome_size<<" disjoint = "<<num_disjoint<<" excess = "<<num_excess<<" diff = "<<mut_diff_total<<"  TOTAL = "<<(disjoint_coeff*(num_disjoint/1.0)+excess_coeff*(num_excess/1.0)+mutdiff_coeff*(mut_diff_total/num_matching))<<endl;
-
     return (disjoint_coeff*(num_disjoint/1.0)+excess_coeff*(num_excess/1.0)
         +mutdiff_coeff*(mut_diff_total/num_matching));
 }
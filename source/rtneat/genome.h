@@ -16,6 +16,48 @@ namespace NEAT
         COLDGAUSSIAN = 1
     };
 
+    //-----------------------------------------------------------------------
+    //The innovation and mutation numbers of the genes of a Genome, in gene
+    //order, packed into one array so that compatibility checks merge two
+    //arrays instead of chasing Gene pointers.  The revision is unique among
+    //all genomes and changes whenever the genes do, so it can tell whether
+    //something computed from the genes is still current.
+    class GeneSignature
+    {
+        public:
+            struct Entry
+            {
+                F64 innovation_num;
+                F64 mutation_num;
+            };
+
+            GeneSignature();
+
+            // A copy belongs to another genome, so it gets its own revision
+            GeneSignature(const GeneSignature& other);
+            GeneSignature& operator=(const GeneSignature& other);
+
+            U64 get_revision() const { return revision; }
+
+            bool is_packed() const { return packed; }
+
+            const std::vector<Entry>& get_entries() const { return entries; }
+
+            // Pack the genes, unless they are already packed
+            void pack(const std::vector<GenePtr>& genes);
+
+            // Forget the packed genes and take a new revision
+            void invalidate();
+
+            // The compatibility formula of Genome::compatibility() on two packed signatures
+            static F64 compatibility(const GeneSignature& a, const GeneSignature& b);
+
+        private:
+            std::vector<Entry> entries;
+            U64 revision;
+            bool packed;
+    };
+
     //-----------------------------------------------------------------------
     //A Genome is the primary source of genotype information used to create
     //a phenotype.  It contains 3 major constituents:
@@ -134,14 +176,14 @@ namespace NEAT
             //   Generally, if they fail, they can be called again if desired.
 
             // Mutate genome by adding a node respresentation
-            bool mutate_add_node(std::vector<InnovationPtr> &innovs,
+            bool mutate_add_node(InnovationRegistry &innovs,
                                  S32 &curnode_id, F64 &curinnov);
 
             // Mutate the genome by adding a new link between 2 random NNodes
-            bool mutate_add_link(std::vector<InnovationPtr> &innovs,
+            bool mutate_add_link(InnovationRegistry &innovs,
                                  F64 &curinnov, S32 tries);
 
-            void mutate_add_sensor(std::vector<InnovationPtr> &innovs,
+            void mutate_add_sensor(InnovationRegistry &innovs,
                                    double &curinnov);
 
             // ****** MATING METHODS *****
@@ -179,8 +221,17 @@ namespace NEAT
             //   MATCHING GENES.  So the formula for compatibility
             //   is:  disjoint_coeff*pdg+excess_coeff*peg+mutdiff_coeff*mdmg.
             //   The 3 coefficients are global system parameters
+            //   The genes of both Genomes are packed into their signatures first.
             F64 compatibility(GenomePtr g);
 
+            // The packed genes, packing them if they changed.  Pack genomes
+            //   before sharing them between threads: packing is not locked.
+            const GeneSignature& get_signature();
+
+            // Code that changes the genes, or their innovation or mutation
+            //   numbers, directly must call this (the mutators do)
+            void genes_changed() { signature.invalidate(); }
+
             F64 trait_compare(TraitPtr t1, TraitPtr t2);
 
             // Return number of non-disabled genes
@@ -213,6 +264,8 @@ namespace NEAT
             //*correct order* into the list of genes in the genome
             void add_gene(std::vector<GenePtr> &glist, GenePtr g);
 
+        private:
+            GeneSignature signature; // packed genes for compatibility()
     };
 
     //Calls special constructor that creates a Genome of 3 possible types:
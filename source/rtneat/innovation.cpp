@@ -1,5 +1,6 @@
 #include "core/Common.h"
 #include "innovation.h"
+#include <boost/functional/hash.hpp>
 
 using namespace NEAT;
 
@@ -50,3 +51,95 @@ Innovation::Innovation(int nin, int nout, double num1, double w, int t,
     newnode_id=0;
     recur_flag=recur;
 }
+
+InnovationRegistry::Key::Key(const Innovation& innov)
+    : type(innov.innovation_type)
+    , in(innov.node_in_id)
+    , out(innov.node_out_id)
+    , old_innov(innov.innovation_type == NEWNODE ? innov.old_innov_num : 0.0)
+    , recur(innov.innovation_type == NEWLINK && innov.recur_flag)
+{
+}
+
+bool InnovationRegistry::Key::operator==(const Key& other) const
+{
+    return type == other.type && in == other.in && out == other.out
+        && old_innov == other.old_innov && recur == other.recur;
+}
+
+size_t InnovationRegistry::KeyHash::operator()(const Key& key) const
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key.type);
+    boost::hash_combine(seed, key.in);
+    boost::hash_combine(seed, key.out);
+    boost::hash_combine(seed, key.old_innov);
+    boost::hash_combine(seed, key.recur);
+    return seed;
+}
+
+InnovationRegistry::InnovationRegistry() : max_size(innovation_memory)
+{
+}
+
+InnovationPtr InnovationRegistry::find(const Key& key) const
+{
+    Index::const_iterator found = index.find(key);
+    if (found == index.end())
+        return InnovationPtr();
+    return found->second;
+}
+
+InnovationPtr InnovationRegistry::find_node(S32 in, S32 out, F64 old_innov) const
+{
+    return find(Key(NEWNODE, in, out, old_innov, false));
+}
+
+InnovationPtr InnovationRegistry::find_link(S32 in, S32 out, bool recur) const
+{
+    return find(Key(NEWLINK, in, out, 0.0, recur));
+}
+
+void InnovationRegistry::add(InnovationPtr innov)
+{
+    if (!index.insert(Index::value_type(Key(*innov), innov)).second)
+        return;
+    order.push_back(innov);
+    while (max_size > 0 && order.size() > static_cast<size_t>(max_size))
+        forget_oldest();
+}
+
+void InnovationRegistry::forget_oldest()
+{
+    index.erase(Key(*order.front()));
+    order.pop_front();
+}
+
+void InnovationRegistry::clear()
+{
+    order.clear();
+    index.clear();
+}
+
+void InnovationRegistry::set_max_size(S32 size)
+{
+    max_size = size;
+    while (max_size > 0 && order.size() > static_cast<size_t>(max_size))
+        forget_oldest();
+}
+
+void InnovationRegistry::assign(const std::vector<InnovationPtr>& innovs)
+{
+    clear();
+    for (size_t i = 0; i < innovs.size(); ++i)
+        add(innovs[i]);
+}
+
+void InnovationRegistry::reindex()
+{
+    std::deque<InnovationPtr> innovs;
+    innovs.swap(order);
+    index.clear();
+    for (size_t i = 0; i < innovs.size(); ++i)
+        add(innovs[i]);
+}
@@ -1,6 +1,9 @@
 #ifndef _INNOVATION_H_
 #define _INNOVATION_H_
 
+#include <deque>
+#include <vector>
+#include <boost/unordered_map.hpp>
 #include "neat.h"
 #include "XMLSerializable.h"
 
@@ -79,6 +82,86 @@ namespace NEAT
             }
     };
 
+    // ------------------------------------------------------------
+    // The INNOVATION REGISTRY remembers the innovations of a Population
+    //   and finds a matching one in constant time.  Innovations are
+    //   keyed by what identifies them in the mutation operators: their
+    //   type, the two nodes, the split gene (new nodes) and recurrency
+    //   (new links).  Only the first innovation with a key is kept, as
+    //   with the linear search it replaces.
+    //
+    //  In real-time evolution nothing ever clears the registry, so it
+    //  keeps at most max_size innovations and forgets the oldest first.
+    // ------------------------------------------------------------
+    class InnovationRegistry
+    {
+        public:
+            InnovationRegistry();
+
+            // The new node innovation splitting the gene old_innov between in and out, or null
+            InnovationPtr find_node(S32 in, S32 out, F64 old_innov) const;
+
+            // The new link innovation from in to out, or null
+            InnovationPtr find_link(S32 in, S32 out, bool recur) const;
+
+            // Remember an innovation unless one with the same key is known
+            void add(InnovationPtr innov);
+
+            // Forget all innovations (at the end of a generation)
+            void clear();
+
+            size_t size() const { return order.size(); }
+
+            // The innovations, oldest first
+            const std::deque<InnovationPtr>& get_innovations() const { return order; }
+
+            // Most innovations remembered (0 for no limit)
+            S32 get_max_size() const { return max_size; }
+            void set_max_size(S32 size);
+
+            /// serialize this object to/from a Boost serialization archive
+            template<class Archive>
+            void serialize(Archive & ar, const unsigned int version)
+            {
+                ar & BOOST_SERIALIZATION_NVP(max_size);
+                ar & BOOST_SERIALIZATION_NVP(order);
+                if (Archive::is_loading::value)
+                    reindex();
+            }
+
+            // Replace the contents with a list of innovations, oldest first
+            void assign(const std::vector<InnovationPtr>& innovs);
+
+        private:
+            struct Key
+            {
+                S32 type;
+                S32 in;
+                S32 out;
+                F64 old_innov;
+                bool recur;
+                Key(const Innovation& innov);
+                Key(S32 t, S32 i, S32 o, F64 old, bool r)
+                    : type(t), in(i), out(o), old_innov(old), recur(r) {}
+                bool operator==(const Key& other) const;
+            };
+
+            struct KeyHash
+            {
+                size_t operator()(const Key& key) const;
+            };
+
+            typedef boost::unordered_map<Key, InnovationPtr, KeyHash> Index;
+
+            InnovationPtr find(const Key& key) const;
+            void forget_oldest();
+            void reindex();
+
+            std::deque<InnovationPtr> order; // insertion order, for forgetting
+            Index index; // key -> innovation
+            S32 max_size;
+    };
+
 } // namespace NEAT
 
 #endif
@@ -5,7 +5,7 @@
 using namespace NEAT;
 using namespace std;
 
-Link::Link(F64 w, NNodePtr inode, NNodePtr onode, bool recur) :
+Link::Link(F64 w, const NNodePtr& inode, const NNodePtr& onode, bool recur) :
     in_node(inode), 
     out_node(onode), 
     weight(w), 
@@ -17,7 +17,7 @@ Link::Link(F64 w, NNodePtr inode, NNodePtr onode, bool recur) :
 {
 }
 
-Link::Link(TraitPtr lt, F64 w, NNodePtr inode, NNodePtr onode, bool recur) :
+Link::Link(const TraitPtr& lt, F64 w, const NNodePtr& inode, const NNodePtr& onode, bool recur) :
     in_node(inode), 
     out_node(onode), 
     weight(w), 
@@ -55,7 +55,7 @@ Link::Link(const Link& link) :
 {
 }
 
-void Link::derive_trait(TraitPtr curtrait)
+void Link::derive_trait(const TraitPtr& curtrait)
 {
 
     if (curtrait!=0)
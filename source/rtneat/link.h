@@ -5,6 +5,7 @@
 #include "trait.h"
 #include "nnode.h"
 #include "XMLSerializable.h"
+#include "pooled.h"
 #include <ostream>
 #include <string>
 
@@ -14,7 +15,7 @@ namespace NEAT
     // A LINK is a connection from one node to another with an associated weight 
     // It can be marked as recurrent 
     // Its parameters are made public for efficiency 
-    class Link : public XMLSerializable
+    class Link : public XMLSerializable, public Pooled<Link>
     {
             friend class boost::serialization::access;
             Link() {}
@@ -37,11 +38,11 @@ namespace NEAT
             F64 added_weight; // The amount of weight adjustment 
             F64 params[NEAT::num_trait_params];
 
-            Link(F64 w, NNodePtr inode, NNodePtr onode, bool recur);
+            Link(F64 w, const NNodePtr& inode, const NNodePtr& onode, bool recur);
 
             // Including a trait pointer in the Link creation
-            Link(TraitPtr lt, F64 w, const NNodePtr inode,
-                 const NNodePtr onode, bool recur);
+            Link(const TraitPtr& lt, F64 w, const NNodePtr& inode,
+                 const NNodePtr& onode, bool recur);
 
             // For when you don't know the connections yet
             Link(F64 w);
@@ -50,7 +51,7 @@ namespace NEAT
             Link(const Link& link);
 
             // Derive a trait into link params
-            void derive_trait(TraitPtr curtrait);
+            void derive_trait(const TraitPtr& curtrait);
 
             // get input node
             NNodePtr get_in_node() const
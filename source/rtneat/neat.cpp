@@ -3,6 +3,7 @@
 #include <cmath>
 #include <iostream>
 #include <string>
+#include <boost/thread/tss.hpp>
 #include "neat.h"
 #include "XMLSerializable.h"
 
@@ -45,6 +46,8 @@ namespace NEAT
     S32 babies_stolen = 0; // The number of babies to siphen off to the champions 
     F64 backprop_learning_rate = 0; // Learning rate of back-propagation algorithm
     F64 max_link_weight = 3; // Link weights are capped at this (and negative of this) value
+    S32 num_threads = 0; // Threads used to evaluate a generation (0 for one per core)
+    S32 innovation_memory = 10000; // Most innovations a Population remembers, oldest forgotten first (0 for no limit)
     MTRand NEATRandGen((U64)time(NULL)); //TODO: we should probably move the Mersenne Twister random generator to OpenNero common
 
     bool load_neat_params(const string& filename)
@@ -126,6 +129,8 @@ namespace NEAT
         paramFile >> backprop_learning_rate;
         paramFile >> curword;
         paramFile >> max_link_weight;
+        paramFile >> curword;
+        paramFile >> innovation_memory;
         cout << "trait_param_mut_prob="<< trait_param_mut_prob << endl;
         cout << "trait_mutation_power="<< trait_mutation_power << endl;
         cout << "linktrait_mut_sig="<< linktrait_mut_sig << endl;
@@ -160,6 +165,7 @@ namespace NEAT
         cout << "babies_stolen="<< babies_stolen << endl;
         cout << "backprop_learning_rate="<< backprop_learning_rate << endl;
         cout << "max_link_weight="<<max_link_weight<<endl;
+        cout << "innovation_memory="<<innovation_memory<<endl;
         paramFile.close();
         return true;
     }
@@ -168,7 +174,64 @@ namespace NEAT
     /// Uses the mersenne twister implementation
     F64 gaussrand()
     {
-        return NEATRandGen.randNorm(0, 1);
+        return randgen().randNorm(0, 1);
+    }
+
+    namespace
+    {
+        // the generators belong to their ScopedRandGen, so do not delete them
+        void keep_randgen(MTRand*)
+        {
+        }
+
+        boost::thread_specific_ptr<MTRand> thread_randgen(&keep_randgen);
+    }
+
+    MTRand& randgen()
+    {
+        MTRand* gen = thread_randgen.get();
+        return gen ? *gen : NEATRandGen;
+    }
+
+    ScopedRandGen::ScopedRandGen(U32 seed) : gen(), previous(thread_randgen.get())
+    {
+        gen.emplace(seed);
+        thread_randgen.reset(gen.get_ptr());
+    }
+
+    ScopedRandGen::ScopedRandGen(MTRand& stream) : gen(), previous(thread_randgen.get())
+    {
+        thread_randgen.reset(&stream);
+    }
+
+    ScopedRandGen::~ScopedRandGen()
+    {
+        thread_randgen.reset(previous);
+    }
+
+    PopulationParams::PopulationParams()
+        : compat_threshold(NEAT::compat_threshold)
+        , time_alive_minimum(NEAT::time_alive_minimum)
+        , randgen(NEAT::randgen().randInt())
+    {
+    }
+
+    PopulationParams::PopulationParams(const PopulationParams& other)
+        : compat_threshold(other.compat_threshold)
+        , time_alive_minimum(other.time_alive_minimum)
+        , randgen(MTRand::uint32(0))
+    {
+        *this = other;
+    }
+
+    PopulationParams& PopulationParams::operator=(const PopulationParams& other)
+    {
+        compat_threshold = other.compat_threshold;
+        time_alive_minimum = other.time_alive_minimum;
+        MTRand::uint32 state[MTRand::SAVE];
+        other.randgen.save(state);
+        randgen.load(state);
+        return *this;
     }
 
     F64 fsigmoid(F64 activesum, F64 slope, F64 constant)
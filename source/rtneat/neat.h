@@ -5,6 +5,8 @@
 #include "mersennetwister.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 
 namespace NEAT
 {
@@ -58,13 +60,53 @@ namespace NEAT
     extern S32 babies_stolen; // The number of babies to siphon off to the champions 
     extern F64 backprop_learning_rate; // Learning rate of back-propagation algorithm
     extern F64 max_link_weight; // Link weights are capped at this (and negative of this) value
+    extern S32 num_threads; // Threads used to evaluate a generation (0 for one per core)
+    extern S32 innovation_memory; // Most innovations a Population remembers, oldest forgotten first (0 for no limit)
 
     extern MTRand NEATRandGen; // Random number generator; can pass seed value as argument
 
+    /// The random stream of the calling thread: the one set up by the
+    /// innermost ScopedRandGen on this thread, or NEATRandGen
+    MTRand& randgen();
+
+    /// Gives the calling thread its own seeded random stream while it lives,
+    /// so that organisms evaluated in parallel draw reproducible numbers
+    class ScopedRandGen : boost::noncopyable
+    {
+        public:
+            explicit ScopedRandGen(U32 seed);
+            /// draw from the given stream instead, such as the one of a population
+            explicit ScopedRandGen(MTRand& stream);
+            ~ScopedRandGen();
+        private:
+            boost::optional<MTRand> gen; ///< the stream of this scope, unless it borrows one
+            MTRand* previous; ///< the stream to restore
+    };
+
+    /// The settings that populations evolving side by side (for example on
+    /// the islands of an island model) do not share.  A new population
+    /// copies them from the globals of the same names and seeds its random
+    /// stream from the calling thread's stream.
+    struct PopulationParams
+    {
+        PopulationParams();
+
+        /// copies the state of the random stream (MTRand itself cannot be
+        /// copied, as it points into its own state)
+        PopulationParams(const PopulationParams& other);
+
+        /// copies the state of the random stream, as the copy constructor does
+        PopulationParams& operator=(const PopulationParams& other);
+
+        F64 compat_threshold; // Compatibility threshold under which two Genomes are considered the same species
+        U32 time_alive_minimum; // Minimum time alive to be considered for selection or death in real-time evolution
+        MTRand randgen; // The random stream of the population; scope it with ScopedRandGen while evolving
+    };
+
     // Inline Random Functions 
     extern inline S32 randposneg()
     {
-        if (NEAT::NEATRandGen.randInt()%2)
+        if (NEAT::randgen().randInt()%2)
             return 1;
         else
             return -1;
@@ -72,12 +114,12 @@ namespace NEAT
 
     extern inline S32 randint(S32 x, S32 y)
     {
-        return NEAT::NEATRandGen.randInt()%(y-x+1)+x;
+        return NEAT::randgen().randInt()%(y-x+1)+x;
     }
 
     extern inline F64 randfloat()
     {
-        return NEAT::NEATRandGen.rand();
+        return NEAT::randgen().rand();
     }
 
     // SIGMOID FUNCTION ********************************
@@ -146,6 +188,7 @@ namespace NEAT
     class Innovation;
     typedef boost::shared_ptr<Innovation> InnovationPtr;
     typedef boost::weak_ptr<Innovation> InnovationWeakPtr;
+    class InnovationRegistry;
 
     class Gene;
     typedef boost::shared_ptr<Gene> GenePtr;
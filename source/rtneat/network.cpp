@@ -58,15 +58,41 @@ Network::~Network()
     destroy(); // Kill off all the nodes and links
 }
 
+// Flatten the nodes and links into a CompiledNetwork
+void Network::compile()
+{
+    compiled.reset(new CompiledNetwork(all_nodes, inputs, outputs));
+}
+
+// Copy the compiled activation state back into the NNodes so that
+// code walking the nodes sees the current values
+void Network::sync_nodes() const
+{
+    if (compiled)
+        compiled->store_nodes(all_nodes);
+}
+
+// Reload the compiled state (including weights) from the NNodes after
+// they have been changed by code walking the nodes
+void Network::sync_compiled()
+{
+    if (compiled)
+        compiled->load_nodes(all_nodes);
+}
+
 // Puts the network back into an initial state
 void Network::flush()
 {
     vector<NNodePtr>::iterator curnode;
 
+    sync_nodes();
+
     for (curnode=outputs.begin(); curnode!=outputs.end(); ++curnode)
     {
         (*curnode)->flushback();
     }
+
+    sync_compiled();
 }
 
 // If all output are not active then return true
@@ -88,6 +114,9 @@ bool Network::nodesoff() const
 {
     vector<NNodePtr>::const_iterator curnode;
 
+    if (compiled)
+        return compiled->nodesoff();
+
     for (curnode=all_nodes.begin(); curnode!=all_nodes.end(); ++curnode)
     {
         if ((*curnode)->activation_count == 0)
@@ -174,6 +203,23 @@ bool Network::activate()
 
     //cout<<"Activating network: "<<this->genotype<<endl;
 
+    if (compiled)
+    {
+        bool activated = compiled->activate();
+        if (activated && adaptable)
+        {
+            // adaptation changes link weights, so it runs on the NNodes
+            sync_nodes();
+            adapt();
+            sync_compiled();
+        }
+        else
+        {
+            compiled->store_outputs(outputs);
+        }
+        return activated;
+    }
+
     //Keep activating until all the nodes have become active 
     //(This only happens on the first activation, because after that they
     // are always active)
@@ -270,51 +316,64 @@ bool Network::activate()
     }
 
     if (adaptable)
+        adapt();
+
+    return true;
+}
+
+// Adapt weights based on activations
+void Network::adapt()
+{
+    vector<NNodePtr>::iterator curnode;
+    vector<LinkPtr>::iterator curlink;
+
+    // ADAPTATION:  Adapt weights based on activations 
+    for (curnode=all_nodes.begin(); curnode!=all_nodes.end(); ++curnode)
     {
+        //Ignore SENSORS
 
-        // ADAPTATION:  Adapt weights based on activations 
-        for (curnode=all_nodes.begin(); curnode!=all_nodes.end(); ++curnode)
-        {
-            //Ignore SENSORS
+        //cout<<"On node "<<(*curnode)->node_id<<endl;
 
-            //cout<<"On node "<<(*curnode)->node_id<<endl;
+        if (((*curnode)->type)!=SENSOR)
+        {
 
-            if (((*curnode)->type)!=SENSOR)
+            // For each incoming connection, perform adaptation based on the trait of the connection 
+            for (curlink=((*curnode)->incoming).begin(); curlink!=((*curnode)->incoming).end(); ++curlink)
             {
 
-                // For each incoming connection, perform adaptation based on the trait of the connection 
-                for (curlink=((*curnode)->incoming).begin(); curlink!=((*curnode)->incoming).end(); ++curlink)
+                if (((*curlink)->trait_id==2)||((*curlink)->trait_id==3)||((*curlink)->trait_id==4))
                 {
 
-                    if (((*curlink)->trait_id==2)||((*curlink)->trait_id==3)||((*curlink)->trait_id==4))
+                    //In the recurrent case we must take the last activation of the input for calculating hebbian changes
+                    if ((*curlink)->is_recurrent)
                     {
+                        (*curlink)->weight=hebbian((*curlink)->weight, maxweight, (*curlink)->get_in_node()->last_activation, (*curlink)->get_out_node()->get_active_out(), (*curlink)->params[0], (*curlink)->params[1], (*curlink)->params[2]);
 
-                        //In the recurrent case we must take the last activation of the input for calculating hebbian changes
-                        if ((*curlink)->is_recurrent)
-                        {
-                            (*curlink)->weight=hebbian((*curlink)->weight, maxweight, (*curlink)->get_in_node()->last_activation, (*curlink)->get_out_node()->get_active_out(), (*curlink)->params[0], (*curlink)->params[1], (*curlink)->params[2]);
-
-                        }
-                        else
-                        { //non-recurrent case
-                            (*curlink)->weight=hebbian((*curlink)->weight, maxweight, (*curlink)->get_in_node()->get_active_out(), (*curlink)->get_out_node()->get_active_out(), (*curlink)->params[0], (*curlink)->params[1], (*curlink)->params[2]);
-                        }
                     }
-
+                    else
+                    { //non-recurrent case
+                        (*curlink)->weight=hebbian((*curlink)->weight, maxweight, (*curlink)->get_in_node()->get_active_out(), (*curlink)->get_out_node()->get_active_out(), (*curlink)->params[0], (*curlink)->params[1], (*curlink)->params[2]);
+                    }
                 }
 
             }
 
         }
 
-    } //end if (adaptable)
-
-    return true;
+    }
 }
 
 // Back-propagates error in the net such that all inputs are active
 // Returns true on success;
 bool Network::backprop()
+{
+    sync_nodes();
+    bool result = backprop_nodes();
+    sync_compiled();
+    return result;
+}
+
+bool Network::backprop_nodes()
 {
     vector<NNodePtr>::iterator curnode;
     F64 add_amount; //For adding to the activesum
@@ -390,6 +449,8 @@ bool Network::backprop()
 // Prints the values of all its nodes
 void Network::show_activation() const
 {
+    sync_nodes();
+
     vector<NNodePtr>::const_iterator curnode;
 
     cout<<"Network "<<name<<" with id "<<net_id<<": (";
@@ -405,6 +466,8 @@ void Network::show_activation() const
 // Prints the values of its inputs
 void Network::show_input() const
 {
+    sync_nodes();
+
     vector<NNodePtr>::const_iterator curnode;
     S32 count;
 
@@ -423,6 +486,8 @@ void Network::show_input() const
 // Prints the values of its outputs
 void Network::show_output() const
 {
+    sync_nodes();
+
     vector<NNodePtr>::const_iterator curnode;
     S32 count;
 
@@ -464,6 +529,12 @@ void Network::load_sensors(const F64 *sensvals)
 {
     vector<NNodePtr>::iterator sensPtr;
 
+    if (compiled)
+    {
+        compiled->load_sensors(sensvals);
+        return;
+    }
+
     for (sensPtr=inputs.begin(); sensPtr!=inputs.end(); ++sensPtr)
     {
         if (((*sensPtr)->type)==SENSOR)
@@ -486,6 +557,12 @@ void Network::load_sensors(const vector<F64> &sensvals)
 {
     vector<NNodePtr>::iterator sensPtr;
     vector<F64>::const_iterator valPtr;
+
+    if (compiled)
+    {
+        compiled->load_sensors(sensvals);
+        return;
+    }
     
     AssertMsg
         (sensvals.size() == inputs.size(), "Got " << sensvals.size() 
@@ -502,11 +579,53 @@ void Network::load_sensors(const vector<F64> &sensvals)
     }
 }
 
+void Network::get_outputs(vector<F64> &outvals) const
+{
+    outvals.resize(outputs.size());
+    if (!outvals.empty())
+        get_outputs(&outvals[0]);
+}
+
+void Network::get_outputs(F64 *outvals) const
+{
+    if (compiled)
+    {
+        for (size_t i = 0; i < outputs.size(); ++i)
+            outvals[i] = compiled->get_output(i);
+    }
+    else
+    {
+        for (size_t i = 0; i < outputs.size(); ++i)
+            outvals[i] = outputs[i]->get_active_out();
+    }
+}
+
+void Network::activate_all(const vector<NetworkPtr> &nets,
+                           const F64 *sensors, size_t num_inputs,
+                           F64 *outvals, size_t num_outputs)
+{
+    // the networks do not share any state, so each one goes through all
+    // of its steps while its nodes are in the cache
+    for (size_t b = 0; b < nets.size(); ++b)
+    {
+        Network& net = *nets[b];
+        AssertMsg(net.inputs.size() == num_inputs,
+                  "Got " << num_inputs << " sensors for a network with " << net.inputs.size() << " inputs");
+        AssertMsg(net.outputs.size() == num_outputs,
+                  "Got room for " << num_outputs << " outputs of a network with " << net.outputs.size());
+        net.load_sensors(sensors + b * num_inputs);
+        net.activate();
+        net.get_outputs(outvals + b * num_outputs);
+    }
+}
+
 void Network::load_errors(const vector<F64> &errorvals)
 {
     vector<NNodePtr>::iterator outPtr;
     vector<F64>::const_iterator valPtr;
 
+    sync_nodes();
+
     for (valPtr = errorvals.begin(), outPtr = outputs.begin(); outPtr
         != outputs.end() && valPtr != errorvals.end(); ++outPtr, ++valPtr)
     {
@@ -521,12 +640,16 @@ void Network::override_outputs(F64* outvals)
 
     vector<NNodePtr>::iterator outPtr;
 
+    sync_nodes();
+
     for (outPtr=outputs.begin(); outPtr!=outputs.end(); ++outPtr)
     {
         (*outPtr)->override_output(*outvals);
         outvals++;
     }
 
+    sync_compiled();
+
 }
 
 void Network::give_name(const string& newname)
@@ -705,7 +828,10 @@ S32 Network::input_start()
 
 S32 Network::load_in(F64 d)
 {
-    (*input_iter)->sensor_load(d);
+    if (compiled)
+        compiled->load_input(input_iter - inputs.begin(), d);
+    else
+        (*input_iter)->sensor_load(d);
     input_iter++;
     if (input_iter==inputs.end())
         return 0;
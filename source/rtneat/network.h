@@ -3,6 +3,7 @@
 
 #include "neat.h"
 #include "nnode.h"
+#include "compilednetwork.h"
 #include "XMLSerializable.h"
 
 namespace NEAT
@@ -35,6 +36,20 @@ namespace NEAT
             void linkcounthelper(const NNodePtr curnode, S32 &counter,
                                  std::vector<NNodePtr> &seenlist) const;
 
+            CompiledNetworkPtr compiled; ///< Flat copy used for activation (null if not compiled)
+
+            /// Bring the NNode objects up to date with the compiled state
+            void sync_nodes() const;
+
+            /// Reload the compiled state after the NNode objects were changed
+            void sync_compiled();
+
+            /// Hebbian adaptation of the link weights after an activation
+            void adapt();
+
+            /// Back-propagation over the NNode objects
+            bool backprop_nodes();
+
         public:
 
             std::vector<NNodePtr> all_nodes; /// A list of all the nodes
@@ -63,6 +78,12 @@ namespace NEAT
 
             ~Network();
 
+            /// Build the flat phenotype used by activate() and load_sensors()
+            void compile();
+
+            /// Is this network activated through a compiled phenotype?
+            bool is_compiled() const { return compiled.get() != 0; }
+
             /// Puts the network back into an inactive state
             void flush();
 
@@ -91,6 +112,19 @@ namespace NEAT
             /// Takes a vector of sensor values and loads it into SENSOR inputs ONLY
             void load_sensors(const std::vector<F64> &sensvals);
 
+            /// Copies the current output activations into outvals
+            void get_outputs(std::vector<F64> &outvals) const;
+
+            /// Copies the current output activations into an array of outputs.size() values
+            void get_outputs(F64 *outvals) const;
+
+            /// Activates a batch of networks, each on its own row of a row-major
+            /// buffer of sensor values, and copies the outputs of each network
+            /// into its row of a row-major output buffer
+            static void activate_all(const std::vector<NetworkPtr> &nets,
+                                     const F64 *sensors, size_t num_inputs,
+                                     F64 *outvals, size_t num_outputs);
+
             /// Takes an array of error values and loads it into OUTPUT nodes
             void load_errors(const std::vector<F64> &errorvals);
 
@@ -59,6 +59,7 @@ NNode::NNode(nodetype ntype, S32 nodeid, nodeplace placement) :
     dup(), 
     analogue(), 
     override(false), 
+    override_value(0), 
     _sensorName(), 
     _sensorArgs(),
     frozen(false),
@@ -88,6 +89,7 @@ NNode::NNode(nodetype ntype, S32 nodeid, nodeplace placement, functype function)
     dup(), 
     analogue(), 
     override(false), 
+    override_value(0), 
     _sensorName(), 
     _sensorArgs(),
     frozen(false),
@@ -95,7 +97,7 @@ NNode::NNode(nodetype ntype, S32 nodeid, nodeplace placement, functype function)
 {
 }
 
-NNode::NNode(NNodePtr n, TraitPtr t) :
+NNode::NNode(const NNodePtr& n, const TraitPtr& t) :
     active_flag(false), 
     activesum(0), 
     activation(0), 
@@ -117,6 +119,7 @@ NNode::NNode(NNodePtr n, TraitPtr t) :
     dup(), 
     analogue(), 
     override(false), 
+    override_value(0), 
     _sensorName(n->_sensorName),
     _sensorArgs(n->_sensorArgs),
     frozen(false), 
@@ -143,6 +146,7 @@ NNode::NNode(istream &args, vector<TraitPtr> &traits) :
     dup(), 
     analogue(), 
     override(false), 
+    override_value(0), 
     _sensorName(), 
     _sensorArgs(),
     frozen(false),
@@ -210,6 +214,7 @@ NNode::NNode(const NNode& nnode)
     frozen = nnode.frozen;
     trait_id = nnode.trait_id;
     override = nnode.override;
+    override_value = nnode.override_value;
 
     _sensorName = nnode._sensorName;
     _sensorArgs = nnode._sensorArgs;
@@ -351,7 +356,7 @@ void NNode::flushback()
 }
 
 // Reserved for future system expansion
-void NNode::derive_trait(TraitPtr curtrait)
+void NNode::derive_trait(const TraitPtr& curtrait)
 {
 
     if (curtrait!=0)
@@ -11,6 +11,7 @@
 #include "trait.h"
 #include "link.h"
 #include "XMLSerializable.h"
+#include "pooled.h"
 
 namespace NEAT
 {
@@ -43,7 +44,7 @@ namespace NEAT
     //   - If it's a sensor, it can be loaded with a value for output
     //   - If it's a neuron, it has a list of its incoming input signals (List<Link> is used) 
     // Use an activation count to avoid flushing
-    class NNode : public boost::enable_shared_from_this<NNode>, public XMLSerializable
+    class NNode : public boost::enable_shared_from_this<NNode>, public XMLSerializable, public Pooled<NNode>
     {
 
             friend class Network;
@@ -118,7 +119,7 @@ namespace NEAT
             NNode(nodetype ntype, S32 nodeid, nodeplace placement, functype function);
 
             // Construct a NNode off another NNode for genome purposes
-            NNode(NNodePtr n, TraitPtr t);
+            NNode(const NNodePtr& n, const TraitPtr& t);
 
             // Construct the node out of a file specification using given list of traits
             NNode(std::istream &iFile, std::vector<TraitPtr> &traits);
@@ -162,7 +163,7 @@ namespace NEAT
             void print_to_file(std::ofstream &outFile);
 
             // Have NNode gain its properties from the trait
-            void derive_trait(TraitPtr curtrait);
+            void derive_trait(const TraitPtr& curtrait);
 
             // Returns the gene that created the node
             NNodePtr get_analogue();
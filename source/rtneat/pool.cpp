@@ -439,7 +439,7 @@ OrganismPtr Pool::reproduce_one(S32 generation, PopulationPtr pop,
                     comporg=(*curspecies)->first();
             }
             else if (((baby->gnome)->compatibility(comporg->gnome))
-                <NEAT::compat_threshold)
+                <pop->params.compat_threshold)
             {
                 //Found compatible species, so add this organism to it
                 (*curspecies)->add_Organism(baby);
@@ -0,0 +1,46 @@
+#ifndef _POOLED_H_
+#define _POOLED_H_
+
+#include <new>
+#include <boost/pool/singleton_pool.hpp>
+
+namespace NEAT
+{
+    /// Base class that makes a class allocate its objects from a pool of
+    ///   fixed-size chunks instead of the general heap.  Genomes create and
+    ///   destroy genes, links, nodes and traits by the thousand during
+    ///   reproduction, and a pool turns each of those into a free-list
+    ///   push or pop.  The pool is shared by all threads and is locked.
+    /// Allocations of any other size (a derived class) go to the heap.
+    template <typename T>
+    class Pooled
+    {
+        public:
+            static void* operator new(std::size_t size)
+            {
+                if (size != sizeof(T))
+                    return ::operator new(size);
+                void* p = boost::singleton_pool<Tag, sizeof(T)>::malloc();
+                if (!p)
+                    throw std::bad_alloc();
+                return p;
+            }
+
+            static void operator delete(void* p, std::size_t size)
+            {
+                if (!p)
+                    return;
+                if (size != sizeof(T))
+                    ::operator delete(p);
+                else
+                    boost::singleton_pool<Tag, sizeof(T)>::free(p);
+            }
+
+        private:
+            /// tells the pools of different classes of the same size apart
+            struct Tag {};
+    };
+
+} // namespace NEAT
+
+#endif
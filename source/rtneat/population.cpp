@@ -1,5 +1,7 @@
 #include "core/Common.h"
 #include "population.h"
+#include "core/ThreadPool.h"
+#include "math/Random.h"
 #include <vector>
 #include <algorithm>
 #include <cmath>
@@ -10,6 +12,61 @@
 using namespace std;
 using namespace NEAT;
 
+namespace
+{
+    // Evaluates one organism for Population::evaluate_all
+    struct EvaluateOrganism
+    {
+        const vector<OrganismPtr>* organisms;
+        const vector<U32>* seeds;
+        const boost::function<bool (OrganismPtr)>* evaluate;
+        vector<char>* wins;
+
+        void operator()(size_t i) const
+        {
+            ScopedRandGen neat_stream((*seeds)[2*i]);
+            OpenNero::ScopedRandomStream stream((*seeds)[2*i+1]);
+            (*wins)[i] = (*evaluate)((*organisms)[i]);
+        }
+    };
+
+    // Finds the first compatible representative of one organism for
+    // Population::reassign_all_species
+    struct MatchOrganism
+    {
+        const vector<OrganismPtr>* organisms;
+        const vector<GenomePtr>* representatives;
+        const CompatibilityCache* cache;
+        F64 compat_threshold;
+        vector<S32>* matches;
+        vector<vector<pair<size_t, F64> > >* computed; // distances to representatives that were not cached
+
+        void operator()(size_t i) const
+        {
+            const GenomePtr& genome = (*organisms)[i]->gnome;
+            (*matches)[i] = -1;
+            for (size_t r = 0; r < representatives->size(); ++r)
+            {
+                const GenomePtr& rep = (*representatives)[r];
+                F64 distance;
+                if (!cache->find(genome, rep, distance))
+                {
+                    distance = GeneSignature::compatibility(genome->get_signature(), rep->get_signature());
+                    (*computed)[i].push_back(make_pair(r, distance));
+                }
+                if (distance < compat_threshold)
+                {
+                    (*matches)[i] = static_cast<S32>(r);
+                    break;
+                }
+            }
+        }
+    };
+
+    // a reassignment with fewer comparisons than this is not worth waking threads for
+    const size_t kMinParallelComparisons = 1 << 14;
+}
+
 PopulationPtr Population::copy(PopulationPtr p) {
   //FIXME - size hardcoded
   PopulationPtr np(new Population(p->organisms[0]->gnome,1));
@@ -254,10 +311,22 @@ Population::Population(const std::string& filename, S32 size)
     }
 }
 
+Population::Population()
+{
+}
+
 Population::~Population()
 {
 }
 
+OpenNero::ThreadPool& Population::get_thread_pool(S32 threads)
+{
+    size_t num_threads = threads > 0 ? threads : 0;
+    if (!thread_pool || (num_threads != 0 && thread_pool->GetNumThreads() != num_threads))
+        thread_pool.reset(new OpenNero::ThreadPool(num_threads));
+    return *thread_pool;
+}
+
 bool Population::verify()
 {
     vector<OrganismPtr>::iterator curorg;
@@ -272,6 +341,28 @@ bool Population::verify()
     return verification;
 }
 
+bool Population::evaluate_all(const boost::function<bool (OrganismPtr)>& evaluate, S32 threads)
+{
+    // draw the seeds serially so that they do not depend on the scheduling
+    vector<U32> seeds(2*organisms.size());
+    for (size_t i = 0; i < seeds.size(); ++i)
+    {
+        seeds[i] = randgen().randInt();
+    }
+
+    vector<char> wins(organisms.size(), false);
+
+    EvaluateOrganism task;
+    task.organisms = &organisms;
+    task.seeds = &seeds;
+    task.evaluate = &evaluate;
+    task.wins = &wins;
+
+    get_thread_pool(threads).ParallelFor(organisms.size(), task);
+
+    return find(wins.begin(), wins.end(), true) != wins.end();
+}
+
 bool Population::clone(GenomePtr g, S32 size, F32 power)
 {
     S32 count;
@@ -335,6 +426,7 @@ bool Population::spawn(GenomePtr g, S32 size)
 
 bool Population::speciate()
 {
+    removal_index.clear();
     vector<OrganismPtr>::iterator curorg; //For stepping through Population
     vector<SpeciesPtr>::iterator curspecies; //Steps through species
     OrganismPtr comporg; //Organism for comparison 
@@ -363,7 +455,7 @@ bool Population::speciate()
             {
 
                 if ((((*curorg)->gnome)->compatibility(comporg->gnome))
-                    <NEAT::compat_threshold)
+                    <params.compat_threshold)
                 {
 
                     //Found compatible species, so add this organism to it
@@ -429,6 +521,7 @@ bool Population::print_to_file(std::ofstream &outFile)
 
 bool Population::epoch(S32 generation)
 {
+    removal_index.clear();
 
     vector<SpeciesPtr>::iterator curspecies;
     vector<SpeciesPtr>::iterator deadspecies; //For removing empty Species
@@ -484,12 +577,12 @@ bool Population::epoch(S32 generation)
     if (generation>1)
     {
         if (num_species<num_species_target)
-            NEAT::compat_threshold-=compat_mod;
+            params.compat_threshold-=compat_mod;
         else if (num_species>num_species_target)
-            NEAT::compat_threshold+=compat_mod;
+            params.compat_threshold+=compat_mod;
 
-        if (NEAT::compat_threshold<0.3)
-            NEAT::compat_threshold=0.3;
+        if (params.compat_threshold<0.3)
+            params.compat_threshold=0.3;
 
     }
 
@@ -979,7 +1072,7 @@ void Population::estimate_all_averages()
 
     for (curspecies=species.begin(); curspecies!=species.end(); ++curspecies)
     {
-        (*curspecies)->estimate_average();
+        (*curspecies)->estimate_average(params.time_alive_minimum);
     }
 
 }
@@ -1005,11 +1098,11 @@ SpeciesPtr Population::choose_parent_species()
     // normally would be held constant
 
     //if (num_species<num_species_target)
-    //	NEAT::compat_threshold-=compat_mod;
+    //	params.compat_threshold-=compat_mod;
     //else if (num_species>num_species_target)
-    //	NEAT::compat_threshold+=compat_mod;
+    //	params.compat_threshold+=compat_mod;
 
-    //if (NEAT::compat_threshold<0.3) NEAT::compat_threshold=0.3;
+    //if (params.compat_threshold<0.3) params.compat_threshold=0.3;
 
 
     //Use the roulette method to choose the species 
@@ -1055,51 +1148,23 @@ bool Population::remove_species(SpeciesPtr spec)
 
 OrganismPtr Population::remove_worst()
 {
-
-    F64 adjusted_fitness;
-    F64 min_fitness=999999;
-    vector<OrganismPtr>::iterator curorg;
     OrganismPtr org_to_kill;
-    vector<OrganismPtr>::iterator deadorg;
     SpeciesPtr orgs_species; //The species of the dead organism
 
-    //Make sure the organism is deleted from its species and the population
-
-    //First find the organism with minimum *adjusted* fitness
-    for (curorg=organisms.begin(); curorg!=organisms.end(); ++curorg)
-    {
-        adjusted_fitness=((*curorg)->fitness)/((*curorg)->species.lock()->organisms.size());
-
-        if ((*curorg)->smited)
-        {
-            //get the next time multiple
-            U32 nextMultiple;
-            if ((*curorg)->time_alive % NEAT::time_alive_minimum == 0)
-                nextMultiple = (*curorg)->time_alive;
-            else
-                nextMultiple = NEAT::time_alive_minimum * ((*curorg)->time_alive / NEAT::time_alive_minimum + 1);
-
-            adjusted_fitness=-9999;
-            (*curorg)->time_alive = nextMultiple;
-        }
-
-        if ( (adjusted_fitness<min_fitness)
-            &&((*curorg)->time_alive
-                >= static_cast<S32>(NEAT::time_alive_minimum) ))
-        {
-            min_fitness=adjusted_fitness;
-            org_to_kill=(*curorg);
-            deadorg=curorg;
-            orgs_species = (*curorg)->species.lock();
-        }
-    }
+    //Find the organism with minimum *adjusted* fitness
+    if (!removal_index.is_built() || removal_index.get_time_alive_minimum() != params.time_alive_minimum)
+        removal_index.build(organisms, params.time_alive_minimum);
+    org_to_kill = removal_index.worst();
 
+    //Make sure the organism is deleted from its species and the population
     if (org_to_kill)
     {
+        orgs_species = org_to_kill->species.lock();
 
         //Remove the organism from its species and the population
         orgs_species->remove_org(org_to_kill); //Remove from species
-        organisms.erase(deadorg); //Remove from population list
+        organisms.erase(find(organisms.begin(), organisms.end(), org_to_kill)); //Remove from population list
+        removal_index.remove(org_to_kill);
 
         //Did the species become empty?
         if (orgs_species->organisms.size()==0)
@@ -1109,15 +1174,32 @@ OrganismPtr Population::remove_worst()
         //If not, re-estimate the species average after removing the organism
         else
         {
-            orgs_species->estimate_average();
+            orgs_species->estimate_average(params.time_alive_minimum);
+            removal_index.update_species(orgs_species);
         }
     }
 
     return org_to_kill;
 }
 
+void Population::update_organism(const OrganismPtr& org)
+{
+    if (removal_index.is_built())
+        removal_index.update(org);
+}
+
+void Population::set_fitness(const OrganismPtr& org, F64 fitness)
+{
+    // most organisms keep their fitness from one evaluation to the next
+    if (org->fitness == fitness)
+        return;
+    org->fitness = fitness;
+    update_organism(org);
+}
+
 OrganismPtr Population::remove_worst(U32 range)
 {
+    removal_index.clear();
 
     F64 adjusted_fitness;
     F64 min_fitness=999999;
@@ -1138,10 +1220,10 @@ OrganismPtr Population::remove_worst(U32 range)
         {
             //get the next time multiple
             U32 nextMultiple;
-            if ((*curorg)->time_alive % NEAT::time_alive_minimum == 0)
+            if ((*curorg)->time_alive % params.time_alive_minimum == 0)
                 nextMultiple = (*curorg)->time_alive;
             else
-                nextMultiple = NEAT::time_alive_minimum * ((*curorg)->time_alive / NEAT::time_alive_minimum + 1);
+                nextMultiple = params.time_alive_minimum * ((*curorg)->time_alive / params.time_alive_minimum + 1);
 
             adjusted_fitness=-9999;
             (*curorg)->time_alive = nextMultiple;
@@ -1149,7 +1231,7 @@ OrganismPtr Population::remove_worst(U32 range)
 
         if ( (adjusted_fitness<min_fitness)
             &&((*curorg)->time_alive
-                >= static_cast<S32>(NEAT::time_alive_minimum) ))
+                >= static_cast<S32>(params.time_alive_minimum) ))
         {
             min_fitness=adjusted_fitness;
             org_to_kill=(*curorg);
@@ -1173,7 +1255,7 @@ OrganismPtr Population::remove_worst(U32 range)
         //If not, re-estimate the species average after removing the organism
         else
         {
-            orgs_species->estimate_average();
+            orgs_species->estimate_average(params.time_alive_minimum);
         }
     }
 
@@ -1182,6 +1264,7 @@ OrganismPtr Population::remove_worst(U32 range)
 
 OrganismPtr Population::remove_worst_probabilistic()
 {
+    removal_index.clear();
 
     vector<OrganismPtr>::iterator curorg;
     OrganismPtr org_to_kill;
@@ -1194,7 +1277,7 @@ OrganismPtr Population::remove_worst_probabilistic()
 
     for (curorg = organisms.begin(); curorg != organisms.end(); ++curorg)
     {
-        if ((*curorg)->time_alive >= static_cast<S32>(NEAT::time_alive_minimum) )
+        if ((*curorg)->time_alive >= static_cast<S32>(params.time_alive_minimum) )
             sorted_adjusted_orgs.push_back(*curorg);
     }
 
@@ -1238,7 +1321,7 @@ OrganismPtr Population::remove_worst_probabilistic()
         //If not, re-estimate the species average after removing the organism
         else
         {
-            orgs_species->estimate_average();
+            orgs_species->estimate_average(params.time_alive_minimum);
         }
     }
 
@@ -1264,7 +1347,7 @@ OrganismPtr Population::reproduce_champ(S32 generation)
     //Find the population champ
     for (curorg = organisms.begin(); curorg != organisms.end(); ++curorg)
     {
-        if (((*curorg)->fitness>max_fitness)&&((*curorg)->time_alive >= static_cast<S32>(NEAT::time_alive_minimum)))
+        if (((*curorg)->fitness>max_fitness)&&((*curorg)->time_alive >= static_cast<S32>(params.time_alive_minimum)))
         {
             champ=(*curorg);
             max_fitness=champ->fitness;
@@ -1308,7 +1391,7 @@ OrganismPtr Population::reproduce_champ(S32 generation)
                     comporg=(*curspecies)->first();
             }
             else if (((baby->gnome)->compatibility(comporg->gnome))
-                <NEAT::compat_threshold)
+                <params.compat_threshold)
             {
                 //Found compatible species, so add this organism to it
                 (*curspecies)->add_Organism(baby);
@@ -1372,7 +1455,7 @@ void Population::reassign_species(OrganismPtr org)
             if (curspecies!=(species).end())
                 comporg=(*curspecies)->first();
         }
-        else if (((org->gnome)->compatibility(comporg->gnome))<NEAT::compat_threshold)
+        else if (compat_cache.compatibility(org->gnome, comporg->gnome)<params.compat_threshold)
         {
             //If we found the same species it's already in, return 0
             if ( *curspecies == org->species.lock() )
@@ -1411,6 +1494,75 @@ void Population::reassign_species(OrganismPtr org)
     
 }
 
+void Population::reassign_all_species(S32 threads)
+{
+    if (species.empty())
+        return;
+
+    //Compare with the species as they are now, so that the comparisons do not
+    //depend on each other and can run in parallel
+    vector<SpeciesPtr> targets;
+    vector<GenomePtr> representatives;
+    for (vector<SpeciesPtr>::iterator curspecies = species.begin(); curspecies != species.end(); ++curspecies)
+    {
+        if ((*curspecies)->organisms.empty())
+            continue;
+        targets.push_back(*curspecies);
+        representatives.push_back((*curspecies)->first()->gnome);
+        representatives.back()->get_signature();
+    }
+    for (vector<OrganismPtr>::iterator curorg = organisms.begin(); curorg != organisms.end(); ++curorg)
+        (*curorg)->gnome->get_signature();
+
+    vector<OrganismPtr> orgs(organisms);
+    vector<S32> matches(orgs.size(), -1);
+    vector<vector<pair<size_t, F64> > > computed(orgs.size());
+
+    MatchOrganism task;
+    task.organisms = &orgs;
+    task.representatives = &representatives;
+    task.cache = &compat_cache;
+    task.compat_threshold = params.compat_threshold;
+    task.matches = &matches;
+    task.computed = &computed;
+
+    if (threads != 1 && orgs.size() * representatives.size() >= kMinParallelComparisons)
+    {
+        get_thread_pool(threads).ParallelFor(orgs.size(), task);
+    }
+    else
+    {
+        for (size_t i = 0; i < orgs.size(); ++i)
+            task(i);
+    }
+
+    //Remember the new distances and move the organisms in order
+    for (size_t i = 0; i < orgs.size(); ++i)
+    {
+        for (size_t k = 0; k < computed[i].size(); ++k)
+            compat_cache.insert(orgs[i]->gnome, representatives[computed[i][k].first], computed[i][k].second);
+
+        OrganismPtr org = orgs[i];
+        SpeciesPtr current = org->species.lock();
+        if (matches[i] < 0)
+        {
+            //No species matched: maybe one created earlier in this pass does
+            reassign_species(org);
+            continue;
+        }
+        SpeciesPtr target = targets[matches[i]];
+        if (target == current)
+            continue;
+        if (target->organisms.empty())
+        {
+            //Everybody left the matching species and it is gone
+            reassign_species(org);
+            continue;
+        }
+        switch_species(org, current, target);
+    }
+}
+
 //Move an Organism from one Species to another
 void Population::switch_species(OrganismPtr org, SpeciesPtr orig_species,
                                 SpeciesPtr new_species)
@@ -1423,6 +1575,14 @@ void Population::switch_species(OrganismPtr org, SpeciesPtr orig_species,
     new_species->add_Organism(org);
     org->species=new_species;
 
+    //Both species changed size, so their members need new adjusted fitnesses
+    if (removal_index.is_built())
+    {
+        removal_index.update(org);
+        removal_index.update_species(new_species);
+        if (orig_species) removal_index.update_species(orig_species);
+    }
+
     //KEN: Delete orig_species if empty, and remove it from pop
     if (orig_species && orig_species->organisms.size() == 0)
     {
@@ -1430,14 +1590,14 @@ void Population::switch_species(OrganismPtr org, SpeciesPtr orig_species,
         remove_species(orig_species);
 
         //Re-estimate the average of the species that now has a new member
-        new_species->estimate_average();
+        new_species->estimate_average(params.time_alive_minimum);
     }
     //If not, re-estimate the species average after removing the organism
     // AND the new species with the new member
     else
     {
-        if (orig_species) orig_species->estimate_average();
-        new_species->estimate_average();
+        if (orig_species) orig_species->estimate_average(params.time_alive_minimum);
+        new_species->estimate_average(params.time_alive_minimum);
     }
 }
 
@@ -1473,7 +1633,7 @@ void Population::add_organism(OrganismPtr org)
                 if (curspecies!=species.end())
                     comporg=(*curspecies)->first();
             }
-            else if (org->gnome->compatibility(comporg->gnome) < NEAT::compat_threshold )
+            else if (compat_cache.compatibility(org->gnome, comporg->gnome) < params.compat_threshold )
             {
                 //Found compatible species, so add this organism to it
                 (*curspecies)->add_Organism(org);
@@ -1502,4 +1662,11 @@ void Population::add_organism(OrganismPtr org)
 
     //Put the org also in the master organism list
     organisms.push_back(org);
+
+    //Its species grew, so the other members need new adjusted fitnesses
+    if (removal_index.is_built())
+    {
+        removal_index.update(org);
+        removal_index.update_species(org->species.lock());
+    }
 }
@@ -7,7 +7,17 @@
 #include "species.h"
 #include "organism.h"
 #include "pool.h"
+#include "removalindex.h"
+#include "compatibility.h"
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/serialization/version.hpp>
+
+namespace OpenNero
+{
+    class ThreadPool;
+}
 
 namespace NEAT
 {
@@ -25,14 +35,21 @@ namespace NEAT
     {
         private:
             friend class boost::serialization::access;
+            friend PopulationPtr load_population_snapshot(const std::string& filename);
         
-            Population() {}
+            Population();
         
             // A Population can be spawned off of a single Genome 
             // There will be size Genomes added to the Population 
             // The Population does not have to be empty to add Genomes 
             bool spawn(GenomePtr g, S32 size);
 
+            boost::scoped_ptr<OpenNero::ThreadPool> thread_pool; // Made by the first parallel loop, then kept
+
+            // The pool to run parallel loops on with threads threads (0 for one per core),
+            // made again only when the number of threads changes
+            OpenNero::ThreadPool& get_thread_pool(S32 threads);
+
         public:
 
 			PopulationPtr copy(PopulationPtr p);
@@ -42,12 +59,18 @@ namespace NEAT
             std::vector<SpeciesPtr> species; // Species in the Population. Note that the species should comprise all the genomes 
 
             // ******* Member variables used during reproduction *******
-            std::vector<InnovationPtr> innovations; // For holding the genetic innovations of the newest generation
+            InnovationRegistry innovations; // For matching the genetic innovations of the newest generation
             S32 cur_node_id; //Current label number available
             F64 cur_innov_num;
 
             S32 last_species; //The highest species number
 
+            PopulationParams params; // Compatibility threshold, time_alive_minimum and random stream of this population
+
+            // ******* Member variables used during real-time evolution *******
+            RemovalIndex removal_index; // Finds the organism for remove_worst(); built by its first call
+            CompatibilityCache compat_cache; // Compatibilities of organisms with species representatives
+
             // ******* Fitness Statistics *******
             F64 mean_fitness;
             F64 variance;
@@ -77,6 +100,15 @@ namespace NEAT
             // Run verify on all Genomes in this Population (Debugging)
             bool verify();
 
+            // Evaluate every organism with the given function on threads threads
+            // (0 for one per core).  Every evaluation gets its own random streams,
+            // seeded from NEATRandGen in organism order, so the results depend on
+            // the seed but not on the number of threads.  The threads are kept from
+            // one generation to the next.
+            // Returns true if any of the evaluations returned true (a winner)
+            bool evaluate_all(const boost::function<bool (OrganismPtr)>& evaluate,
+                              S32 threads = num_threads);
+
             // Turnover the population to a new generation using fitness 
             // The generation argument is the next generation
             bool epoch(S32 generation);
@@ -106,8 +138,16 @@ namespace NEAT
             // Removes worst member of population that has been around for a minimum amount of time and returns
             // a pointer to the Organism that was removed (note that the pointer will not point to anything at all,
             // since the Organism it was pointing to has been deleted from memory)
+            // The worst member is looked up in removal_index, so callers that change the fitness
+            // or time_alive of organisms need to call update_organism() on them
             OrganismPtr remove_worst();
 
+            // Tell remove_worst() that the fitness, time_alive or smited flag of an organism changed
+            void update_organism(const OrganismPtr& org);
+
+            // Set the fitness of an organism, telling remove_worst() only if it changed
+            void set_fitness(const OrganismPtr& org, F64 fitness);
+
             OrganismPtr remove_worst_probabilistic();
 
             // Similar to remove_worst(), but considers only the first range organisms.
@@ -119,6 +159,13 @@ namespace NEAT
             //as the speciation threshold changes.
             void reassign_species(OrganismPtr org);
 
+            // Reassign every organism, as if reassign_species were called on each in turn,
+            // except that all of them are compared with the first members the species had
+            // when the call started.  The comparisons run on threads threads (0 for one per
+            // core) when there are enough of them to be worth it, on the pool the population
+            // keeps.  Pass 1 when already on a worker thread, as an island ticked in parallel is.
+            void reassign_all_species(S32 threads = num_threads);
+
             //Move an Organism from one Species to another (called by reassign_species)
             void switch_species(OrganismPtr org, SpeciesPtr orig_species,
                                 SpeciesPtr new_species);
@@ -165,7 +212,17 @@ namespace NEAT
                 ar & BOOST_SERIALIZATION_NVP(last_species);
                 ar & BOOST_SERIALIZATION_NVP(cur_innov_num);
                 ar & BOOST_SERIALIZATION_NVP(cur_node_id);
-                ar & BOOST_SERIALIZATION_NVP(innovations);
+                if (Archive::is_loading::value && version < 1)
+                {
+                    // older populations kept a plain list of innovations
+                    std::vector<InnovationPtr> innovation_list;
+                    ar & boost::serialization::make_nvp("innovations", innovation_list);
+                    innovations.assign(innovation_list);
+                }
+                else
+                {
+                    ar & BOOST_SERIALIZATION_NVP(innovations);
+                }
                 ar & BOOST_SERIALIZATION_NVP(mean_fitness);
                 ar & BOOST_SERIALIZATION_NVP(variance);
                 ar & BOOST_SERIALIZATION_NVP(standard_deviation);
@@ -183,4 +240,7 @@ namespace NEAT
     
 } // namespace NEAT
 
+// version 1 keeps the innovations in an InnovationRegistry
+BOOST_CLASS_VERSION(NEAT::Population, 1)
+
 #endif
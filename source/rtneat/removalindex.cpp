@@ -0,0 +1,186 @@
+#include "core/Common.h"
+#include "removalindex.h"
+#include "organism.h"
+#include "species.h"
+
+using namespace std;
+using namespace NEAT;
+
+namespace
+{
+    // adjusted fitness of smited organisms (see Population::remove_worst)
+    const F64 kSmitedFitness = -9999;
+}
+
+bool RemovalIndex::Entry::operator<(const Entry& other) const
+{
+    if (smited != other.smited)
+        return smited;
+    if (fitness != other.fitness)
+        return fitness < other.fitness;
+    return seq < other.seq;
+}
+
+bool RemovalIndex::SpeciesKey::operator<(const SpeciesKey& other) const
+{
+    if (adjusted != other.adjusted)
+        return adjusted < other.adjusted;
+    return seq < other.seq;
+}
+
+RemovalIndex::RemovalIndex()
+    : built(false)
+    , time_alive_min(0)
+    , next_seq(0)
+    , num_eligible(0)
+    , updates(0)
+{
+}
+
+void RemovalIndex::build(const vector<OrganismPtr>& orgs, U32 time_alive_minimum)
+{
+    clear();
+    built = true;
+    time_alive_min = time_alive_minimum;
+    for (size_t i = 0; i < orgs.size(); ++i)
+        update(orgs[i]);
+    updates = 0;
+}
+
+void RemovalIndex::clear()
+{
+    built = false;
+    num_eligible = 0;
+    updates = 0;
+    organisms.clear();
+    species.clear();
+    keys.clear();
+}
+
+void RemovalIndex::update(const OrganismPtr& org)
+{
+    ++updates;
+    OrganismMap::iterator found = organisms.find(org.get());
+    if (found == organisms.end())
+    {
+        OrganismInfo info;
+        info.org = org;
+        info.seq = next_seq++;
+        info.spec = NULL;
+        info.eligible = false;
+        found = organisms.insert(make_pair(org.get(), info)).first;
+    }
+    OrganismInfo& info = found->second;
+    unlink(info);
+
+    if (org->smited)
+    {
+        //Smited organisms are judged at the next time multiple
+        if (org->time_alive % time_alive_min != 0)
+            org->time_alive = time_alive_min * (org->time_alive / time_alive_min + 1);
+    }
+
+    SpeciesPtr spec = org->species.lock();
+    if (spec && org->time_alive >= static_cast<S32>(time_alive_min))
+    {
+        Entry entry;
+        entry.smited = org->smited;
+        entry.fitness = org->fitness;
+        entry.seq = info.seq;
+        entry.org = org.get();
+        SpeciesMap::iterator s = species.find(spec.get());
+        if (s == species.end())
+        {
+            SpeciesInfo empty;
+            empty.key = keys.end();
+            empty.size = 0;
+            s = species.insert(make_pair(spec.get(), empty)).first;
+        }
+        info.pos = s->second.members.insert(entry).first;
+        info.spec = spec.get();
+        info.eligible = true;
+        ++num_eligible;
+        rekey(spec.get(), spec->organisms.size());
+    }
+}
+
+void RemovalIndex::update_species(const SpeciesPtr& spec)
+{
+    if (species.count(spec.get()))
+        rekey(spec.get(), spec->organisms.size());
+}
+
+void RemovalIndex::remove(const OrganismPtr& org)
+{
+    OrganismMap::iterator found = organisms.find(org.get());
+    if (found != organisms.end())
+    {
+        unlink(found->second);
+        organisms.erase(found);
+    }
+}
+
+OrganismPtr RemovalIndex::worst()
+{
+    while (!keys.empty())
+    {
+        const Species* key_spec = keys.begin()->spec;
+        SpeciesInfo& s = species.find(key_spec)->second;
+        const Entry& entry = *s.members.begin();
+        OrganismPtr org = organisms.find(entry.org)->second.org;
+
+        // somebody changed the organism without telling us
+        SpeciesPtr spec = org->species.lock();
+        if (spec.get() != key_spec
+            || org->fitness != entry.fitness
+            || org->smited != entry.smited
+            || org->time_alive < static_cast<S32>(time_alive_min))
+        {
+            update(org);
+            continue;
+        }
+        if (spec->organisms.size() != s.size)
+        {
+            rekey(key_spec, spec->organisms.size());
+            continue;
+        }
+        return org;
+    }
+    return OrganismPtr();
+}
+
+void RemovalIndex::unlink(OrganismInfo& info)
+{
+    if (!info.eligible)
+        return;
+    SpeciesInfo& s = species.find(info.spec)->second;
+    s.members.erase(info.pos);
+    info.eligible = false;
+    --num_eligible;
+    // the species may have grown or shrunk too, keep the size it was keyed with
+    rekey(info.spec, s.size);
+    info.spec = NULL;
+}
+
+void RemovalIndex::rekey(const Species* spec, size_t size)
+{
+    SpeciesMap::iterator found = species.find(spec);
+    SpeciesInfo& s = found->second;
+    if (s.key != keys.end())
+    {
+        keys.erase(s.key);
+        s.key = keys.end();
+    }
+    if (s.members.empty())
+    {
+        species.erase(found);
+        return;
+    }
+    const Entry& worst = *s.members.begin();
+    SpeciesKey key;
+    key.adjusted = worst.smited ? kSmitedFitness : worst.fitness / (size > 0 ? size : 1);
+    key.seq = worst.seq;
+    key.spec = spec;
+    s.key = keys.insert(key).first;
+    s.size = size;
+}
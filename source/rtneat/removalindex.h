@@ -0,0 +1,118 @@
+#ifndef _REMOVALINDEX_H_
+#define _REMOVALINDEX_H_
+
+#include <set>
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include "neat.h"
+
+namespace NEAT
+{
+    class Organism;
+    class Species;
+
+    /// A REMOVAL INDEX finds the organism that real-time evolution should
+    ///   remove next: the one with the lowest fitness divided by the size of
+    ///   its species, among those that have lived at least the time_alive_minimum
+    ///   of the population (smited organisms go first).
+    /// Dividing by the species size does not change the order within a
+    ///   species, so each species keeps its eligible members sorted by fitness
+    ///   and the species are sorted by the adjusted fitness of their worst
+    ///   member.  Re-keying an organism or a species costs O(log n).
+    /// The index does not watch the organisms: whoever changes the fitness,
+    ///   time_alive, smited flag or species of an organism calls update(),
+    ///   and whoever changes the size of a species calls update_species().
+    ///   The candidate returned by worst() is checked against its organism
+    ///   and re-keyed if it went stale.
+    class RemovalIndex
+    {
+        public:
+            RemovalIndex();
+
+            /// Has the index been built since it was last cleared?
+            bool is_built() const { return built; }
+
+            /// Index all the given organisms, in order, counting those that
+            /// have lived at least time_alive_minimum as eligible
+            void build(const std::vector<OrganismPtr>& organisms, U32 time_alive_minimum);
+
+            /// The time_alive_minimum the index was built with
+            U32 get_time_alive_minimum() const { return time_alive_min; }
+
+            /// Forget all the organisms until the index is built again
+            void clear();
+
+            /// Re-key an organism, adding it to the index if it is new
+            void update(const OrganismPtr& org);
+
+            /// Re-key a species whose size changed
+            void update_species(const SpeciesPtr& spec);
+
+            /// Drop an organism that left the population
+            void remove(const OrganismPtr& org);
+
+            /// The eligible organism with the lowest adjusted fitness, or null if none is eligible
+            OrganismPtr worst();
+
+            /// Number of eligible organisms
+            size_t size() const { return num_eligible; }
+
+            /// Number of times an organism was re-keyed since the index was built
+            size_t num_updates() const { return updates; }
+
+        private:
+            // an eligible organism in the sorted members of its species;
+            // seq orders ties by when the organism joined the population
+            struct Entry
+            {
+                bool smited;
+                F64 fitness;
+                U64 seq;
+                const Organism* org;
+                bool operator<(const Entry& other) const;
+            };
+
+            // a species, sorted by the adjusted fitness of its worst member
+            struct SpeciesKey
+            {
+                F64 adjusted;
+                U64 seq;
+                const Species* spec;
+                bool operator<(const SpeciesKey& other) const;
+            };
+
+            struct SpeciesInfo
+            {
+                std::set<Entry> members; // eligible members only
+                std::set<SpeciesKey>::iterator key;
+                size_t size; // species size that the key was computed with
+            };
+
+            struct OrganismInfo
+            {
+                OrganismPtr org;
+                U64 seq;
+                const Species* spec; // the species it is indexed in, if eligible
+                bool eligible;
+                std::set<Entry>::iterator pos;
+            };
+
+            typedef boost::unordered_map<const Organism*, OrganismInfo> OrganismMap;
+            typedef boost::unordered_map<const Species*, SpeciesInfo> SpeciesMap;
+
+            void unlink(OrganismInfo& info);
+            void rekey(const Species* spec, size_t size);
+
+            bool built;
+            U32 time_alive_min;
+            U64 next_seq;
+            size_t num_eligible;
+            size_t updates;
+            OrganismMap organisms;
+            SpeciesMap species;
+            std::set<SpeciesKey> keys;
+    };
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,667 @@
+#include "core/Common.h"
+#include "snapshot.h"
+#include "population.h"
+#include "organism.h"
+#include "species.h"
+#include "genome.h"
+#include "gene.h"
+#include "link.h"
+#include "nnode.h"
+#include "trait.h"
+#include "factor.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace NEAT;
+
+namespace
+{
+    const char kMagic[8] = { 'N', 'E', 'A', 'T', 'S', 'N', 'A', 'P' };
+    const U32 kVersion = 2;
+    const S32 kNone = -1;
+
+    // flag bits of an OrganismRecord
+    enum
+    {
+        kWinner = 1 << 0,
+        kEliminate = 1 << 1,
+        kChampion = 1 << 2,
+        kPopChamp = 1 << 3,
+        kPopChampChild = 1 << 4,
+        kMutStructBaby = 1 << 5,
+        kMateBaby = 1 << 6,
+        kSmited = 1 << 7
+    };
+
+    // flag bits of a SpeciesRecord
+    enum
+    {
+        kNovel = 1 << 0,
+        kChecked = 1 << 1,
+        kObliterate = 1 << 2
+    };
+
+    // a string stored in the character section
+    struct StringRecord
+    {
+        U64 offset;
+        U64 length;
+    };
+
+    // an organism and the ranges of its genome in the trait, node, gene and factor sections
+    struct OrganismRecord
+    {
+        F64 fitness;
+        F64 orig_fitness;
+        F64 error;
+        F64 expected_offspring;
+        F64 high_fit;
+        StringRecord metadata;
+        U32 first_trait, num_traits;
+        U32 first_node, num_nodes;
+        U32 first_gene, num_genes;
+        U32 first_factor, num_factors;
+        S32 genome_id;
+        S32 generation;
+        S32 super_champ_offspring;
+        S32 time_alive;
+        U32 flags;
+        S32 species; // index of the species record or kNone
+    };
+
+    // a species and the range of its members in the member section
+    struct SpeciesRecord
+    {
+        F64 ave_fitness;
+        F64 max_fitness;
+        F64 max_fitness_ever;
+        F64 average_est;
+        S32 id;
+        S32 age;
+        S32 expected_offspring;
+        S32 age_of_last_improvement;
+        U32 first_member, num_members;
+        U32 flags;
+        U32 padding;
+    };
+
+    struct TraitRecord
+    {
+        F64 params[NEAT::num_trait_params];
+        S32 trait_id;
+        U32 padding;
+    };
+
+    // trait indices are relative to the first trait of the genome
+    struct NodeRecord
+    {
+        StringRecord sensor_name;
+        StringRecord sensor_args;
+        S32 node_id;
+        S32 trait;
+        S32 type;
+        S32 gen_node_label;
+        S32 ftype;
+        U32 frozen;
+    };
+
+    // trait and node indices are relative to the first trait and node of the genome
+    struct GeneRecord
+    {
+        F64 weight;
+        F64 innovation_num;
+        F64 mutation_num;
+        S32 trait;
+        U32 in_node;
+        U32 out_node;
+        U32 recurrent;
+        U32 enable;
+        U32 frozen;
+    };
+
+    struct FactorRecord
+    {
+        StringRecord record;
+        S32 id;
+        U32 padding;
+    };
+
+    // the sections of a snapshot after the header
+    enum Section
+    {
+        kChars,
+        kOrganisms,
+        kSpecies,
+        kMembers,
+        kTraits,
+        kNodes,
+        kGenes,
+        kFactors,
+        kNumSections
+    };
+
+    // where the sections are and how big their records were when written
+    struct Header
+    {
+        char magic[8];
+        U32 version;
+        U32 num_trait_params;
+        U32 record_sizes[kNumSections];
+        U64 offsets[kNumSections];
+        U64 counts[kNumSections];
+        F64 cur_innov_num;
+        F64 mean_fitness;
+        F64 variance;
+        F64 standard_deviation;
+        F64 highest_fitness;
+        S32 cur_node_id;
+        S32 last_species;
+        S32 winnergen;
+        S32 highest_last_changed;
+        U32 randgen[MTRand::SAVE]; // the state of the random stream of the population
+    };
+
+    void set_record_sizes(U32 sizes[kNumSections])
+    {
+        sizes[kChars] = sizeof(char);
+        sizes[kOrganisms] = sizeof(OrganismRecord);
+        sizes[kSpecies] = sizeof(SpeciesRecord);
+        sizes[kMembers] = sizeof(U32);
+        sizes[kTraits] = sizeof(TraitRecord);
+        sizes[kNodes] = sizeof(NodeRecord);
+        sizes[kGenes] = sizeof(GeneRecord);
+        sizes[kFactors] = sizeof(FactorRecord);
+    }
+
+    // Appends strings to the character section
+    class StringWriter
+    {
+        public:
+            vector<char> chars;
+
+            StringRecord add(const string& s)
+            {
+                StringRecord r;
+                r.offset = chars.size();
+                r.length = s.size();
+                chars.insert(chars.end(), s.begin(), s.end());
+                return r;
+            }
+    };
+
+    // the records of one section, as the bytes to write
+    struct SectionBytes
+    {
+        const char* data;
+        U64 size;
+    };
+
+    template <typename T>
+    SectionBytes section_bytes(const vector<T>& records)
+    {
+        SectionBytes s;
+        s.data = records.empty() ? NULL : reinterpret_cast<const char*>(&records[0]);
+        s.size = records.size() * sizeof(T);
+        return s;
+    }
+
+    // Gives checked access to the sections of a mapped snapshot
+    class SnapshotReader
+    {
+        public:
+            SnapshotReader(const char* data, size_t size, const string& filename)
+                : data(data), size(size), filename(filename), header(NULL)
+            {
+                if (size < sizeof(Header))
+                    fail("file is too short");
+                header = reinterpret_cast<const Header*>(data);
+                if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0)
+                    fail("not a population snapshot");
+                if (header->version != kVersion)
+                    fail("unsupported version");
+                U32 sizes[kNumSections];
+                set_record_sizes(sizes);
+                if (header->num_trait_params != (U32)NEAT::num_trait_params
+                    || memcmp(header->record_sizes, sizes, sizeof(sizes)) != 0)
+                    fail("written by an incompatible build");
+                for (S32 s = 0; s < kNumSections; ++s)
+                {
+                    U64 at = header->offsets[s], count = header->counts[s];
+                    if (at > size || at % 8 != 0 || count > (size - at) / sizes[s])
+                        fail("section out of bounds");
+                }
+            }
+
+            template <typename T>
+            const T* section(Section s) const
+            {
+                return reinterpret_cast<const T*>(data + header->offsets[s]);
+            }
+
+            U64 count(Section s) const
+            {
+                return header->counts[s];
+            }
+
+            // check that [first, first + n) lies inside section s
+            void check_range(Section s, U64 first, U64 n) const
+            {
+                if (first > count(s) || n > count(s) - first)
+                    fail("record range out of bounds");
+            }
+
+            void check_index(S32 index, U32 n) const
+            {
+                if (index != kNone && (index < 0 || (U32)index >= n))
+                    fail("record index out of bounds");
+            }
+
+            string get_string(const StringRecord& r) const
+            {
+                check_range(kChars, r.offset, r.length);
+                return string(section<char>(kChars) + r.offset, r.length);
+            }
+
+            void fail(const string& why) const
+            {
+                throw std::runtime_error("Invalid population snapshot " + filename + ": " + why);
+            }
+
+            const char* data;
+            size_t size;
+            string filename;
+            const Header* header;
+    };
+
+    GenomePtr read_genome(const SnapshotReader& reader, const OrganismRecord& o)
+    {
+        reader.check_range(kTraits, o.first_trait, o.num_traits);
+        reader.check_range(kNodes, o.first_node, o.num_nodes);
+        reader.check_range(kGenes, o.first_gene, o.num_genes);
+        reader.check_range(kFactors, o.first_factor, o.num_factors);
+        if (o.num_nodes == 0)
+            reader.fail("genome without nodes");
+
+        vector<TraitPtr> traits;
+        traits.reserve(o.num_traits);
+        const TraitRecord* t = reader.section<TraitRecord>(kTraits) + o.first_trait;
+        for (U32 i = 0; i < o.num_traits; ++i, ++t)
+        {
+            TraitPtr trait(new Trait());
+            trait->trait_id = t->trait_id;
+            memcpy(trait->params, t->params, sizeof(trait->params));
+            traits.push_back(trait);
+        }
+
+        vector<NNodePtr> nodes;
+        nodes.reserve(o.num_nodes);
+        const NodeRecord* n = reader.section<NodeRecord>(kNodes) + o.first_node;
+        for (U32 i = 0; i < o.num_nodes; ++i, ++n)
+        {
+            reader.check_index(n->trait, o.num_traits);
+            NNodePtr node(new NNode((nodetype)n->type, n->node_id,
+                                    (nodeplace)n->gen_node_label, (functype)n->ftype));
+            if (n->trait != kNone)
+            {
+                node->nodetrait = traits[n->trait];
+                node->trait_id = node->nodetrait->trait_id;
+            }
+            node->_sensorName = reader.get_string(n->sensor_name);
+            node->_sensorArgs = reader.get_string(n->sensor_args);
+            node->frozen = n->frozen != 0;
+            nodes.push_back(node);
+        }
+
+        vector<GenePtr> genes;
+        genes.reserve(o.num_genes);
+        const GeneRecord* g = reader.section<GeneRecord>(kGenes) + o.first_gene;
+        for (U32 i = 0; i < o.num_genes; ++i, ++g)
+        {
+            reader.check_index(g->trait, o.num_traits);
+            if (g->in_node >= o.num_nodes || g->out_node >= o.num_nodes)
+                reader.fail("gene connects a missing node");
+            TraitPtr trait;
+            if (g->trait != kNone)
+                trait = traits[g->trait];
+            GenePtr gene(new Gene(trait, g->weight, nodes[g->in_node], nodes[g->out_node],
+                                  g->recurrent != 0, g->innovation_num, g->mutation_num));
+            gene->enable = g->enable != 0;
+            gene->frozen = g->frozen != 0;
+            genes.push_back(gene);
+        }
+
+        vector<FactorPtr> factors;
+        factors.reserve(o.num_factors);
+        const FactorRecord* f = reader.section<FactorRecord>(kFactors) + o.first_factor;
+        for (U32 i = 0; i < o.num_factors; ++i, ++f)
+        {
+            factors.push_back(FactorPtr(new Factor(reader.get_string(f->record), f->id)));
+        }
+
+        return GenomePtr(new Genome(o.genome_id, traits, nodes, genes, factors));
+    }
+}
+
+bool NEAT::is_population_snapshot(const std::string& filename)
+{
+    ifstream in(filename.c_str(), ios::binary);
+    char magic[sizeof(kMagic)];
+    return in.read(magic, sizeof(magic)) && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool NEAT::save_population_snapshot(const PopulationPtr& pop, const std::string& filename)
+{
+    vector<OrganismRecord> organisms;
+    vector<SpeciesRecord> species;
+    vector<U32> members;
+    vector<TraitRecord> traits;
+    vector<NodeRecord> nodes;
+    vector<GeneRecord> genes;
+    vector<FactorRecord> factors;
+    StringWriter strings;
+
+    boost::unordered_map<const Organism*, U32> organism_index;
+    boost::unordered_map<const Species*, S32> species_index;
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+        organism_index[pop->organisms[i].get()] = i;
+    for (size_t i = 0; i < pop->species.size(); ++i)
+        species_index[pop->species[i].get()] = i;
+
+    organisms.reserve(pop->organisms.size());
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        const Organism& org = *pop->organisms[i];
+        const Genome& genome = *org.gnome;
+
+        OrganismRecord o;
+        memset(&o, 0, sizeof(o));
+        o.fitness = org.fitness;
+        o.orig_fitness = org.orig_fitness;
+        o.error = org.error;
+        o.expected_offspring = org.expected_offspring;
+        o.high_fit = org.high_fit;
+        o.metadata = strings.add(org.metadata);
+        o.genome_id = genome.genome_id;
+        o.generation = org.generation;
+        o.super_champ_offspring = org.super_champ_offspring;
+        o.time_alive = org.time_alive;
+        o.flags = (org.winner ? kWinner : 0)
+            | (org.eliminate ? kEliminate : 0)
+            | (org.champion ? kChampion : 0)
+            | (org.pop_champ ? kPopChamp : 0)
+            | (org.pop_champ_child ? kPopChampChild : 0)
+            | (org.mut_struct_baby ? kMutStructBaby : 0)
+            | (org.mate_baby ? kMateBaby : 0)
+            | (org.smited ? kSmited : 0);
+        o.species = kNone;
+        SpeciesPtr spec = org.species.lock();
+        if (spec && species_index.count(spec.get()))
+            o.species = species_index[spec.get()];
+
+        boost::unordered_map<const Trait*, S32> trait_index;
+        boost::unordered_map<const NNode*, U32> node_index;
+
+        o.first_trait = traits.size();
+        o.num_traits = genome.traits.size();
+        for (size_t j = 0; j < genome.traits.size(); ++j)
+        {
+            TraitRecord t;
+            memset(&t, 0, sizeof(t));
+            t.trait_id = genome.traits[j]->trait_id;
+            memcpy(t.params, genome.traits[j]->params, sizeof(t.params));
+            traits.push_back(t);
+            trait_index[genome.traits[j].get()] = j;
+        }
+
+        o.first_node = nodes.size();
+        o.num_nodes = genome.nodes.size();
+        for (size_t j = 0; j < genome.nodes.size(); ++j)
+        {
+            const NNode& node = *genome.nodes[j];
+            NodeRecord n;
+            memset(&n, 0, sizeof(n));
+            n.sensor_name = strings.add(node._sensorName);
+            n.sensor_args = strings.add(node._sensorArgs);
+            n.node_id = node.node_id;
+            n.trait = node.nodetrait ? trait_index[node.nodetrait.get()] : kNone;
+            n.type = node.type;
+            n.gen_node_label = node.gen_node_label;
+            n.ftype = node.ftype;
+            n.frozen = node.frozen;
+            nodes.push_back(n);
+            node_index[&node] = j;
+        }
+
+        o.first_gene = genes.size();
+        o.num_genes = genome.genes.size();
+        for (size_t j = 0; j < genome.genes.size(); ++j)
+        {
+            const Gene& gene = *genome.genes[j];
+            GeneRecord g;
+            memset(&g, 0, sizeof(g));
+            g.weight = gene.lnk->weight;
+            g.innovation_num = gene.innovation_num;
+            g.mutation_num = gene.mutation_num;
+            g.trait = gene.lnk->linktrait ? trait_index[gene.lnk->linktrait.get()] : kNone;
+            g.in_node = node_index[gene.lnk->get_in_node().get()];
+            g.out_node = node_index[gene.lnk->get_out_node().get()];
+            g.recurrent = gene.lnk->is_recurrent;
+            g.enable = gene.enable;
+            g.frozen = gene.frozen;
+            genes.push_back(g);
+        }
+
+        o.first_factor = factors.size();
+        o.num_factors = genome.factors.size();
+        for (size_t j = 0; j < genome.factors.size(); ++j)
+        {
+            FactorRecord f;
+            memset(&f, 0, sizeof(f));
+            f.record = strings.add(genome.factors[j]->get_record());
+            f.id = genome.factors[j]->get_id();
+            factors.push_back(f);
+        }
+
+        organisms.push_back(o);
+    }
+
+    species.reserve(pop->species.size());
+    for (size_t i = 0; i < pop->species.size(); ++i)
+    {
+        const Species& spec = *pop->species[i];
+        SpeciesRecord s;
+        memset(&s, 0, sizeof(s));
+        s.ave_fitness = spec.ave_fitness;
+        s.max_fitness = spec.max_fitness;
+        s.max_fitness_ever = spec.max_fitness_ever;
+        s.average_est = spec.average_est;
+        s.id = spec.id;
+        s.age = spec.age;
+        s.expected_offspring = spec.expected_offspring;
+        s.age_of_last_improvement = spec.age_of_last_improvement;
+        s.flags = (spec.novel ? kNovel : 0)
+            | (spec.checked ? kChecked : 0)
+            | (spec.obliterate ? kObliterate : 0);
+        s.first_member = members.size();
+        for (size_t j = 0; j < spec.organisms.size(); ++j)
+        {
+            // members that have already left the population are dropped
+            if (organism_index.count(spec.organisms[j].get()))
+                members.push_back(organism_index[spec.organisms[j].get()]);
+        }
+        s.num_members = members.size() - s.first_member;
+        species.push_back(s);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.num_trait_params = NEAT::num_trait_params;
+    set_record_sizes(header.record_sizes);
+
+    // every section is written from here, so none can be left out
+    SectionBytes sections[kNumSections];
+    sections[kOrganisms] = section_bytes(organisms);
+    sections[kSpecies] = section_bytes(species);
+    sections[kMembers] = section_bytes(members);
+    sections[kTraits] = section_bytes(traits);
+    sections[kNodes] = section_bytes(nodes);
+    sections[kGenes] = section_bytes(genes);
+    sections[kFactors] = section_bytes(factors);
+    sections[kChars] = section_bytes(strings.chars);
+    for (S32 s = 0; s < kNumSections; ++s)
+        header.counts[s] = sections[s].size / header.record_sizes[s];
+    header.cur_innov_num = pop->cur_innov_num;
+    header.mean_fitness = pop->mean_fitness;
+    header.variance = pop->variance;
+    header.standard_deviation = pop->standard_deviation;
+    header.highest_fitness = pop->highest_fitness;
+    header.cur_node_id = pop->cur_node_id;
+    header.last_species = pop->last_species;
+    header.winnergen = pop->winnergen;
+    header.highest_last_changed = pop->highest_last_changed;
+    MTRand::uint32 randgen[MTRand::SAVE];
+    pop->params.randgen.save(randgen);
+    std::copy(randgen, randgen + MTRand::SAVE, header.randgen);
+
+    // lay the sections out one after the other, each aligned to 8 bytes
+    const Section order[] = { kOrganisms, kSpecies, kMembers, kTraits, kNodes, kGenes, kFactors, kChars };
+    U64 at = sizeof(Header);
+    for (size_t i = 0; i < kNumSections; ++i)
+    {
+        at = (at + 7) & ~U64(7);
+        header.offsets[order[i]] = at;
+        at += header.counts[order[i]] * header.record_sizes[order[i]];
+    }
+
+    ofstream out(filename.c_str(), ios::binary);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    U64 written = sizeof(Header);
+    for (size_t i = 0; i < kNumSections; ++i)
+    {
+        // pad up to the start of the section
+        static const char zeros[8] = { 0 };
+        const SectionBytes& section = sections[order[i]];
+        out.write(zeros, header.offsets[order[i]] - written);
+        if (section.size > 0)
+            out.write(section.data, section.size);
+        written = header.offsets[order[i]] + section.size;
+    }
+    out.close();
+    if (out.fail())
+    {
+        // a partial snapshot would only be rejected when it is loaded
+        std::remove(filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+PopulationPtr NEAT::load_population_snapshot(const std::string& filename)
+{
+    using namespace boost::interprocess;
+
+    file_mapping file;
+    mapped_region region;
+    try
+    {
+        file_mapping(filename.c_str(), read_only).swap(file);
+        mapped_region(file, read_only).swap(region);
+    }
+    catch (const interprocess_exception& e)
+    {
+        throw std::runtime_error("Could not map population snapshot " + filename + ": " + e.what());
+    }
+    SnapshotReader reader(static_cast<const char*>(region.get_address()), region.get_size(), filename);
+    const Header& header = *reader.header;
+
+    PopulationPtr pop(new Population());
+    pop->cur_node_id = header.cur_node_id;
+    pop->cur_innov_num = header.cur_innov_num;
+    pop->last_species = header.last_species;
+    pop->mean_fitness = header.mean_fitness;
+    pop->variance = header.variance;
+    pop->standard_deviation = header.standard_deviation;
+    pop->winnergen = header.winnergen;
+    pop->highest_fitness = header.highest_fitness;
+    pop->highest_last_changed = header.highest_last_changed;
+    if (header.randgen[MTRand::N] > MTRand::N)
+        reader.fail("random stream out of bounds");
+    MTRand::uint32 randgen[MTRand::SAVE];
+    std::copy(header.randgen, header.randgen + MTRand::SAVE, randgen);
+    pop->params.randgen.load(randgen);
+
+    const U32 num_organisms = reader.count(kOrganisms);
+    const U32 num_species = reader.count(kSpecies);
+
+    pop->species.reserve(num_species);
+    const SpeciesRecord* s = reader.section<SpeciesRecord>(kSpecies);
+    for (U32 i = 0; i < num_species; ++i, ++s)
+    {
+        SpeciesPtr spec(new Species(s->id));
+        spec->age = s->age;
+        spec->ave_fitness = s->ave_fitness;
+        spec->max_fitness = s->max_fitness;
+        spec->max_fitness_ever = s->max_fitness_ever;
+        spec->expected_offspring = s->expected_offspring;
+        spec->novel = (s->flags & kNovel) != 0;
+        spec->checked = (s->flags & kChecked) != 0;
+        spec->obliterate = (s->flags & kObliterate) != 0;
+        spec->age_of_last_improvement = s->age_of_last_improvement;
+        spec->average_est = s->average_est;
+        pop->species.push_back(spec);
+    }
+
+    pop->organisms.reserve(num_organisms);
+    const OrganismRecord* o = reader.section<OrganismRecord>(kOrganisms);
+    for (U32 i = 0; i < num_organisms; ++i, ++o)
+    {
+        reader.check_index(o->species, num_species);
+        OrganismPtr org(new Organism(o->fitness, read_genome(reader, *o), o->generation,
+                                     reader.get_string(o->metadata)));
+        org->orig_fitness = o->orig_fitness;
+        org->error = o->error;
+        org->expected_offspring = o->expected_offspring;
+        org->high_fit = o->high_fit;
+        org->super_champ_offspring = o->super_champ_offspring;
+        org->time_alive = o->time_alive;
+        org->winner = (o->flags & kWinner) != 0;
+        org->eliminate = (o->flags & kEliminate) != 0;
+        org->champion = (o->flags & kChampion) != 0;
+        org->pop_champ = (o->flags & kPopChamp) != 0;
+        org->pop_champ_child = (o->flags & kPopChampChild) != 0;
+        org->mut_struct_baby = (o->flags & kMutStructBaby) != 0;
+        org->mate_baby = (o->flags & kMateBaby) != 0;
+        org->smited = (o->flags & kSmited) != 0;
+        if (o->species != kNone)
+            org->species = pop->species[o->species];
+        pop->organisms.push_back(org);
+    }
+
+    // the species keep their members in the saved order (rank order in real time)
+    const U32* members = reader.section<U32>(kMembers);
+    s = reader.section<SpeciesRecord>(kSpecies);
+    for (U32 i = 0; i < num_species; ++i, ++s)
+    {
+        reader.check_range(kMembers, s->first_member, s->num_members);
+        for (U32 j = s->first_member; j < s->first_member + s->num_members; ++j)
+        {
+            if (members[j] >= num_organisms)
+                reader.fail("species member out of bounds");
+            pop->species[i]->add_Organism(pop->organisms[members[j]]);
+        }
+    }
+
+    return pop;
+}
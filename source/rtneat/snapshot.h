@@ -0,0 +1,30 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <string>
+#include "neat.h"
+
+namespace NEAT
+{
+    /// A population SNAPSHOT is a binary image of a Population: the traits,
+    ///   nodes, genes and factors of all the genomes are stored as flat
+    ///   arrays of fixed-size records, followed by the species and their
+    ///   members, so that loading needs neither a text parser nor speciate().
+    /// Snapshots are written in the byte order and layout of the machine
+    ///   that saves them; the header records the layout and a snapshot from
+    ///   an incompatible build is rejected rather than misread.
+
+    /// Return true if the file starts with the snapshot magic number
+    bool is_population_snapshot(const std::string& filename);
+
+    /// Write the population to a snapshot file, returns false if the file could not be written
+    bool save_population_snapshot(const PopulationPtr& pop, const std::string& filename);
+
+    /// Read a population from a snapshot file, mapping it into memory and building
+    ///   the organisms and species straight from the mapped records.
+    /// Throws std::runtime_error if the file cannot be read or is not a valid snapshot.
+    PopulationPtr load_population_snapshot(const std::string& filename);
+
+} // namespace NEAT
+
+#endif
@@ -66,7 +66,7 @@ bool Species::rank()
     return true;
 }
 
-F64 Species::estimate_average()
+F64 Species::estimate_average(U32 time_alive_minimum)
 {
     vector<OrganismPtr>::iterator curorg;
     F64 total = 0.0; //running total of fitnesses
@@ -80,7 +80,7 @@ F64 Species::estimate_average()
     for (curorg = organisms.begin(); curorg != organisms.end(); ++curorg)
     {
         //New variable time_alive
-        if (((*curorg)->time_alive) >= static_cast<S32>(NEAT::time_alive_minimum))
+        if (((*curorg)->time_alive) >= static_cast<S32>(time_alive_minimum))
         {
             total += (*curorg)->fitness;
             ++num_orgs;
@@ -115,10 +115,6 @@ OrganismPtr Species::reproduce_one(S32 generation, PopulationPtr& pop,
 
     GenomePtr new_genome; //For holding baby's genes
 
-    vector<SpeciesPtr>::iterator curspecies; //For adding baby
-    SpeciesPtr newspecies; //For babies in new Species
-    OrganismPtr comporg; //For Species determination through comparison
-
     SpeciesPtr randspecies; //For mating outside the Species
     F64 randmult;
     S32 randspeciesnum;
@@ -127,8 +123,6 @@ OrganismPtr Species::reproduce_one(S32 generation, PopulationPtr& pop,
 
     bool outside;
 
-    bool found; //When a Species is found
-
     S32 giveup; //For giving up finding a mate outside the species
 
     bool mut_struct_baby;
@@ -151,7 +145,7 @@ OrganismPtr Species::reproduce_one(S32 generation, PopulationPtr& pop,
     //Now transfer the list to elig_orgs without including the ones that are too young (Ken)
     for (curorg=organisms.begin(); curorg!=organisms.end(); ++curorg)
     {
-        if ((*curorg)->time_alive >= static_cast<S32>(NEAT::time_alive_minimum))
+        if ((*curorg)->time_alive >= static_cast<S32>(pop->params.time_alive_minimum))
             elig_orgs.push_back(*curorg);
     }
 
@@ -446,65 +440,11 @@ OrganismPtr Species::reproduce_one(S32 generation, PopulationPtr& pop,
 
     }
 
-    //Add the baby to its proper Species
-    //If it doesn't fit a Species, create a new one
-
     baby->mut_struct_baby=mut_struct_baby;
     baby->mate_baby=mate_baby;
 
-    curspecies = pop->species.begin();
-    if (curspecies == pop->species.end())
-    {
-        //Create the first species
-        newspecies.reset(new Species(++(pop->last_species),true));
-        (pop->species).push_back(newspecies);
-        newspecies->add_Organism(baby); //Add the baby
-        baby->species=newspecies; //Point the baby to its species
-    }
-    else
-    {
-        comporg=(*curspecies)->first();
-        assert(comporg->gnome);
-        found=false;
-
-        while ( curspecies != pop->species.end() && (!found) )
-        {
-            if (!comporg)
-            {
-                //Keep searching for a matching species
-                ++curspecies;
-                if (curspecies!=(pop->species).end())
-                    comporg=(*curspecies)->first();
-            }
-            else if (baby->gnome->compatibility(comporg->gnome) < NEAT::compat_threshold )
-            {
-                //Found compatible species, so add this organism to it
-                (*curspecies)->add_Organism(baby);
-                baby->species=(*curspecies); //Point organism to its species
-                found=true; //Note the search is over
-            }
-            else
-            {
-                //Keep searching for a matching species
-                ++curspecies;
-                if (curspecies!=(pop->species).end())
-                    comporg=(*curspecies)->first();
-            }
-        }
-
-        //If we didn't find a match, create a new species
-        if (found==false)
-        {
-            newspecies.reset(new Species(++(pop->last_species),true));
-            (pop->species).push_back(newspecies);
-            newspecies->add_Organism(baby); //Add the baby
-            baby->species=newspecies; //Point baby to its species
-        }
-
-    } //end else     
-
-    //Put the baby also in the master organism list
-    (pop->organisms).push_back(baby);
+    //Add the baby to its proper Species (or a new one) and to the population
+    pop->add_organism(baby);
 
     return baby; //Return a pointer to the baby
 }
@@ -1167,7 +1107,7 @@ bool Species::reproduce(S32 generation, PopulationPtr pop,
                         comporg=(*curspecies)->first();
                 }
                 else if (((baby->gnome)->compatibility(comporg->gnome))
-                    <NEAT::compat_threshold)
+                    <pop->params.compat_threshold)
                 {
                     //Found compatible species, so add this organism to it
                     (*curspecies)->add_Organism(baby);
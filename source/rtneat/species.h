@@ -92,10 +92,11 @@ namespace NEAT
 
             //Compute an estimate of the average fitness of the species
             //The result is left in variable average_est and returned
-            //New variable: average_est, NEAT::time_alive_minimum (const) 
+            //Only organisms that have lived at least time_alive_minimum (the one of
+            //the population) are counted
             //Note: Initialization requires calling estimate_average() on all species
             //      Later it should be called only when a species changes 
-            double estimate_average();
+            double estimate_average(U32 time_alive_minimum);
 
             //Like the usual reproduce() method except only one offspring is produced
             //Note that "generation" will be used to just count which offspring # this is over all evolution
@@ -33,7 +33,7 @@ Trait::Trait(const Trait& t)
     trait_id = t.trait_id;
 }
 
-Trait::Trait(TraitPtr t)
+Trait::Trait(const TraitPtr& t)
 {
     for (S32 count=0; count<NEAT::num_trait_params; count++)
         params[count]=(t->params)[count];
@@ -55,7 +55,7 @@ Trait::Trait(istream &argline)
 
 }
 
-Trait::Trait(TraitPtr t1, TraitPtr t2)
+Trait::Trait(const TraitPtr& t1, const TraitPtr& t2)
 {
     for (S32 count=0; count<NEAT::num_trait_params; count++)
         params[count]=(((t1->params)[count])+((t2->params)[count]))/2.0;
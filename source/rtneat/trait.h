@@ -3,6 +3,7 @@
 
 #include "neat.h"
 #include "XMLSerializable.h"
+#include "pooled.h"
 #include <iostream>
 #include <fstream>
 
@@ -15,7 +16,7 @@ namespace NEAT
     //        algorithm from having to search vast parameter landscapes  
     //        on every node.  Instead, each node can simply point to a trait 
     //        and those traits can evolve on their own 
-    class Trait : public XMLSerializable
+    class Trait : public XMLSerializable, public Pooled<Trait>
     {
             friend class boost::serialization::access;
 
@@ -37,13 +38,13 @@ namespace NEAT
             Trait(const Trait& t);
 
             // Create a trait exactly like another trait
-            Trait(TraitPtr t);
+            Trait(const TraitPtr& t);
 
             // Special constructor off a file assume word "trait" has been read in
             Trait(std::istream &argline);
 
             // Special Constructor creates a new Trait which is the average of 2 existing traits passed in
-            Trait(TraitPtr t1, TraitPtr t2);
+            Trait(const TraitPtr& t1, const TraitPtr& t2);
 
             // Dump trait to a file
             void print_to_file(std::ofstream &file);
@@ -20,6 +20,7 @@
 #include "ai/rl/QLearning.h"
 #include "ai/Environment.h"
 #include "ai/rtneat/rtNEAT.h"
+#include "ai/rtneat/IslandModel.h"
 #include "ai/sensors/Sensor.h"
 #include "ai/sensors/RaySensor.h"
 #include "ai/sensors/RadarSensor.h"
@@ -43,6 +44,10 @@ namespace py = boost::python;
 namespace OpenNero {
 	namespace scripting {
 
+        BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(TDBrain_to_file_overloads, to_file, 1, 2)
+
+        BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(TDBrain_from_file_overloads, from_file, 1, 2)
+
 		/**
          * Export Agent-specific script components
          */
@@ -69,12 +74,15 @@ namespace OpenNero {
 				.def("act", &TDBrain::act, "Called for every step of the state-action loop")
 				.def("end", &TDBrain::end, "Called at the end of a learning episode")
 				.def("destroy", &TDBrain::destroy, "Called after learning ends")
+				.def("to_file", &TDBrain::to_file, TDBrain_to_file_overloads("Save to a file, as a binary archive (binary=True) or as the text of to_string"))
+				.def("from_file", &TDBrain::from_file, TDBrain_from_file_overloads("Load from a file saved by to_file, mapping a binary archive into memory if mapped=True"))
 				.add_property("epsilon", &TDBrain::getEpsilon, &TDBrain::setEpsilon)
 				.add_property("alpha", &TDBrain::getAlpha, &TDBrain::setAlpha)
 				.add_property("gamma", &TDBrain::getGamma, &TDBrain::setGamma)
+				.add_property("shared", &TDBrain::getShared, &TDBrain::setShared, "Whether to learn into one approximator with the other agents from the same template (saved between begin_brain_save and end_brain_save, only the first of them writes the shared values)")
 				.add_property("state", make_function(&TDBrain::GetSharedState, return_value_policy<reference_existing_object>()), "Body of the agent");
 			// export the interface to python so that we can override its methods there
-			py::class_<SarsaBrain, bases<TDBrain>, SarsaBrainPtr >("SarsaBrain", "SARSA RL agent", init<double, double, double, double, int, int, int, int>() )
+			py::class_<SarsaBrain, bases<TDBrain>, SarsaBrainPtr >("SarsaBrain", "SARSA RL agent", init<double, double, double, double, int, int, int, int, py::optional<int> >() )
 				.def("initialize", &SarsaBrain::initialize, "Called before learning starts")
 				.def("start", &SarsaBrain::start, "Called at the beginning of a learning episode")
 				.def("act", &SarsaBrain::act, "Called for every step of the state-action loop")
@@ -82,9 +90,10 @@ namespace OpenNero {
 				.add_property("epsilon", &TDBrain::getEpsilon, &TDBrain::setEpsilon)
 				.add_property("alpha", &TDBrain::getAlpha, &TDBrain::setAlpha)
 				.add_property("gamma", &TDBrain::getGamma, &TDBrain::setGamma)
+				.add_property("shared", &TDBrain::getShared, &TDBrain::setShared, "Whether to learn into one approximator with the other agents from the same template (saved between begin_brain_save and end_brain_save, only the first of them writes the shared values)")
 				.add_property("state", make_function(&SarsaBrain::GetSharedState, return_value_policy<reference_existing_object>()), "Body of the agent");
 			// export the interface to python so that we can override its methods there
-			py::class_<QLearningBrain, bases<TDBrain>, QLearningBrainPtr >("QLearningBrain", "Q-Learning RL agent", init<double, double, double, int, int, int, int>() )
+			py::class_<QLearningBrain, bases<TDBrain>, QLearningBrainPtr >("QLearningBrain", "Q-Learning RL agent", init<double, double, double, int, int, int, int, py::optional<int> >() )
 				.def("initialize", &QLearningBrain::initialize, "Called before learning starts")
 				.def("start", &QLearningBrain::start, "Called at the beginning of a learning episode")
 				.def("act", &QLearningBrain::act, "Called for every step of the state-action loop")
@@ -95,6 +104,7 @@ namespace OpenNero {
 				.add_property("epsilon", &TDBrain::getEpsilon, &TDBrain::setEpsilon)
 				.add_property("alpha", &TDBrain::getAlpha, &TDBrain::setAlpha)
 				.add_property("gamma", &TDBrain::getGamma, &TDBrain::setGamma)
+				.add_property("shared", &TDBrain::getShared, &TDBrain::setShared, "Whether to learn into one approximator with the other agents from the same template (saved between begin_brain_save and end_brain_save, only the first of them writes the shared values)")
 				.add_property("state", make_function(&QLearningBrain::GetSharedState, return_value_policy<reference_existing_object>()), "Body of the agent");
 			;
 		}
@@ -268,6 +278,42 @@ namespace OpenNero {
 			AIManager::instance().SetEnabled(false);
 		}
 
+		/// tick the agents in phases, so that the results do not depend on the number of threads
+		void set_ai_phased(bool phased)
+		{
+			AIManager::instance().SetPhased(phased);
+		}
+
+		/// whether the agents tick in phases
+		bool get_ai_phased()
+		{
+			return AIManager::const_instance().IsPhased();
+		}
+
+		/// start saving a group of brains, which write the values they share once
+		void begin_brain_save()
+		{
+			BrainSavePass::Begin();
+		}
+
+		/// stop saving the group of brains started by begin_brain_save
+		void end_brain_save()
+		{
+			BrainSavePass::End();
+		}
+
+		/// set the number of threads to sense and decide on when the agents tick in phases
+		void set_ai_threads(size_t num_threads)
+		{
+			AIManager::instance().SetNumThreads(num_threads);
+		}
+
+		/// get the number of threads to tick the agents on
+		size_t get_ai_threads()
+		{
+			return AIManager::const_instance().GetNumThreads();
+		}
+
 		/// reset environment
 		void reset_ai()
 		{
@@ -296,6 +342,12 @@ namespace OpenNero {
 			py::def("enable_ai", &enable_ai, "enable AI");
 			py::def("disable_ai", &disable_ai, "disable AI");
 			py::def("reset_ai", &reset_ai, "reset AI");
+			py::def("begin_brain_save", &begin_brain_save, "start saving a group of brains (such as a team), so that the values they share are written by the first of them only");
+			py::def("end_brain_save", &end_brain_save, "stop saving the group of brains started by begin_brain_save");
+			py::def("set_ai_phased", &set_ai_phased, "tick the agents in phases (sense and decide for all of them, then act) instead of one after another");
+			py::def("get_ai_phased", &get_ai_phased, "whether the agents tick in phases");
+			py::def("set_ai_threads", &set_ai_threads, "set the number of threads to sense and decide on when the agents tick in phases (0 for one per core)");
+			py::def("get_ai_threads", &get_ai_threads, "get the number of threads to tick the agents on");
 			py::def("get_environment", &get_environment, "get the current environment");
 			py::def("set_environment", &set_environment, "set the current environment");
 
@@ -352,11 +404,31 @@ namespace OpenNero {
                 .def("release_organism", &RTNEAT::release_organism, "release the organism after the agent is done")
                 .def("ready", &RTNEAT::ready, "return true iff RTNEAT is ready to produce a new organism")
                 .def("has_organism", &RTNEAT::has_organism, "return true iff RTNEAT has an organism for this agent")
+                .def("fielded_bodies", &RTNEAT::fielded_bodies, "return the ids of the fielded agents, in the order of the rows of activate_all")
+                .def("activate_all", (size_t (RTNEAT::*)(py::object, py::object))&RTNEAT::activate_all, "activate the networks of all fielded agents, reading a row of sensors per agent from a contiguous buffer of doubles (such as a float64 numpy array) and writing a row of outputs per agent into another; returns the number of agents")
                 .def("set_weight", &RTNEAT::set_weight, "set weight i to value f")
                 .def("set_lifetime", &RTNEAT::set_lifetime, "set the lifetime of an agent")
-				.def("save_population", &RTNEAT::save_population, "save the population to a file")
+				.def("save_population", &RTNEAT::save_population, "save the population to a file (a binary snapshot if the name ends in .snap)")
+				.def("load_population", &RTNEAT::load_population, "load a population saved as a snapshot or as text")
                 .def("enable_evolution", &RTNEAT::enable_evolution, "turn evolution on")
                 .def("disable_evolution", &RTNEAT::disable_evolution, "turn evolution off");
+
+			// export the island model
+			py::enum_<MigrationPolicy::Topology>("MigrationTopology")
+				.value("RING", MigrationPolicy::MIGRATE_RING)
+				.value("ALL", MigrationPolicy::MIGRATE_ALL);
+
+			py::class_<MigrationPolicy>("MigrationPolicy", "when and where champions move between rtNEAT islands", init<size_t, size_t, MigrationPolicy::Topology>())
+				.def_readwrite("interval", &MigrationPolicy::interval, "reproductions an island makes between migrations (0 to never migrate)")
+				.def_readwrite("migrants", &MigrationPolicy::migrants, "number of champions an island sends each time")
+				.def_readwrite("topology", &MigrationPolicy::topology, "where the champions go");
+
+			py::class_<IslandModel, bases<AI>, IslandModelPtr, noncopyable>("IslandModel", "several RTNEATs evolving in parallel with periodic migration", init<const MigrationPolicy&, size_t>())
+				.def("add_island", &IslandModel::add_island, "add an RTNEAT island (tick the model instead of the island)")
+				.def("get_island", &IslandModel::get_island, "return the i'th RTNEAT island")
+				.add_property("num_islands", &IslandModel::get_num_islands, "number of islands")
+				.add_property("policy", py::make_function(&IslandModel::get_policy, py::return_value_policy<py::copy_const_reference>()), &IslandModel::set_policy, "the migration policy")
+				.def("migrate", &IslandModel::migrate, "send the champions of the islands that are due; returns the number of immigrants");
 		}
         
 		/// the pickling suite for the Vector class
@@ -776,6 +848,8 @@ namespace OpenNero {
 
         BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(findInRay_overloads, PyFindInRay, 2, 6)
 
+        BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(findInRays_overloads, PyFindInRays, 1, 6)
+
         void ExportSimContextScripts()
         {
             py::class_<SimContext>("SimContext", "The simulation context from an XML file", no_init )
@@ -812,6 +886,12 @@ namespace OpenNero {
                 .def("findInRay",
                      &SimContext::PyFindInRay,
                      findInRay_overloads("Find the first object that intersects the specified ray (origin:Vector3f, target:Vector3f, [int])") )
+                .def("findInRays",
+                     &SimContext::PyFindInRays,
+                     findInRays_overloads("Find the first object that intersects each ray (rays:list of (origin, target), [type:int], [threads:int], [vis:bool], [foundColor], [noneColor])") )
+                .def("setStaticRayTypes",
+                     &SimContext::SetStaticRayTypes,
+                     "Set the types of the objects that do not move once added, so that rays can index them once")
                 .def("getClickedPosition",
                      &SimContext::GetClickedPosition,
                      "Approximate 3d position of the mouse click")
@@ -821,6 +901,9 @@ namespace OpenNero {
                 .def("getMousePosition",
                      &SimContext::GetMousePosition,
                      "Get the current position of the mouse")
+                .def("getEntityIds",
+                     &SimContext::PyGetEntityIds,
+                     "Get the ids of all the entities that have any of the types in the mask")
                 .def("setObjectPosition",
                      &SimContext::SetObjectPosition,
                      "Set the position of an object specified by its id")
@@ -866,7 +949,21 @@ namespace OpenNero {
                 .def("transformVector",
                      &SimContext::TransformVector,
                      "Transform the given vector by the matrix of the object specified by id")
+                .def("snapshotWorld",
+                     &SimContext::TakeSnapshot,
+                     "Capture the entities, their brains and the random number generators")
+                .def("restoreWorld",
+                     &SimContext::RestoreSnapshot,
+                     "Put the world back the way it was when the snapshot was taken")
                 .add_property("delay", &SimContext::GetFrameDelay, &SimContext::SetFrameDelay)
+                .add_property("timestep", &SimContext::GetTimeStep, &SimContext::SetTimeStep)
+                .add_property("ticks_per_frame", &SimContext::GetTicksPerFrame, &SimContext::SetTicksPerFrame)
+                ;
+
+            py::class_<WorldSnapshot, WorldSnapshotPtr>("WorldSnapshot", "A binary image of the simulated world", init<>())
+                .def("save", &WorldSnapshot::Save, "Write the snapshot to a file")
+                .def("load", &WorldSnapshot::Load, "Read a snapshot from a file")
+                .add_property("size", &WorldSnapshot::ByteLength, "The size of the snapshot in bytes")
                 ;
 
             // this is how Python can access the C++ reference to SimContext
@@ -928,6 +1025,9 @@ namespace OpenNero {
                 .def_readonly("fullscreen", &AppConfig::FullScreen)
                 .def_readonly("stencilbufer", &AppConfig::StencilBuffer)
                 .def_readonly("randomseeds", &AppConfig::RandomSeeds)
+                .def_readonly("timestep", &AppConfig::TimeStep)
+                .def_readonly("ticks_per_frame", &AppConfig::TicksPerFrame)
+                .def_readonly("native_collisions", &AppConfig::NativeCollisions)
                 ;
 
             py::def("getAppConfig", &GetAppConfig, return_value_policy<reference_existing_object>());
@@ -10,6 +10,7 @@
 #include "scripting/scripting.h"
 #include "tclap/CmdLine.h"
 #include "math/Random.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <boost/archive/xml_oarchive.hpp>
@@ -38,6 +39,9 @@ namespace OpenNero
         , VSync(false)
         , RandomSeeds("12345")
         , FrameDelay(0.5)
+        , TimeStep(0)
+        , TicksPerFrame(1)
+        , NativeCollisions(false)
     {
     }
 
@@ -86,6 +90,12 @@ namespace OpenNero
                 argRandomSeeds("", "random", "Random seeds to use", false, "12345", "numbers");
             TCLAP::ValueArg<float32_t>
                 argFrameDelay("", "delay", "the delay between AI frames to use for animation", false, 0.0, "seconds");
+            TCLAP::ValueArg<float32_t>
+                argTimeStep("", "timestep", "fixed length of an AI frame, independent of the clock (0 to follow the clock)", false, 0.0, "seconds");
+            TCLAP::ValueArg<uint32_t>
+                argTicksPerFrame("", "ticks_per_frame", "AI frames to run per rendered frame when the timestep is fixed", false, 1, "integer");
+            TCLAP::SwitchArg
+                argNativeCollisions("", "native_collisions", "Resolve collisions in the simulation instead of in the scene graph", false);
             
             // add them to CmdLine object
             cmd.add(argLogFile);
@@ -104,6 +114,9 @@ namespace OpenNero
             cmd.add(argVSync);
             cmd.add(argRandomSeeds);
             cmd.add(argFrameDelay);
+            cmd.add(argTimeStep);
+            cmd.add(argTicksPerFrame);
+            cmd.add(argNativeCollisions);
 
 #if !NERO_PLATFORM_MAC
             // parse the command line
@@ -130,6 +143,9 @@ namespace OpenNero
             StencilBuffer = argStencilBuffer.getValue();
             VSync = argVSync.getValue();
             RandomSeeds = argRandomSeeds.getValue();
+            TimeStep = argTimeStep.getValue();
+            TicksPerFrame = std::max<uint32_t>(1, argTicksPerFrame.getValue());
+            NativeCollisions = argNativeCollisions.getValue();
 
 			stringstream ss;
 			ss << RandomSeeds;
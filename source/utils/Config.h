@@ -35,6 +35,9 @@ namespace OpenNero
         bool        VSync;              ///< Should we use vsync?
         std::string RandomSeeds;        ///< Random seed buffer
         float32_t   FrameDelay;         ///< the delay between AI frames to use for animation (in seconds)
+        float32_t   TimeStep;           ///< the fixed length of an AI frame (in seconds), 0 to follow the clock
+        uint32_t    TicksPerFrame;      ///< AI frames per rendered frame when the time step is fixed
+        bool        NativeCollisions;   ///< resolve collisions in the simulation instead of with Irrlicht animators
 
         /// Constructor
         AppConfig();
@@ -60,6 +63,9 @@ namespace OpenNero
             ar & BOOST_SERIALIZATION_NVP(VSync);
             ar & BOOST_SERIALIZATION_NVP(RandomSeeds);
             ar & BOOST_SERIALIZATION_NVP(FrameDelay);
+            ar & BOOST_SERIALIZATION_NVP(TimeStep);
+            ar & BOOST_SERIALIZATION_NVP(TicksPerFrame);
+            ar & BOOST_SERIALIZATION_NVP(NativeCollisions);
         }
     };
 
@@ -0,0 +1,198 @@
+#include "core/Common.h"
+#include "core/Bitstream.h"
+#include "ai/rl/Approximator.h"
+#include "ai/rl/BackpropApproximator.h"
+#include <cmath>
+#include <sstream>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// two continuous sensors in [-1, 1] and [0, 10], and one discrete
+    /// action in [0, 2]
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        sensors.addContinuous(0, 10);
+        ActionInfo actions;
+        actions.addDiscrete(0, 2);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    FeatureVector MakeState(int i)
+    {
+        FeatureVector state(2);
+        state[0] = (i % 21) / 10.0 - 1;
+        state[1] = (i * 7 % 11);
+        return state;
+    }
+
+    FeatureVector MakeAction(int a)
+    {
+        FeatureVector action(1);
+        action[0] = a;
+        return action;
+    }
+
+    /// the function the network learns
+    double Target(const FeatureVector& state, const FeatureVector& action)
+    {
+        return state[0] * (action[0] - 1) + state[1] / 10;
+    }
+
+    /// the mean squared error of the network over the states and actions it learns
+    double Error(Approximator& approximator)
+    {
+        double sum = 0;
+        for (int i = 0; i < 231; ++i)
+        {
+            for (int a = 0; a <= 2; ++a)
+            {
+                double e = approximator.predict(MakeState(i), MakeAction(a)) - Target(MakeState(i), MakeAction(a));
+                sum += e * e;
+            }
+        }
+        return sum / (231 * 3);
+    }
+
+    void Train(Approximator& approximator, int steps)
+    {
+        for (int i = 0; i < steps; ++i)
+        {
+            FeatureVector state = MakeState(i * 31);
+            FeatureVector action = MakeAction(i % 3);
+            approximator.update(state, action, Target(state, action));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_backprop_approximator )
+{
+    AgentInitInfo info = MakeInfo();
+    BackpropApproximator network(info, 16);
+
+    // it learns from minibatches of replayed examples
+    double before = Error(network);
+    Train(network, 20000);
+    double after = Error(network);
+    BOOST_TEST_MESSAGE( "backprop error " << before << " -> " << after );
+    BOOST_CHECK( after < before / 10 );
+    BOOST_CHECK( after < 0.05 );
+
+    // all the actions of a state at once, as one at a time
+    std::vector<FeatureVector> actions;
+    for (int a = 0; a <= 2; ++a)
+    {
+        actions.push_back(MakeAction(a));
+    }
+    std::vector<double> values;
+    for (int i = 0; i < 20; ++i)
+    {
+        network.predict_all(MakeState(i), actions, values);
+        BOOST_REQUIRE_EQUAL( values.size(), actions.size() );
+        for (size_t a = 0; a < actions.size(); ++a)
+        {
+            BOOST_CHECK_CLOSE( values[a], network.predict(MakeState(i), actions[a]), 1e-3 );
+        }
+    }
+
+    // a network without hidden layers is linear
+    BackpropApproximator linear(info, 1, 0);
+    linear.predict_all(MakeState(3), actions, values);
+    for (size_t a = 0; a < actions.size(); ++a)
+    {
+        BOOST_CHECK_CLOSE( values[a], linear.predict(MakeState(3), actions[a]), 1e-3 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_backprop_approximator_save )
+{
+    AgentInitInfo info = MakeInfo();
+    BackpropApproximator network(info, 8, 2);
+    Train(network, 1000);
+    FeatureVector state = MakeState(5);
+    FeatureVector action = MakeAction(2);
+    double value = network.predict(state, action);
+
+    // the text archive keeps the weights
+    std::stringstream ss;
+    {
+        boost::archive::text_oarchive oa(ss);
+        const BackpropApproximator& saved = network;
+        oa << saved;
+    }
+    BackpropApproximator loaded;
+    {
+        boost::archive::text_iarchive ia(ss);
+        ia >> loaded;
+    }
+    BOOST_CHECK_CLOSE( loaded.predict(state, action), value, 1e-3 );
+
+    // a snapshot keeps the replay buffer too, so both go on to learn the same
+    Bitstream stream;
+    network.SaveState(stream);
+    BackpropApproximator restored(info, 8, 2);
+    BOOST_CHECK( restored.LoadState(stream) );
+    BOOST_CHECK_EQUAL( restored.predict(state, action), value );
+
+    // but only into a network of the same shape
+    Bitstream other;
+    network.SaveState(other);
+    BackpropApproximator small(info, 4, 2);
+    BOOST_CHECK( !small.LoadState(other) );
+
+    // and a record whose replay buffer does not fit leaves the shared
+    // weights alone
+    BackpropApproximator donor(info, 8, 2);
+    Bitstream donor_stream;
+    donor.SaveState(donor_stream);
+    std::vector<uint32_t> layers;
+    std::vector<float> weights;
+    donor_stream >> layers >> weights;
+    Bitstream broken;
+    broken << layers << weights;
+    broken << uint32_t(3) << uint32_t(1) << uint32_t(0);
+    broken << std::vector<float>() << std::vector<float>();
+    ApproximatorPtr view = network.share();
+    BOOST_CHECK( !view->LoadState(broken) );
+    BOOST_CHECK_EQUAL( network.predict(state, action), value );
+    BOOST_CHECK( donor.predict(state, action) != value );
+}
+
+BOOST_AUTO_TEST_CASE( test_backprop_approximator_share )
+{
+    AgentInitInfo info = MakeInfo();
+    BackpropApproximator network(info, 16);
+    ApproximatorPtr other = network.share();
+    FeatureVector state = MakeState(4);
+    FeatureVector action = MakeAction(1);
+
+    // one learns, both know
+    BOOST_CHECK_EQUAL( other->predict(state, action), network.predict(state, action) );
+    double before = std::fabs(network.predict(state, action) - 5);
+    for (int i = 0; i < 200; ++i)
+    {
+        other->update(state, action, 5);
+    }
+    BOOST_CHECK( std::fabs(network.predict(state, action) - 5) < before );
+    BOOST_CHECK_EQUAL( other->predict(state, action), network.predict(state, action) );
+
+    // a copy does not share
+    ApproximatorPtr copy = network.copy();
+    for (int i = 0; i < 200; ++i)
+    {
+        copy->update(state, action, -5);
+    }
+    BOOST_CHECK( copy->predict(state, action) != network.predict(state, action) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
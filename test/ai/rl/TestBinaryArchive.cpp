@@ -0,0 +1,159 @@
+#include "core/Common.h"
+#include "ai/rl/Approximator.h"
+#include "ai/rl/BackpropApproximator.h"
+#include "ai/rl/BinaryArchive.h"
+#include <cstdio>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// one continuous sensor in [-1, 1], one discrete sensor in [0, 3] and
+    /// one continuous action in [0, 1]
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        sensors.addDiscrete(0, 3);
+        ActionInfo actions;
+        actions.addContinuous(0, 1);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    FeatureVector MakeState(int i)
+    {
+        FeatureVector v(2);
+        v[0] = (i % 21) / 10.0 - 1;
+        v[1] = i % 4;
+        return v;
+    }
+
+    FeatureVector MakeAction(int i)
+    {
+        FeatureVector v(1);
+        v[0] = (i % 5) / 4.0;
+        return v;
+    }
+
+    void Fill(Approximator& approximator)
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            approximator.update(MakeState(i), MakeAction(i * 7), i + 1);
+        }
+    }
+
+    /// save one approximator into memory and load it into another
+    bool RoundTrip(const Approximator& from, Approximator& to)
+    {
+        BinaryWriter out;
+        from.SaveBinary(out);
+        BinaryReader in(&out.data()[0], out.data().size());
+        return to.LoadBinary(in);
+    }
+
+    void CheckSame(Approximator& a, Approximator& b)
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            BOOST_REQUIRE_EQUAL( a.predict(MakeState(i), MakeAction(i * 7)), b.predict(MakeState(i), MakeAction(i * 7)) );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_binary_archive )
+{
+    BinaryWriter out;
+    out.write(uint8_t(7));
+    out.write(2.5);
+    std::vector<float> floats(3, 1.5f);
+    out.write_array(floats);
+    BOOST_CHECK_EQUAL( out.data().size() % 8, 0u );
+
+    BinaryReader in(&out.data()[0], out.data().size());
+    uint8_t small;
+    double d;
+    const float* view;
+    size_t count;
+    BOOST_CHECK( in.read(small) && small == 7 );
+    BOOST_CHECK( in.read(d) && d == 2.5 );
+    BOOST_CHECK( in.view_array(view, count) );
+    BOOST_CHECK_EQUAL( count, 3u );
+    BOOST_CHECK_EQUAL( view[2], 1.5f );
+
+    // reading past the end fails, and keeps failing
+    BOOST_CHECK( !in.read(d) );
+    BOOST_CHECK( !in.good() );
+
+    // as does an array that claims more elements than there are
+    BinaryReader truncated(&out.data()[0], out.data().size() - 8);
+    BOOST_CHECK( truncated.read(small) && truncated.read(d) );
+    BOOST_CHECK( !truncated.view_array(view, count) );
+
+    // files are read or mapped, and checked
+    const std::string filename = "test_binary_archive.bin";
+    BOOST_REQUIRE( out.save(filename) );
+    BOOST_CHECK( BinaryReader::is_archive(filename) );
+    for (int mapped = 0; mapped < 2; ++mapped)
+    {
+        BinaryReader file;
+        BOOST_REQUIRE( file.open(filename, mapped != 0) );
+        std::vector<float> loaded;
+        BOOST_CHECK( file.read(small) && file.read(d) && file.read_array(loaded) );
+        BOOST_CHECK( loaded == floats );
+    }
+    std::remove(filename.c_str());
+    BinaryReader missing;
+    BOOST_CHECK( !missing.open(filename, true) );
+    BOOST_CHECK( !BinaryReader::is_archive(filename) );
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_archive_approximators )
+{
+    AgentInitInfo info = MakeInfo();
+
+    // a flat array, a hashed one and the exact map
+    TableApproximator dense(info, 3, 5), dense_loaded(info, 3, 5);
+    TableApproximator hashed(info, 1000, 1000), hashed_loaded(info, 1000, 1000);
+    TableApproximator exact(info, 0, 0), exact_loaded(info, 0, 0);
+    Fill(dense);
+    Fill(hashed);
+    Fill(exact);
+    BOOST_CHECK( RoundTrip(dense, dense_loaded) );
+    BOOST_CHECK( RoundTrip(hashed, hashed_loaded) );
+    BOOST_CHECK( RoundTrip(exact, exact_loaded) );
+    CheckSame(dense, dense_loaded);
+    CheckSame(hashed, hashed_loaded);
+    CheckSame(exact, exact_loaded);
+
+    // into shared values
+    TableApproximator shared(info, 1000, 1000);
+    ApproximatorPtr view = shared.share();
+    BOOST_CHECK( RoundTrip(hashed, *view) );
+    CheckSame(hashed, shared);
+
+    // not into a table stored another way
+    BOOST_CHECK( !RoundTrip(exact, dense_loaded) );
+
+    // tiles and networks
+    TilesApproximator tiles(info, 8, 1024), tiles_loaded(info, 8, 1024), tiles_small(info, 8, 512);
+    Fill(tiles);
+    BOOST_CHECK( RoundTrip(tiles, tiles_loaded) );
+    CheckSame(tiles, tiles_loaded);
+    BOOST_CHECK( !RoundTrip(tiles, tiles_small) );
+
+    BackpropApproximator network(info, 8), network_loaded(info, 8), network_wide(info, 16);
+    Fill(network);
+    BOOST_CHECK( RoundTrip(network, network_loaded) );
+    CheckSame(network, network_loaded);
+    BOOST_CHECK( !RoundTrip(network, network_wide) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
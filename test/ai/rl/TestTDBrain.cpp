@@ -0,0 +1,88 @@
+#include "core/Common.h"
+#include "core/Bitstream.h"
+#include "ai/AgentBrain.h"
+#include "ai/rl/QLearning.h"
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// one continuous sensor in [-1, 1] and one continuous action in [0, 1]
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        ActionInfo actions;
+        actions.addContinuous(0, 1);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    /// a brain learning into a table, shared with the others of its name if asked
+    QLearningBrainPtr MakeBrain(const std::string& name, bool shared)
+    {
+        QLearningBrainPtr brain(new QLearningBrain(0.8, 0.8, 0.1, 3, 5, 0, 0));
+        brain->name = name;
+        brain->setShared(shared);
+        brain->initialize(MakeInfo());
+        return brain;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_td_brain_shared_save )
+{
+    QLearningBrainPtr first = MakeBrain("team", true);
+    QLearningBrainPtr second = MakeBrain("team", true);
+    QLearningBrainPtr alone = MakeBrain("alone", false);
+
+    // on their own, both write the shared values
+    BOOST_CHECK_EQUAL( first->to_string().size(), second->to_string().size() );
+    Bitstream first_values, second_values;
+    first->SaveState(first_values);
+    second->SaveState(second_values);
+
+    // in one pass, only the first one does, to each output it is saved to
+    std::string first_text, second_text;
+    Bitstream first_state, second_state;
+    {
+        BrainSavePass pass;
+        first_text = first->to_string();
+        second_text = second->to_string();
+        first->SaveState(first_state);
+        second->SaveState(second_state);
+    }
+    BOOST_CHECK( second_text.size() < first_text.size() );
+    BOOST_CHECK( first_state == first_values );
+    BOOST_CHECK( !(second_state == second_values) );
+
+    // a pass opened inside another one (a snapshot taken while a team is
+    // saved) writes the values again, to its own output
+    Bitstream outer_state, inner_state;
+    {
+        BrainSavePass team;
+        first->SaveState(outer_state);
+        {
+            BrainSavePass snapshot;
+            second->SaveState(inner_state);
+        }
+    }
+    BOOST_CHECK( outer_state == first_values );
+    BOOST_CHECK( inner_state == second_values );
+
+    // a reference loads into a brain sharing those values, and no other
+    BOOST_CHECK( second->from_string(second_text) );
+    BOOST_CHECK( !alone->from_string(second_text) );
+    Bitstream reference(second_state);
+    BOOST_CHECK( second->LoadState(reference) );
+    reference = second_state;
+    BOOST_CHECK( !alone->LoadState(reference) );
+    BOOST_CHECK( first->LoadState(first_state) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+#include "core/Common.h"
+#include "core/Bitstream.h"
+#include "ai/rl/Approximator.h"
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <sstream>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// one continuous sensor in [-1, 1], one discrete sensor in [0, 3] and
+    /// one continuous action in [0, 1]
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        sensors.addDiscrete(0, 3);
+        ActionInfo actions;
+        actions.addContinuous(0, 1);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    FeatureVector Make(double a)
+    {
+        FeatureVector v(1);
+        v[0] = a;
+        return v;
+    }
+
+    FeatureVector Make(double a, double b)
+    {
+        FeatureVector v(2);
+        v[0] = a;
+        v[1] = b;
+        return v;
+    }
+
+    /// store a value for each bin (the center of it) of the first sensor in one row of the table
+    void FillRow(ApproximatorPtr table, int row)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            table->update(Make(-1 + i * 2.0 / 999, row), Make(0.5), row * 1000 + i + 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_table_approximator )
+{
+    AgentInitInfo info = MakeInfo();
+    TableApproximator table(info, 3, 5);
+
+    // values in the same bin share an entry
+    BOOST_CHECK_EQUAL( table.predict(Make(0.3, 2), Make(0.1)), 0 );
+    table.update(Make(0.3, 2), Make(0.1), 4);
+    BOOST_CHECK_EQUAL( table.predict(Make(0.3, 2), Make(0.1)), 4 );
+    BOOST_CHECK_EQUAL( table.predict(Make(0.7, 2), Make(0.2)), 4 );
+    BOOST_CHECK_EQUAL( table.predict(Make(0.2, 2), Make(0.1)), 0 );
+    BOOST_CHECK_EQUAL( table.predict(Make(0.3, 1), Make(0.1)), 0 );
+    BOOST_CHECK_EQUAL( table.predict(Make(0.3, 2), Make(0.3)), 0 );
+
+    // the text archive keeps the quantized vectors
+    std::stringstream ss;
+    {
+        boost::archive::text_oarchive oa(ss);
+        const TableApproximator& saved = table;
+        oa << saved;
+    }
+    TableApproximator loaded;
+    {
+        boost::archive::text_iarchive ia(ss);
+        ia >> loaded;
+    }
+    BOOST_CHECK_EQUAL( loaded.predict(Make(0.5, 2), Make(0)), 4 );
+    BOOST_CHECK_EQUAL( loaded.predict(Make(-0.5, 2), Make(0)), 0 );
+
+    // and so does a binary snapshot
+    Bitstream stream;
+    table.update(Make(-1, 0), Make(1), -2);
+    table.SaveState(stream);
+    TableApproximator restored(info, 3, 5);
+    BOOST_CHECK( restored.LoadState(stream) );
+    BOOST_CHECK_EQUAL( restored.predict(Make(0.3, 2), Make(0.1)), 4 );
+    BOOST_CHECK_EQUAL( restored.predict(Make(-1, 0), Make(1)), -2 );
+}
+
+BOOST_AUTO_TEST_CASE( test_table_approximator_storage )
+{
+    AgentInitInfo info = MakeInfo();
+
+    // too many cells for a flat array
+    TableApproximator big(info, 1000, 1000);
+    big.update(Make(0.5, 3), Make(0.5), 1);
+    big.update(Make(-0.5, 3), Make(0.5), 2);
+    BOOST_CHECK_EQUAL( big.predict(Make(0.5, 3), Make(0.5)), 1 );
+    BOOST_CHECK_EQUAL( big.predict(Make(-0.5, 3), Make(0.5)), 2 );
+    BOOST_CHECK_EQUAL( big.predict(Make(0.5, 3), Make(0.25)), 0 );
+
+    // continuous values that are not quantized are kept as they are
+    TableApproximator exact(info, 0, 0);
+    exact.update(Make(0.5, 3), Make(0.5), 1);
+    BOOST_CHECK_EQUAL( exact.predict(Make(0.5, 3), Make(0.5)), 1 );
+    BOOST_CHECK_EQUAL( exact.predict(Make(0.50001, 3), Make(0.5)), 0 );
+
+    // a snapshot only loads into a table stored the same way
+    Bitstream stream;
+    exact.SaveState(stream);
+    BOOST_CHECK( !big.LoadState(stream) );
+}
+
+BOOST_AUTO_TEST_CASE( test_table_approximator_share )
+{
+    AgentInitInfo info = MakeInfo();
+
+    // a flat array
+    TableApproximator dense(info, 3, 5);
+    ApproximatorPtr other = dense.share();
+    other->update(Make(0.3, 2), Make(0.1), 4);
+    BOOST_CHECK_EQUAL( dense.predict(Make(0.3, 2), Make(0.1)), 4 );
+
+    // a copy does not share
+    ApproximatorPtr copy = dense.copy();
+    copy->update(Make(0.3, 2), Make(0.1), 5);
+    BOOST_CHECK_EQUAL( other->predict(Make(0.3, 2), Make(0.1)), 4 );
+
+    // hashed values, filled from four threads at once
+    TableApproximator hashed(info, 1000, 1000);
+    boost::thread_group threads;
+    for (int row = 0; row < 4; ++row)
+    {
+        threads.create_thread(boost::bind(&FillRow, hashed.share(), row));
+    }
+    threads.join_all();
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            BOOST_REQUIRE_EQUAL( hashed.predict(Make(-1 + i * 2.0 / 999, row), Make(0.5)), row * 1000 + i + 1 );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
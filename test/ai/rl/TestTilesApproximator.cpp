@@ -0,0 +1,125 @@
+#include "core/Common.h"
+#include "ai/rl/Approximator.h"
+#include <cmath>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// two continuous sensors, one discrete sensor, and one discrete and
+    /// one continuous action
+    AgentInitInfo MakeInfo()
+    {
+        SensorInfo sensors;
+        sensors.addContinuous(-1, 1);
+        sensors.addDiscrete(0, 4);
+        sensors.addContinuous(0, 10);
+        ActionInfo actions;
+        actions.addDiscrete(0, 2);
+        actions.addContinuous(-1, 1);
+        RewardInfo reward;
+        reward.addContinuous(0, 1);
+        return AgentInitInfo(sensors, actions, reward);
+    }
+
+    std::vector<FeatureVector> MakeActions()
+    {
+        std::vector<FeatureVector> actions;
+        for (int a = 0; a <= 2; ++a)
+        {
+            for (int b = -2; b <= 2; ++b)
+            {
+                FeatureVector action(2);
+                action[0] = a;
+                action[1] = b * 0.5;
+                actions.push_back(action);
+            }
+        }
+        return actions;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_tiles_predict_all )
+{
+    AgentInitInfo info = MakeInfo();
+    TilesApproximator tiles(info, 16, 4096);
+    std::vector<FeatureVector> actions = MakeActions();
+    FeatureVector state(3);
+    std::vector<double> values;
+    for (int i = 0; i < 50; ++i)
+    {
+        state[0] = (i % 20) / 10.0 - 1;
+        state[1] = i % 5;
+        state[2] = (i * 13 % 100) / 10.0;
+        tiles.update(state, actions[i % actions.size()], i % 7);
+
+        // the state is hashed once, with the same tiles as one action at a time
+        tiles.predict_all(state, actions, values);
+        BOOST_REQUIRE_EQUAL( values.size(), actions.size() );
+        for (size_t a = 0; a < actions.size(); ++a)
+        {
+            BOOST_CHECK_EQUAL( values[a], tiles.predict(state, actions[a]) );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_tiles_share )
+{
+    AgentInitInfo info = MakeInfo();
+    TilesApproximator tiles(info, 16, 4096);
+    ApproximatorPtr other = tiles.share();
+    std::vector<FeatureVector> actions = MakeActions();
+    FeatureVector state(3);
+    state[0] = 0.5;
+    state[1] = 2;
+    state[2] = 3;
+
+    // one learns, both know
+    double before = tiles.predict(state, actions[0]);
+    BOOST_CHECK_EQUAL( other->predict(state, actions[0]), before );
+    for (int i = 0; i < 100; ++i)
+    {
+        other->update(state, actions[0], 10);
+    }
+    double after = tiles.predict(state, actions[0]);
+    BOOST_CHECK( std::fabs(after - 10) < std::fabs(before - 10) );
+    BOOST_CHECK_EQUAL( other->predict(state, actions[0]), after );
+}
+
+BOOST_AUTO_TEST_CASE( test_table_predict_all )
+{
+    AgentInitInfo info = MakeInfo();
+    std::vector<FeatureVector> actions = MakeActions();
+    FeatureVector state(3);
+    std::vector<double> values;
+
+    // a flat array, a hashed one and the exact map
+    TableApproximator dense(info, 5, 3);
+    TableApproximator hashed(info, 5, 1000);
+    TableApproximator exact(info, 0, 0);
+    TableApproximator* tables[3] = { &dense, &hashed, &exact };
+    for (size_t t = 0; t < 3; ++t)
+    {
+        for (int i = 0; i < 50; ++i)
+        {
+            state[0] = (i % 20) / 10.0 - 1;
+            state[1] = i % 5;
+            state[2] = (i * 13 % 100) / 10.0;
+            tables[t]->update(state, actions[i % actions.size()], i + 1);
+            tables[t]->predict_all(state, actions, values);
+            BOOST_REQUIRE_EQUAL( values.size(), actions.size() );
+            for (size_t a = 0; a < actions.size(); ++a)
+            {
+                BOOST_CHECK_EQUAL( values[a], tables[t]->predict(state, actions[a]) );
+            }
+            BOOST_CHECK_EQUAL( values[i % actions.size()], i + 1 );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,63 @@
+#include "core/Common.h"
+
+#include "ai/rtneat/ScoreHelper.h"
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_score_helper )
+{
+    using namespace OpenNero;
+
+    RewardInfo info;
+    info.addContinuous(-10, 10);
+    info.addContinuous(-10, 10);
+
+    Reward a(info.getInstance()), b(info.getInstance()), c(info.getInstance());
+    a[0] = 1; a[1] = 5;
+    b[0] = 3; b[1] = 5;
+    c[0] = 8; c[1] = -2;
+
+    // adding c and taking it out again matches never having added it
+    ScoreHelper running(info);
+    running.addSample(a);
+    running.addSample(c);
+    running.addSample(b);
+    running.removeSample(c);
+    running.doCalculations();
+
+    ScoreHelper fresh(info);
+    fresh.addSample(a);
+    fresh.addSample(b);
+    fresh.doCalculations();
+
+    BOOST_CHECK_EQUAL( running.getSampleSize(), 2u );
+    for (size_t i = 0; i < 2; ++i)
+    {
+        BOOST_CHECK_SMALL( running.getAverage()[i] - fresh.getAverage()[i], 1e-9 );
+        BOOST_CHECK_SMALL( running.getStandardDeviation()[i] - fresh.getStandardDeviation()[i], 1e-9 );
+    }
+    BOOST_CHECK_CLOSE( running.getAverage()[0], 2.0, 1e-9 );
+    BOOST_CHECK_CLOSE( running.getStandardDeviation()[0], 1.0, 1e-9 );
+
+    // the weighted score is the weighted sum of the relative scores,
+    // and dimensions without spread do not count
+    FeatureVector weights(2);
+    weights[0] = 2;
+    weights[1] = 7;
+    Reward relative = running.getRelativeScore(b);
+    BOOST_CHECK_CLOSE( relative[0], 1.0, 1e-9 );
+    BOOST_CHECK_EQUAL( relative[1], 0.0 );
+    BOOST_CHECK_CLOSE( running.getWeightedScore(b, weights), 2.0, 1e-9 );
+
+    // removing every sample starts over
+    running.removeSample(a);
+    running.removeSample(b);
+    running.doCalculations();
+    BOOST_CHECK_EQUAL( running.getSampleSize(), 0u );
+    BOOST_CHECK_EQUAL( running.getAverage()[0], 0.0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+#include "core/Common.h"
+#include "core/Log.h"
+#include "core/LogConnections.h"
+#include <cstdio>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    /// keeps the messages sent to it
+    class RecordingConnection : public Log::ILogConnection
+    {
+    public:
+        RecordingConnection() : messages(), errors(0), flushes(0) {}
+        void LogDebug( const char* msg )   { messages.push_back(msg); }
+        void LogMsg( const char* msg )     { messages.push_back(msg); }
+        void LogWarning( const char* msg ) { messages.push_back(msg); }
+        void LogError( const char* msg )   { messages.push_back(msg); ++errors; }
+        const std::string getConnectionName() const { return "test_log"; }
+        void flush() { ++flushes; }
+
+        std::vector<std::string> messages;
+        size_t errors;
+        size_t flushes;
+    };
+
+    /// log numbered messages, every tenth of them an error
+    void LogMany( Log::ILogConnection* connection, int thread, int count )
+    {
+        for( int i = 0; i < count; ++i )
+        {
+            char msg[32];
+            sprintf(msg, "%d %d", thread, i);
+            if( i % 10 == 0 )
+                connection->LogError(msg);
+            else
+                connection->LogMsg(msg);
+        }
+    }
+
+    /// counts the times a message is formatted
+    int Formatted( int& count )
+    {
+        return ++count;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_log_levels )
+{
+    using namespace OpenNero;
+
+    boost::shared_ptr<RecordingConnection> connection( new RecordingConnection() );
+    Log::AddLogConnection(connection);
+    int count = 0;
+
+    // categories start out showing every level
+    BOOST_CHECK_EQUAL( Log::GetLogLevel("test.log"), Log::kLevelDebug );
+    LOG_FD_WARNING( "test.log", "test_log", "shown " << Formatted(count) );
+    BOOST_CHECK_EQUAL( count, 1 );
+    BOOST_CHECK_EQUAL( connection->messages.size(), 1u );
+
+    // a message below the level of its category is not even formatted
+    Log::SetLogLevel( "test.log", Log::kLevelError );
+    for( int i = 0; i < 3; ++i )
+    {
+        LOG_FD_WARNING( "test.log", "test_log", "hidden " << Formatted(count) );
+        LOG_FD_ERROR( "test.log", "test_log", "shown " << Formatted(count) );
+    }
+    BOOST_CHECK_EQUAL( count, 4 );
+    BOOST_CHECK_EQUAL( connection->messages.size(), 4u );
+
+    // other categories are not affected
+    LOG_FD_WARNING( "test.log.other", "test_log", "shown " << Formatted(count) );
+    BOOST_CHECK_EQUAL( count, 5 );
+
+    // filters turn their categories off and all others back on
+    Log::FilterList filters;
+    filters.push_back("test.log.other");
+    Log::LogSystemSpecifyFilters(filters);
+    BOOST_CHECK_EQUAL( Log::GetLogLevel("test.log"), Log::kLevelDebug );
+    BOOST_CHECK_EQUAL( Log::GetLogLevel("test.log.other"), Log::kLevelOff );
+    LOG_FD_ERROR( "test.log.other", "test_log", "hidden " << Formatted(count) );
+    LOG_FD_WARNING( "test.log", "test_log", "shown " << Formatted(count) );
+    BOOST_CHECK_EQUAL( count, 6 );
+    BOOST_CHECK_EQUAL( connection->messages.size(), 6u );
+
+    // as do the functions that take a category
+    Log::LogError( "test.log.other", "test_log", "hidden" );
+    Log::LogError( "test.log", "test_log", "shown" );
+    BOOST_CHECK_EQUAL( connection->messages.size(), 7u );
+    BOOST_CHECK_EQUAL( connection->messages.back(), "shown" );
+
+    Log::LogSystemSpecifyFilters( Log::FilterList() );
+    Log::RemoveLogConnection(connection);
+}
+
+BOOST_AUTO_TEST_CASE( test_async_log )
+{
+    using namespace OpenNero;
+
+    boost::shared_ptr<RecordingConnection> target( new RecordingConnection() );
+    {
+        Log::AsyncLogConnection connection( target, 16 );
+        BOOST_CHECK_EQUAL( connection.getConnectionName(), "test_log" );
+
+        // messages are written by the time flush returns
+        connection.LogMsg("first");
+        connection.flush();
+        BOOST_REQUIRE_EQUAL( target->messages.size(), 1u );
+        BOOST_CHECK_EQUAL( target->messages[0], "first" );
+        BOOST_CHECK( target->flushes > 0 );
+
+        // long messages are cut short
+        connection.LogMsg( std::string(1000, 'x').c_str() );
+        connection.flush();
+        BOOST_CHECK_EQUAL( target->messages.back().size(), Log::AsyncLogConnection::kMaxMessageLength );
+        target->messages.clear();
+
+        // several threads fill the small ring faster than it is written:
+        // some messages are dropped, but no errors, and each thread's
+        // messages stay in order
+        const int kThreads = 4, kCount = 2000;
+        boost::thread_group threads;
+        for( int t = 0; t < kThreads; ++t )
+            threads.create_thread( boost::bind(&LogMany, &connection, t, kCount) );
+        threads.join_all();
+        connection.flush();
+
+        BOOST_CHECK_EQUAL( target->errors, size_t(kThreads * kCount / 10) );
+        BOOST_CHECK_EQUAL( connection.getDropped(Log::kLevelError), 0u );
+        size_t logged = 0, reports = 0;
+        std::vector<int> last(kThreads, -1);
+        for( size_t i = 0; i < target->messages.size(); ++i )
+        {
+            int t, n;
+            if( sscanf(target->messages[i].c_str(), "%d %d", &t, &n) == 2 )
+            {
+                BOOST_REQUIRE( t >= 0 && t < kThreads );
+                BOOST_CHECK( n > last[t] );
+                last[t] = n;
+                ++logged;
+            }
+            else
+            {
+                BOOST_CHECK( target->messages[i].find("dropped") != std::string::npos );
+                ++reports;
+            }
+        }
+        BOOST_CHECK_EQUAL( logged + connection.getDropped(Log::kLevelMsg), size_t(kThreads * kCount) );
+        BOOST_CHECK_EQUAL( reports > 0, connection.getDropped(Log::kLevelMsg) > 0 );
+        target->messages.clear();
+
+        // what is left is written when the connection goes away
+        connection.LogWarning("last");
+    }
+    BOOST_REQUIRE_EQUAL( target->messages.size(), 1u );
+    BOOST_CHECK_EQUAL( target->messages[0], "last" );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
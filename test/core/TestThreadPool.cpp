@@ -0,0 +1,58 @@
+#include "core/Common.h"
+
+#include "core/ThreadPool.h"
+#include "math/Random.h"
+#include <vector>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    struct DrawRandom
+    {
+        std::vector<uint32_t>* results;
+        void operator()(size_t i) const
+        {
+            ScopedRandomStream stream(static_cast<uint32_t>(i));
+            uint32_t x = 0;
+            // uneven amounts of work so that the workers have to steal
+            for (size_t k = 0; k <= i % 17; ++k)
+                x ^= ThreadRandom().randI();
+            (*results)[i] = x;
+        }
+    };
+
+    std::vector<uint32_t> draw(size_t num_threads, size_t count)
+    {
+        std::vector<uint32_t> results(count, 0);
+        DrawRandom task;
+        task.results = &results;
+        ThreadPool pool(num_threads);
+        pool.ParallelFor(count, task);
+        pool.ParallelFor(count, task);
+        return results;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_thread_pool )
+{
+    const size_t count = 1000;
+    std::vector<uint32_t> serial = draw(1, count);
+    for (size_t threads = 2; threads <= 8; threads *= 2)
+    {
+        std::vector<uint32_t> parallel = draw(threads, count);
+        BOOST_CHECK( serial == parallel );
+    }
+    // the per-task streams do not disturb the global one
+    OpenNero::RandomNumberGenerator reference(55555);
+    OpenNero::RANDOM.seed(55555);
+    draw(4, count);
+    BOOST_CHECK_EQUAL( OpenNero::ThreadRandom().randI(), reference.randI() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
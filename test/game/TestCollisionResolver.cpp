@@ -0,0 +1,117 @@
+#include "core/Common.h"
+#include "game/CollisionResolver.h"
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    const float32_t kTolerance = 1e-3f;
+
+    bool near(const Vector2f& a, const Vector2f& b)
+    {
+        return a.getDistanceFrom(b) < kTolerance;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_collision_box )
+{
+    // a 4 by 2 box around the origin
+    CollisionBox box(Vector2f(0, 0), 0, Vector2f(2, 1), 0, 10);
+
+    // far enough away
+    Vector2f point(4, 0);
+    BOOST_CHECK( !box.PushOut(point, 1) );
+    BOOST_CHECK( near(point, Vector2f(4, 0)) );
+
+    // touching the side
+    point = Vector2f(2.5f, 0);
+    BOOST_CHECK( box.PushOut(point, 1) );
+    BOOST_CHECK( near(point, Vector2f(3, 0)) );
+
+    // touching the corner
+    point = Vector2f(2.5f, 1.5f);
+    BOOST_CHECK( box.PushOut(point, 1) );
+    BOOST_CHECK( point.getDistanceFrom(Vector2f(2, 1)) > 1 - kTolerance );
+
+    // inside, nearer the long side
+    point = Vector2f(0.5f, 0.5f);
+    BOOST_CHECK( box.PushOut(point, 1) );
+    BOOST_CHECK( near(point, Vector2f(0.5f, 2)) );
+
+    // the same box turned a quarter turn counter-clockwise
+    CollisionBox turned(Vector2f(0, 0), 90, Vector2f(2, 1), 0, 10);
+    Vector2f lo, hi;
+    turned.GetBounds(lo, hi);
+    BOOST_CHECK( near(lo, Vector2f(-1, -2)) );
+    BOOST_CHECK( near(hi, Vector2f(1, 2)) );
+    point = Vector2f(0, 2.5f);
+    BOOST_CHECK( turned.PushOut(point, 1) );
+    BOOST_CHECK( near(point, Vector2f(0, 3)) );
+    point = Vector2f(1.5f, 0);
+    BOOST_CHECK( turned.PushOut(point, 1) );
+    BOOST_CHECK( near(point, Vector2f(2, 0)) );
+}
+
+BOOST_AUTO_TEST_CASE( test_collision_resolver )
+{
+    CollisionResolver resolver(10);
+
+    // a thin wall along the Y axis, and a box far away
+    BOOST_CHECK_EQUAL( resolver.AddBox(CollisionBox(Vector2f(0, 0), 0, Vector2f(0.1f, 50), 0, 10)), 0u );
+    BOOST_CHECK_EQUAL( resolver.AddBox(CollisionBox(Vector2f(1000, 1000), 0, Vector2f(1, 1), 0, 10)), 1u );
+
+    // out of reach of the wall
+    Vector2f point(-5, 0);
+    BOOST_CHECK( !resolver.PushOut(point, 1, 0, 2) );
+
+    // above the wall
+    point = Vector2f(0, 0);
+    BOOST_CHECK( !resolver.PushOut(point, 1, 11, 13) );
+
+    // in the wall
+    point = Vector2f(-0.5f, 20);
+    BOOST_CHECK( resolver.PushOut(point, 1, 0, 2) );
+    BOOST_CHECK( near(point, Vector2f(-1.1f, 20)) );
+
+    // a fast move straight through the wall stops at it
+    Vector2f end = resolver.Sweep(Vector2f(-5, 0), Vector2f(5, 0), 1, 0, 2);
+    BOOST_CHECK( near(end, Vector2f(-1.1f, 0)) );
+
+    // a move at an angle slides along it
+    end = resolver.Sweep(Vector2f(-5, 0), Vector2f(5, 4), 1, 0, 2);
+    BOOST_CHECK( end.X < -1.1f + kTolerance );
+    BOOST_CHECK( end.Y > 0 );
+
+    // a move that clears the wall is not changed
+    end = resolver.Sweep(Vector2f(-5, 0), Vector2f(5, 0), 1, 11, 13);
+    BOOST_CHECK( near(end, Vector2f(5, 0)) );
+
+    // nothing to collide with
+    resolver.ClearBoxes();
+    end = resolver.Sweep(Vector2f(-5, 0), Vector2f(5, 0), 1, 0, 2);
+    BOOST_CHECK( near(end, Vector2f(5, 0)) );
+}
+
+BOOST_AUTO_TEST_CASE( test_collision_resolver_note_change )
+{
+    CollisionResolver resolver(10);
+
+    // a box that moves, turns or changes type is collected again
+    BOOST_CHECK( resolver.NoteChange(0, SimEntityData::kDB_Position) );
+    BOOST_CHECK( resolver.NoteChange(0, SimEntityData::kDB_Rotation) );
+    BOOST_CHECK( resolver.NoteChange(0, SimEntityData::kDB_Type) );
+
+    // and so is an entity that starts or stops colliding
+    BOOST_CHECK( resolver.NoteChange(1, SimEntityData::kDB_Collision) );
+
+    // but not a box that only changes color, or an entity that collides and moves
+    BOOST_CHECK( !resolver.NoteChange(0, SimEntityData::kDB_Color) );
+    BOOST_CHECK( !resolver.NoteChange(1, SimEntityData::kDB_Position | SimEntityData::kDB_Rotation) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
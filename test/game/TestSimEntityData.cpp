@@ -50,4 +50,68 @@ BOOST_AUTO_TEST_CASE( test_simentity_data )
     BOOST_CHECK_EQUAL( data.GetDirtyBits(), SimEntityData::kDB_Position | SimEntityData::kDB_Velocity );
 }
 
+BOOST_AUTO_TEST_CASE( test_simentity_data_bitstream )
+{
+    using namespace OpenNero;
+    SimEntityData data(Vector3f(1,2,3), Vector3f(0,0,90), Vector3f(1,1,2), "agent", 4, 8, 42);
+    data.ProcessTick(0.1f);
+    data.SetPosition( Vector3f(4,5,6) );
+    data.SetVelocity( Vector3f(0,1,0) );
+    data.SetColor( SColor(0x80, 0x10, 0x20, 0x30) );
+    data.SetLabel( "moved" );
+    data.ClearDirtyBits();
+
+    Bitstream stream;
+    stream << data;
+
+    SimEntityData copy;
+    copy.ClearDirtyBits();
+    stream >> copy;
+    BOOST_CHECK( stream.IsEmpty() );
+
+    BOOST_CHECK_EQUAL( copy.GetId(), 42u );
+    BOOST_CHECK_EQUAL( copy.GetPosition(), Vector3f(4,5,6) );
+    BOOST_CHECK_EQUAL( copy.GetRotation(), Vector3f(0,0,90) );
+    BOOST_CHECK_EQUAL( copy.GetVelocity(), Vector3f(0,1,0) );
+    BOOST_CHECK_EQUAL( copy.GetScale(), Vector3f(1,1,2) );
+    BOOST_CHECK_EQUAL( copy.GetLabel(), "moved" );
+    BOOST_CHECK( copy.GetColor() == SColor(0x80, 0x10, 0x20, 0x30) );
+    BOOST_CHECK_EQUAL( copy.GetType(), 4u );
+    BOOST_CHECK_EQUAL( copy.GetCollision(), 8u );
+
+    // the previous state comes along, so that animation continues from it
+    BOOST_CHECK_EQUAL( copy.GetPrevious().mPosition, Vector3f(1,2,3) );
+    BOOST_CHECK_EQUAL( copy.GetPrevious().mLabel, "agent" );
+
+    // and everything needs to be shown again
+    BOOST_CHECK_EQUAL( copy.GetDirtyBits(), U32(-1) );
+}
+
+BOOST_AUTO_TEST_CASE( test_simentity_data_truncated )
+{
+    using namespace OpenNero;
+    SimEntityData data;
+    data.SetLabel( "agent" );
+
+    Bitstream whole;
+    whole << data;
+
+    // cut the record short: the read fails instead of running off the end
+    std::vector<uint8_t> bytes(whole.ByteLength());
+    whole.PopBytes( &bytes[0], (uint32_t)bytes.size() );
+    Bitstream cut;
+    cut.PushBytes( &bytes[0], (uint32_t)bytes.size() / 2 );
+    SimEntityData copy;
+    cut >> copy;
+    BOOST_CHECK( cut.Failed() );
+
+    // a vector longer than the stream fails before it is allocated
+    Bitstream corrupt;
+    corrupt << uint32_t(0x7FFFFFFF);
+    std::vector<float32_t> values;
+    corrupt >> values;
+    BOOST_CHECK( corrupt.Failed() );
+    BOOST_CHECK( values.empty() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
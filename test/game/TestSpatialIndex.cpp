@@ -0,0 +1,86 @@
+#include "core/Common.h"
+#include "game/SpatialIndex.h"
+#include "game/SimEntity.h"
+#include <algorithm>
+#include <cstdlib>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    float32_t coordinate()
+    {
+        return float32_t(rand() % 2000) / 4.0f - 250.0f;
+    }
+
+    // the full scan that sensors used to do
+    SimEntityVector scan_within(const std::vector<SimEntityPtr>& ents, const Vector3f& center, float32_t radius, uint32_t types)
+    {
+        SimEntityVector result;
+        for (size_t i = 0; i < ents.size(); ++i)
+        {
+            if ((ents[i]->GetType() & types) && ents[i]->GetPosition().getDistanceFrom(center) <= radius)
+                result.push_back(ents[i]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_spatial_index )
+{
+    SpatialIndex index(20);
+    std::vector<SimEntityPtr> ents;
+    for (SimId id = 1; id <= 200; ++id)
+    {
+        Vector3f pos(coordinate(), coordinate(), 0);
+        SimEntityData data(pos, Vector3f(0,0,0), Vector3f(1,1,1), "", 1 << (id % 3), 0, id);
+        SimEntityPtr ent(new SimEntity(data, ""));
+        index.Insert(ent);
+        ents.push_back(ent);
+    }
+    BOOST_CHECK_EQUAL( index.Size(), ents.size() );
+
+    SimEntityVector found;
+    for (int step = 0; step < 100; ++step)
+    {
+        // some entities move, the index hears about it from their data
+        for (int k = 0; k < 20; ++k)
+        {
+            SimEntityPtr ent = ents[rand() % ents.size()];
+            ent->SetPosition(Vector3f(coordinate(), coordinate(), 0));
+        }
+
+        Vector3f center(coordinate(), coordinate(), 0);
+        float32_t radius = float32_t(rand() % 300);
+        uint32_t types = 1 + rand() % 7;
+        index.GetEntitiesWithin(center, radius, types, found);
+        std::sort(found.begin(), found.end());
+        BOOST_CHECK( found == scan_within(ents, center, radius, types) );
+    }
+
+    // a radius larger than the world looks at every entity of the type
+    index.GetEntitiesWithin(Vector3f(0,0,0), 1e30f, 0xFFFFFFFF, found);
+    BOOST_CHECK_EQUAL( found.size(), ents.size() );
+
+    // entities that are removed are not found any more
+    for (size_t i = 0; i < ents.size(); i += 2)
+        index.Remove(ents[i]);
+    BOOST_CHECK_EQUAL( index.Size(), ents.size() / 2 );
+    index.GetEntitiesWithin(Vector3f(0,0,0), 1e30f, 0xFFFFFFFF, found);
+    BOOST_CHECK_EQUAL( found.size(), ents.size() / 2 );
+
+    // and a cleared index forgets everything
+    index.Clear();
+    BOOST_CHECK_EQUAL( index.Size(), 0 );
+    ents[1]->SetPosition(Vector3f(1,2,3));
+    index.GetEntitiesWithin(Vector3f(0,0,0), 1e30f, 0xFFFFFFFF, found);
+    BOOST_CHECK( found.empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
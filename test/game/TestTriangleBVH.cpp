@@ -0,0 +1,189 @@
+#include "core/Common.h"
+#include "game/RayCaster.h"
+#include "game/SimEntity.h"
+#include <cstdlib>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    float32_t coordinate()
+    {
+        return float32_t(rand() % 4000) / 10.0f - 200.0f;
+    }
+
+    Vector3f point()
+    {
+        return Vector3f(coordinate(), coordinate(), coordinate());
+    }
+
+    // a small triangle somewhere in the world
+    Triangle3f triangle()
+    {
+        Vector3f a = point();
+        Vector3f b = a + Vector3f(float32_t(rand() % 200) / 10.0f, float32_t(rand() % 200) / 10.0f, 0);
+        Vector3f c = a + Vector3f(0, float32_t(rand() % 200) / 10.0f, float32_t(rand() % 200) / 10.0f);
+        return Triangle3f(a, b, c);
+    }
+
+    // the test CSceneCollisionManager::getCollisionPoint does for every node
+    TriangleBVH::Hit brute_force(const std::vector<std::vector<Triangle3f> >& objects,
+                                 const std::vector<int32_t>& ids,
+                                 const Line3f& ray, int32_t bits)
+    {
+        TriangleBVH::Hit hit;
+        const Vector3f linevect = ray.getVector().normalize();
+        const float32_t raylength = ray.getLengthSQ();
+        for (size_t o = 0; o < objects.size(); ++o)
+        {
+            if (bits != 0 && !(ids[o] & bits))
+                continue;
+            for (size_t i = 0; i < objects[o].size(); ++i)
+            {
+                Vector3f intersection;
+                if (objects[o][i].getIntersectionWithLine(ray.start, linevect, intersection))
+                {
+                    const float32_t tmp = intersection.getDistanceFromSQ(ray.start);
+                    const float32_t tmp2 = intersection.getDistanceFromSQ(ray.end);
+                    if (tmp < raylength && tmp2 < raylength && tmp < hit.distanceSQ)
+                    {
+                        hit.object = static_cast<int32_t>(o);
+                        hit.distanceSQ = tmp;
+                        hit.point = intersection;
+                    }
+                }
+            }
+        }
+        return hit;
+    }
+
+    // a wall across the x axis, where the scene node of the entity would put it
+    std::vector<Triangle3f> wall(const SimEntityPtr& ent)
+    {
+        float32_t x = ent->GetPosition().X;
+        Vector3f a(x, -10, -10), b(x, 10, -10), c(x, 10, 10), d(x, -10, 10);
+        std::vector<Triangle3f> triangles;
+        triangles.push_back(Triangle3f(a, b, c));
+        triangles.push_back(Triangle3f(a, c, d));
+        return triangles;
+    }
+
+    // what a rebuild of the static hierarchy would index
+    void index_walls(const std::vector<SimEntityPtr>& walls, TriangleBVH& bvh)
+    {
+        bvh.Clear();
+        for (size_t i = 0; i < walls.size(); ++i)
+            bvh.AddObject(int32_t((walls[i]->GetSimId() << 4) | walls[i]->GetType()), wall(walls[i]));
+        bvh.Build();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_triangle_bvh )
+{
+    TriangleBVH bvh;
+    std::vector<std::vector<Triangle3f> > objects(50);
+    std::vector<int32_t> ids(objects.size());
+    for (size_t o = 0; o < objects.size(); ++o)
+    {
+        // scene object ids are (sim id << 4) | type
+        ids[o] = int32_t(((o + 1) << 4) | (1 << (o % 3)));
+        for (int i = rand() % 40; i >= 0; --i)
+            objects[o].push_back(triangle());
+        BOOST_CHECK_EQUAL( bvh.AddObject(ids[o], objects[o]), o );
+    }
+    bvh.Build();
+    BOOST_CHECK_EQUAL( bvh.GetNumObjects(), objects.size() );
+
+    size_t hits = 0;
+    for (int r = 0; r < 2000; ++r)
+    {
+        Line3f ray(point(), point());
+        int32_t bits = rand() % 8;
+        TriangleBVH::Hit expected = brute_force(objects, ids, ray, bits);
+        TriangleBVH::Hit found;
+        bvh.Intersect(ray, bits, found);
+        BOOST_CHECK_EQUAL( found.object, expected.object );
+        BOOST_CHECK_EQUAL( found.distanceSQ, expected.distanceSQ );
+        if (expected.object >= 0)
+            ++hits;
+    }
+    // make sure the rays actually hit something
+    BOOST_CHECK( hits > 0 );
+
+    // a hit closer than anything in the tree is kept
+    Line3f ray(Vector3f(-300, 0, 0), Vector3f(300, 0, 0));
+    TriangleBVH::Hit closer;
+    closer.object = 1000;
+    closer.distanceSQ = 0;
+    bvh.Intersect(ray, 0, closer);
+    BOOST_CHECK_EQUAL( closer.object, 1000 );
+
+    // and an empty tree does not hit anything
+    bvh.Clear();
+    bvh.Build();
+    TriangleBVH::Hit none;
+    bvh.Intersect(ray, 0, none);
+    BOOST_CHECK_EQUAL( none.object, -1 );
+}
+
+BOOST_AUTO_TEST_CASE( test_ray_caster_static_move )
+{
+    const uint32_t kWall = 1, kAgent = 2;
+    RayCaster caster;
+    caster.SetStaticTypes(kWall);
+
+    // a wall whose scene node is up to date
+    SimEntityData data(Vector3f(10, 0, 0), Vector3f(0,0,0), Vector3f(1,1,1), "", kWall, 0, 1);
+    data.ClearDirtyBits();
+    SimEntityPtr ent(new SimEntity(data, ""));
+    std::vector<SimEntityPtr> walls(1, ent);
+    TriangleBVH bvh;
+    index_walls(walls, bvh);
+
+    Line3f ray(Vector3f(0, 0, 0), Vector3f(100, 0, 0));
+    TriangleBVH::Hit hit;
+    bvh.Intersect(ray, 0, hit);
+    BOOST_CHECK_EQUAL( hit.object, 0 );
+    BOOST_CHECK_CLOSE( hit.point.X, 10.0f, 1e-3f );
+
+    // nothing happened to it
+    BOOST_CHECK( !caster.NoteChange(kWall, kWall, ent->GetState().GetDirtyBits()) );
+    ent->SetColor(SColor(255, 255, 0, 0));
+    BOOST_CHECK( !caster.NoteChange(kWall, kWall, ent->GetState().GetDirtyBits()) );
+
+    // the wall moves, so the cast has to see the rebuilt hierarchy
+    ent->SetPosition(Vector3f(40, 0, 0));
+    BOOST_CHECK( caster.NoteChange(kWall, kWall, ent->GetState().GetDirtyBits()) );
+    index_walls(walls, bvh);
+    TriangleBVH::Hit moved;
+    bvh.Intersect(ray, 0, moved);
+    BOOST_CHECK_EQUAL( moved.object, 0 );
+    BOOST_CHECK_CLOSE( moved.point.X, 40.0f, 1e-3f );
+
+    // turning and scaling move the triangles too
+    SimEntityData turned(data);
+    turned.SetRotation(Vector3f(0, 0, 90));
+    BOOST_CHECK( caster.NoteChange(kWall, kWall, turned.GetDirtyBits()) );
+    SimEntityData scaled(data);
+    scaled.SetScale(Vector3f(2, 2, 2));
+    BOOST_CHECK( caster.NoteChange(kWall, kWall, scaled.GetDirtyBits()) );
+
+    // agents move all the time without touching the static hierarchy
+    SimEntityData agent(Vector3f(0,0,0), Vector3f(0,0,0), Vector3f(1,1,1), "", kAgent, 0, 2);
+    agent.ClearDirtyBits();
+    agent.SetPosition(Vector3f(5, 5, 0));
+    BOOST_CHECK( !caster.NoteChange(kAgent, kAgent, agent.GetDirtyBits()) );
+
+    // but not when they turn into walls or walls into agents
+    agent.ClearDirtyBits();
+    BOOST_CHECK( caster.NoteChange(kAgent, kWall, agent.GetDirtyBits()) );
+    BOOST_CHECK( caster.NoteChange(kWall, kAgent, agent.GetDirtyBits()) );
+    BOOST_CHECK( !caster.NoteChange(kAgent, kAgent | 4, agent.GetDirtyBits()) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+#include "core/Common.h"
+#include "game/TypeIndex.h"
+#include "game/SimEntity.h"
+#include <algorithm>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace OpenNero;
+
+    SimEntityPtr entity(SimId id, uint32_t type)
+    {
+        SimEntityData data(Vector3f(0,0,0), Vector3f(0,0,0), Vector3f(1,1,1), "", type, 0, id);
+        return SimEntityPtr(new SimEntity(data, ""));
+    }
+
+    // collects the visited entities in order
+    struct Visited
+    {
+        SimEntityVector ents;
+        void operator()(const SimEntityPtr& ent) { ents.push_back(ent); }
+    };
+
+    SimEntityVector visit(const TypeIndex& index, uint32_t types)
+    {
+        Visited visited;
+        index.ForEach(types, visited);
+        return visited.ents;
+    }
+
+    bool contains(const SimEntityVector& ents, const SimEntityPtr& ent)
+    {
+        return std::find(ents.begin(), ents.end(), ent) != ents.end();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_type_index )
+{
+    TypeIndex index;
+    SimEntityPtr a = entity(1, 1);
+    SimEntityPtr b = entity(2, 2);
+    SimEntityPtr ab = entity(3, 3);
+    index.Insert(a);
+    index.Insert(b);
+    index.Insert(ab);
+
+    BOOST_CHECK_EQUAL( index.Get(0).size(), 2u );
+    BOOST_CHECK_EQUAL( index.Get(1).size(), 2u );
+    BOOST_CHECK_EQUAL( index.Get(2).size(), 0u );
+
+    // an entity with both types is visited once
+    SimEntityVector both = visit(index, 3);
+    BOOST_CHECK_EQUAL( both.size(), 3u );
+    BOOST_CHECK( contains(both, a) && contains(both, b) && contains(both, ab) );
+    BOOST_CHECK_EQUAL( visit(index, 2).size(), 2u );
+
+    b->SetRemoved();
+    index.RemoveMarked();
+    BOOST_CHECK_EQUAL( index.Get(1).size(), 1u );
+    BOOST_CHECK_EQUAL( visit(index, 3).size(), 2u );
+
+    index.Clear();
+    BOOST_CHECK_EQUAL( visit(index, 3).size(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( test_type_index_type_change )
+{
+    TypeIndex index;
+    SimEntityPtr a = entity(1, 1);
+    SimEntityPtr b = entity(2, 2);
+    index.Insert(a);
+    index.Insert(b);
+
+    // until it is refiled, the entity is visited once, by the type it is filed under
+    a->SetType(3);
+    BOOST_CHECK_EQUAL( TypeIndex::GetFiledType(*a), 1u );
+    SimEntityVector both = visit(index, 3);
+    BOOST_CHECK_EQUAL( both.size(), 2u );
+    BOOST_CHECK( contains(both, a) && contains(both, b) );
+    BOOST_CHECK( !contains(visit(index, 2), a) );
+
+    BOOST_CHECK_EQUAL( index.Refile(a), 1u );
+    BOOST_CHECK_EQUAL( TypeIndex::GetFiledType(*a), 3u );
+    BOOST_CHECK_EQUAL( index.Get(0).size(), 1u );
+    BOOST_CHECK_EQUAL( index.Get(1).size(), 2u );
+    BOOST_CHECK_EQUAL( visit(index, 3).size(), 2u );
+    BOOST_CHECK( contains(visit(index, 2), a) );
+
+    // a type change that drops the lower bit
+    b->SetType(1);
+    a->SetType(2);
+    both = visit(index, 3);
+    BOOST_CHECK_EQUAL( both.size(), 2u );
+    BOOST_CHECK( contains(both, a) && contains(both, b) );
+    BOOST_CHECK_EQUAL( index.Refile(b), 2u );
+    BOOST_CHECK_EQUAL( index.Refile(a), 3u );
+    BOOST_CHECK_EQUAL( index.Refile(a), 2u ); // nothing more to do
+    SimEntityVector ones = visit(index, 1);
+    BOOST_CHECK_EQUAL( ones.size(), 1u );
+    BOOST_CHECK( contains(ones, b) );
+    SimEntityVector twos = visit(index, 2);
+    BOOST_CHECK_EQUAL( twos.size(), 1u );
+    BOOST_CHECK( contains(twos, a) );
+    BOOST_CHECK_EQUAL( visit(index, 3).size(), 2u );
+
+    // removed by the type it is filed under
+    a->SetType(1);
+    a->SetRemoved();
+    index.RemoveMarked();
+    BOOST_CHECK_EQUAL( visit(index, 3).size(), 1u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+#include "core/Common.h"
+
+#include "rtneat/population.h"
+#include <cmath>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace NEAT;
+
+    // the gene-by-gene merge that Genome::compatibility used to do
+    F64 merge_genes(const std::vector<GenePtr>& genes1, const std::vector<GenePtr>& genes2)
+    {
+        F64 num_disjoint = 0, num_excess = 0, mut_diff_total = 0, num_matching = 0;
+        std::vector<GenePtr>::const_iterator p1 = genes1.begin(), p2 = genes2.begin();
+        while (p1 != genes1.end() || p2 != genes2.end())
+        {
+            if (p1 == genes1.end()) { ++p2; num_excess += 1; }
+            else if (p2 == genes2.end()) { ++p1; num_excess += 1; }
+            else if ((*p1)->innovation_num == (*p2)->innovation_num)
+            {
+                num_matching += 1;
+                mut_diff_total += std::fabs((*p1)->mutation_num - (*p2)->mutation_num);
+                ++p1;
+                ++p2;
+            }
+            else if ((*p1)->innovation_num < (*p2)->innovation_num) { ++p1; num_disjoint += 1; }
+            else { ++p2; num_disjoint += 1; }
+        }
+        return disjoint_coeff * num_disjoint + excess_coeff * num_excess
+            + mutdiff_coeff * (mut_diff_total / num_matching);
+    }
+
+    // every organism starts out in a species of its own (the global threshold is 0)
+    PopulationPtr make_population(U32 seed, S32 size)
+    {
+        ScopedRandGen stream(seed);
+        std::vector<Genome*> genomes;
+        for (S32 id = 1; id <= size; ++id)
+            genomes.push_back(new Genome(id, 4, 2, 5, 10, true, 0.5));
+        return PopulationPtr(new Population(genomes, 0));
+    }
+
+    // the compatibility coefficients of the NERO parameters, for the duration of a test
+    struct Coefficients
+    {
+        F64 disjoint, excess, mutdiff;
+        Coefficients() : disjoint(disjoint_coeff), excess(excess_coeff), mutdiff(mutdiff_coeff)
+        {
+            disjoint_coeff = 1.0;
+            excess_coeff = 1.0;
+            mutdiff_coeff = 0.4;
+        }
+        ~Coefficients()
+        {
+            disjoint_coeff = disjoint;
+            excess_coeff = excess;
+            mutdiff_coeff = mutdiff;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_compatibility_cache )
+{
+    Coefficients coefficients;
+    PopulationPtr pop = make_population(7, 20);
+    CompatibilityCache cache;
+
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        for (size_t j = 0; j < pop->organisms.size(); ++j)
+        {
+            GenomePtr a = pop->organisms[i]->gnome, b = pop->organisms[j]->gnome;
+            F64 expected = merge_genes(a->genes, b->genes);
+            BOOST_CHECK_EQUAL( a->compatibility(b), expected );
+            BOOST_CHECK_EQUAL( cache.compatibility(a, b), expected );
+            BOOST_CHECK_EQUAL( cache.compatibility(b, a), expected );
+        }
+    }
+    BOOST_CHECK_EQUAL( cache.size(), 20u * 21u / 2 );
+
+    // a mutation makes the cached distances stale
+    GenomePtr a = pop->organisms[0]->gnome, b = pop->organisms[1]->gnome;
+    F64 before = cache.compatibility(a, b);
+    a->mutate_link_weights(2.0, 1.0, GAUSSIAN);
+    F64 after = merge_genes(a->genes, b->genes);
+    BOOST_CHECK( before != after );
+    BOOST_CHECK_EQUAL( cache.compatibility(a, b), after );
+
+    // and so does a copy that takes over the id
+    GenomePtr copy = b->duplicate(a->genome_id);
+    copy->mutate_link_weights(2.0, 1.0, GAUSSIAN);
+    BOOST_CHECK_EQUAL( cache.compatibility(copy, b), merge_genes(copy->genes, b->genes) );
+}
+
+BOOST_AUTO_TEST_CASE( test_reassign_all_species )
+{
+    Coefficients coefficients;
+    // the same population twice, reassigned serially and in parallel
+    PopulationPtr serial = make_population(11, 400);
+    PopulationPtr parallel = make_population(11, 400);
+    BOOST_REQUIRE_EQUAL( serial->species.size(), parallel->species.size() );
+
+    // enough species and organisms for the comparisons to run on the threads
+    BOOST_REQUIRE_EQUAL( serial->species.size(), 400u );
+    serial->params.compat_threshold = parallel->params.compat_threshold = 28.0;
+    serial->reassign_all_species(1);
+    parallel->reassign_all_species(4);
+
+    BOOST_REQUIRE_EQUAL( serial->species.size(), parallel->species.size() );
+    BOOST_CHECK( serial->species.size() < 400 );
+    size_t total = 0;
+    for (size_t s = 0; s < serial->species.size(); ++s)
+    {
+        BOOST_CHECK_EQUAL( serial->species[s]->id, parallel->species[s]->id );
+        BOOST_CHECK( !serial->species[s]->organisms.empty() );
+        total += serial->species[s]->organisms.size();
+    }
+    BOOST_CHECK_EQUAL( total, serial->organisms.size() );
+    for (size_t i = 0; i < serial->organisms.size(); ++i)
+    {
+        SpeciesPtr spec = serial->organisms[i]->species.lock();
+        BOOST_CHECK( std::find(spec->organisms.begin(), spec->organisms.end(), serial->organisms[i]) != spec->organisms.end() );
+        BOOST_CHECK_EQUAL( spec->id, parallel->organisms[i]->species.lock()->id );
+    }
+
+    // a second pass finds the distances it needs in the cache
+    size_t misses = serial->compat_cache.misses();
+    BOOST_CHECK( misses > 0 );
+    serial->reassign_all_species(1);
+    BOOST_CHECK_EQUAL( serial->compat_cache.misses(), misses );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
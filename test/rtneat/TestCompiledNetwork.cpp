@@ -0,0 +1,101 @@
+#include "core/Common.h"
+
+#include "rtneat/genome.h"
+#include "rtneat/network.h"
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_compiled_network )
+{
+    using namespace NEAT;
+
+    for (S32 id = 0; id < 20; ++id)
+    {
+        // random recurrent genome with 4 inputs (last one is the bias) and 2 outputs
+        GenomePtr genome(new Genome(id, 4, 2, 5, 10, true, 0.5));
+        NetworkPtr compiled = genome->genesis(id);
+        NetworkPtr other = genome->genesis(id);
+        // same nodes, but activated through the pointer-based path
+        NetworkPtr plain(new Network(other->inputs, other->outputs, other->all_nodes, id));
+
+        BOOST_CHECK( compiled->is_compiled() );
+        BOOST_CHECK( !plain->is_compiled() );
+
+        for (S32 step = 0; step < 30; ++step)
+        {
+            std::vector<F64> sensors(4);
+            for (size_t i = 0; i < sensors.size(); ++i)
+                sensors[i] = randfloat();
+            compiled->load_sensors(sensors);
+            plain->load_sensors(sensors);
+            BOOST_CHECK_EQUAL( compiled->activate(), plain->activate() );
+
+            std::vector<F64> a, b;
+            compiled->get_outputs(a);
+            plain->get_outputs(b);
+            BOOST_REQUIRE_EQUAL( a.size(), b.size() );
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                // outputs must be bit-identical, not just close
+                BOOST_CHECK( a[i] == b[i] );
+                BOOST_CHECK( compiled->outputs[i]->get_active_out() == b[i] );
+            }
+
+            if (step == 15)
+            {
+                compiled->flush();
+                plain->flush();
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_activate_all )
+{
+    using namespace NEAT;
+
+    // the same networks twice, activated in one batch and one at a time;
+    // every other network goes through the pointer-based path
+    const size_t kNets = 12, kInputs = 4, kOutputs = 2;
+    std::vector<NetworkPtr> batch, single;
+    for (S32 id = 0; id < S32(kNets); ++id)
+    {
+        GenomePtr genome(new Genome(id, kInputs, kOutputs, 5, 10, true, 0.5));
+        NetworkPtr a = genome->genesis(id);
+        NetworkPtr b = genome->genesis(id);
+        if (id % 2)
+        {
+            a.reset(new Network(a->inputs, a->outputs, a->all_nodes, id));
+            b.reset(new Network(b->inputs, b->outputs, b->all_nodes, id));
+        }
+        batch.push_back(a);
+        single.push_back(b);
+    }
+
+    std::vector<F64> sensors(kNets * kInputs), outputs(kNets * kOutputs);
+    for (S32 step = 0; step < 30; ++step)
+    {
+        for (size_t i = 0; i < sensors.size(); ++i)
+            sensors[i] = randfloat();
+        Network::activate_all(batch, &sensors[0], kInputs, &outputs[0], kOutputs);
+
+        for (size_t n = 0; n < kNets; ++n)
+        {
+            single[n]->load_sensors(&sensors[n * kInputs]);
+            single[n]->activate();
+            std::vector<F64> expected;
+            single[n]->get_outputs(expected);
+            BOOST_REQUIRE_EQUAL( expected.size(), kOutputs );
+            for (size_t i = 0; i < kOutputs; ++i)
+            {
+                // outputs must be bit-identical, not just close
+                BOOST_CHECK( outputs[n * kOutputs + i] == expected[i] );
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#include "core/Common.h"
+
+#include "rtneat/innovation.h"
+
+#include <sstream>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/deque.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_innovation_registry )
+{
+    using namespace NEAT;
+
+    InnovationRegistry registry;
+    registry.set_max_size(3);
+
+    InnovationPtr node(new Innovation(1, 2, 10.0, 11.0, 7, 5.0));
+    InnovationPtr link(new Innovation(1, 2, 12.0, 0.5, 0));
+    InnovationPtr recur(new Innovation(1, 2, 13.0, 0.5, 0, true));
+    registry.add(node);
+    registry.add(link);
+    registry.add(recur);
+    // only the first innovation with a key is kept
+    registry.add(InnovationPtr(new Innovation(1, 2, 14.0, 0.7, 1)));
+
+    BOOST_CHECK_EQUAL( registry.size(), 3u );
+    BOOST_CHECK( registry.find_node(1, 2, 5.0) == node );
+    BOOST_CHECK( !registry.find_node(1, 2, 6.0) );
+    BOOST_CHECK( registry.find_link(1, 2, false) == link );
+    BOOST_CHECK( registry.find_link(1, 2, true) == recur );
+    BOOST_CHECK( !registry.find_link(2, 1, false) );
+
+    // the oldest innovation is forgotten first
+    registry.add(InnovationPtr(new Innovation(3, 4, 15.0, 0.1, 0)));
+    BOOST_CHECK_EQUAL( registry.size(), 3u );
+    BOOST_CHECK( !registry.find_node(1, 2, 5.0) );
+    BOOST_CHECK( registry.find_link(1, 2, false) == link );
+
+    std::stringstream buffer;
+    {
+        boost::archive::text_oarchive out(buffer);
+        out << registry;
+    }
+    InnovationRegistry loaded;
+    {
+        boost::archive::text_iarchive in(buffer);
+        in >> loaded;
+    }
+    BOOST_CHECK_EQUAL( loaded.size(), 3u );
+    BOOST_CHECK_EQUAL( loaded.get_max_size(), 3 );
+    BOOST_CHECK( loaded.find_link(3, 4, false) );
+    BOOST_CHECK_EQUAL( loaded.find_link(1, 2, true)->innovation_num1, 13.0 );
+
+    registry.clear();
+    BOOST_CHECK_EQUAL( registry.size(), 0u );
+    BOOST_CHECK( !registry.find_link(1, 2, false) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include "core/Common.h"
+
+#include "rtneat/population.h"
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace NEAT;
+
+    PopulationPtr make_population(S32 size)
+    {
+        std::vector<Genome*> genomes;
+        for (S32 id = 1; id <= size; ++id)
+            genomes.push_back(new Genome(id, 4, 2, 5, 10, true, 0.5));
+        return PopulationPtr(new Population(genomes, 0));
+    }
+
+    // mutate the weights of every organism a few times, drawing from the
+    // stream of the population
+    void mutate_population(PopulationPtr pop)
+    {
+        ScopedRandGen stream(pop->params.randgen);
+        for (S32 round = 0; round < 20; ++round)
+            for (size_t i = 0; i < pop->organisms.size(); ++i)
+                pop->organisms[i]->gnome->mutate_link_weights(1.0, 1.0, GAUSSIAN);
+    }
+
+    std::vector<F64> weights(const PopulationPtr& pop)
+    {
+        std::vector<F64> result;
+        for (size_t i = 0; i < pop->organisms.size(); ++i)
+        {
+            const std::vector<GenePtr>& genes = pop->organisms[i]->gnome->genes;
+            for (size_t j = 0; j < genes.size(); ++j)
+                result.push_back(genes[j]->lnk->weight);
+        }
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_population_params_lifetime )
+{
+    PopulationPtr young = make_population(20);
+    PopulationPtr old = make_population(20);
+    young->params.time_alive_minimum = 5;
+    old->params.time_alive_minimum = 50;
+    for (size_t i = 0; i < young->organisms.size(); ++i)
+    {
+        young->organisms[i]->time_alive = 20;
+        old->organisms[i]->time_alive = 20;
+    }
+
+    // each population judges its organisms by its own lifetime
+    BOOST_CHECK( young->remove_worst() );
+    BOOST_CHECK( !old->remove_worst() );
+
+    // and notices when it changes
+    old->params.time_alive_minimum = 10;
+    BOOST_CHECK( old->remove_worst() );
+}
+
+BOOST_AUTO_TEST_CASE( test_population_params_random_stream )
+{
+    // populations built from the same stream are alike, random stream included
+    PopulationPtr a1, a2, b1, b2;
+    { ScopedRandGen stream(1); a1 = make_population(10); }
+    { ScopedRandGen stream(1); a2 = make_population(10); }
+    { ScopedRandGen stream(2); b1 = make_population(10); }
+    { ScopedRandGen stream(2); b2 = make_population(10); }
+    BOOST_REQUIRE( weights(a1) == weights(a2) );
+    BOOST_REQUIRE( weights(b1) == weights(b2) );
+
+    // one pair evolves one after the other, the other pair side by side
+    mutate_population(a1);
+    mutate_population(b1);
+    boost::thread ta(boost::bind(&mutate_population, a2));
+    boost::thread tb(boost::bind(&mutate_population, b2));
+    ta.join();
+    tb.join();
+
+    BOOST_CHECK( weights(a1) == weights(a2) );
+    BOOST_CHECK( weights(b1) == weights(b2) );
+    BOOST_CHECK( weights(a1) != weights(b1) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+#include "core/Common.h"
+
+#include "rtneat/population.h"
+#include "rtneat/snapshot.h"
+#include "rtneat/network.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_population_snapshot )
+{
+    using namespace NEAT;
+
+    // random recurrent genomes with 4 inputs (last one is the bias) and 2 outputs
+    std::vector<Genome*> genomes;
+    for (S32 id = 1; id <= 30; ++id)
+        genomes.push_back(new Genome(id, 4, 2, 5, 10, true, 0.5));
+    PopulationPtr pop(new Population(genomes, 0));
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        pop->organisms[i]->fitness = i * 0.5;
+        pop->organisms[i]->time_alive = i;
+        pop->organisms[i]->metadata = "brain " + boost::lexical_cast<std::string>(i);
+    }
+    pop->organisms[3]->champion = true;
+    for (int i = 0; i < 1000; ++i)
+        pop->params.randgen.randInt();
+
+    std::string fname = (boost::filesystem::temp_directory_path()
+        / boost::filesystem::unique_path("population-%%%%%%%%.snap")).string();
+    BOOST_REQUIRE( save_population_snapshot(pop, fname) );
+    BOOST_CHECK( is_population_snapshot(fname) );
+
+    PopulationPtr loaded = load_population_snapshot(fname);
+    BOOST_REQUIRE_EQUAL( loaded->organisms.size(), pop->organisms.size() );
+    BOOST_REQUIRE_EQUAL( loaded->species.size(), pop->species.size() );
+    BOOST_CHECK_EQUAL( loaded->cur_node_id, pop->cur_node_id );
+    BOOST_CHECK_EQUAL( loaded->cur_innov_num, pop->cur_innov_num );
+    BOOST_CHECK_EQUAL( loaded->last_species, pop->last_species );
+
+    // the random stream continues where the saved one left off
+    for (int i = 0; i < 1000; ++i)
+        BOOST_CHECK_EQUAL( loaded->params.randgen.randInt(), pop->params.randgen.randInt() );
+
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        OrganismPtr a = pop->organisms[i], b = loaded->organisms[i];
+        BOOST_CHECK_EQUAL( a->fitness, b->fitness );
+        BOOST_CHECK_EQUAL( a->time_alive, b->time_alive );
+        BOOST_CHECK_EQUAL( a->champion, b->champion );
+        BOOST_CHECK_EQUAL( a->metadata, b->metadata );
+        BOOST_CHECK_EQUAL( a->species.lock()->id, b->species.lock()->id );
+        BOOST_CHECK_EQUAL( a->gnome->genome_id, b->gnome->genome_id );
+        BOOST_REQUIRE_EQUAL( a->gnome->nodes.size(), b->gnome->nodes.size() );
+        BOOST_REQUIRE_EQUAL( a->gnome->genes.size(), b->gnome->genes.size() );
+        for (size_t j = 0; j < a->gnome->genes.size(); ++j)
+        {
+            LinkPtr la = a->gnome->genes[j]->lnk, lb = b->gnome->genes[j]->lnk;
+            BOOST_CHECK( la->weight == lb->weight );
+            BOOST_CHECK_EQUAL( la->is_recurrent, lb->is_recurrent );
+            BOOST_CHECK_EQUAL( la->get_in_node()->node_id, lb->get_in_node()->node_id );
+            BOOST_CHECK_EQUAL( la->get_out_node()->node_id, lb->get_out_node()->node_id );
+            BOOST_CHECK_EQUAL( a->gnome->genes[j]->enable, b->gnome->genes[j]->enable );
+        }
+
+        // the networks built from the loaded genomes behave the same
+        std::vector<F64> sensors(4, 0.5), outa, outb;
+        a->net->load_sensors(sensors);
+        b->net->load_sensors(sensors);
+        a->net->activate();
+        b->net->activate();
+        a->net->get_outputs(outa);
+        b->net->get_outputs(outb);
+        BOOST_CHECK( outa == outb );
+    }
+
+    // species membership is restored, not recomputed
+    for (size_t i = 0; i < pop->species.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL( pop->species[i]->id, loaded->species[i]->id );
+        BOOST_REQUIRE_EQUAL( pop->species[i]->organisms.size(), loaded->species[i]->organisms.size() );
+        for (size_t j = 0; j < pop->species[i]->organisms.size(); ++j)
+            BOOST_CHECK_EQUAL( pop->species[i]->organisms[j]->metadata,
+                               loaded->species[i]->organisms[j]->metadata );
+    }
+
+    // a truncated snapshot is rejected
+    boost::filesystem::resize_file(fname, boost::filesystem::file_size(fname) / 2);
+    BOOST_CHECK_THROW( load_population_snapshot(fname), std::runtime_error );
+
+    // and so is a text population
+    std::ofstream text(fname.c_str());
+    pop->print_to_file(text);
+    text.close();
+    BOOST_CHECK( !is_population_snapshot(fname) );
+    BOOST_CHECK_THROW( load_population_snapshot(fname), std::runtime_error );
+
+    std::remove(fname.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+#include "core/Common.h"
+
+#include "rtneat/population.h"
+#include <algorithm>
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    using namespace NEAT;
+
+    // the full scan that remove_worst used to do
+    OrganismPtr scan_for_worst(const PopulationPtr& pop)
+    {
+        F64 min_fitness = 999999;
+        OrganismPtr worst;
+        for (size_t i = 0; i < pop->organisms.size(); ++i)
+        {
+            const OrganismPtr& org = pop->organisms[i];
+            F64 adjusted = org->fitness / org->species.lock()->organisms.size();
+            if (adjusted < min_fitness && org->time_alive >= static_cast<S32>(pop->params.time_alive_minimum))
+            {
+                min_fitness = adjusted;
+                worst = org;
+            }
+        }
+        return worst;
+    }
+
+    struct OldEnough
+    {
+        S32 time_alive_minimum;
+        bool operator()(const OrganismPtr& org) const
+        {
+            return org->time_alive >= time_alive_minimum;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE( test_opennero )
+
+BOOST_AUTO_TEST_CASE( test_removal_index )
+{
+    std::vector<Genome*> genomes;
+    for (S32 id = 1; id <= 60; ++id)
+        genomes.push_back(new Genome(id, 4, 2, 5, 10, true, 0.5));
+    PopulationPtr pop(new Population(genomes, 0));
+    pop->params.time_alive_minimum = 10;
+    OldEnough old_enough = { 10 };
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        pop->organisms[i]->fitness = randfloat();
+        pop->organisms[i]->time_alive = randint(0, 20);
+    }
+    BOOST_REQUIRE( pop->species.size() > 1 );
+
+    S32 next_id = 100;
+    for (S32 step = 0; step < 200; ++step)
+    {
+        // some organisms get older and get new fitness values
+        for (S32 k = 0; k < 5; ++k)
+        {
+            OrganismPtr org = pop->organisms[randint(0, pop->organisms.size() - 1)];
+            org->time_alive += randint(0, 10);
+            org->fitness = randfloat();
+            pop->update_organism(org);
+        }
+
+        // and once in a while somebody forgets to tell the index about
+        // the organism that it would pick
+        if (step % 7 == 3 && pop->removal_index.is_built())
+        {
+            OrganismPtr worst = pop->removal_index.worst();
+            if (worst)
+                worst->fitness += 1.0;
+        }
+
+        OrganismPtr expected = scan_for_worst(pop);
+        OrganismPtr removed = pop->remove_worst();
+        BOOST_CHECK( removed == expected );
+        BOOST_CHECK_EQUAL( pop->removal_index.size(),
+                           static_cast<size_t>(std::count_if(pop->organisms.begin(), pop->organisms.end(),
+                                                             old_enough)) );
+
+        // a newcomer takes the place of the removed organism
+        if (removed)
+        {
+            GenomePtr genome(new Genome(next_id++, 4, 2, 5, 10, true, 0.5));
+            OrganismPtr baby(new Organism(0.0, genome, 1));
+            pop->add_organism(baby);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_removal_index_updates )
+{
+    std::vector<Genome*> genomes;
+    for (S32 id = 1; id <= 60; ++id)
+        genomes.push_back(new Genome(id, 4, 2, 5, 10, true, 0.5));
+    PopulationPtr pop(new Population(genomes, 0));
+    pop->params.time_alive_minimum = 10;
+    for (size_t i = 0; i < pop->organisms.size(); ++i)
+    {
+        pop->organisms[i]->fitness = randfloat();
+        pop->organisms[i]->time_alive = 20;
+    }
+    // build the index
+    BOOST_CHECK( pop->remove_worst() );
+    BOOST_CHECK_EQUAL( pop->removal_index.num_updates(), 0u );
+
+    for (S32 tick = 1; tick <= 20; ++tick)
+    {
+        // every tick all the fitness values are assigned again, but only a few change
+        size_t before = pop->removal_index.num_updates();
+        size_t changed = 0;
+        for (size_t i = 0; i < pop->organisms.size(); ++i)
+        {
+            OrganismPtr org = pop->organisms[i];
+            F64 fitness = org->fitness;
+            if (i % 20 == size_t(tick) % 20)
+            {
+                fitness += 1.0;
+                ++changed;
+            }
+            pop->set_fitness(org, fitness);
+        }
+        BOOST_CHECK_EQUAL( pop->removal_index.num_updates() - before, changed );
+        BOOST_CHECK( pop->removal_index.worst() == scan_for_worst(pop) );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()